@@ -0,0 +1,682 @@
+/*
+ * VoteMe Benchmark Suite
+ *
+ * Builds a synthetic election per scale in a scratch directory and times
+ * the paths that matter at that size:
+ *
+ *   read_voter_scan    read_voter without a lookup index (file scan)
+ *   read_voter         read_voter through the voting_number index
+ *   read_voter_mt      the same from several threads at once; every row and
+ *                      every thread's error code is checked
+ *   update_candidate   rename a candidate (rewrites approved_candidates.txt)
+ *   tally              execute_voting_algorithm over data/votes.txt, cold
+ *                      (no checkpoint)
+ *   display_results    load_voting_results over a parliament of every candidate
+ *   create_temp_voted  record a voter in a temp voted list of scale rows
+ *
+ * A scale of N means N approved voters, N votes and N/10 candidates (at
+ * least 100, at most 1000000). Scenarios that touch the whole file per
+ * operation run fewer operations at larger scales. Every operation is timed
+ * on its own; each scenario reports ops/sec and the p50/p99 latency, and can
+ * append them to a CSV file to compare builds. Data sets are generated from a
+ * fixed seed, so runs are repeatable.
+ *
+ * Usage: bench [--scales 10k,1M,10M] [--only name,...] [--threads N]
+ *              [--ops N] [--csv file] [--label name] [--dir path] [--keep]
+ */
+
+// mkdtemp/chdir/dup need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "data_handler_enhanced.h"
+#include "display.h"
+#include "tally.h"
+#include "voting.h"
+
+#define BENCH_SEED 0x5eed2024ULL
+#define BENCH_PARTIES 20
+#define BENCH_DISTRICTS 25
+#define BENCH_MAX_SCALES 8
+#define BENCH_MAX_THREADS 64
+#define BENCH_DEFAULT_SCALES "10k,1M"
+
+#define VOTERS_FILE "data/approved_voters.txt"
+#define CANDIDATES_FILE "data/approved_candidates.txt"
+#define TEMP_VOTED_FILE "data/temp-voted-list.txt"
+
+// One scale's data set, as seen by the operations
+typedef struct
+{
+    long long voters;
+    long long candidates;
+    int threads;
+} bench_data_t;
+
+// How many operations a scenario runs: base_ops, or fewer when each one
+// touches the whole file (row_budget / rows, kept within [min_ops, base_ops])
+typedef struct
+{
+    const char *name;
+    int (*setup)(const bench_data_t *data);
+    int (*op)(const bench_data_t *data, size_t i);
+    size_t base_ops;
+    size_t min_ops;
+    double row_budget; // 0 when an operation's cost does not grow with the file
+    int per_candidate; // the file it walks has a row per candidate, not per voter
+    int threaded;
+} scenario_t;
+
+static struct
+{
+    long long scales[BENCH_MAX_SCALES];
+    int scale_count;
+    const char *only;
+    int threads;
+    size_t ops;
+    const char *csv;
+    const char *label;
+    const char *dir;
+    int keep;
+} opts;
+
+/* ==== Helpers ==== */
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// SplitMix64: the i-th pseudo-random number of a run, independent of thread timing
+static uint64_t mix(uint64_t x)
+{
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static void voter_id(char *out, size_t size, long long n)
+{
+    snprintf(out, size, "V%08lld", n);
+}
+
+static void candidate_id(char *out, size_t size, long long n)
+{
+    snprintf(out, size, "C%06lld", n);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// "10000", "10k", "1M", "1.5M"; 0 when malformed
+static long long parse_scale(const char *s)
+{
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || v <= 0)
+        return 0;
+    if (*end == 'k' || *end == 'K')
+        v *= 1e3, end++;
+    else if (*end == 'm' || *end == 'M')
+        v *= 1e6, end++;
+    return *end ? 0 : (long long)v;
+}
+
+static int parse_scales(const char *list)
+{
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", list);
+    opts.scale_count = 0;
+    const char *sep = ", ";
+    for (char *p = buf; *p;)
+    {
+        size_t len = strcspn(p, sep);
+        char save = p[len];
+        p[len] = '\0';
+        if (len > 0)
+        {
+            long long n = parse_scale(p);
+            if (n <= 0 || opts.scale_count == BENCH_MAX_SCALES)
+            {
+                fprintf(stderr, "bench: bad scale '%s'\n", p);
+                return 0;
+            }
+            opts.scales[opts.scale_count++] = n;
+        }
+        p += len + (save ? 1 : 0);
+    }
+    return opts.scale_count > 0;
+}
+
+static int selected(const char *name)
+{
+    if (!opts.only)
+        return 1;
+    size_t len = strlen(name);
+    for (const char *p = opts.only; (p = strstr(p, name)) != NULL; p += len)
+    {
+        if ((p == opts.only || p[-1] == ',') && (p[len] == '\0' || p[len] == ','))
+            return 1;
+    }
+    return 0;
+}
+
+/* ==== Data sets ==== */
+
+static FILE *open_data(const char *path, const char *header)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+    {
+        fprintf(stderr, "bench: cannot create %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+    fprintf(fp, "%s\n", header);
+    return fp;
+}
+
+static int close_data(FILE *fp, const char *path)
+{
+    if (ferror(fp) | fclose(fp))
+    {
+        fprintf(stderr, "bench: cannot write %s\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+static int write_temp_voted(long long rows, long long candidates)
+{
+    FILE *fp = open_data(TEMP_VOTED_FILE, "voting_number,candidate_number,party_id");
+    if (!fp)
+        return 0;
+    char v[24], c[24];
+    for (long long i = 1; i <= rows; i++)
+    {
+        long long cand = (long long)(mix(BENCH_SEED ^ 0x7e ^ (uint64_t)i) % (uint64_t)candidates);
+        voter_id(v, sizeof(v), i);
+        candidate_id(c, sizeof(c), cand + 1);
+        fprintf(fp, "%s,%s,P%02lld\n", v, c, cand % BENCH_PARTIES + 1);
+    }
+    return close_data(fp, TEMP_VOTED_FILE);
+}
+
+static int write_parliament(long long members)
+{
+    FILE *fp = open_data("data/parliament_candidates.txt", "candidate_number,party_id");
+    if (!fp)
+        return 0;
+    char c[24];
+    for (long long i = 0; i < members; i++)
+    {
+        candidate_id(c, sizeof(c), i + 1);
+        fprintf(fp, "%s,P%02lld\n", c, i % BENCH_PARTIES + 1);
+    }
+    return close_data(fp, "data/parliament_candidates.txt");
+}
+
+static int generate(const bench_data_t *data)
+{
+    if (mkdir("data", 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "bench: cannot create data/: %s\n", strerror(errno));
+        return 0;
+    }
+    FILE *fp = open_data("data/system_config.txt", "# VoteMe benchmark configuration");
+    if (!fp)
+        return 0;
+    fprintf(fp, "voting_enabled=1\ntally_threads=0\n");
+    if (!close_data(fp, "data/system_config.txt"))
+        return 0;
+
+    if (!(fp = open_data("data/party_name.txt", "party_id,party_name")))
+        return 0;
+    for (int p = 1; p <= BENCH_PARTIES; p++)
+        fprintf(fp, "P%02d,Party %d\n", p, p);
+    if (!close_data(fp, "data/party_name.txt"))
+        return 0;
+
+    if (!(fp = open_data("data/district.txt", "district_id,district_name")))
+        return 0;
+    for (int d = 1; d <= BENCH_DISTRICTS; d++)
+        fprintf(fp, "D%02d,District %d\n", d, d);
+    if (!close_data(fp, "data/district.txt"))
+        return 0;
+
+    char id[24];
+    if (!(fp = open_data(VOTERS_FILE, "voting_number,name,nic,district_id")))
+        return 0;
+    for (long long i = 1; i <= data->voters; i++)
+    {
+        voter_id(id, sizeof(id), i);
+        fprintf(fp, "%s,Voter %lld,%lld,D%02lld\n", id, i, 200000000000LL + i, i % BENCH_DISTRICTS + 1);
+    }
+    if (!close_data(fp, VOTERS_FILE))
+        return 0;
+
+    if (!(fp = open_data(CANDIDATES_FILE, "candidate_number,name,party_id,district_id,nic")))
+        return 0;
+    for (long long i = 1; i <= data->candidates; i++)
+    {
+        candidate_id(id, sizeof(id), i);
+        fprintf(fp, "%s,Candidate %lld,P%02lld,D%02lld,%09lldV\n", id, i, (i - 1) % BENCH_PARTIES + 1,
+                (i - 1) % BENCH_DISTRICTS + 1, 100000000LL + i);
+    }
+    if (!close_data(fp, CANDIDATES_FILE))
+        return 0;
+
+    if (!(fp = open_data("data/votes.txt", "voter_id,candidate_id")))
+        return 0;
+    char c[24];
+    for (long long i = 1; i <= data->voters; i++)
+    {
+        voter_id(id, sizeof(id), i);
+        candidate_id(c, sizeof(c), (long long)(mix(BENCH_SEED ^ (uint64_t)i) % (uint64_t)data->candidates) + 1);
+        fprintf(fp, "%s,%s\n", id, c);
+    }
+    if (!close_data(fp, "data/votes.txt"))
+        return 0;
+
+    return write_temp_voted(0, data->candidates) && write_parliament(0);
+}
+
+// Remove a directory with the files the data layer leaves in it
+static void remove_tree(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir)
+    {
+        struct dirent *e;
+        char child[1024];
+        while ((e = readdir(dir)) != NULL)
+        {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+            snprintf(child, sizeof(child), "%s/%s", path, e->d_name);
+            // unlink() of a directory fails with EISDIR on Linux, EPERM elsewhere
+            if (unlink(child) != 0 && (errno == EISDIR || errno == EPERM))
+                remove_tree(child);
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+/* ==== Scenarios ==== */
+
+static int op_read_voter(const bench_data_t *data, size_t i)
+{
+    // One lookup in ten asks for a voter who is not on the roll
+    long long n = (long long)(mix(BENCH_SEED ^ 0xa11 ^ i) % (uint64_t)(data->voters + data->voters / 9 + 1)) + 1;
+    char id[24];
+    voter_id(id, sizeof(id), n);
+    char *row = read_voter(id);
+    int ok = n <= data->voters ? row && strncmp(row, id, strlen(id)) == 0 && row[strlen(id)] == ','
+                               : !row && get_last_error_code() == DATA_ERROR_RECORD_NOT_FOUND;
+    free(row);
+    return ok ? 0 : -1;
+}
+
+static int setup_unindexed(const bench_data_t *data)
+{
+    (void)data;
+    drop_index(VOTERS_FILE, 0);
+    return 1;
+}
+
+static int setup_indexed(const bench_data_t *data)
+{
+    (void)data;
+    return create_index(VOTERS_FILE, 0) == DATA_SUCCESS;
+}
+
+static int op_update_candidate(const bench_data_t *data, size_t i)
+{
+    char id[24], name[32];
+    candidate_id(id, sizeof(id), (long long)(mix(BENCH_SEED ^ 0xca ^ i) % (uint64_t)data->candidates) + 1);
+    snprintf(name, sizeof(name), "Renamed %zu", i);
+    return update_candidate(id, 1, name) == DATA_SUCCESS ? 0 : -1;
+}
+
+static int setup_tally(const bench_data_t *data)
+{
+    return write_temp_voted(0, data->candidates); // count data/votes.txt, not the temp list
+}
+
+static int op_tally(const bench_data_t *data, size_t i)
+{
+    (void)data;
+    (void)i;
+    unlink(TALLY_CHECKPOINT_FILE);
+    // The report goes to /dev/null; only the work behind it is timed
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    if (saved < 0 || null < 0)
+    {
+        if (saved >= 0)
+            close(saved);
+        if (null >= 0)
+            close(null);
+        return -1;
+    }
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    int rc = execute_voting_algorithm(1, 225);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    return rc == DATA_SUCCESS ? 0 : -1;
+}
+
+static int setup_display(const bench_data_t *data)
+{
+    return write_parliament(data->candidates);
+}
+
+static int op_display(const bench_data_t *data, size_t i)
+{
+    (void)i;
+    result_row_t *rows;
+    size_t count;
+    if (load_voting_results(&rows, &count) != DATA_SUCCESS)
+        return -1;
+    free(rows);
+    return count == (size_t)data->candidates ? 0 : -1;
+}
+
+static int setup_temp_voted(const bench_data_t *data)
+{
+    return write_temp_voted(data->voters, data->candidates);
+}
+
+static int op_temp_voted(const bench_data_t *data, size_t i)
+{
+    // Voters past the roll, so every one is new to the list
+    char v[24], c[24], p[8];
+    long long cand = (long long)(mix(BENCH_SEED ^ 0x7f ^ i) % (uint64_t)data->candidates);
+    voter_id(v, sizeof(v), data->voters + 1 + (long long)i);
+    candidate_id(c, sizeof(c), cand + 1);
+    snprintf(p, sizeof(p), "P%02lld", cand % BENCH_PARTIES + 1);
+    return create_temp_voted(v, c, p) == DATA_SUCCESS ? 0 : -1;
+}
+
+static const scenario_t scenarios[] = {
+    {"read_voter_scan", setup_unindexed, op_read_voter, 2000, 5, 5e7, 0, 0},
+    {"read_voter", setup_indexed, op_read_voter, 20000, 20000, 0, 0, 0},
+    {"read_voter_mt", setup_indexed, op_read_voter, 40000, 40000, 0, 0, 1},
+    {"update_candidate", NULL, op_update_candidate, 200, 3, 2e7, 1, 0},
+    {"tally", setup_tally, op_tally, 20, 3, 5e7, 0, 0},
+    {"display_results", setup_display, op_display, 200, 3, 2e7, 1, 0},
+    {"create_temp_voted", setup_temp_voted, op_temp_voted, 2000, 5, 5e7, 0, 0},
+};
+
+/* ==== Runner ==== */
+
+typedef struct
+{
+    const scenario_t *sc;
+    const bench_data_t *data;
+    uint64_t *lat;
+    size_t first;
+    size_t count;
+    int failed;
+} worker_t;
+
+static void *run_worker(void *arg)
+{
+    worker_t *w = arg;
+    for (size_t i = w->first; i < w->first + w->count; i++)
+    {
+        uint64_t t0 = now_ns();
+        if (w->sc->op(w->data, i) != 0)
+        {
+            w->failed = 1;
+            return NULL;
+        }
+        w->lat[i] = now_ns() - t0;
+    }
+    return NULL;
+}
+
+static size_t scenario_ops(const scenario_t *sc, long long rows)
+{
+    size_t ops = opts.ops ? opts.ops : sc->base_ops;
+    if (sc->row_budget > 0 && !opts.ops)
+    {
+        double by_size = sc->row_budget / (double)rows;
+        if (by_size < (double)ops)
+            ops = by_size < (double)sc->min_ops ? sc->min_ops : (size_t)by_size;
+    }
+    return ops;
+}
+
+static void report(FILE *csv, const char *name, long long scale, size_t ops, double seconds, uint64_t lat[])
+{
+    qsort(lat, ops, sizeof(*lat), cmp_u64);
+    double p50 = (double)lat[(ops - 1) * 50 / 100] / 1000.0;
+    double p99 = (double)lat[(ops - 1) * 99 / 100] / 1000.0;
+    double rate = seconds > 0 ? (double)ops / seconds : 0.0;
+    printf("%-18s %10lld %8zu %14.1f %12.1f %12.1f\n", name, scale, ops, rate, p50, p99);
+    fflush(stdout);
+    if (csv)
+        fprintf(csv, "%s,%s,%lld,%zu,%.6f,%.1f,%.1f,%.1f\n", opts.label, name, scale, ops, seconds, rate, p50, p99);
+}
+
+// Returns 0 on success, -1 when an operation failed
+static int run_scenario(const scenario_t *sc, const bench_data_t *data, long long scale, FILE *csv)
+{
+    if (sc->setup && !sc->setup(data))
+    {
+        printf("%-18s %10lld  setup failed: %s\n", sc->name, scale, get_last_error());
+        return -1;
+    }
+    size_t ops = scenario_ops(sc, sc->per_candidate ? data->candidates : data->voters);
+    uint64_t *lat = malloc(ops * sizeof(*lat));
+    if (!lat)
+        return -1;
+
+    // One untimed operation first (index past the timed ones) warms caches and
+    // compiles the catalog snapshot when the scenario needs it
+    int failed = sc->op(data, ops) != 0;
+    int threads = sc->threaded ? data->threads : 1;
+    worker_t workers[BENCH_MAX_THREADS];
+    pthread_t tids[BENCH_MAX_THREADS];
+    uint64_t start = now_ns();
+    for (int t = 0; t < threads && !failed; t++)
+    {
+        workers[t].sc = sc;
+        workers[t].data = data;
+        workers[t].lat = lat;
+        workers[t].first = ops * (size_t)t / (size_t)threads;
+        workers[t].count = ops * (size_t)(t + 1) / (size_t)threads - workers[t].first;
+        workers[t].failed = 0;
+    }
+    if (!failed && threads == 1)
+    {
+        run_worker(&workers[0]);
+    }
+    else if (!failed)
+    {
+        int started = 0;
+        while (started < threads && pthread_create(&tids[started], NULL, run_worker, &workers[started]) == 0)
+            started++;
+        for (int t = 0; t < started; t++)
+            pthread_join(tids[t], NULL);
+        failed = started < threads;
+    }
+    double seconds = (double)(now_ns() - start) / 1e9;
+    for (int t = 0; t < threads && !failed; t++)
+        failed = workers[t].failed;
+
+    if (failed)
+        printf("%-18s %10lld  FAILED: %s\n", sc->name, scale, get_last_error());
+    else
+        report(csv, sc->name, scale, ops, seconds, lat);
+    free(lat);
+    return failed ? -1 : 0;
+}
+
+static int run_scale(long long scale, FILE *csv)
+{
+    bench_data_t data;
+    data.voters = scale;
+    data.candidates = scale / 10 < 100 ? 100 : scale / 10 > 1000000 ? 1000000 : scale / 10;
+    data.threads = opts.threads;
+
+    char dir[64];
+    snprintf(dir, sizeof(dir), "scale-%lld", scale);
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "bench: cannot create %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    if (chdir(dir) != 0)
+        return -1;
+
+    uint64_t t0 = now_ns();
+    int rc = generate(&data) ? 0 : -1;
+    if (rc == 0)
+        printf("# scale %lld: %lld voters, %lld votes, %lld candidates generated in %.1f s\n", scale, data.voters,
+               data.voters, data.candidates, (double)(now_ns() - t0) / 1e9);
+    for (size_t i = 0; rc == 0 && i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+    {
+        if (selected(scenarios[i].name) && run_scenario(&scenarios[i], &data, scale, csv) != 0)
+            rc = -1;
+    }
+
+    if (chdir("..") != 0)
+        return -1;
+    if (!opts.keep)
+        remove_tree(dir);
+    return rc;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --scales LIST   data set sizes, e.g. 10k,1M,10M (default " BENCH_DEFAULT_SCALES ")\n"
+            "  --only LIST     scenarios to run (default all)\n"
+            "  --threads N     threads for read_voter_mt (default 4)\n"
+            "  --ops N         operations per scenario, overriding the defaults\n"
+            "  --csv FILE      append results to FILE as CSV\n"
+            "  --label NAME    build label for the CSV rows\n"
+            "  --dir PATH      scratch directory (default: a new one under /tmp)\n"
+            "  --keep          keep the generated data sets\n"
+            "Scenarios:",
+            prog);
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+        fprintf(stderr, " %s", scenarios[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    opts.threads = 4;
+    opts.label = "";
+    const char *scales = BENCH_DEFAULT_SCALES;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--keep") == 0)
+        {
+            opts.keep = 1;
+            continue;
+        }
+        if (!val || strncmp(arg, "--", 2) != 0)
+        {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0 ? 0 : 2;
+        }
+        i++;
+        if (strcmp(arg, "--scales") == 0)
+            scales = val;
+        else if (strcmp(arg, "--only") == 0)
+            opts.only = val;
+        else if (strcmp(arg, "--threads") == 0)
+            opts.threads = atoi(val);
+        else if (strcmp(arg, "--ops") == 0)
+            opts.ops = (size_t)strtoul(val, NULL, 10);
+        else if (strcmp(arg, "--csv") == 0)
+            opts.csv = val;
+        else if (strcmp(arg, "--label") == 0)
+            opts.label = val;
+        else if (strcmp(arg, "--dir") == 0)
+            opts.dir = val;
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (!parse_scales(scales) || opts.threads < 1 || opts.threads > BENCH_MAX_THREADS)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Relative paths must resolve before we leave the caller's directory
+    FILE *csv = NULL;
+    if (opts.csv)
+    {
+        csv = fopen(opts.csv, "a+");
+        if (!csv)
+        {
+            fprintf(stderr, "bench: cannot open %s: %s\n", opts.csv, strerror(errno));
+            return 1;
+        }
+        fseek(csv, 0, SEEK_END);
+        if (ftell(csv) == 0)
+            fprintf(csv, "label,scenario,scale,ops,seconds,ops_per_sec,p50_us,p99_us\n");
+    }
+
+    char scratch[] = "/tmp/voteme-bench-XXXXXX";
+    const char *dir = opts.dir;
+    if (!dir && !(dir = mkdtemp(scratch)))
+    {
+        fprintf(stderr, "bench: cannot create a scratch directory: %s\n", strerror(errno));
+        return 1;
+    }
+    if ((mkdir(dir, 0755) != 0 && errno != EEXIST) || chdir(dir) != 0)
+    {
+        fprintf(stderr, "bench: cannot use %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+    printf("# scratch directory %s\n", dir);
+    printf("%-18s %10s %8s %14s %12s %12s\n", "scenario", "scale", "ops", "ops/sec", "p50 us", "p99 us");
+
+    int rc = 0;
+    for (int s = 0; s < opts.scale_count; s++)
+    {
+        if (run_scale(opts.scales[s], csv) != 0)
+            rc = 1;
+    }
+
+    if (csv)
+        fclose(csv);
+    if (!opts.dir && !opts.keep && chdir("/") == 0)
+        rmdir(scratch);
+    return rc;
+}
@@ -30,28 +30,45 @@ echo === Building with %CC% ===
 set CFLAGS=-Wall -Wextra -std=c99 -O2 -Isrc
 
 echo [1/5] bin\voteme.exe
-%CC% %CFLAGS% -o bin\voteme.exe src\main.c src\display.c
+%CC% %CFLAGS% -o bin\voteme.exe src\main.c src\display.c src\catalog_snapshot.c src\vote_source.c src\csv_io.c src\record_index.c src\data_errors.c
 if errorlevel 1 goto err
 
 echo [2/5] bin\admin.exe
-%CC% %CFLAGS% -o bin\admin.exe ^
+%CC% %CFLAGS% -pthread -o bin\admin.exe ^
   src\admin.c ^
   src\data_handler_enhanced.c ^
   src\voting.c ^
   src\ui_utils.c ^
   src\csv_io.c ^
+  src\record_index.c ^
   src\data_errors.c ^
   src\entity_codec.c ^
   src\entity_service.c ^
-  src\voting-interface.c
+  src\voting-interface.c ^
+  src\votemed_proto.c ^
+  src\tally.c ^
+  src\sys_config.c ^
+  src\vote_source.c ^
+  src\vote_journal.c ^
+  src\voted_set.c ^
+  src\ballot_catalog.c ^
+  src\catalog_snapshot.c
 if errorlevel 1 goto err
 
 echo [3/5] bin\voter_register.exe
-%CC% %CFLAGS% -o bin\voter_register.exe ^
+%CC% %CFLAGS% -pthread -o bin\voter_register.exe ^
   src\voter_register.c ^
   src\voting-interface.c ^
+  src\votemed_proto.c ^
+  src\ballot_catalog.c ^
+  src\catalog_snapshot.c ^
+  src\vote_journal.c ^
+  src\voted_set.c ^
+  src\vote_source.c ^
+  src\sys_config.c ^
   src\data_handler_enhanced.c ^
   src\csv_io.c ^
+  src\record_index.c ^
   src\data_errors.c
 if errorlevel 1 goto err
 
@@ -60,15 +77,24 @@ echo [4/5] bin\candidate_register.exe
   src\candidate_register.c ^
   src\data_handler_enhanced.c ^
   src\csv_io.c ^
+  src\record_index.c ^
   src\data_errors.c
 if errorlevel 1 goto err
 
 echo [5/5] bin\vote.exe
-%CC% %CFLAGS% -o bin\vote.exe ^
+%CC% %CFLAGS% -pthread -o bin\vote.exe ^
   src\vote_cli.c ^
   src\voting-interface.c ^
+  src\votemed_proto.c ^
+  src\ballot_catalog.c ^
+  src\catalog_snapshot.c ^
+  src\vote_journal.c ^
+  src\voted_set.c ^
+  src\vote_source.c ^
+  src\sys_config.c ^
   src\data_handler_enhanced.c ^
   src\csv_io.c ^
+  src\record_index.c ^
   src\data_errors.c
 if errorlevel 1 goto err
 
@@ -83,7 +109,7 @@ echo === Building with MSVC (cl) ===
 set CLFLAGS=/nologo /W4 /EHsc /I src
 
 echo [1/5] bin\voteme.exe
-cl %CLFLAGS% /Fe:bin\voteme.exe src\main.c src\display.c
+cl %CLFLAGS% /Fe:bin\voteme.exe src\main.c src\display.c src\catalog_snapshot.c src\vote_source.c src\csv_io.c src\record_index.c src\data_errors.c
 if errorlevel 1 goto err
 
 echo [2/5] bin\admin.exe
@@ -93,18 +119,35 @@ cl %CLFLAGS% /Fe:bin\admin.exe ^
   src\voting.c ^
   src\ui_utils.c ^
   src\csv_io.c ^
+  src\record_index.c ^
   src\data_errors.c ^
   src\entity_codec.c ^
   src\entity_service.c ^
-  src\voting-interface.c
+  src\voting-interface.c ^
+  src\votemed_proto.c ^
+  src\tally.c ^
+  src\sys_config.c ^
+  src\vote_source.c ^
+  src\vote_journal.c ^
+  src\voted_set.c ^
+  src\ballot_catalog.c ^
+  src\catalog_snapshot.c
 if errorlevel 1 goto err
 
 echo [3/5] bin\voter_register.exe
 cl %CLFLAGS% /Fe:bin\voter_register.exe ^
   src\voter_register.c ^
   src\voting-interface.c ^
+  src\votemed_proto.c ^
+  src\ballot_catalog.c ^
+  src\catalog_snapshot.c ^
+  src\vote_journal.c ^
+  src\voted_set.c ^
+  src\vote_source.c ^
+  src\sys_config.c ^
   src\data_handler_enhanced.c ^
   src\csv_io.c ^
+  src\record_index.c ^
   src\data_errors.c
 if errorlevel 1 goto err
 
@@ -113,6 +156,7 @@ cl %CLFLAGS% /Fe:bin\candidate_register.exe ^
   src\candidate_register.c ^
   src\data_handler_enhanced.c ^
   src\csv_io.c ^
+  src\record_index.c ^
   src\data_errors.c
 if errorlevel 1 goto err
 
@@ -120,8 +164,16 @@ echo [5/5] bin\vote.exe
 cl %CLFLAGS% /Fe:bin\vote.exe ^
   src\vote_cli.c ^
   src\voting-interface.c ^
+  src\votemed_proto.c ^
+  src\ballot_catalog.c ^
+  src\catalog_snapshot.c ^
+  src\vote_journal.c ^
+  src\voted_set.c ^
+  src\vote_source.c ^
+  src\sys_config.c ^
   src\data_handler_enhanced.c ^
   src\csv_io.c ^
+  src\record_index.c ^
   src\data_errors.c
 if errorlevel 1 goto err
 
@@ -20,6 +20,8 @@
 #include "voting.h"
 #include "voting.h"
 #include "voting-interface.h"
+#include "record_index.h"
+#include "vote_journal.h"
 
 // Color codes for better user interface
 #define GREEN "\033[0;32m"
@@ -42,6 +44,9 @@ typedef struct
     int max_parties;
     int max_districts;
     int voting_enabled;
+    int tally_threads; // 0 = one worker per CPU
+    int journal_sync_ms; // -1 = no fdatasync, 0 = every vote, N = group commit window
+    int ballot_district_filter; // 1 = voters only see their district's candidates
 } system_config_t;
 
 // Global system configuration
@@ -52,7 +57,10 @@ static system_config_t sys_config = {
     .max_parliament_members = 225,
     .max_parties = 50,
     .max_districts = 25,
-    .voting_enabled = 1};
+    .voting_enabled = 1,
+    .tally_threads = 0,
+    .journal_sync_ms = VOTE_JOURNAL_SYNC_EVERY_VOTE,
+    .ballot_district_filter = 0};
 
 // Configuration file path
 #define CONFIG_FILE "data/system_config.txt"
@@ -77,6 +85,21 @@ static const data_file_t data_files[] = {
     {NULL, NULL, NULL} // Sentinel
 };
 
+// On-disk lookup indexes maintained for hot key reads
+typedef struct
+{
+    const char *filename;
+    int field;
+} lookup_index_t;
+
+// Indexes (re)created by "Rebuild Lookup Indexes" even if they do not exist yet
+static const lookup_index_t lookup_indexes[] = {
+    {"data/approved_voters.txt", 0},     // voting_number (voter validation)
+    {"data/approved_voters.txt", 3},     // district_id
+    {"data/approved_candidates.txt", 2}, // party_id
+    {NULL, 0}                            // Sentinel
+};
+
 // Function prototypes
 void display_main_menu(void);
 void handle_crud_operations(void);
@@ -100,6 +123,8 @@ void delete_entity_menu(void);
 void view_all_data_files(void);
 void view_specific_file(const char *filename, const char *description);
 void display_file_list(void);
+void manage_lookup_indexes(void);
+void rebuild_lookup_indexes(void);
 
 // System configuration functions
 void load_system_config(void);
@@ -121,6 +146,7 @@ void read_district_interactive(void);
 
 void update_voter_interactive(void);
 void update_candidate_interactive(void);
+void bulk_update_candidates_interactive(void);
 void update_party_interactive(void);
 void update_district_interactive(void);
 
@@ -159,6 +185,20 @@ int main(void)
         display_error("Failed to create data directory!");
     }
 
+    // Apply votes a crashed voting session committed to the journal but never wrote out
+    int replayed = 0;
+    if (vote_journal_recover(&replayed) != DATA_SUCCESS)
+    {
+        display_error("Vote journal recovery failed!");
+        printf(RED "Error: %s\n" RESET, get_last_error());
+    }
+    else if (replayed > 0)
+    {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Recovered %d vote(s) from the vote journal.", replayed);
+        display_info(msg);
+    }
+
     int choice;
     do
     {
@@ -227,9 +267,8 @@ int main(void)
         }
         case 7:
         {
-            char ***records = NULL;
-            int rows = 0, cols = 0;
-            int rc = read_all_temp_voted(&records, &rows, &cols);
+            temp_voted_table_t table;
+            int rc = read_temp_voted_table(&table);
             if (rc != DATA_SUCCESS)
             {
                 char msg[256];
@@ -238,38 +277,39 @@ int main(void)
                 pause_for_user();
                 break;
             }
-            if (rows <= 0)
+            if (table.rows <= 0)
             {
                 display_info("No temp voted records found.");
+                free_temp_voted_table(&table);
                 pause_for_user();
                 break;
             }
 
             // Print records in 2D array style: {{V0003,C001,P01},{...}}
-            printf("\nTemp Voted Records (%d):\n", rows);
+            printf("\nTemp Voted Records (%d):\n", table.rows);
             printf("{");
-            for (int r = 0; r < rows; ++r)
+            for (int r = 0; r < table.rows; ++r)
             {
                 printf("{");
-                for (int c = 0; c < cols; ++c)
+                for (int c = 0; c < table.cols; ++c)
                 {
-                    printf("%s", records[r][c] ? records[r][c] : "");
-                    if (c + 1 < cols)
+                    printf("%s", temp_voted_cell(&table, r, c));
+                    if (c + 1 < table.cols)
                         printf(",");
                 }
                 printf("}");
-                if (r + 1 < rows)
+                if (r + 1 < table.rows)
                     printf(",");
             }
             printf("}\n\n");
 
-            free_temp_voted_records(records, rows, cols);
+            free_temp_voted_table(&table);
             pause_for_user();
             break;
         }
         case 8:
         {
-            int rc = clear_temp_voted();
+            int rc = vote_journal_clear_temp_voted();
             if (rc == DATA_SUCCESS)
             {
                 display_success("Temporary voted list cleared (header preserved).");
@@ -445,9 +485,10 @@ void handle_data_viewing(void)
     printf("Select viewing option:\n\n");
     printf(YELLOW "1." RESET " 📋 View All Data Files Summary\n");
     printf(YELLOW "2." RESET " 🔍 Browse Specific File\n");
+    printf(YELLOW "3." RESET " 🗂️  Manage Lookup Indexes\n");
     printf(YELLOW "0." RESET " ⬅️  Back to Main Menu\n\n");
 
-    int choice = get_user_choice("Enter your choice", 0, 2);
+    int choice = get_user_choice("Enter your choice", 0, 3);
 
     switch (choice)
     {
@@ -457,6 +498,9 @@ void handle_data_viewing(void)
     case 2:
         display_file_list();
         break;
+    case 3:
+        manage_lookup_indexes();
+        break;
     case 0:
         break;
     default:
@@ -488,6 +532,137 @@ void view_all_data_files(void)
     pause_for_user();
 }
 
+/**
+ * Print every index file present for the known data files
+ * @return Number of indexes listed
+ */
+static int list_lookup_indexes(void)
+{
+    int listed = 0;
+    printf("%-32s %-6s %s\n", "Data File", "Field", "State");
+    printf("─────────────────────────────────────────────────────────\n");
+    for (int i = 0; data_files[i].filename != NULL; i++)
+    {
+        for (int field = 0; field < MAX_FIELDS; field++)
+        {
+            if (!record_index_exists(data_files[i].filename, field))
+                continue;
+            record_index_t ri;
+            int fresh = record_index_open(&ri, data_files[i].filename, field) == DATA_SUCCESS;
+            record_index_close(&ri);
+            printf("%-32s %-6d %s\n", data_files[i].filename, field,
+                   fresh ? GREEN "fresh" RESET : YELLOW "stale (rebuild)" RESET);
+            listed++;
+        }
+    }
+    if (listed == 0)
+        printf("(no lookup indexes)\n");
+    return listed;
+}
+
+/**
+ * Pick a data file and column for create/drop
+ * @return Index into data_files, or -1 if cancelled
+ */
+static int choose_index_target(int *field)
+{
+    int total = 0;
+    printf("\n");
+    for (int i = 0; data_files[i].filename != NULL; i++)
+    {
+        printf(YELLOW "%d." RESET " %s (%s)\n", i + 1, data_files[i].description, data_files[i].header);
+        total++;
+    }
+    printf(YELLOW "0." RESET " ⬅️  Back\n\n");
+
+    int choice = get_user_choice("Enter file number", 0, total);
+    if (choice <= 0)
+        return -1;
+    *field = get_user_choice("Column number (0 = first column)", 0, MAX_FIELDS - 1);
+    return choice - 1;
+}
+
+void manage_lookup_indexes(void)
+{
+    int choice;
+    do
+    {
+        clear_screen();
+        printf(BOLD BLUE "🗂️  Lookup Indexes\n" RESET);
+        printf("══════════════════\n\n");
+        list_lookup_indexes();
+
+        printf("\n");
+        printf(YELLOW "1." RESET " 🔄 Rebuild Lookup Indexes\n");
+        printf(YELLOW "2." RESET " ➕ Create Index on a Column\n");
+        printf(YELLOW "3." RESET " ➖ Drop Index\n");
+        printf(YELLOW "0." RESET " ⬅️  Back\n\n");
+
+        choice = get_user_choice("Enter your choice", 0, 3);
+        int field = 0;
+        int target;
+        switch (choice)
+        {
+        case 1:
+            rebuild_lookup_indexes();
+            break;
+        case 2:
+            target = choose_index_target(&field);
+            if (target < 0)
+                break;
+            if (create_index(data_files[target].filename, field) == DATA_SUCCESS)
+                display_success("Index created.");
+            else
+                display_error(get_last_error());
+            pause_for_user();
+            break;
+        case 3:
+            target = choose_index_target(&field);
+            if (target < 0)
+                break;
+            if (drop_index(data_files[target].filename, field) == DATA_SUCCESS)
+                display_success("Index dropped.");
+            else
+                display_error(get_last_error());
+            pause_for_user();
+            break;
+        default:
+            break;
+        }
+    } while (choice != 0);
+}
+
+void rebuild_lookup_indexes(void)
+{
+    clear_screen();
+    printf(BOLD BLUE "🗂️  Rebuild Lookup Indexes\n" RESET);
+    printf("═══════════════════════════\n\n");
+
+    // Every existing index plus the standard ones, even if not created yet
+    for (int i = 0; data_files[i].filename != NULL; i++)
+    {
+        for (int field = 0; field < MAX_FIELDS; field++)
+        {
+            int wanted = record_index_exists(data_files[i].filename, field);
+            for (int d = 0; !wanted && lookup_indexes[d].filename != NULL; d++)
+                wanted = strcmp(lookup_indexes[d].filename, data_files[i].filename) == 0 &&
+                         lookup_indexes[d].field == field;
+            if (!wanted)
+                continue;
+
+            char path[MAX_LINE_LENGTH];
+            record_index_path(data_files[i].filename, field, path, sizeof(path));
+            if (create_index(data_files[i].filename, field) == DATA_SUCCESS)
+                printf(GREEN "✓" RESET " %s\n", path);
+            else
+                printf(RED "✗" RESET " %s: %s\n", path, get_last_error());
+        }
+    }
+
+    printf("\n");
+    pause_for_user();
+}
+
 void display_file_list(void)
 {
     clear_screen();
@@ -635,6 +810,10 @@ void display_current_limits(void)
     printf("│ " YELLOW "Maximum Districts:" RESET "           %-8d │\n", sys_config.max_districts);
     printf("│ " YELLOW "Voting System:" RESET "               %-8s │\n",
            sys_config.voting_enabled ? GREEN "ENABLED" RESET : RED "DISABLED" RESET);
+    printf("│ " YELLOW "Tally Threads (0=auto):" RESET "      %-8d │\n", sys_config.tally_threads);
+    printf("│ " YELLOW "Journal Sync (ms, -1=off):" RESET "   %-8d │\n", sys_config.journal_sync_ms);
+    printf("│ " YELLOW "Ballot by District:" RESET "          %-8s │\n",
+           sys_config.ballot_district_filter ? GREEN "ON" RESET : "OFF");
     printf("╰─────────────────────────────────────────╯\n");
 }
 
@@ -656,9 +835,13 @@ void modify_system_limits(void)
     printf(YELLOW "6." RESET " Maximum Districts (current: %d)\n", sys_config.max_districts);
     printf(YELLOW "7." RESET " Voting System Status (current: %s)\n",
            sys_config.voting_enabled ? "ENABLED" : "DISABLED");
+    printf(YELLOW "8." RESET " Tally Threads (current: %d, 0=auto)\n", sys_config.tally_threads);
+    printf(YELLOW "9." RESET " Vote Journal Sync (current: %d ms, -1=no sync, 0=every vote)\n", sys_config.journal_sync_ms);
+    printf(YELLOW "10." RESET " Ballot by Voter's District (current: %s)\n",
+           sys_config.ballot_district_filter ? "ON" : "OFF");
     printf(YELLOW "0." RESET " ⬅️  Back\n\n");
 
-    int choice = get_user_choice("Enter parameter number", 0, 7);
+    int choice = get_user_choice("Enter parameter number", 0, 10);
     int new_value;
 
     switch (choice)
@@ -698,6 +881,21 @@ void modify_system_limits(void)
         sys_config.voting_enabled = new_value;
         display_success(new_value ? "Voting enabled!" : "Voting disabled!");
         break;
+    case 8:
+        new_value = get_user_choice("Enter tally worker threads (0=auto, 1-64)", 0, 64);
+        sys_config.tally_threads = new_value;
+        display_success("Tally threads updated!");
+        break;
+    case 9:
+        new_value = get_user_choice("Enter journal sync (-1=no sync, 0=every vote, 1-10000=group commit ms)", -1, 10000);
+        sys_config.journal_sync_ms = new_value;
+        display_success("Vote journal sync policy updated!");
+        break;
+    case 10:
+        new_value = get_user_choice("Show voters only their district's candidates? (1=Yes, 0=No)", 0, 1);
+        sys_config.ballot_district_filter = new_value;
+        display_success(new_value ? "District ballots enabled!" : "District ballots disabled!");
+        break;
     case 0:
         return;
     default:
@@ -753,6 +951,18 @@ void load_system_config(void)
         {
             sys_config.voting_enabled = atoi(line + 15);
         }
+        else if (strncmp(line, "tally_threads=", 14) == 0)
+        {
+            sys_config.tally_threads = atoi(line + 14);
+        }
+        else if (strncmp(line, "journal_sync_ms=", 16) == 0)
+        {
+            sys_config.journal_sync_ms = atoi(line + 16);
+        }
+        else if (strncmp(line, "ballot_district_filter=", 23) == 0)
+        {
+            sys_config.ballot_district_filter = atoi(line + 23);
+        }
     }
 
     fclose(fp);
@@ -776,6 +986,9 @@ void save_system_config(void)
     fprintf(fp, "max_parties=%d\n", sys_config.max_parties);
     fprintf(fp, "max_districts=%d\n", sys_config.max_districts);
     fprintf(fp, "voting_enabled=%d\n", sys_config.voting_enabled);
+    fprintf(fp, "tally_threads=%d\n", sys_config.tally_threads);
+    fprintf(fp, "journal_sync_ms=%d\n", sys_config.journal_sync_ms);
+    fprintf(fp, "ballot_district_filter=%d\n", sys_config.ballot_district_filter);
 
     fclose(fp);
 }
@@ -789,6 +1002,9 @@ void reset_to_defaults(void)
     sys_config.max_parties = 50;
     sys_config.max_districts = 25;
     sys_config.voting_enabled = 1;
+    sys_config.tally_threads = 0;
+    sys_config.journal_sync_ms = VOTE_JOURNAL_SYNC_EVERY_VOTE;
+    sys_config.ballot_district_filter = 0;
 }
 
 // =====================================================
@@ -1145,9 +1361,10 @@ void update_entity_menu(void)
     printf(YELLOW "2." RESET " 🏛️  Update Candidate\n");
     printf(YELLOW "3." RESET " 🎭 Update Party\n");
     printf(YELLOW "4." RESET " 🏘️  Update District\n");
+    printf(YELLOW "5." RESET " 📋 Bulk Candidate Corrections\n");
     printf(YELLOW "0." RESET " ⬅️  Back\n\n");
 
-    int choice = get_user_choice("Enter your choice", 0, 4);
+    int choice = get_user_choice("Enter your choice", 0, 5);
 
     switch (choice)
     {
@@ -1163,6 +1380,9 @@ void update_entity_menu(void)
     case 4:
         update_district_interactive();
         break;
+    case 5:
+        bulk_update_candidates_interactive();
+        break;
     case 0:
         break;
     default:
@@ -1286,6 +1506,105 @@ void update_candidate_interactive(void)
     pause_for_user();
 }
 
+// Corrections entered per bulk session
+#define BULK_CORRECTION_LIMIT 50
+
+void bulk_update_candidates_interactive(void)
+{
+    clear_screen();
+    printf(BOLD YELLOW "📋 Bulk Candidate Corrections\n" RESET);
+    printf("═════════════════════════════\n\n");
+    printf("Enter corrections one at a time; leave the candidate number empty to finish.\n");
+    printf("All corrections are applied together in a single pass over the file.\n\n");
+    printf("Fields: " YELLOW "1" RESET " Name  " YELLOW "2" RESET " Party ID  "
+           YELLOW "3" RESET " District ID  " YELLOW "4" RESET " NIC Number\n\n");
+
+    static char keys[BULK_CORRECTION_LIMIT][MAX_LINE_LENGTH];
+    static char sets[BULK_CORRECTION_LIMIT][MAX_LINE_LENGTH];
+    char *key_ptrs[BULK_CORRECTION_LIMIT];
+    const char *set_ptrs[BULK_CORRECTION_LIMIT];
+    record_update_t ops[BULK_CORRECTION_LIMIT];
+    int count = 0;
+
+    while (count < BULK_CORRECTION_LIMIT)
+    {
+        char candidate_number[100];
+        printf("\n" CYAN "Correction %d\n" RESET, count + 1);
+        get_user_input("Candidate Number (empty to finish)", candidate_number, sizeof(candidate_number));
+        if (candidate_number[0] == '\0')
+            break;
+
+        int field_choice = get_user_choice("Field number (0 = skip)", 0, 4);
+        if (field_choice == 0)
+            continue;
+
+        char new_value[100];
+        get_user_input("New value", new_value, sizeof(new_value));
+        if (new_value[0] == '\0' || strchr(new_value, ',') || strchr(new_value, ':'))
+        {
+            display_error("Value must be non-empty and contain no ',' or ':'; correction skipped.");
+            continue;
+        }
+
+        snprintf(keys[count], sizeof(keys[count]), "0:%s", candidate_number);
+        snprintf(sets[count], sizeof(sets[count]), "%d:%s", field_choice, new_value);
+        key_ptrs[count] = keys[count];
+        set_ptrs[count] = sets[count];
+        ops[count].primary_keys = &key_ptrs[count];
+        ops[count].num_keys = 1;
+        ops[count].assignments = &set_ptrs[count];
+        ops[count].num_assignments = 1;
+        ops[count].status = 0;
+        count++;
+    }
+
+    if (count == 0)
+    {
+        display_info("No corrections entered.");
+        pause_for_user();
+        return;
+    }
+
+    printf("\n%d correction(s) queued.\n", count);
+    if (!get_user_choice("Apply all? (1=Yes, 0=No)", 0, 1))
+    {
+        display_info("Bulk update cancelled.");
+        pause_for_user();
+        return;
+    }
+
+    int result = update_records_bulk("data/approved_candidates.txt", ops, count);
+    if (result == DATA_SUCCESS || result == DATA_ERROR_RECORD_NOT_FOUND)
+    {
+        int applied = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (ops[i].status == DATA_SUCCESS)
+                applied++;
+            else
+                printf(YELLOW "  %s: candidate not found\n" RESET, keys[i] + 2);
+        }
+        printf("\n");
+        if (applied > 0)
+        {
+            char msg[128];
+            snprintf(msg, sizeof(msg), "%d of %d correction(s) applied.", applied, count);
+            display_success(msg);
+        }
+        else
+        {
+            display_error("None of the candidates were found; nothing changed.");
+        }
+    }
+    else
+    {
+        display_error("Bulk update failed; no changes were made!");
+        printf(RED "Error: %s\n" RESET, get_last_error());
+    }
+
+    pause_for_user();
+}
+
 void update_party_interactive(void)
 {
     clear_screen();
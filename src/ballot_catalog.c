@@ -0,0 +1,338 @@
+/*
+ * VoteMe Ballot Catalog Implementation
+ */
+
+// strdup needs POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#include "ballot_catalog.h"
+#include "data_handler_enhanced.h"
+
+#define BALLOT_ID_MAX 64
+
+/* ==== Interning ==== */
+
+// FNV-1a, same family as the tally index
+static size_t hash_name(const char *s)
+{
+    uint32_t h = 2166136261u;
+    for (; *s; s++)
+    {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int intern_find(const ballot_intern_t *in, const char *name)
+{
+    if (!in->slots)
+        return -1;
+    for (size_t i = hash_name(name) & in->mask; in->slots[i] >= 0; i = (i + 1) & in->mask)
+    {
+        if (strcmp(in->names[in->slots[i]], name) == 0)
+            return in->slots[i];
+    }
+    return -1;
+}
+
+// Index of name, added if new; -1 on allocation failure
+static int intern_add(ballot_intern_t *in, const char *name)
+{
+    int found = intern_find(in, name);
+    if (found >= 0)
+        return found;
+
+    if (in->count == in->capacity)
+    {
+        int cap = in->capacity ? in->capacity * 2 : 32;
+        char **grown = realloc(in->names, (size_t)cap * sizeof(*grown));
+        if (!grown)
+            return -1;
+        in->names = grown;
+        in->capacity = cap;
+    }
+    if (!in->slots || (size_t)(in->count + 1) * 2 > in->mask + 1)
+    {
+        size_t size = in->slots ? (in->mask + 1) * 2 : 64;
+        int *slots = malloc(size * sizeof(*slots));
+        if (!slots)
+            return -1;
+        for (size_t i = 0; i < size; i++)
+            slots[i] = -1;
+        for (int k = 0; k < in->count; k++)
+        {
+            size_t i = hash_name(in->names[k]) & (size - 1);
+            while (slots[i] >= 0)
+                i = (i + 1) & (size - 1);
+            slots[i] = k;
+        }
+        free(in->slots);
+        in->slots = slots;
+        in->mask = size - 1;
+    }
+
+    char *copy = strdup(name);
+    if (!copy)
+        return -1;
+    size_t i = hash_name(name) & in->mask;
+    while (in->slots[i] >= 0)
+        i = (i + 1) & in->mask;
+    in->names[in->count] = copy;
+    in->slots[i] = in->count;
+    return in->count++;
+}
+
+static void intern_free(ballot_intern_t *in)
+{
+    for (int i = 0; i < in->count; i++)
+        free(in->names[i]);
+    free(in->names);
+    free(in->slots);
+    memset(in, 0, sizeof(*in));
+}
+
+/* ==== Loading ==== */
+
+// Normalize party id by uppercasing and removing leading zeros after 'P'
+static void normalize_party_id(const char *in, size_t len, char *out, size_t outsz)
+{
+    while (len > 0 && isspace((unsigned char)*in))
+    {
+        in++;
+        len--;
+    }
+    while (len > 0 && isspace((unsigned char)in[len - 1]))
+        len--;
+
+    size_t n = 0;
+    size_t i = 0;
+    if (len > 0 && toupper((unsigned char)in[0]) == 'P')
+    {
+        out[n++] = 'P';
+        for (i = 1; i < len && in[i] == '0'; i++)
+            ;
+        if (i == len && n < outsz - 1)
+            out[n++] = '0'; // all zeros or empty -> P0
+    }
+    for (; i < len && n < outsz - 1; i++)
+        out[n++] = (char)toupper((unsigned char)in[i]);
+    out[n] = '\0';
+}
+
+// A candidate row before grouping
+typedef struct
+{
+    int party;
+    int district;
+    int seq;                 // file order
+    const char *id;
+    const char *name;
+} staged_candidate_t;
+
+// Party, then file order
+static int compare_by_party(const void *a, const void *b)
+{
+    const staged_candidate_t *x = a, *y = b;
+    if (x->party != y->party)
+        return x->party < y->party ? -1 : 1;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+// Party, then district, then file order
+static int compare_by_district(const void *a, const void *b)
+{
+    const staged_candidate_t *x = a, *y = b;
+    if (x->party != y->party)
+        return x->party < y->party ? -1 : 1;
+    if (x->district != y->district)
+        return x->district < y->district ? -1 : 1;
+    return (x->seq > y->seq) - (x->seq < y->seq);
+}
+
+static int load_parties(ballot_catalog_t *cat)
+{
+    const catalog_snapshot_t *cs = &cat->snapshot;
+    if (cs->party_count > 0)
+    {
+        cat->parties = malloc((size_t)cs->party_count * sizeof(*cat->parties));
+        if (!cat->parties)
+            return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    for (int i = 0; i < cs->party_count; i++)
+    {
+        const char *id = catalog_str(cs, cs->parties[i].id);
+        char key[BALLOT_ID_MAX];
+        normalize_party_id(id, strlen(id), key, sizeof(key));
+        if (intern_find(&cat->party_keys, key) >= 0)
+            continue; // first spelling of a party wins
+
+        ballot_party_t *p = &cat->parties[cat->party_count];
+        memset(p, 0, sizeof(*p));
+        p->id = id;
+        p->name = catalog_str(cs, cs->parties[i].name);
+        if (intern_add(&cat->party_keys, key) != cat->party_count)
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        cat->party_count++;
+    }
+    return DATA_SUCCESS;
+}
+
+static int load_candidates(ballot_catalog_t *cat)
+{
+    const catalog_snapshot_t *cs = &cat->snapshot;
+    staged_candidate_t *staged = malloc((size_t)(cs->candidate_count > 0 ? cs->candidate_count : 1) * sizeof(*staged));
+    if (!staged)
+        return DATA_ERROR_MEMORY_ALLOCATION;
+
+    int count = 0;
+    for (int i = 0; i < cs->candidate_count; i++)
+    {
+        // Rows of parties not on the ballot fall out here
+        const catalog_candidate_t *row = &cs->candidates[i];
+        const char *party_id = catalog_str(cs, row->party_id);
+        char key[BALLOT_ID_MAX];
+        normalize_party_id(party_id, strlen(party_id), key, sizeof(key));
+        int party = intern_find(&cat->party_keys, key);
+        if (party < 0)
+            continue;
+
+        staged_candidate_t *c = &staged[count];
+        c->party = party;
+        c->district = BALLOT_NO_DISTRICT;
+        c->seq = count;
+        c->id = catalog_str(cs, row->number);
+        c->name = catalog_str(cs, row->name);
+        const char *district = catalog_str(cs, row->district_id);
+        if (district[0])
+        {
+            c->district = intern_add(&cat->districts, district);
+            if (c->district == -1)
+            {
+                free(staged);
+                return DATA_ERROR_MEMORY_ALLOCATION;
+            }
+        }
+        count++;
+    }
+
+    if (count > 0)
+    {
+        cat->candidates = malloc((size_t)count * sizeof(*cat->candidates));
+        cat->by_district = malloc((size_t)count * sizeof(*cat->by_district));
+        if (!cat->candidates || !cat->by_district)
+        {
+            free(staged);
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+
+    // Group by party; each party's range follows from the order and is the
+    // same in both arrays, which differ only in the order inside a party
+    if (count > 0)
+        qsort(staged, (size_t)count, sizeof(*staged), compare_by_party);
+    for (int i = 0; i < count; i++)
+    {
+        ballot_party_t *p = &cat->parties[staged[i].party];
+        if (p->count++ == 0)
+            p->first = i;
+        cat->candidates[i].id = staged[i].id;
+        cat->candidates[i].name = staged[i].name;
+        cat->candidates[i].district = staged[i].district;
+    }
+    if (count > 0)
+        qsort(staged, (size_t)count, sizeof(*staged), compare_by_district);
+    for (int i = 0; i < count; i++)
+    {
+        cat->by_district[i].id = staged[i].id;
+        cat->by_district[i].name = staged[i].name;
+        cat->by_district[i].district = staged[i].district;
+    }
+    cat->candidate_count = count;
+    free(staged);
+    return DATA_SUCCESS;
+}
+
+/* ==== Public API ==== */
+
+int ballot_catalog_load(ballot_catalog_t *cat, const char *snapshot_path)
+{
+    memset(cat, 0, sizeof(*cat));
+    int rc = catalog_snapshot_open(&cat->snapshot, snapshot_path);
+    if (rc == DATA_SUCCESS)
+        rc = load_parties(cat);
+    if (rc == DATA_SUCCESS)
+        rc = load_candidates(cat);
+    if (rc != DATA_SUCCESS)
+    {
+        if (rc == DATA_ERROR_MEMORY_ALLOCATION)
+            set_error_message("Error: Memory allocation failed while loading the ballot");
+        ballot_catalog_free(cat);
+    }
+    return rc;
+}
+
+void ballot_catalog_free(ballot_catalog_t *cat)
+{
+    free(cat->parties);
+    free(cat->candidates);
+    free(cat->by_district);
+    intern_free(&cat->party_keys);
+    intern_free(&cat->districts);
+    catalog_snapshot_close(&cat->snapshot);
+    memset(cat, 0, sizeof(*cat));
+}
+
+int ballot_catalog_find_party(const ballot_catalog_t *cat, const char *party_id)
+{
+    char key[BALLOT_ID_MAX];
+    if (!party_id)
+        return -1;
+    normalize_party_id(party_id, strlen(party_id), key, sizeof(key));
+    return intern_find(&cat->party_keys, key);
+}
+
+int ballot_catalog_district(const ballot_catalog_t *cat, const char *district_id)
+{
+    int d = district_id ? intern_find(&cat->districts, district_id) : -1;
+    return d >= 0 ? d : BALLOT_NO_DISTRICT;
+}
+
+int ballot_catalog_candidates(const ballot_catalog_t *cat, int party, int district,
+                              const ballot_candidate_t **first)
+{
+    *first = NULL;
+    if (party < 0 || party >= cat->party_count || cat->parties[party].count == 0 || district == BALLOT_NO_DISTRICT)
+        return 0;
+    const ballot_party_t *p = &cat->parties[party];
+    int lo = p->first, hi = p->first + p->count;
+    if (district == BALLOT_ANY_DISTRICT)
+    {
+        *first = &cat->candidates[lo];
+        return hi - lo;
+    }
+
+    // The party's range of by_district is sorted by district: find its sub-range
+    int a = lo, b = hi;
+    while (a < b)
+    {
+        int mid = a + (b - a) / 2;
+        if (cat->by_district[mid].district < district)
+            a = mid + 1;
+        else
+            b = mid;
+    }
+    for (b = a; b < hi && cat->by_district[b].district == district; b++)
+        ;
+    if (b > a)
+        *first = &cat->by_district[a];
+    return b - a;
+}
@@ -0,0 +1,103 @@
+/*
+ * VoteMe Ballot Catalog Header
+ *
+ * In-memory (party, district) -> candidates index for the voting booth,
+ * built once per session from the catalog snapshot (data/catalog.bin) so
+ * building a ballot between voters does no file I/O. Ids and names point
+ * into the snapshot, which stays open for the life of the catalog.
+ *
+ * Party ids are normalized once at load time (upper-cased, leading zeros of
+ * "P<digits>" dropped, so "p03" and "P3" are the same party) and interned in
+ * a hash table. Candidates are stored grouped by party in file order, and a
+ * second time grouped by party and then district: a party's ballot, or its
+ * ballot for one district, is a contiguous range.
+ */
+
+#ifndef BALLOT_CATALOG_H
+#define BALLOT_CATALOG_H
+
+#include <stddef.h>
+#include "catalog_snapshot.h"
+
+// 1 = voters only see candidates standing in their own district_id
+#define BALLOT_DISTRICT_FILTER_CONFIG_KEY "ballot_district_filter"
+
+// District argument meaning "every district"
+#define BALLOT_ANY_DISTRICT -1
+// District index for a district_id no candidate stands in
+#define BALLOT_NO_DISTRICT -2
+
+typedef struct
+{
+    const char *id;          // candidate_number
+    const char *name;
+    int district;            // interned district index, BALLOT_NO_DISTRICT when missing
+} ballot_candidate_t;
+
+typedef struct
+{
+    const char *id;          // party_id as written in data/party_name.txt
+    const char *name;
+    int first;               // range of the party's candidates
+    int count;
+} ballot_party_t;
+
+// String -> index hash table over interned names
+typedef struct
+{
+    char **names;
+    int count;
+    int capacity;
+    int *slots;              // -1 when empty
+    size_t mask;             // slot count - 1, 0 when empty
+} ballot_intern_t;
+
+typedef struct
+{
+    ballot_party_t *parties; // data/party_name.txt order
+    int party_count;
+    ballot_candidate_t *candidates;  // grouped by party, file order within a party
+    ballot_candidate_t *by_district; // same rows grouped by party, then district
+    int candidate_count;
+    ballot_intern_t party_keys; // normalized party id -> party index
+    ballot_intern_t districts;  // district_id -> district index
+    catalog_snapshot_t snapshot; // owns every id and name string
+} ballot_catalog_t;
+
+/**
+ * Load the catalog from the snapshot, compiling it first when stale
+ * Parties without a name in data/party_name.txt are not on the ballot, as
+ * before. Missing files give an empty catalog.
+ * @param snapshot_path Snapshot file (CATALOG_SNAPSHOT_FILE)
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int ballot_catalog_load(ballot_catalog_t *cat, const char *snapshot_path);
+
+/**
+ * Release everything the catalog owns (safe on a zeroed catalog)
+ */
+void ballot_catalog_free(ballot_catalog_t *cat);
+
+/**
+ * Find a party by id, in any spelling that normalizes to the same id
+ * @return Party index, or -1 if unknown
+ */
+int ballot_catalog_find_party(const ballot_catalog_t *cat, const char *party_id);
+
+/**
+ * Resolve a district_id for filtering
+ * @return District index, or BALLOT_NO_DISTRICT when no candidate stands there
+ */
+int ballot_catalog_district(const ballot_catalog_t *cat, const char *district_id);
+
+/**
+ * A party's candidates, optionally only those of one district
+ * @param party Party index
+ * @param district District index, or BALLOT_ANY_DISTRICT
+ * @param first Output: first candidate of the range
+ * @return Number of candidates in the range
+ */
+int ballot_catalog_candidates(const ballot_catalog_t *cat, int party, int district,
+                              const ballot_candidate_t **first);
+
+#endif // BALLOT_CATALOG_H
@@ -0,0 +1,719 @@
+/*
+ * VoteMe Catalog Snapshot Implementation
+ *
+ * Compiles the catalog CSVs into one flat image (header, row arrays, hash
+ * slots, string table) that is written with temp file + rename and mapped
+ * read-only. Opening validates every offset, so a damaged file is simply
+ * recompiled instead of trusted.
+ */
+
+// mmap/st_mtim/getpid need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#define CATALOG_HAVE_MMAP 1
+#endif
+
+#include "catalog_snapshot.h"
+#include "data_handler_enhanced.h"
+#include "vote_source.h"
+
+#define CATALOG_MAGIC "VMCATLG"
+#define CATALOG_VERSION 1
+#define CATALOG_SOURCES 3
+#define CATALOG_MIN_SLOTS 16
+#define CATALOG_EMPTY_SLOT UINT32_MAX
+// Rows per section; keeps every size computation far from overflow
+#define CATALOG_MAX_ROWS (1 << 28)
+
+typedef struct
+{
+    uint64_t size;           // source fingerprint when compiled
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint64_t ino;
+    uint32_t present;        // 0 when the source did not exist
+    uint32_t reserved;
+} snapshot_source_t;
+
+// Sections follow the header in this order: parties, districts,
+// candidates, party slots, district slots, candidate slots, strings
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t file_size;
+    snapshot_source_t sources[CATALOG_SOURCES];
+    uint32_t party_count;
+    uint32_t district_count;
+    uint32_t candidate_count;
+    uint32_t party_slots;
+    uint32_t district_slots;
+    uint32_t candidate_slots;
+    uint64_t strings_size;
+} snapshot_header_t;
+
+static const char *const source_paths[CATALOG_SOURCES] = {
+    CATALOG_PARTIES_FILE,
+    CATALOG_DISTRICTS_FILE,
+    CATALOG_CANDIDATES_FILE,
+};
+
+/* ==== Fingerprints ==== */
+
+static long long mtime_nsec(const struct stat *st)
+{
+#if defined(_WIN32)
+    (void)st;
+    return 0;
+#else
+    return (long long)st->st_mtim.tv_nsec;
+#endif
+}
+
+static void source_stat(int i, snapshot_source_t *out)
+{
+    struct stat st;
+    memset(out, 0, sizeof(*out));
+    if (stat(source_paths[i], &st) != 0)
+        return;
+    out->size = (uint64_t)st.st_size;
+    out->mtime_sec = (int64_t)st.st_mtime;
+    out->mtime_nsec = (int64_t)mtime_nsec(&st);
+    out->ino = (uint64_t)st.st_ino;
+    out->present = 1;
+}
+
+static int sources_match(const snapshot_header_t *h)
+{
+    for (int i = 0; i < CATALOG_SOURCES; i++)
+    {
+        snapshot_source_t now;
+        source_stat(i, &now);
+        const snapshot_source_t *then = &h->sources[i];
+        if (now.present != then->present)
+            return 0;
+        if (now.present && (now.size != then->size || now.mtime_sec != then->mtime_sec ||
+                            now.mtime_nsec != then->mtime_nsec || now.ino != then->ino))
+            return 0;
+    }
+    return 1;
+}
+
+/* ==== Id tables ==== */
+
+// FNV-1a, same family as the tally index
+static uint32_t hash_id(const char *s)
+{
+    uint32_t h = 2166136261u;
+    for (; *s; s++)
+    {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// The rows behind one set of hash slots
+typedef struct
+{
+    const catalog_entry_t *entries;         // parties or districts
+    const catalog_candidate_t *candidates;  // used when entries is NULL
+    const char *strings;
+    const uint32_t *slots;
+    uint32_t mask;
+} id_table_t;
+
+static const char *table_id(const id_table_t *t, uint32_t row)
+{
+    return t->strings + (t->entries ? t->entries[row].id : t->candidates[row].number);
+}
+
+static int table_find(const id_table_t *t, const char *id)
+{
+    if (!t->slots || !id)
+        return -1;
+    for (uint32_t i = hash_id(id) & t->mask; t->slots[i] != CATALOG_EMPTY_SLOT; i = (i + 1) & t->mask)
+    {
+        if (strcmp(table_id(t, t->slots[i]), id) == 0)
+            return (int)t->slots[i];
+    }
+    return -1;
+}
+
+// Fill slots for rows in file order; a repeated id keeps its first row
+static void table_fill(const id_table_t *t, uint32_t *slots, uint32_t count)
+{
+    for (uint32_t i = 0; i <= t->mask; i++)
+        slots[i] = CATALOG_EMPTY_SLOT;
+    for (uint32_t row = 0; row < count; row++)
+    {
+        const char *id = table_id(t, row);
+        uint32_t i = hash_id(id) & t->mask;
+        while (slots[i] != CATALOG_EMPTY_SLOT && strcmp(table_id(t, slots[i]), id) != 0)
+            i = (i + 1) & t->mask;
+        if (slots[i] == CATALOG_EMPTY_SLOT)
+            slots[i] = row;
+    }
+}
+
+// Slot count for a section: a power of two at least twice the rows
+static uint32_t slot_count(uint32_t rows)
+{
+    uint32_t n = CATALOG_MIN_SLOTS;
+    while (n < rows * 2)
+        n <<= 1;
+    return n;
+}
+
+/* ==== Layout ==== */
+
+typedef struct
+{
+    size_t parties;
+    size_t districts;
+    size_t candidates;
+    size_t party_slots;
+    size_t district_slots;
+    size_t candidate_slots;
+    size_t strings;
+    size_t end;
+} snapshot_layout_t;
+
+static void compute_layout(const snapshot_header_t *h, snapshot_layout_t *l)
+{
+    l->parties = sizeof(snapshot_header_t);
+    l->districts = l->parties + (size_t)h->party_count * sizeof(catalog_entry_t);
+    l->candidates = l->districts + (size_t)h->district_count * sizeof(catalog_entry_t);
+    l->party_slots = l->candidates + (size_t)h->candidate_count * sizeof(catalog_candidate_t);
+    l->district_slots = l->party_slots + (size_t)h->party_slots * sizeof(uint32_t);
+    l->candidate_slots = l->district_slots + (size_t)h->district_slots * sizeof(uint32_t);
+    l->strings = l->candidate_slots + (size_t)h->candidate_slots * sizeof(uint32_t);
+    l->end = l->strings + (size_t)h->strings_size;
+}
+
+static int slots_valid(const uint32_t *slots, uint32_t n, uint32_t rows)
+{
+    // Probing stops at an empty slot, so at least one must exist
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (slots[i] == CATALOG_EMPTY_SLOT)
+            continue;
+        if (slots[i] >= rows)
+            return 0;
+        used++;
+    }
+    return used < n;
+}
+
+static int slot_size_valid(uint32_t slots, uint32_t rows)
+{
+    return slots >= CATALOG_MIN_SLOTS && (slots & (slots - 1)) == 0 && slots > rows;
+}
+
+/**
+ * Point cs at a snapshot image after checking everything in it
+ * @return 1 if the image is well-formed, 0 otherwise
+ */
+static int attach_image(catalog_snapshot_t *cs, const void *base, size_t size)
+{
+    const snapshot_header_t *h = base;
+    if (size < sizeof(*h) || memcmp(h->magic, CATALOG_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != CATALOG_VERSION || h->header_size != sizeof(*h) || h->file_size != size ||
+        h->party_count > CATALOG_MAX_ROWS || h->district_count > CATALOG_MAX_ROWS ||
+        h->candidate_count > CATALOG_MAX_ROWS || h->strings_size == 0 || h->strings_size > size ||
+        !slot_size_valid(h->party_slots, h->party_count) ||
+        !slot_size_valid(h->district_slots, h->district_count) ||
+        !slot_size_valid(h->candidate_slots, h->candidate_count))
+        return 0;
+    snapshot_layout_t l;
+    compute_layout(h, &l);
+    if (l.end != size)
+        return 0;
+
+    const char *b = base;
+    const catalog_entry_t *parties = (const catalog_entry_t *)(b + l.parties);
+    const catalog_entry_t *districts = (const catalog_entry_t *)(b + l.districts);
+    const catalog_candidate_t *candidates = (const catalog_candidate_t *)(b + l.candidates);
+    const char *strings = b + l.strings;
+    uint64_t ssize = h->strings_size;
+
+    // Every offset must land inside a table that starts and ends with NUL
+    if (strings[0] != '\0' || strings[ssize - 1] != '\0')
+        return 0;
+    for (uint32_t i = 0; i < h->party_count; i++)
+        if (parties[i].id >= ssize || parties[i].name >= ssize)
+            return 0;
+    for (uint32_t i = 0; i < h->district_count; i++)
+        if (districts[i].id >= ssize || districts[i].name >= ssize)
+            return 0;
+    for (uint32_t i = 0; i < h->candidate_count; i++)
+    {
+        const catalog_candidate_t *c = &candidates[i];
+        if (c->number >= ssize || c->name >= ssize || c->party_id >= ssize || c->district_id >= ssize ||
+            c->party < -1 || c->party >= (int32_t)h->party_count ||
+            c->district < -1 || c->district >= (int32_t)h->district_count)
+            return 0;
+    }
+    const uint32_t *party_slots = (const uint32_t *)(b + l.party_slots);
+    const uint32_t *district_slots = (const uint32_t *)(b + l.district_slots);
+    const uint32_t *candidate_slots = (const uint32_t *)(b + l.candidate_slots);
+    if (!slots_valid(party_slots, h->party_slots, h->party_count) ||
+        !slots_valid(district_slots, h->district_slots, h->district_count) ||
+        !slots_valid(candidate_slots, h->candidate_slots, h->candidate_count))
+        return 0;
+
+    cs->base = base;
+    cs->size = size;
+    cs->parties = parties;
+    cs->party_count = (int)h->party_count;
+    cs->districts = districts;
+    cs->district_count = (int)h->district_count;
+    cs->candidates = candidates;
+    cs->candidate_count = (int)h->candidate_count;
+    cs->strings = strings;
+    cs->party_slots = party_slots;
+    cs->district_slots = district_slots;
+    cs->candidate_slots = candidate_slots;
+    cs->party_mask = h->party_slots - 1;
+    cs->district_mask = h->district_slots - 1;
+    cs->candidate_mask = h->candidate_slots - 1;
+    return 1;
+}
+
+/* ==== Compiling ==== */
+
+typedef struct
+{
+    char *strings;
+    size_t strings_len;
+    size_t strings_cap;
+    catalog_entry_t *parties;
+    int party_count;
+    int party_cap;
+    catalog_entry_t *districts;
+    int district_count;
+    int district_cap;
+    catalog_candidate_t *candidates;
+    int candidate_count;
+    int candidate_cap;
+} builder_t;
+
+// Room for one more element; returns the (possibly moved) array or NULL
+static void *grow_rows(void *rows, int count, int *cap, size_t elem_size)
+{
+    if (count < *cap)
+        return rows;
+    if (count >= CATALOG_MAX_ROWS)
+        return NULL;
+    int n = *cap ? *cap * 2 : 64;
+    void *grown = realloc(rows, (size_t)n * elem_size);
+    if (grown)
+        *cap = n;
+    return grown;
+}
+
+/**
+ * Append a field (unescaped) to the string table
+ * @return 1 on success, 0 on allocation failure or overflow
+ */
+static int put_string(builder_t *b, const csv_span_t *span, uint32_t *offset)
+{
+    if (!span || span->len == 0)
+    {
+        *offset = 0; // the table starts with ""
+        return 1;
+    }
+    size_t need = b->strings_len + span->len + 1;
+    if (need > UINT32_MAX)
+        return 0;
+    if (need > b->strings_cap)
+    {
+        size_t cap = b->strings_cap ? b->strings_cap : 4096;
+        while (cap < need)
+            cap *= 2;
+        char *grown = realloc(b->strings, cap);
+        if (!grown)
+            return 0;
+        b->strings = grown;
+        b->strings_cap = cap;
+    }
+    *offset = (uint32_t)b->strings_len;
+    b->strings_len += csv_span_copy(span, b->strings + b->strings_len, span->len + 1) + 1;
+    return 1;
+}
+
+// Open a source and skip its header; 0 when there is nothing to read
+static int open_source(vote_source_t *src, const char *path, int *rc)
+{
+    *rc = DATA_SUCCESS;
+    if (access(path, F_OK) != 0)
+        return 0;
+    *rc = vote_source_open(src, path);
+    if (*rc != DATA_SUCCESS)
+        return 0;
+    vote_field_t header;
+    if (vote_source_next_line(src, &header) != 1)
+    {
+        vote_source_close(src);
+        return 0;
+    }
+    return 1;
+}
+
+// id,name files. An unquoted name that still has commas (written before
+// quoting existed) is taken whole, as the rest of the row.
+static int compile_entries(builder_t *b, const char *path, catalog_entry_t **rows, int *count, int *cap)
+{
+    vote_source_t src;
+    int rc;
+    if (!open_source(&src, path, &rc))
+        return rc;
+
+    vote_field_t fields[MAX_FIELDS];
+    int nf, r;
+    while ((r = vote_source_next(&src, fields, MAX_FIELDS, &nf)) == 1)
+    {
+        if (nf < 2 || fields[0].len == 0)
+            continue;
+        vote_field_t name = fields[1];
+        if (nf > 2 && name.quoting == CSV_SPAN_PLAIN)
+            name.len = (size_t)(fields[nf - 1].ptr + fields[nf - 1].len - name.ptr);
+
+        catalog_entry_t *grown = grow_rows(*rows, *count, cap, sizeof(**rows));
+        if (!grown)
+        {
+            r = DATA_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        *rows = grown;
+        catalog_entry_t *e = &grown[*count];
+        if (!put_string(b, &fields[0], &e->id) || !put_string(b, &name, &e->name))
+        {
+            r = DATA_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        (*count)++;
+    }
+    vote_source_close(&src);
+    return r < 0 ? r : DATA_SUCCESS;
+}
+
+static int compile_candidates(builder_t *b, const char *path)
+{
+    vote_source_t src;
+    int rc;
+    if (!open_source(&src, path, &rc))
+        return rc;
+
+    // columns: candidate_number,name,party_id,district_id,nic
+    vote_field_t fields[4];
+    int nf, r;
+    while ((r = vote_source_next(&src, fields, 4, &nf)) == 1)
+    {
+        if (nf < 1 || fields[0].len == 0)
+            continue;
+        catalog_candidate_t *grown = grow_rows(b->candidates, b->candidate_count, &b->candidate_cap,
+                                               sizeof(*b->candidates));
+        if (!grown)
+        {
+            r = DATA_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        b->candidates = grown;
+        catalog_candidate_t *c = &grown[b->candidate_count];
+        c->party = -1;
+        c->district = -1;
+        if (!put_string(b, &fields[0], &c->number) ||
+            !put_string(b, nf > 1 ? &fields[1] : NULL, &c->name) ||
+            !put_string(b, nf > 2 ? &fields[2] : NULL, &c->party_id) ||
+            !put_string(b, nf > 3 ? &fields[3] : NULL, &c->district_id))
+        {
+            r = DATA_ERROR_MEMORY_ALLOCATION;
+            break;
+        }
+        b->candidate_count++;
+    }
+    vote_source_close(&src);
+    return r < 0 ? r : DATA_SUCCESS;
+}
+
+static void builder_free(builder_t *b)
+{
+    free(b->strings);
+    free(b->parties);
+    free(b->districts);
+    free(b->candidates);
+    memset(b, 0, sizeof(*b));
+}
+
+/**
+ * Compile the CSVs into a heap image
+ * @param out Output image (caller frees)
+ * @param out_size Output image size
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+static int compile_image(void **out, size_t *out_size)
+{
+    snapshot_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CATALOG_MAGIC, sizeof(h.magic));
+    h.version = CATALOG_VERSION;
+    h.header_size = sizeof(h);
+    // Fingerprint before reading: a change made while compiling leaves the snapshot stale
+    for (int i = 0; i < CATALOG_SOURCES; i++)
+        source_stat(i, &h.sources[i]);
+
+    builder_t b;
+    memset(&b, 0, sizeof(b));
+    int rc = DATA_SUCCESS;
+    b.strings = malloc(4096);
+    if (!b.strings)
+        rc = DATA_ERROR_MEMORY_ALLOCATION;
+    else
+    {
+        // The empty string sits at offset 0
+        b.strings[0] = '\0';
+        b.strings_len = 1;
+        b.strings_cap = 4096;
+        rc = compile_entries(&b, source_paths[0], &b.parties, &b.party_count, &b.party_cap);
+    }
+    if (rc == DATA_SUCCESS)
+        rc = compile_entries(&b, source_paths[1], &b.districts, &b.district_count, &b.district_cap);
+    if (rc == DATA_SUCCESS)
+        rc = compile_candidates(&b, source_paths[2]);
+    if (rc != DATA_SUCCESS)
+    {
+        if (rc == DATA_ERROR_MEMORY_ALLOCATION)
+            set_error_message("Error: Memory allocation failed while compiling the catalog");
+        builder_free(&b);
+        return rc;
+    }
+
+    h.party_count = (uint32_t)b.party_count;
+    h.district_count = (uint32_t)b.district_count;
+    h.candidate_count = (uint32_t)b.candidate_count;
+    h.party_slots = slot_count(h.party_count);
+    h.district_slots = slot_count(h.district_count);
+    h.candidate_slots = slot_count(h.candidate_count);
+    h.strings_size = b.strings_len;
+    snapshot_layout_t l;
+    compute_layout(&h, &l);
+    h.file_size = l.end;
+
+    char *image = malloc(l.end);
+    if (!image)
+    {
+        builder_free(&b);
+        set_error_message("Error: Memory allocation failed while compiling the catalog");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    memcpy(image, &h, sizeof(h));
+    if (b.party_count > 0)
+        memcpy(image + l.parties, b.parties, (size_t)b.party_count * sizeof(*b.parties));
+    if (b.district_count > 0)
+        memcpy(image + l.districts, b.districts, (size_t)b.district_count * sizeof(*b.districts));
+    memcpy(image + l.strings, b.strings, b.strings_len);
+
+    id_table_t parties = {b.parties, NULL, b.strings, NULL, h.party_slots - 1};
+    id_table_t districts = {b.districts, NULL, b.strings, NULL, h.district_slots - 1};
+    id_table_t candidates = {NULL, b.candidates, b.strings, NULL, h.candidate_slots - 1};
+    uint32_t *party_slots = (uint32_t *)(image + l.party_slots);
+    uint32_t *district_slots = (uint32_t *)(image + l.district_slots);
+    table_fill(&parties, party_slots, h.party_count);
+    table_fill(&districts, district_slots, h.district_count);
+    table_fill(&candidates, (uint32_t *)(image + l.candidate_slots), h.candidate_count);
+
+    // Resolve each candidate's party and district rows once, here
+    parties.slots = party_slots;
+    districts.slots = district_slots;
+    for (int i = 0; i < b.candidate_count; i++)
+    {
+        catalog_candidate_t *c = &b.candidates[i];
+        if (c->party_id != 0)
+            c->party = table_find(&parties, b.strings + c->party_id);
+        if (c->district_id != 0)
+            c->district = table_find(&districts, b.strings + c->district_id);
+    }
+    if (b.candidate_count > 0)
+        memcpy(image + l.candidates, b.candidates, (size_t)b.candidate_count * sizeof(*b.candidates));
+
+    builder_free(&b);
+    *out = image;
+    *out_size = l.end;
+    return DATA_SUCCESS;
+}
+
+static int write_image(const char *path, const void *image, size_t size)
+{
+    char tmp_path[MAX_LINE_LENGTH + 32];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%ld.tmp", path, (long)getpid());
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp)
+    {
+        set_error_message("Error: Cannot write catalog snapshot '%s': %s", tmp_path, strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+    int ok = fwrite(image, 1, size, fp) == size;
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok || rename(tmp_path, path) != 0)
+    {
+        remove(tmp_path);
+        set_error_message("Error: Failed to write catalog snapshot '%s': %s", path, strerror(errno));
+        return DATA_ERROR_DISK_FULL;
+    }
+    return DATA_SUCCESS;
+}
+
+/* ==== Public API ==== */
+
+int catalog_snapshot_build(const char *path)
+{
+    if (!path)
+    {
+        set_error_message("Error: Invalid parameters for catalog_snapshot_build");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    void *image;
+    size_t size;
+    int rc = compile_image(&image, &size);
+    if (rc == DATA_SUCCESS)
+    {
+        rc = write_image(path, image, size);
+        free(image);
+    }
+    return rc;
+}
+
+// Map (or read) an existing snapshot file; 1 when it is valid and fresh
+static int open_existing(catalog_snapshot_t *cs, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(snapshot_header_t))
+    {
+        close(fd);
+        return 0;
+    }
+    size_t size = (size_t)st.st_size;
+    void *base = NULL;
+#ifdef CATALOG_HAVE_MMAP
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED)
+    {
+        base = map;
+        cs->mapped = 1;
+    }
+#endif
+    if (!base)
+    {
+        // No mmap: read the image instead
+        base = malloc(size);
+        size_t got = 0;
+        while (base && got < size)
+        {
+            ssize_t n = read(fd, (char *)base + got, size - got);
+            if (n <= 0)
+                break;
+            got += (size_t)n;
+        }
+        if (base && got != size)
+        {
+            free(base);
+            base = NULL;
+        }
+    }
+    close(fd);
+    if (!base)
+        return 0;
+
+    if (!attach_image(cs, base, size) || !sources_match(base))
+    {
+        cs->base = base; // released by the caller's close
+        cs->size = size;
+        return 0;
+    }
+    return 1;
+}
+
+int catalog_snapshot_open(catalog_snapshot_t *cs, const char *path)
+{
+    if (!cs || !path)
+    {
+        set_error_message("Error: Invalid parameters for catalog_snapshot_open");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    memset(cs, 0, sizeof(*cs));
+    if (open_existing(cs, path))
+        return DATA_SUCCESS;
+    catalog_snapshot_close(cs);
+
+    // Missing, stale or damaged: recompile, and keep the image we just built
+    void *image;
+    size_t size;
+    int rc = compile_image(&image, &size);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    write_image(path, image, size); // not fatal: the next open compiles again
+    if (!attach_image(cs, image, size))
+    {
+        free(image);
+        set_error_message("Error: Compiled catalog snapshot is inconsistent");
+        return DATA_ERROR_MALFORMED_DATA;
+    }
+    return DATA_SUCCESS;
+}
+
+void catalog_snapshot_close(catalog_snapshot_t *cs)
+{
+    if (!cs)
+        return;
+    if (cs->base)
+    {
+#ifdef CATALOG_HAVE_MMAP
+        if (cs->mapped)
+            munmap((void *)cs->base, cs->size);
+        else
+#endif
+            free((void *)cs->base);
+    }
+    memset(cs, 0, sizeof(*cs));
+}
+
+const char *catalog_str(const catalog_snapshot_t *cs, uint32_t offset)
+{
+    return cs->strings + offset;
+}
+
+int catalog_find_party(const catalog_snapshot_t *cs, const char *party_id)
+{
+    id_table_t t = {cs->parties, NULL, cs->strings, cs->party_slots, cs->party_mask};
+    return table_find(&t, party_id);
+}
+
+int catalog_find_district(const catalog_snapshot_t *cs, const char *district_id)
+{
+    id_table_t t = {cs->districts, NULL, cs->strings, cs->district_slots, cs->district_mask};
+    return table_find(&t, district_id);
+}
+
+int catalog_find_candidate(const catalog_snapshot_t *cs, const char *candidate_number)
+{
+    id_table_t t = {NULL, cs->candidates, cs->strings, cs->candidate_slots, cs->candidate_mask};
+    return table_find(&t, candidate_number);
+}
@@ -0,0 +1,105 @@
+/*
+ * VoteMe Catalog Snapshot Header
+ *
+ * Compiled, mmappable form of the three catalog CSVs (data/party_name.txt,
+ * data/district.txt, data/approved_candidates.txt) in data/catalog.bin, so
+ * the admin, vote and voteme binaries start without re-parsing them and
+ * look ids up without allocating.
+ *
+ * The file holds one string table, the party, district and candidate rows
+ * in file order (strings as offsets into the table), and an open-addressing
+ * hash table per row kind keyed on the exact id. Ids are looked up as
+ * written; when an id appears twice the first row wins, like a scan.
+ *
+ * Like the record indexes, the snapshot records the size/mtime/inode of
+ * each source. Opening it checks them, and a stale or damaged snapshot is
+ * recompiled from the CSVs (temp file + rename) before use.
+ */
+
+#ifndef CATALOG_SNAPSHOT_H
+#define CATALOG_SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CATALOG_SNAPSHOT_FILE "data/catalog.bin"
+#define CATALOG_PARTIES_FILE "data/party_name.txt"
+#define CATALOG_DISTRICTS_FILE "data/district.txt"
+#define CATALOG_CANDIDATES_FILE "data/approved_candidates.txt"
+
+// Row of data/party_name.txt or data/district.txt
+typedef struct
+{
+    uint32_t id;             // string table offsets
+    uint32_t name;
+} catalog_entry_t;
+
+// Row of data/approved_candidates.txt
+typedef struct
+{
+    uint32_t number;         // string table offsets; missing columns are ""
+    uint32_t name;
+    uint32_t party_id;
+    uint32_t district_id;
+    int32_t party;           // row of party_id in the parties, -1 when not listed
+    int32_t district;        // row of district_id in the districts, -1 when not listed
+} catalog_candidate_t;
+
+typedef struct
+{
+    const void *base;        // whole snapshot image
+    size_t size;
+    int mapped;              // 1 when base is a mapping, 0 when heap memory
+
+    const catalog_entry_t *parties;
+    int party_count;
+    const catalog_entry_t *districts;
+    int district_count;
+    const catalog_candidate_t *candidates;
+    int candidate_count;
+    const char *strings;
+
+    const uint32_t *party_slots;     // row per slot, UINT32_MAX when empty
+    const uint32_t *district_slots;
+    const uint32_t *candidate_slots;
+    uint32_t party_mask;             // slot count - 1
+    uint32_t district_mask;
+    uint32_t candidate_mask;
+} catalog_snapshot_t;
+
+/**
+ * Open a fresh snapshot, compiling it from the CSVs first when it is
+ * missing, stale or damaged
+ * If the snapshot cannot be written the compiled image is used from memory.
+ * Missing CSVs give empty sections.
+ * @param path Snapshot file (CATALOG_SNAPSHOT_FILE)
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int catalog_snapshot_open(catalog_snapshot_t *cs, const char *path);
+
+/**
+ * Release the snapshot (safe on a zeroed or closed snapshot)
+ * Every string and row obtained from it becomes invalid.
+ */
+void catalog_snapshot_close(catalog_snapshot_t *cs);
+
+/**
+ * Compile the CSVs into a new snapshot file
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int catalog_snapshot_build(const char *path);
+
+/**
+ * String at a string table offset taken from a row
+ */
+const char *catalog_str(const catalog_snapshot_t *cs, uint32_t offset);
+
+/**
+ * Find a row by its exact id
+ * @return Row index, or -1 if not listed
+ */
+int catalog_find_party(const catalog_snapshot_t *cs, const char *party_id);
+int catalog_find_district(const catalog_snapshot_t *cs, const char *district_id);
+int catalog_find_candidate(const catalog_snapshot_t *cs, const char *candidate_number);
+
+#endif // CATALOG_SNAPSHOT_H
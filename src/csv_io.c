@@ -1,18 +1,33 @@
+// fileno/fsync/mkstemp/fchmod/pread need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#include <immintrin.h>
+#define CSV_SCAN_X86 1
+#endif
 
 #include "csv_io.h"
+#include "record_index.h"
 
 // Local helpers
 int validate_file_access(const char *filename, const char *mode)
 {
     if (!filename)
     {
-        set_error_message("Error: filename cannot be NULL");
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: filename cannot be NULL");
         return 0;
     }
 
@@ -44,14 +59,14 @@ int validate_file_access(const char *filename, const char *mode)
             dir = malloc(len);
             if (!dir)
             {
-                set_error_message("Error: Memory allocation failed for path duplication");
+                set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for path duplication");
                 return 0;
             }
             memcpy(dir, filename, len);
         }
         if (!dir)
         {
-            set_error_message("Error: Memory allocation failed for path duplication");
+            set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for path duplication");
             return 0;
         }
         char *last_slash = strrchr(dir, '/');
@@ -100,88 +115,575 @@ static int validate_string_input(const char *str, const char *param_name, size_t
     return 1;
 }
 
-int read_csv_line(FILE *fp, char *fields[], int max_fields, char delimiter)
+static int is_csv_space(char c)
 {
-    if (!fp || !fields || max_fields <= 0)
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* ==== Structural Character Scanner ==== */
+
+// Structural characters: the delimiter, '\n', '\r' and '"'. x86 builds test
+// 16 (SSE2) or 32 (AVX2, picked at run time) bytes per step; other targets
+// and the last partial block use the byte loop.
+
+static int is_structural(char c, char delimiter)
+{
+    return c == delimiter || c == '\n' || c == '\r' || c == '"';
+}
+
+static size_t scan_structurals_scalar(const char *buf, size_t from, size_t len, char delimiter,
+                                      uint32_t positions[], size_t n)
+{
+    for (size_t i = from; i < len; i++)
+        if (is_structural(buf[i], delimiter))
+            positions[n++] = (uint32_t)i;
+    return n;
+}
+
+static const char *scan_next_scalar(const char *p, const char *end, char delimiter)
+{
+    while (p < end && !is_structural(*p, delimiter))
+        p++;
+    return p;
+}
+
+static size_t count_newlines_scalar(const char *p, const char *end, size_t count)
+{
+    while (p < end && (p = memchr(p, '\n', (size_t)(end - p))) != NULL)
     {
-        set_error_message("Error: Invalid parameters for read_csv_line");
-        return 0;
+        count++;
+        p++;
     }
+    return count;
+}
 
-    char line[MAX_LINE_LENGTH];
-    if (!fgets(line, sizeof(line), fp))
+#ifdef CSV_SCAN_X86
+static unsigned int sse2_structural_mask(const char *p, char delimiter)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(delimiter)),
+                                          _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                                          _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))));
+    return (unsigned int)_mm_movemask_epi8(m);
+}
+
+__attribute__((target("avx2"))) static unsigned int avx2_structural_mask(const char *p, char delimiter)
+{
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(delimiter)),
+                                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))));
+    return (unsigned int)_mm256_movemask_epi8(m);
+}
+
+__attribute__((target("avx2"))) static size_t scan_structurals_avx2(const char *buf, size_t len, char delimiter,
+                                                                    uint32_t positions[], size_t *from)
+{
+    size_t n = 0;
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
     {
-        if (feof(fp))
+        unsigned int m = avx2_structural_mask(buf + i, delimiter);
+        while (m)
         {
-            return 0; // EOF is not an error
+            positions[n++] = (uint32_t)(i + (size_t)__builtin_ctz(m));
+            m &= m - 1;
         }
-        set_error_message("Error: Failed to read line from file");
+    }
+    *from = i;
+    return n;
+}
+
+__attribute__((target("avx2"))) static const char *scan_next_avx2(const char *p, const char *end, char delimiter)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        unsigned int m = avx2_structural_mask(p, delimiter);
+        if (m)
+            return p + __builtin_ctz(m);
+    }
+    return p;
+}
+
+__attribute__((target("avx2"))) static size_t count_newlines_avx2(const char *p, const char *end, size_t *count)
+{
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t done = 0;
+    for (; end - p >= 32; p += 32, done += 32)
+        *count += (size_t)__builtin_popcount(
+            (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), nl)));
+    return done;
+}
+
+static int have_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+#endif // CSV_SCAN_X86
+
+size_t csv_scan_structurals(const char *buf, size_t len, char delimiter, uint32_t positions[])
+{
+    if (!buf || !positions)
         return 0;
+    size_t n = 0;
+    size_t i = 0;
+#ifdef CSV_SCAN_X86
+    if (have_avx2())
+        n = scan_structurals_avx2(buf, len, delimiter, positions, &i);
+    for (; i + 16 <= len; i += 16)
+    {
+        unsigned int m = sse2_structural_mask(buf + i, delimiter);
+        while (m)
+        {
+            positions[n++] = (uint32_t)(i + (size_t)__builtin_ctz(m));
+            m &= m - 1;
+        }
     }
+#endif
+    return scan_structurals_scalar(buf, i, len, delimiter, positions, n);
+}
 
-    if (strlen(line) >= MAX_LINE_LENGTH - 1 && line[MAX_LINE_LENGTH - 2] != '\n')
+const char *csv_scan_next(const char *p, const char *end, char delimiter)
+{
+#ifdef CSV_SCAN_X86
+    if (end - p >= 32 && have_avx2())
     {
-        set_error_message("Error: Line exceeds maximum length of %d characters", MAX_LINE_LENGTH);
+        p = scan_next_avx2(p, end, delimiter);
+        if (p < end && is_structural(*p, delimiter))
+            return p;
+    }
+    for (; end - p >= 16; p += 16)
+    {
+        unsigned int m = sse2_structural_mask(p, delimiter);
+        if (m)
+            return p + __builtin_ctz(m);
+    }
+#endif
+    return scan_next_scalar(p, end, delimiter);
+}
+
+size_t csv_count_newlines(const char *buf, size_t len)
+{
+    if (!buf)
         return 0;
+    const char *p = buf;
+    const char *end = buf + len;
+    size_t count = 0;
+#ifdef CSV_SCAN_X86
+    if (have_avx2())
+        p += count_newlines_avx2(p, end, &count);
+    const __m128i nl = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16)
+        count += (size_t)__builtin_popcount(
+            (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), nl)));
+#endif
+    return count_newlines_scalar(p, end, count);
+}
+
+// Next delimiter in [p, end), or end; other structural characters are field content here
+static const char *next_delimiter(const char *p, const char *end, char delimiter)
+{
+    const char *q = csv_scan_next(p, end, delimiter);
+    while (q < end && *q != delimiter)
+        q = csv_scan_next(q + 1, end, delimiter);
+    return q;
+}
+
+/**
+ * Parse an RFC 4180 quoted field starting at the opening quote
+ * A doubled quote inside is an escaped quote. Only spaces may follow the
+ * closing quote before the delimiter; anything else (or a missing closing
+ * quote) makes the field plain text, as it was read before quoting existed.
+ * @param after Output: the delimiter ending the field, or end
+ * @return 1 if the field is a well-formed quoted field, 0 otherwise
+ */
+static int parse_quoted(const char *open, const char *end, char delimiter, csv_span_t *field, const char **after)
+{
+    const char *s = open + 1;
+    int escaped = 0;
+    for (;;)
+    {
+        const char *q = memchr(s, '"', (size_t)(end - s));
+        if (!q)
+            return 0;
+        if (q + 1 < end && q[1] == '"')
+        {
+            escaped = 1;
+            s = q + 2;
+            continue;
+        }
+        const char *t = q + 1;
+        while (t < end && is_csv_space(*t))
+            t++;
+        if (t < end && *t != delimiter)
+            return 0;
+        field->ptr = open + 1;
+        field->len = (size_t)(q - (open + 1));
+        field->quoting = escaped ? CSV_SPAN_ESCAPED : CSV_SPAN_QUOTED;
+        *after = t;
+        return 1;
+    }
+}
+
+int csv_split_spans(const char *line, size_t len, char delimiter, csv_span_t fields[], int max_fields)
+{
+    if (!line || !fields || max_fields <= 0)
+        return 0;
+
+    const char *p = line;
+    const char *end = line + len;
+    while (end > p && is_csv_space(end[-1]))
+        end--;
+    if (end == p)
+        return 0; // blank row
+
+    int n = 0;
+    while (n < max_fields)
+    {
+        const char *a = p;
+        while (a < end && is_csv_space(*a))
+            a++;
+        const char *q;
+        // Only a field that opens with '"' pays for quote handling
+        if (a == end || *a != '"' || !parse_quoted(a, end, delimiter, &fields[n], &q))
+        {
+            q = next_delimiter(a, end, delimiter);
+            const char *b = q;
+            while (b > a && is_csv_space(b[-1]))
+                b--;
+            fields[n].ptr = a;
+            fields[n].len = (size_t)(b - a);
+            fields[n].quoting = CSV_SPAN_PLAIN;
+        }
+        n++;
+        if (q == end)
+            break;
+        p = q + 1;
+    }
+    return n;
+}
+
+int csv_span_eq(const csv_span_t *span, const char *s)
+{
+    if (span->quoting != CSV_SPAN_ESCAPED)
+        return strncmp(span->ptr, s, span->len) == 0 && s[span->len] == '\0';
+    for (size_t i = 0; i < span->len; i++, s++)
+    {
+        if (*s != span->ptr[i])
+            return 0;
+        if (span->ptr[i] == '"')
+            i++; // second quote of an escaped pair
     }
+    return *s == '\0';
+}
 
-    int i = 0;
-    char delim_str[2] = {delimiter, '\0'};
-    char *token = strtok(line, delim_str);
-    while (token && i < max_fields)
+size_t csv_span_copy(const csv_span_t *span, char *out, size_t outsz)
+{
+    if (!out || outsz == 0)
+        return 0;
+    size_t n = 0;
+    if (span && span->ptr)
     {
-        while (*token == ' ' || *token == '\t')
-            token++;
-        char *end = token + strlen(token) - 1;
-        while (end > token && (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r'))
+        for (size_t i = 0; i < span->len && n < outsz - 1; i++)
         {
-            *end-- = '\0';
+            out[n++] = span->ptr[i];
+            if (span->quoting == CSV_SPAN_ESCAPED && span->ptr[i] == '"')
+                i++;
         }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+char *csv_span_dup(const csv_span_t *span)
+{
+    char *s = malloc(span->len + 1);
+    if (s)
+        csv_span_copy(span, s, span->len + 1);
+    return s;
+}
+
+// Whether a value must be quoted to read back unchanged
+static int needs_quotes(const char *value, size_t len)
+{
+    if (len == 0)
+        return 0;
+    if (is_csv_space(value[0]) || is_csv_space(value[len - 1]))
+        return 1; // readers trim unquoted fields
+    return csv_scan_next(value, value + len, ',') != value + len;
+}
+
+static void put_char(char *out, size_t outsz, size_t *n, char c)
+{
+    if (*n + 1 < outsz)
+        out[*n] = c;
+    (*n)++;
+}
+
+int csv_quote_field(const char *value, char *out, size_t outsz)
+{
+    size_t len = value ? strlen(value) : 0;
+    size_t n = 0;
+    int quote = needs_quotes(value, len);
+    if (quote)
+        put_char(out, outsz, &n, '"');
+    for (size_t i = 0; i < len; i++)
+    {
+        if (quote && value[i] == '"')
+            put_char(out, outsz, &n, '"');
+        put_char(out, outsz, &n, value[i]);
+    }
+    if (quote)
+        put_char(out, outsz, &n, '"');
+    if (outsz > 0)
+        out[n < outsz ? n : outsz - 1] = '\0';
+    return (int)n;
+}
 
-        // duplicate token safely
-        char *copy = NULL;
+int csv_format_row(char *buf, size_t bufsize, const char *const values[], int count)
+{
+    size_t n = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (i > 0)
         {
-            size_t len = strlen(token) + 1;
-            copy = malloc(len);
-            if (!copy)
-            {
-                set_error_message("Error: Memory allocation failed while parsing CSV fields");
-                for (int j = 0; j < i; j++)
-                {
-                    free(fields[j]);
-                }
-                return 0;
-            }
-            memcpy(copy, token, len);
+            if (n + 2 < bufsize)
+                memcpy(buf + n, ", ", 2);
+            n += 2;
         }
-        if (!copy)
+        n += (size_t)csv_quote_field(values[i], n < bufsize ? buf + n : NULL, n < bufsize ? bufsize - n : 0);
+    }
+    if (bufsize > 0)
+        buf[n < bufsize ? n : bufsize - 1] = '\0';
+    return (int)n;
+}
+
+// Copy field views into separately allocated strings; 0 (and nothing kept) on failure
+static int dup_spans(const csv_span_t spans[], int n, char *fields[])
+{
+    for (int i = 0; i < n; i++)
+    {
+        fields[i] = csv_span_dup(&spans[i]);
+        if (!fields[i])
         {
-            set_error_message("Error: Memory allocation failed while parsing CSV fields");
             for (int j = 0; j < i; j++)
-            {
                 free(fields[j]);
-            }
             return 0;
         }
-        fields[i++] = copy;
-        token = strtok(NULL, delim_str);
     }
+    return n;
+}
 
-    return i;
+int read_csv_line(FILE *fp, char *fields[], int max_fields, char delimiter)
+{
+    if (!fp || !fields || max_fields <= 0)
+    {
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: Invalid parameters for read_csv_line");
+        return 0;
+    }
+
+    char line[MAX_LINE_LENGTH];
+    if (!fgets(line, sizeof(line), fp))
+    {
+        if (feof(fp))
+        {
+            return 0; // EOF is not an error
+        }
+        set_error(DATA_ERROR_MALFORMED_DATA, "Error: Failed to read line from file");
+        return 0;
+    }
+
+    if (strlen(line) >= MAX_LINE_LENGTH - 1 && line[MAX_LINE_LENGTH - 2] != '\n')
+    {
+        set_error_message("Error: Line exceeds maximum length of %d characters", MAX_LINE_LENGTH);
+        return 0;
+    }
+
+    csv_span_t spans[MAX_FIELDS];
+    int n = csv_split_spans(line, strlen(line), delimiter, spans, max_fields < MAX_FIELDS ? max_fields : MAX_FIELDS);
+    if (n > 0 && !dup_spans(spans, n, fields))
+    {
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed while parsing CSV fields");
+        return 0;
+    }
+    return n;
 }
 
-int append_line(const char *filename, const char *line)
+/* ==== Cross-process File Locks ==== */
+
+#if !defined(_WIN32)
+
+// Lock state of one file, kept for the life of the process. The sidecar
+// stays open: closing any descriptor of a file drops every fcntl lock the
+// process holds on it.
+typedef struct csv_lock_entry
 {
-    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) ||
-        !validate_string_input(line, "line", MAX_LINE_LENGTH))
+    char path[MAX_LINE_LENGTH];
+    int fd;                  // "<path>.lock"
+    int held;                // fcntl lock type held, F_UNLCK when none
+    int readers;             // shared holds, any thread
+    int writer_depth;        // nested holds of the exclusive owner
+    pthread_t writer;
+    int busy;                // a thread is waiting in fcntl for this file
+    struct csv_lock_entry *next;
+} csv_lock_entry_t;
+
+static pthread_mutex_t lock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t lock_cond = PTHREAD_COND_INITIALIZER;
+static csv_lock_entry_t *lock_entries;
+
+// Find or create the entry of a file. Caller holds lock_mutex.
+static csv_lock_entry_t *lock_entry(const char *filename)
+{
+    for (csv_lock_entry_t *e = lock_entries; e; e = e->next)
     {
-        return DATA_ERROR_INVALID_INPUT;
+        if (strcmp(e->path, filename) == 0)
+            return e;
     }
 
-    if (!validate_file_access(filename, "a"))
+    char lock_path[MAX_LINE_LENGTH + 8];
+    snprintf(lock_path, sizeof(lock_path), "%s.lock", filename);
+    int fd = open(lock_path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        set_error_message("Error: Cannot open lock file '%s': %s", lock_path, strerror(errno));
+        return NULL;
+    }
+    csv_lock_entry_t *e = calloc(1, sizeof(*e));
+    if (!e)
+    {
+        close(fd);
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for file lock");
+        return NULL;
+    }
+    snprintf(e->path, sizeof(e->path), "%s", filename);
+    e->fd = fd;
+    e->held = F_UNLCK;
+    e->next = lock_entries;
+    lock_entries = e;
+    return e;
+}
+
+// Take the fcntl lock, blocking without holding lock_mutex; other threads
+// wait for busy to clear. Caller holds lock_mutex and no lock is held yet.
+static int lock_wait(csv_lock_entry_t *e, int type)
+{
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = (short)type;
+    fl.l_whence = SEEK_SET;
+
+    e->busy = 1;
+    pthread_mutex_unlock(&lock_mutex);
+    int rc;
+    while ((rc = fcntl(e->fd, F_SETLKW, &fl)) != 0 && errno == EINTR)
+        ;
+    int saved_errno = errno;
+    pthread_mutex_lock(&lock_mutex);
+    e->busy = 0;
+    pthread_cond_broadcast(&lock_cond);
+
+    if (rc != 0)
     {
+        set_error_message("Error: Cannot lock '%s': %s", e->path, strerror(saved_errno));
         return DATA_ERROR_PERMISSION_DENIED;
     }
+    e->held = type;
+    return DATA_SUCCESS;
+}
+
+int csv_lock_acquire(csv_lock_t *lk, const char *filename, int exclusive)
+{
+    if (!lk)
+        return DATA_ERROR_INVALID_INPUT;
+    lk->entry = NULL;
+    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH))
+        return DATA_ERROR_INVALID_INPUT;
+
+    pthread_t self = pthread_self();
+    pthread_mutex_lock(&lock_mutex);
+    csv_lock_entry_t *e = lock_entry(filename);
+    int rc = e ? DATA_SUCCESS : DATA_ERROR_PERMISSION_DENIED;
+    if (e && e->writer_depth > 0 && pthread_equal(e->writer, self))
+    {
+        e->writer_depth++; // already ours exclusively
+    }
+    else if (e)
+    {
+        // A writer needs the file to itself; readers only wait for writers
+        while (e->busy || e->writer_depth > 0 || (exclusive && e->readers > 0))
+            pthread_cond_wait(&lock_cond, &lock_mutex);
+        if (exclusive || e->held == F_UNLCK)
+            rc = lock_wait(e, exclusive ? F_WRLCK : F_RDLCK);
+        if (rc == DATA_SUCCESS && exclusive)
+        {
+            e->writer = self;
+            e->writer_depth = 1;
+        }
+        else if (rc == DATA_SUCCESS)
+        {
+            e->readers++;
+        }
+    }
+    pthread_mutex_unlock(&lock_mutex);
+    if (rc == DATA_SUCCESS)
+        lk->entry = e;
+    return rc;
+}
+
+void csv_lock_release(csv_lock_t *lk)
+{
+    if (!lk || !lk->entry)
+        return;
+    csv_lock_entry_t *e = lk->entry;
+    lk->entry = NULL;
+
+    pthread_mutex_lock(&lock_mutex);
+    if (e->writer_depth > 0 && pthread_equal(e->writer, pthread_self()))
+        e->writer_depth--;
+    else if (e->readers > 0)
+        e->readers--;
+    if (e->writer_depth == 0 && e->readers == 0 && e->held != F_UNLCK)
+    {
+        struct flock fl;
+        memset(&fl, 0, sizeof(fl));
+        fl.l_type = F_UNLCK;
+        fl.l_whence = SEEK_SET;
+        fcntl(e->fd, F_SETLK, &fl);
+        e->held = F_UNLCK;
+    }
+    pthread_cond_broadcast(&lock_cond);
+    pthread_mutex_unlock(&lock_mutex);
+}
+
+#else // _WIN32: single booth per host, nothing to exclude
+
+int csv_lock_acquire(csv_lock_t *lk, const char *filename, int exclusive)
+{
+    (void)filename;
+    (void)exclusive;
+    if (!lk)
+        return DATA_ERROR_INVALID_INPUT;
+    lk->entry = NULL;
+    return DATA_SUCCESS;
+}
+
+void csv_lock_release(csv_lock_t *lk)
+{
+    (void)lk;
+}
+
+#endif
+
+/* ==== Appends and Rewrites ==== */
+
+static int append_line_locked(const char *filename, const char *line)
+{
+    // Fingerprint before writing so a fresh lookup index can be extended in place
+    struct stat before;
+    int have_before = stat(filename, &before) == 0;
 
     FILE *fp = fopen(filename, "a+");
     if (!fp)
@@ -196,9 +698,11 @@ int append_line(const char *filename, const char *line)
     }
 
     // Ensure there is exactly one newline before the appended record
+    long row_offset = -1;
     if (fseek(fp, 0, SEEK_END) == 0)
     {
         long endpos = ftell(fp);
+        row_offset = endpos;
         if (endpos > 0)
         {
             if (fseek(fp, -1L, SEEK_END) == 0)
@@ -209,6 +713,7 @@ int append_line(const char *filename, const char *line)
                 if (last != '\n')
                 {
                     fputc('\n', fp);
+                    row_offset = endpos + 1;
                 }
             }
         }
@@ -227,120 +732,353 @@ int append_line(const char *filename, const char *line)
         return DATA_ERROR_DISK_FULL;
     }
 
+    if (have_before && row_offset >= 0)
+        record_index_note_append(filename, &before, row_offset, strlen(line));
+
     return DATA_SUCCESS;
 }
 
-int overwrite_file(const char *filename, const char *content)
+int append_line(const char *filename, const char *line)
 {
-    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) || !content)
+    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) ||
+        !validate_string_input(line, "line", MAX_LINE_LENGTH))
     {
         return DATA_ERROR_INVALID_INPUT;
     }
 
-    if (strlen(content) > MAX_FILE_SIZE)
+    if (!validate_file_access(filename, "a"))
     {
-        set_error_message("Error: Content size exceeds maximum file size limit");
-        return DATA_ERROR_BUFFER_OVERFLOW;
+        return DATA_ERROR_PERMISSION_DENIED;
     }
 
-    char backup_name[MAX_LINE_LENGTH + 10];
-    snprintf(backup_name, sizeof(backup_name), "%s.backup", filename);
+    // The newline fix-up and the write must not interleave with another writer
+    csv_lock_t lock;
+    int rc = csv_lock_acquire(&lock, filename, 1);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    rc = append_line_locked(filename, line);
+    csv_lock_release(&lock);
+    return rc;
+}
+
+static int append_rows_locked(int fd, const char *filename, const char *header, const char *rows, size_t len,
+                              long long *known_end)
+{
+
+    // Fingerprint before writing so a fresh lookup index can be extended in place
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        set_error_message("Error: Cannot stat file '%s': %s", filename, strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
 
-    FILE *original = fopen(filename, "r");
-    if (original)
+    // Prefix: a missing final newline and/or the header of an empty file.
+    // The last byte only needs checking when someone else wrote since our last append.
+    char prefix[MAX_LINE_LENGTH + 2];
+    size_t prefix_len = 0;
+    if (st.st_size > 0)
     {
-        FILE *backup = fopen(backup_name, "w");
-        if (backup)
+        char last = '\n';
+        if ((!known_end || *known_end != (long long)st.st_size) &&
+            pread(fd, &last, 1, st.st_size - 1) == 1 && last != '\n')
+            prefix[prefix_len++] = '\n';
+    }
+    else if (header)
+    {
+        prefix_len = (size_t)snprintf(prefix, sizeof(prefix), "%s\n", header);
+        if (prefix_len >= sizeof(prefix))
         {
-            char buffer[1024];
-            size_t bytes;
-            while ((bytes = fread(buffer, 1, sizeof(buffer), original)) > 0)
-            {
-                fwrite(buffer, 1, bytes, backup);
-            }
-            fclose(backup);
+            set_error_message("Error: Header for '%s' is too long", filename);
+            return DATA_ERROR_BUFFER_OVERFLOW;
         }
-        fclose(original);
     }
 
-    FILE *fp = fopen(filename, "w");
-    if (!fp)
+    // One write for the whole block
+    struct iovec iov[2] = {{prefix, prefix_len}, {(void *)rows, len}};
+    int iovcnt = 2, first = prefix_len == 0 ? 1 : 0;
+    size_t total = prefix_len + len, done = 0;
+    while (done < total)
     {
-        set_error_message("Error: Cannot open file '%s' for writing: %s", filename, strerror(errno));
-        return DATA_ERROR_PERMISSION_DENIED;
+        ssize_t n = writev(fd, iov + first, iovcnt - first);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            set_error_message("Error: Failed to write to file '%s': %s", filename, strerror(errno));
+            return errno == ENOSPC ? DATA_ERROR_DISK_FULL : DATA_ERROR_PERMISSION_DENIED;
+        }
+        done += (size_t)n;
+        // Short write: skip what went out and retry the rest
+        while (first < iovcnt && (size_t)n >= iov[first].iov_len)
+        {
+            n -= (ssize_t)iov[first].iov_len;
+            first++;
+        }
+        if (first < iovcnt)
+        {
+            iov[first].iov_base = (char *)iov[first].iov_base + n;
+            iov[first].iov_len -= (size_t)n;
+        }
     }
+    if (known_end)
+        *known_end = (long long)st.st_size + (long long)total;
 
-    if (fprintf(fp, "%s", content) < 0)
+    // Tell fresh indexes where each new row landed
+    int nrows = 0;
+    for (size_t i = 0; i < len; i++)
+        nrows += rows[i] == '\n';
+    long long *offsets = malloc((size_t)nrows * sizeof(*offsets));
+    size_t *lens = malloc((size_t)nrows * sizeof(*lens));
+    if (offsets && lens)
     {
-        set_error_message("Error: Failed to write content to file '%s': %s", filename, strerror(errno));
-        fclose(fp);
-        rename(backup_name, filename);
-        return DATA_ERROR_DISK_FULL;
+        long long base = (long long)st.st_size + (long long)prefix_len;
+        int r = 0;
+        size_t start = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            if (rows[i] != '\n')
+                continue;
+            offsets[r] = base + (long long)start;
+            lens[r] = i - start;
+            r++;
+            start = i + 1;
+        }
+        record_index_note_append_rows(filename, &st, offsets, lens, nrows);
     }
+    free(offsets);
+    free(lens);
 
-    if (fclose(fp) != 0)
+    return DATA_SUCCESS;
+}
+
+int append_rows_fd(int fd, const char *filename, const char *header, const char *rows, size_t len,
+                   long long *known_end)
+{
+    if (fd < 0 || !filename || !rows)
+    {
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    if (len == 0)
+        return DATA_SUCCESS;
+    if (rows[len - 1] != '\n')
+    {
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: append_rows needs newline-terminated rows");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    // The last-byte check, header and rows go out as one unit
+    csv_lock_t lock;
+    int rc = csv_lock_acquire(&lock, filename, 1);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    rc = append_rows_locked(fd, filename, header, rows, len, known_end);
+    csv_lock_release(&lock);
+    return rc;
+}
+
+int append_rows(const char *filename, const char *header, const char *rows, size_t len)
+{
+    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) || !rows)
+    {
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    int fd = open(filename, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        set_error_message("Error: Cannot open file '%s' for appending: %s", filename, strerror(errno));
+        return errno == ENOSPC ? DATA_ERROR_DISK_FULL : DATA_ERROR_PERMISSION_DENIED;
+    }
+    int rc = append_rows_fd(fd, filename, header, rows, len, NULL);
+    if (close(fd) != 0 && rc == DATA_SUCCESS)
     {
         set_error_message("Error: Failed to close file '%s': %s", filename, strerror(errno));
-        rename(backup_name, filename);
-        return DATA_ERROR_DISK_FULL;
+        rc = DATA_ERROR_DISK_FULL;
     }
+    return rc;
+}
 
-    remove(backup_name);
+int csv_rewrite_begin(csv_rewrite_t *rw, const char *filename)
+{
+    if (!rw || !validate_string_input(filename, "filename", MAX_LINE_LENGTH))
+    {
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    memset(rw, 0, sizeof(*rw));
+    snprintf(rw->path, sizeof(rw->path), "%s", filename);
+
+    // Held until commit/abort: nobody appends to the file we are replacing
+    int rc = csv_lock_acquire(&rw->lock, filename, 1);
+    if (rc != DATA_SUCCESS)
+        return rc;
+
+    // Same directory as the target so the final rename() stays atomic
+    snprintf(rw->tmp_path, sizeof(rw->tmp_path), "%s.tmpXXXXXX", filename);
+    int fd = mkstemp(rw->tmp_path);
+    if (fd < 0)
+    {
+        int saved_errno = errno;
+        set_error_message("Error: Cannot create temporary file for '%s': %s", filename, strerror(saved_errno));
+        csv_lock_release(&rw->lock);
+        return saved_errno == ENOSPC ? DATA_ERROR_DISK_FULL : DATA_ERROR_PERMISSION_DENIED;
+    }
+
+    // Keep the original's permissions (mkstemp creates 0600)
+    struct stat st;
+    fchmod(fd, stat(filename, &st) == 0 ? (st.st_mode & 07777) : 0644);
+
+    rw->out = fdopen(fd, "w");
+    if (!rw->out)
+    {
+        close(fd);
+        remove(rw->tmp_path);
+        set_error_message("Error: Cannot open temporary file for '%s': %s", filename, strerror(errno));
+        csv_lock_release(&rw->lock);
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
     return DATA_SUCCESS;
 }
 
-static void trim_ws(char *s)
+int csv_rewrite_write(csv_rewrite_t *rw, const char *text)
 {
-    if (!s)
+    if (!rw || !rw->out || rw->failed)
+        return 0;
+    if (fputs(text, rw->out) == EOF)
+    {
+        rw->failed = 1;
+        set_error_message("Error: Failed to write to '%s': %s", rw->tmp_path, strerror(errno));
+        return 0;
+    }
+    return 1;
+}
+
+int csv_rewrite_write_n(csv_rewrite_t *rw, const char *data, size_t len)
+{
+    if (!rw || !rw->out || rw->failed)
+        return 0;
+    if (len > 0 && fwrite(data, 1, len, rw->out) != len)
+    {
+        rw->failed = 1;
+        set_error_message("Error: Failed to write to '%s': %s", rw->tmp_path, strerror(errno));
+        return 0;
+    }
+    return 1;
+}
+
+int csv_rewrite_write_span(csv_rewrite_t *rw, const csv_span_t *span)
+{
+    // Fields read quoted go back exactly as they were
+    if (span->quoting != CSV_SPAN_PLAIN)
+        return csv_rewrite_write(rw, "\"") && csv_rewrite_write_n(rw, span->ptr, span->len) &&
+               csv_rewrite_write(rw, "\"");
+    if (!needs_quotes(span->ptr, span->len))
+        return csv_rewrite_write_n(rw, span->ptr, span->len);
+
+    const char *p = span->ptr;
+    const char *end = span->ptr + span->len;
+    int ok = csv_rewrite_write(rw, "\"");
+    while (ok && p < end)
+    {
+        const char *q = memchr(p, '"', (size_t)(end - p));
+        const char *stop = q ? q + 1 : end;
+        ok = csv_rewrite_write_n(rw, p, (size_t)(stop - p)) && (!q || csv_rewrite_write(rw, "\""));
+        p = stop;
+    }
+    return ok && csv_rewrite_write(rw, "\"");
+}
+
+void csv_rewrite_abort(csv_rewrite_t *rw)
+{
+    if (!rw)
         return;
-    char *start = s;
-    while (*start && (*start == ' ' || *start == '\t' || *start == '\r' || *start == '\n'))
-        start++;
-    char *end = s + strlen(s);
-    while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
-        end--;
-    size_t len = (size_t)(end - start);
-    if (start != s)
-        memmove(s, start, len);
-    s[len] = '\0';
+    csv_lock_release(&rw->lock);
+    if (rw->tmp_path[0] == '\0')
+        return;
+    if (rw->out)
+        fclose(rw->out);
+    rw->out = NULL;
+    remove(rw->tmp_path);
+    rw->tmp_path[0] = '\0';
+}
+
+int csv_rewrite_commit(csv_rewrite_t *rw)
+{
+    if (!rw || !rw->out)
+        return DATA_ERROR_INVALID_INPUT;
+
+    int ok = !rw->failed && fflush(rw->out) == 0 && fsync(fileno(rw->out)) == 0;
+    int saved_errno = errno;
+    ok = (fclose(rw->out) == 0) && ok;
+    rw->out = NULL;
+    if (!ok)
+    {
+        set_error_message("Error: Failed to write '%s': %s", rw->path, strerror(saved_errno));
+        csv_rewrite_abort(rw);
+        return DATA_ERROR_DISK_FULL;
+    }
+
+    if (rename(rw->tmp_path, rw->path) != 0)
+    {
+        set_error_message("Error: Failed to replace '%s': %s", rw->path, strerror(errno));
+        csv_rewrite_abort(rw);
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+    rw->tmp_path[0] = '\0';
+
+    // Persist the directory entry too, so the rename survives a crash
+    char dir[MAX_LINE_LENGTH];
+    snprintf(dir, sizeof(dir), "%s", rw->path);
+    char *slash = strrchr(dir, '/');
+    if (slash)
+        *slash = '\0';
+    else
+        snprintf(dir, sizeof(dir), ".");
+    int dfd = open(dir, O_RDONLY);
+    if (dfd >= 0)
+    {
+        fsync(dfd);
+        close(dfd);
+    }
+
+    // Row offsets moved: re-derive any lookup index of this file
+    record_index_rebuild_all(rw->path);
+    csv_lock_release(&rw->lock);
+    return DATA_SUCCESS;
+}
+
+int overwrite_file(const char *filename, const char *content)
+{
+    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) || !content)
+    {
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    csv_rewrite_t rw;
+    int rc = csv_rewrite_begin(&rw, filename);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    if (!csv_rewrite_write(&rw, content))
+    {
+        csv_rewrite_abort(&rw);
+        return DATA_ERROR_DISK_FULL;
+    }
+    return csv_rewrite_commit(&rw);
 }
 
 int split_csv_fields(const char *line, char *fields[], int max_fields, char delimiter)
 {
     if (!line || !fields || max_fields <= 0)
     {
-        set_error_message("Error: Invalid parameters to split_csv_fields");
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: Invalid parameters to split_csv_fields");
         return 0;
     }
-    size_t L = strlen(line);
-    char *copy = malloc(L + 1);
-    if (!copy)
+    csv_span_t spans[MAX_FIELDS];
+    int n = csv_split_spans(line, strlen(line), delimiter, spans, max_fields < MAX_FIELDS ? max_fields : MAX_FIELDS);
+    if (n > 0 && !dup_spans(spans, n, fields))
     {
-        set_error_message("Error: Memory allocation failed in split_csv_fields");
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed in split_csv_fields");
         return 0;
     }
-    memcpy(copy, line, L + 1);
-
-    int count = 0;
-    char delim_str[2] = {delimiter, '\0'};
-    char *token = strtok(copy, delim_str);
-    while (token && count < max_fields)
-    {
-        trim_ws(token);
-        size_t tlen = strlen(token);
-        char *dup = malloc(tlen + 1);
-        if (!dup)
-        {
-            for (int i = 0; i < count; i++)
-                free(fields[i]);
-            free(copy);
-            set_error_message("Error: Memory allocation failed in split_csv_fields copy");
-            return 0;
-        }
-        memcpy(dup, token, tlen + 1);
-        fields[count++] = dup;
-        token = strtok(NULL, delim_str);
-    }
-    free(copy);
-    return count;
+    return n;
 }
@@ -1,10 +1,66 @@
 #ifndef CSV_IO_H
 #define CSV_IO_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "data_errors.h"
-#include "data_handler_enhanced.h" // for MAX_LINE_LENGTH/MAX_FIELDS/MAX_FILE_SIZE constants
+#include "data_handler_enhanced.h" // for MAX_LINE_LENGTH/MAX_FIELDS constants
+
+// How a field was written. Quoted fields are views of the text between the
+// quotes; if it contains doubled ("") quotes they are still doubled there.
+#define CSV_SPAN_PLAIN 0
+#define CSV_SPAN_QUOTED 1
+#define CSV_SPAN_ESCAPED 2
+
+// A field of a row: a view into a buffer the caller owns (NOT NUL-terminated)
+typedef struct
+{
+    const char *ptr;
+    size_t len;
+    int quoting; // CSV_SPAN_*
+} csv_span_t;
+
+// Find every structural character (delimiter, '\n', '\r', '"') of a buffer
+// and store its offset in positions, which must have room for len entries.
+// Vectorized (SSE2, AVX2 when the CPU has it) on x86, byte loop elsewhere.
+// Returns the number of positions stored, in increasing order.
+size_t csv_scan_structurals(const char *buf, size_t len, char delimiter, uint32_t positions[]);
+
+// First structural character in [p, end), or end if there is none.
+const char *csv_scan_next(const char *p, const char *end, char delimiter);
+
+// Number of '\n' bytes in a buffer.
+size_t csv_count_newlines(const char *buf, size_t len);
+
+// Split one row into trimmed field views without allocating or modifying it.
+// Empty fields are kept ("a,,b" has three fields, "a,b," has three), a blank
+// row has none, and the line terminator is not part of the last field.
+// RFC 4180 quoting is understood: "Smith, J." is one field and "" inside
+// quotes is a literal quote. Fields that do not start with '"' take the fast
+// path and never look at quotes. A field cannot span lines.
+// Returns the number of fields filled; fields beyond max_fields are dropped.
+int csv_split_spans(const char *line, size_t len, char delimiter, csv_span_t fields[], int max_fields);
+
+// Whether a span's value equals a NUL-terminated string.
+int csv_span_eq(const csv_span_t *span, const char *s);
+
+// Copy a span's value (escaped quotes undone) into a NUL-terminated buffer,
+// truncating to fit. A NULL span copies as "". Returns the length copied.
+size_t csv_span_copy(const csv_span_t *span, char *out, size_t outsz);
+
+// csv_span_copy into a new allocation. Returns NULL when out of memory.
+char *csv_span_dup(const csv_span_t *span);
+
+// Write value as one comma-separated field, quoting it when it holds a comma,
+// quote, CR/LF or leading/trailing blanks. Works like snprintf: returns the
+// full length and truncates to outsz.
+int csv_quote_field(const char *value, char *out, size_t outsz);
+
+// Join values into a ", "-separated row with csv_quote_field (no newline).
+// Returns the full length like snprintf; >= bufsize means it did not fit.
+int csv_format_row(char *buf, size_t bufsize, const char *const values[], int count);
 
 // Reads a CSV line and splits into fields (allocated via strdup). Returns number of fields or 0 on EOF/error.
 int read_csv_line(FILE *fp, char *fields[], int max_fields, char delimiter);
@@ -12,14 +68,77 @@ int read_csv_line(FILE *fp, char *fields[], int max_fields, char delimiter);
 // Append a single line to a file with validation and error reporting.
 int append_line(const char *filename, const char *line);
 
-// Overwrite entire file content with backup/rollback behavior.
+// Append a block of newline-terminated rows with a single write(). When the
+// file is missing or empty, header (if not NULL, without newline) is written
+// first. Lookup indexes are extended as for append_line.
+int append_rows(const char *filename, const char *header, const char *rows, size_t len);
+
+// append_rows on a descriptor the caller keeps open (O_RDWR | O_APPEND) for
+// repeated appends. known_end (optional) remembers where our last append
+// ended so the trailing-newline check can be skipped when nobody else wrote.
+int append_rows_fd(int fd, const char *filename, const char *header, const char *rows, size_t len,
+                   long long *known_end);
+
+// Overwrite entire file content atomically (streamed through csv_rewrite_*).
 int overwrite_file(const char *filename, const char *content);
 
+// Advisory lock on a data file shared by every process on the host: shared
+// for readers, exclusive for appends and rewrites. The fcntl lock is taken on
+// a "<file>.lock" sidecar so it survives csv_rewrite_commit renaming a new
+// file into place. Within a process, threads exclude each other the same way,
+// and a thread may nest acquires of a file it already holds (a shared acquire
+// inside its exclusive one is free); it must not ask for exclusive while it
+// only holds shared. Take locks in a fixed order across files to avoid
+// deadlocks. A no-op on Windows.
+typedef struct
+{
+    void *entry; // per-process lock state of the file, NULL when not held
+} csv_lock_t;
+
+// Block until the lock is granted. Returns DATA_SUCCESS or an error code.
+int csv_lock_acquire(csv_lock_t *lk, const char *filename, int exclusive);
+
+// Release a lock from csv_lock_acquire (safe on one that is not held).
+void csv_lock_release(csv_lock_t *lk);
+
+// Streaming replacement of a file: rows are written to a temp file in the same
+// directory, which is fsynced and renamed over the original on commit. Readers
+// see either the old or the new file, never a partial one, and there is no
+// size limit. Lookup indexes of the file are rebuilt after the rename. The
+// file's exclusive lock is held from begin until commit or abort, so read the
+// original only after begin.
+typedef struct
+{
+    FILE *out;
+    csv_lock_t lock;
+    char path[MAX_LINE_LENGTH];
+    char tmp_path[MAX_LINE_LENGTH + 16];
+    int failed; // a write failed; commit will refuse
+} csv_rewrite_t;
+
+// Start a rewrite of filename. Returns DATA_SUCCESS or an error code.
+int csv_rewrite_begin(csv_rewrite_t *rw, const char *filename);
+
+// Append bytes to the new file. Returns 1 on success, 0 on write error.
+int csv_rewrite_write(csv_rewrite_t *rw, const char *text);
+
+// csv_rewrite_write for len bytes that need not be NUL-terminated (e.g. a span).
+int csv_rewrite_write_n(csv_rewrite_t *rw, const char *data, size_t len);
+
+// Write a field: quoted spans go back as read, plain ones are quoted if needed.
+int csv_rewrite_write_span(csv_rewrite_t *rw, const csv_span_t *span);
+
+// Flush, fsync and rename the new file into place. Returns DATA_SUCCESS or an error code.
+int csv_rewrite_commit(csv_rewrite_t *rw);
+
+// Discard the new file and leave the original untouched. Safe after a failed commit.
+void csv_rewrite_abort(csv_rewrite_t *rw);
+
 // Expose file access validation for reuse by higher-level modules
 int validate_file_access(const char *filename, const char *mode);
 
-// Split a CSV line from memory into allocated, trimmed fields.
-// Caller must free each fields[i]. Returns number of fields, or 0 on error.
+// Split a CSV line from memory into allocated, trimmed fields (csv_split_spans
+// rules). Caller must free each fields[i]. Returns number of fields, or 0 on error.
 int split_csv_fields(const char *line, char *fields[], int max_fields, char delimiter);
 
 #endif // CSV_IO_H
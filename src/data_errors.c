@@ -3,17 +3,60 @@
 #include <string.h>
 #include "data_errors.h"
 
-static char last_error_message[256] = {0};
+typedef struct
+{
+    int code;
+    const char *format; // message not formatted into text yet, NULL when text is current
+    int has_arg;
+    char arg[128];
+    char text[256];
+} error_context_t;
+
+static DATA_THREAD_LOCAL error_context_t last_error;
 
 void set_error_message(const char *format, ...)
 {
     va_list args;
     va_start(args, format);
-    vsnprintf(last_error_message, sizeof(last_error_message), format, args);
+    vsnprintf(last_error.text, sizeof(last_error.text), format, args);
     va_end(args);
+    last_error.code = 0;
+    last_error.format = NULL;
+}
+
+void set_error(int code, const char *message)
+{
+    last_error.code = code;
+    last_error.format = message;
+    last_error.has_arg = 0;
+}
+
+void set_error_arg(int code, const char *format, const char *arg)
+{
+    size_t n = 0;
+    while (arg && arg[n] && n < sizeof(last_error.arg) - 1)
+    {
+        last_error.arg[n] = arg[n];
+        n++;
+    }
+    last_error.arg[n] = '\0';
+    last_error.code = code;
+    last_error.format = format;
+    last_error.has_arg = 1;
 }
 
 const char *get_last_error(void)
 {
-    return last_error_message;
+    if (!last_error.format)
+        return last_error.text;
+    if (!last_error.has_arg)
+        return last_error.format;
+    snprintf(last_error.text, sizeof(last_error.text), last_error.format, last_error.arg);
+    last_error.format = NULL;
+    return last_error.text;
+}
+
+int get_last_error_code(void)
+{
+    return last_error.code;
 }
@@ -12,13 +12,37 @@ typedef enum
     DATA_ERROR_BUFFER_OVERFLOW = -5,
     DATA_ERROR_MALFORMED_DATA = -6,
     DATA_ERROR_RECORD_NOT_FOUND = -7,
-    DATA_ERROR_DISK_FULL = -8
+    DATA_ERROR_DISK_FULL = -8,
+    DATA_ERROR_DUPLICATE_RECORD = -9
 } data_error_t;
 
-// Returns a pointer to the last error message (static storage)
+// Storage class for per-thread state of the data layer
+#if defined(_MSC_VER)
+#define DATA_THREAD_LOCAL __declspec(thread)
+#else
+#define DATA_THREAD_LOCAL __thread
+#endif
+
+// The last error is kept per thread: a code and a message. Messages given as
+// a fixed string, or as a one-%s format and its argument, are only formatted
+// when get_last_error() asks for them, so a failed lookup costs no printf.
+
+// Returns the calling thread's last error message (valid until its next error)
 const char *get_last_error(void);
 
+// Returns the calling thread's last error code, 0 when it was set by
+// set_error_message (which has none)
+int get_last_error_code(void);
+
 // Internal: set error message (exposed for reuse across modules)
 void set_error_message(const char *format, ...);
 
+// Set an error whose message is a string that outlives the thread's next
+// error (a literal); nothing is copied or formatted.
+void set_error(int code, const char *message);
+
+// Set an error from a literal format with exactly one %s and its argument.
+// The argument is copied (truncated to 127 bytes) and formatted on demand.
+void set_error_arg(int code, const char *format, const char *arg);
+
 #endif // DATA_ERRORS_H
@@ -12,6 +12,7 @@
 #include <stdarg.h>
 #include "data_errors.h"
 #include "csv_io.h"
+#include "record_index.h"
 
 // Safe strdup implementation if not available
 #ifndef _GNU_SOURCE
@@ -29,7 +30,6 @@ char *strdup(const char *s)
 
 #define MAX_LINE_LENGTH 256
 #define MAX_FIELDS 20
-#define MAX_FILE_SIZE (MAX_LINE_LENGTH * 10000)
 
 // error codes and get_last_error/set_error_message are provided by data_errors.h/.c
 
@@ -98,57 +98,168 @@ int create_record(const char *filename, const char *record)
 
     if (comma_count == 0)
     {
-        set_error_message("Error: Record must contain at least one comma separator");
+        set_error(DATA_ERROR_MALFORMED_DATA, "Error: Record must contain at least one comma separator");
         return DATA_ERROR_MALFORMED_DATA;
     }
 
     return append_line(filename, record);
 }
 
-// Helper: buffered append to content with size checks (avoids O(n^2) strcat)
-static int append_to_buffer(char *content, size_t *len, const char *text)
+// Parsed "field_index:value" key or assignment
+typedef struct
 {
-    size_t add = strlen(text);
-    if (*len + add >= MAX_FILE_SIZE)
+    int index;
+    char *value;
+} field_spec_t;
+
+// Parsed form of one record_update_t
+typedef struct
+{
+    field_spec_t *keys;
+    field_spec_t *sets;
+} bulk_op_t;
+
+// Next run of characters other than delim at or after *p, like strtok_r
+// without modifying the string; returns its length (0 when there is none)
+static size_t next_token(const char **p, const char *end, char delim, const char **token)
+{
+    const char *s = *p;
+    while (s < end && *s == delim)
+        s++;
+    const char *e = s;
+    while (e < end && *e != delim)
+        e++;
+    *token = s;
+    *p = e;
+    return (size_t)(e - s);
+}
+
+// Parse "field_index:value" the way update/delete always have (the value
+// ends at the next ':'); returns DATA_SUCCESS or DATA_ERROR_INVALID_INPUT
+static int parse_field_spec(const char *spec, field_spec_t *out)
+{
+    out->value = NULL;
+    if (!spec)
+        return DATA_ERROR_INVALID_INPUT;
+
+    const char *p = spec;
+    const char *end = spec;
+    while (*end && end - spec < MAX_LINE_LENGTH - 1)
+        end++;
+    const char *idx_str, *value;
+    size_t idx_len = next_token(&p, end, ':', &idx_str);
+    size_t value_len = next_token(&p, end, ':', &value);
+    if (idx_len == 0 || value_len == 0)
+        return DATA_ERROR_INVALID_INPUT;
+
+    out->index = atoi(idx_str);
+    if (out->index < 0)
+        return DATA_ERROR_INVALID_INPUT;
+    out->value = malloc(value_len + 1);
+    if (!out->value)
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    memcpy(out->value, value, value_len);
+    out->value[value_len] = '\0';
+    return DATA_SUCCESS;
+}
+
+// Parse the primary keys of a lookup once, before the scan
+// Returns DATA_SUCCESS, or an error code with the message set
+static int parse_key_specs(char *primary_keys[], int num_keys, field_spec_t specs[])
+{
+    for (int i = 0; i < num_keys; i++)
     {
-        set_error_message("Error: File size would exceed maximum limit");
-        return 0;
+        int rc = parse_field_spec(primary_keys[i], &specs[i]);
+        if (rc != DATA_SUCCESS)
+        {
+            if (rc == DATA_ERROR_INVALID_INPUT)
+                set_error_message("Error: Invalid primary key format in '%s'", primary_keys[i]);
+            else
+                set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for primary keys");
+            for (int j = 0; j < i; j++)
+                free(specs[j].value);
+            return rc;
+        }
     }
-    memcpy(content + *len, text, add);
-    *len += add;
-    content[*len] = '\0';
-    return 1;
+    return DATA_SUCCESS;
 }
 
-// Enhanced read record with improved error handling
-char *read_record(const char *filename, char *primary_keys[], int num_keys)
+static void free_key_specs(field_spec_t specs[], int num_keys)
 {
-    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) ||
-        !primary_keys || num_keys <= 0)
+    for (int i = 0; i < num_keys; i++)
+        free(specs[i].value);
+}
+
+// Whether a row's fields match every key (an out-of-range index does not match)
+static int fields_match_specs(const csv_span_t fields[], int field_count, const field_spec_t specs[], int num_specs)
+{
+    for (int j = 0; j < num_specs; j++)
     {
-        set_error_message("Error: Invalid parameters for read_record");
-        return NULL;
+        if (specs[j].index >= field_count || !csv_span_eq(&fields[specs[j].index], specs[j].value))
+            return 0;
     }
+    return 1;
+}
 
-    // Validate all primary keys
-    for (int i = 0; i < num_keys; i++)
+// Match one raw data line against parsed keys
+static int line_matches_specs(const char *line, const field_spec_t specs[], int num_specs)
+{
+    csv_span_t fields[MAX_FIELDS];
+    int field_count = csv_split_spans(line, strlen(line), ',', fields, MAX_FIELDS);
+    return field_count > 0 && fields_match_specs(fields, field_count, specs, num_specs);
+}
+
+// Look a record up through the first fresh index covering one of the key columns
+// Returns 1 if an index answered (*out is the record or NULL when absent),
+// 0 if no usable index exists, -1 on error
+static int read_record_indexed(const char *filename, const field_spec_t specs[], int num_keys, char **out)
+{
+    *out = NULL;
+    for (int k = 0; k < num_keys; k++)
     {
-        if (!validate_string_input(primary_keys[i], "primary_key", MAX_LINE_LENGTH))
-        {
-            return NULL;
-        }
+        record_index_t ri;
+        if (record_index_open(&ri, filename, specs[k].index) != DATA_SUCCESS)
+            continue;
 
-        // Validate primary key format
-        if (!strchr(primary_keys[i], ':'))
+        char line[MAX_LINE_LENGTH];
+        unsigned int cursor = 0;
+        int rc;
+        while ((rc = record_index_next(&ri, specs[k].value, &cursor, line, sizeof(line))) == 1)
         {
-            set_error_message("Error: Primary key '%s' must be in format 'field_index:value'", primary_keys[i]);
-            return NULL;
+            if (line_matches_specs(line, specs, num_keys))
+            {
+                *out = strdup(line);
+                record_index_close(&ri);
+                if (!*out)
+                {
+                    set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for record duplication");
+                    return -1;
+                }
+                return 1;
+            }
         }
+        record_index_close(&ri);
+        if (rc == 0)
+            return 1; // index is authoritative: no such record
+        // Unreadable index: fall through to the scan
     }
+    return 0;
+}
 
-    if (!validate_file_access(filename, "r"))
-    {
+// Enhanced read record with improved error handling
+// read_record once the keys are parsed; caller holds the file's lock
+static char *read_record_specs_locked(const char *filename, const field_spec_t specs[], int num_keys)
+{
+    // Serve the lookup from a fresh on-disk index when one covers a key column
+    char *result = NULL;
+    int indexed = read_record_indexed(filename, specs, num_keys, &result);
+    if (indexed < 0)
         return NULL;
+    if (indexed)
+    {
+        if (!result)
+            set_error(DATA_ERROR_RECORD_NOT_FOUND, "Record not found with specified primary key(s)");
+        return result;
     }
 
     FILE *fp = fopen(filename, "r");
@@ -159,8 +270,6 @@ char *read_record(const char *filename, char *primary_keys[], int num_keys)
     }
 
     char line[MAX_LINE_LENGTH];
-    char *result = NULL;
-    char *fields[MAX_FIELDS];
     int line_number = 0;
 
     // Read the header first
@@ -184,283 +293,386 @@ char *read_record(const char *filename, char *primary_keys[], int num_keys)
             continue;
         }
 
-        char line_copy[MAX_LINE_LENGTH];
-        strncpy(line_copy, line, sizeof(line_copy) - 1);
-        line_copy[sizeof(line_copy) - 1] = '\0';
-
-        // Split the line into fields (allocated)
-        int field_count = split_csv_fields(line, fields, MAX_FIELDS, ',');
-        if (field_count <= 0)
-            continue;
-
-        // Check if this line matches all primary keys
-        int found = 1;
-        for (int j = 0; j < num_keys && found; j++)
-        {
-            char key_copy[MAX_LINE_LENGTH];
-            strncpy(key_copy, primary_keys[j], sizeof(key_copy) - 1);
-            key_copy[sizeof(key_copy) - 1] = '\0';
-
-            char *index_str = strtok(key_copy, ":");
-            char *value = strtok(NULL, ":");
-
-            if (!index_str || !value)
-            {
-                set_error_message("Error: Invalid primary key format in '%s'", primary_keys[j]);
-                fclose(fp);
-                return NULL;
-            }
-
-            int index = atoi(index_str);
-            if (index < 0 || index >= field_count)
-            {
-                set_error_message("Error: Field index %d out of range (0-%d) at line %d", index, field_count - 1, line_number);
-                found = 0;
-                break;
-            }
-
-            if (strcmp(fields[index], value) != 0)
-            {
-                found = 0;
-            }
-        }
-
-        if (found)
+        if (line_matches_specs(line, specs, num_keys))
         {
             // Duplicate the line safely
-            char *dup = strdup(line_copy);
-            if (!dup)
+            result = strdup(line);
+            if (!result)
             {
-                set_error_message("Error: Memory allocation failed for record duplication");
+                set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for record duplication");
                 fclose(fp);
-                // free allocated fields
-                for (int f = 0; f < field_count; f++)
-                    free(fields[f]);
                 return NULL;
             }
-            result = dup;
-            // free allocated fields before break
-            for (int f = 0; f < field_count; f++)
-                free(fields[f]);
             break;
         }
-        // free allocated fields for this line
-        for (int f = 0; f < field_count; f++)
-            free(fields[f]);
     }
 
     fclose(fp);
 
     if (!result)
     {
-        set_error_message("Record not found with specified primary key(s)");
+        set_error(DATA_ERROR_RECORD_NOT_FOUND, "Record not found with specified primary key(s)");
     }
 
     return result;
 }
 
-// Enhanced update record with comprehensive validation and error handling
-int update_record(const char *filename, char *primary_keys[], int num_keys, const char *field_to_update)
+// read_record_specs_locked under a shared lock, so no append or rewrite is half done
+static char *read_record_specs(const char *filename, const field_spec_t specs[], int num_keys)
+{
+    csv_lock_t lock;
+    if (csv_lock_acquire(&lock, filename, 0) != DATA_SUCCESS)
+        return NULL;
+    char *result = read_record_specs_locked(filename, specs, num_keys);
+    csv_lock_release(&lock);
+    return result;
+}
+
+// Enhanced read record with improved error handling
+char *read_record(const char *filename, char *primary_keys[], int num_keys)
 {
-    // Input validation
     if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) ||
-        !primary_keys || num_keys <= 0 ||
-        !validate_string_input(field_to_update, "field_to_update", MAX_LINE_LENGTH))
+        !primary_keys || num_keys <= 0)
     {
-        return DATA_ERROR_INVALID_INPUT;
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: Invalid parameters for read_record");
+        return NULL;
     }
 
-    // Validate field_to_update format
-    if (!strchr(field_to_update, ':'))
+    // Validate all primary keys
+    for (int i = 0; i < num_keys; i++)
     {
-        set_error_message("Error: field_to_update must be in format 'field_index:new_value'");
-        return DATA_ERROR_INVALID_INPUT;
+        if (!validate_string_input(primary_keys[i], "primary_key", MAX_LINE_LENGTH))
+        {
+            return NULL;
+        }
+
+        // Validate primary key format
+        if (!strchr(primary_keys[i], ':'))
+        {
+            set_error_message("Error: Primary key '%s' must be in format 'field_index:value'", primary_keys[i]);
+            return NULL;
+        }
     }
 
     if (!validate_file_access(filename, "r"))
     {
-        return DATA_ERROR_FILE_NOT_FOUND;
+        return NULL;
     }
 
-    FILE *fp = fopen(filename, "r");
-    if (!fp)
+    // Keys are parsed once; rows are then matched without allocating
+    field_spec_t *specs = malloc((size_t)num_keys * sizeof(*specs));
+    if (!specs)
     {
-        set_error_message("Error: Cannot open file '%s' for reading: %s", filename, strerror(errno));
-        return DATA_ERROR_FILE_NOT_FOUND;
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for primary keys");
+        return NULL;
+    }
+    char *result = NULL;
+    if (parse_key_specs(primary_keys, num_keys, specs) == DATA_SUCCESS)
+    {
+        result = read_record_specs(filename, specs, num_keys);
+        free_key_specs(specs, num_keys);
+    }
+    free(specs);
+    return result;
+}
+
+static void free_bulk_ops(bulk_op_t *parsed, const record_update_t ops[], int num_ops)
+{
+    for (int i = 0; i < num_ops; i++)
+    {
+        for (int k = 0; parsed[i].keys && k < ops[i].num_keys; k++)
+            free(parsed[i].keys[k].value);
+        for (int k = 0; parsed[i].sets && k < ops[i].num_assignments; k++)
+            free(parsed[i].sets[k].value);
+        free(parsed[i].keys);
+        free(parsed[i].sets);
     }
+    free(parsed);
+}
 
-    char *content = malloc(MAX_FILE_SIZE);
-    if (!content)
+// FNV-1a over a key value
+static unsigned int bulk_key_hash(const char *s, size_t len)
+{
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+// bulk_key_hash of a field's value (escaped quotes undone)
+static unsigned int span_key_hash(const csv_span_t *field)
+{
+    if (field->quoting != CSV_SPAN_ESCAPED)
+        return bulk_key_hash(field->ptr, field->len);
+    char value[MAX_LINE_LENGTH];
+    return bulk_key_hash(value, csv_span_copy(field, value, sizeof(value)));
+}
+
+static int compare_op_index(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int update_records_bulk(const char *filename, record_update_t ops[], int num_ops)
+{
+    // Input validation
+    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) || !ops || num_ops <= 0)
     {
-        set_error_message("Error: Memory allocation failed for file content buffer");
-        fclose(fp);
+        if (!ops || num_ops <= 0)
+            set_error(DATA_ERROR_INVALID_INPUT, "Error: update_records_bulk needs at least one op");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    for (int i = 0; i < num_ops; i++)
+        ops[i].status = DATA_ERROR_RECORD_NOT_FOUND;
+
+    // Parse every op up front so a bad spec fails before the file is touched
+    bulk_op_t *parsed = calloc((size_t)num_ops, sizeof(*parsed));
+    if (!parsed)
+    {
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for bulk update");
         return DATA_ERROR_MEMORY_ALLOCATION;
     }
-    content[0] = '\0';
-    size_t content_len = 0;
+    for (int i = 0; i < num_ops; i++)
+    {
+        record_update_t *op = &ops[i];
+        if (!op->primary_keys || op->num_keys <= 0 || !op->assignments || op->num_assignments <= 0)
+        {
+            set_error_message("Error: Bulk update op %d needs primary keys and assignments", i);
+            op->status = DATA_ERROR_INVALID_INPUT;
+            free_bulk_ops(parsed, ops, num_ops);
+            return DATA_ERROR_INVALID_INPUT;
+        }
+        parsed[i].keys = calloc((size_t)op->num_keys, sizeof(field_spec_t));
+        parsed[i].sets = calloc((size_t)op->num_assignments, sizeof(field_spec_t));
+        if (!parsed[i].keys || !parsed[i].sets)
+        {
+            set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for bulk update");
+            free_bulk_ops(parsed, ops, num_ops);
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        }
+        int rc = DATA_SUCCESS;
+        for (int k = 0; k < op->num_keys && rc == DATA_SUCCESS; k++)
+            rc = parse_field_spec(op->primary_keys[k], &parsed[i].keys[k]);
+        for (int k = 0; k < op->num_assignments && rc == DATA_SUCCESS; k++)
+            rc = parse_field_spec(op->assignments[k], &parsed[i].sets[k]);
+        if (rc != DATA_SUCCESS)
+        {
+            if (rc == DATA_ERROR_INVALID_INPUT)
+                set_error_message("Error: Bulk update op %d must use 'field_index:value' specs", i);
+            else
+                set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for bulk update");
+            op->status = rc;
+            free_bulk_ops(parsed, ops, num_ops);
+            return rc;
+        }
+    }
 
-    char line[MAX_LINE_LENGTH];
-    int record_updated = 0;
-    int line_number = 0;
+    // Hash every op on its first key so each row costs O(1) lookups instead of
+    // a comparison against all ops
+    size_t capacity = 16;
+    while (capacity < (size_t)num_ops * 2)
+        capacity <<= 1;
+    int *slots = malloc(capacity * sizeof(int));
+    int *matched = malloc((size_t)num_ops * sizeof(int));
+    char *applied = calloc((size_t)num_ops, 1);
+    if (!slots || !matched || !applied)
+    {
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for bulk update");
+        free(slots);
+        free(matched);
+        free(applied);
+        free_bulk_ops(parsed, ops, num_ops);
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    for (size_t s = 0; s < capacity; s++)
+        slots[s] = -1;
 
-    // Read and copy header
-    if (!fgets(line, sizeof(line), fp))
+    int lead_fields[MAX_FIELDS] = {0};
+    for (int i = 0; i < num_ops; i++)
     {
-        set_error_message("Error: Cannot read header from file '%s'", filename);
-        free(content);
-        fclose(fp);
-        return DATA_ERROR_MALFORMED_DATA;
+        const field_spec_t *lead = &parsed[i].keys[0];
+        if (lead->index >= MAX_FIELDS)
+            continue; // rows never have that many fields: stays not found
+        lead_fields[lead->index] = 1;
+        size_t s = bulk_key_hash(lead->value, strlen(lead->value)) & (capacity - 1);
+        while (slots[s] >= 0)
+            s = (s + 1) & (capacity - 1);
+        slots[s] = i;
     }
 
-    if (!append_to_buffer(content, &content_len, line))
+    int result = DATA_SUCCESS;
+    FILE *fp = NULL;
+    csv_rewrite_t rw;
+    int rewriting = 0;
+
+    if (!validate_file_access(filename, "r"))
     {
-        free(content);
-        fclose(fp);
-        return DATA_ERROR_BUFFER_OVERFLOW;
+        result = DATA_ERROR_FILE_NOT_FOUND;
+        goto done;
     }
-    line_number++;
 
-    // Parse field_to_update
-    char field_copy[MAX_LINE_LENGTH];
-    strncpy(field_copy, field_to_update, sizeof(field_copy) - 1);
-    field_copy[sizeof(field_copy) - 1] = '\0';
+    // Stream the new file next to the original; it replaces it on commit.
+    // The original is read under the rewrite's lock so no append is lost.
+    result = csv_rewrite_begin(&rw, filename);
+    if (result != DATA_SUCCESS)
+        goto done;
+    rewriting = 1;
 
-    char *index_str = strtok(field_copy, ":");
-    char *new_value = strtok(NULL, ":");
-    if (!index_str || !new_value)
+    fp = fopen(filename, "r");
+    if (!fp)
     {
-        set_error_message("Error: Invalid field_to_update format");
-        free(content);
-        fclose(fp);
-        return DATA_ERROR_INVALID_INPUT;
+        set_error_message("Error: Cannot open file '%s' for reading: %s", filename, strerror(errno));
+        result = DATA_ERROR_FILE_NOT_FOUND;
+        goto done;
     }
 
-    int update_index = atoi(index_str);
-    if (update_index < 0)
+    char line[MAX_LINE_LENGTH];
+
+    // Read header
+    if (!fgets(line, sizeof(line), fp))
     {
-        set_error_message("Error: Field index must be non-negative");
-        free(content);
-        fclose(fp);
-        return DATA_ERROR_INVALID_INPUT;
+        set_error_message("Error: Cannot read header from file '%s'", filename);
+        result = DATA_ERROR_MALFORMED_DATA;
+        goto done;
     }
+    csv_rewrite_write(&rw, line);
+
+    int any_applied = 0;
 
     // Process each data line
     while (fgets(line, sizeof(line), fp))
     {
-        line_number++;
-
-        char line_copy[MAX_LINE_LENGTH];
-        strncpy(line_copy, line, sizeof(line_copy) - 1);
-        line_copy[sizeof(line_copy) - 1] = '\0';
-
-        // Parse fields using shared helper
-        char *fields[MAX_FIELDS];
-        int field_count = split_csv_fields(line, fields, MAX_FIELDS, ',');
+        csv_span_t fields[MAX_FIELDS];
+        int field_count = csv_split_spans(line, strlen(line), ',', fields, MAX_FIELDS);
         if (field_count <= 0)
         {
             // keep original line if cannot parse
-            if (!append_to_buffer(content, &content_len, line_copy))
-            {
-                free(content);
-                fclose(fp);
-                return DATA_ERROR_BUFFER_OVERFLOW;
-            }
+            csv_rewrite_write(&rw, line);
             continue;
         }
 
-        // Check if this matches our primary keys
-        int found = 1;
-        for (int j = 0; j < num_keys && found; j++)
+        // Gather the ops whose keys all match this row
+        int num_matched = 0;
+        for (int f = 0; f < field_count; f++)
         {
-            char key_copy[MAX_LINE_LENGTH];
-            strncpy(key_copy, primary_keys[j], sizeof(key_copy) - 1);
-            key_copy[sizeof(key_copy) - 1] = '\0';
-
-            char *idx_str = strtok(key_copy, ":");
-            char *value = strtok(NULL, ":");
-
-            if (!idx_str || !value)
-            {
-                found = 0;
-                break;
-            }
-
-            int index = atoi(idx_str);
-            if (index >= field_count || strcmp(fields[index], value) != 0)
+            if (!lead_fields[f])
+                continue;
+            for (size_t s = span_key_hash(&fields[f]) & (capacity - 1); slots[s] >= 0;
+                 s = (s + 1) & (capacity - 1))
             {
-                found = 0;
+                int i = slots[s];
+                if (parsed[i].keys[0].index != f || !csv_span_eq(&fields[f], parsed[i].keys[0].value))
+                    continue;
+                if (fields_match_specs(fields, field_count, parsed[i].keys + 1, ops[i].num_keys - 1))
+                    matched[num_matched++] = i;
             }
         }
 
-        if (found)
+        if (num_matched == 0)
         {
-            // Validate update index
-            if (update_index >= field_count)
-            {
-                set_error_message("Error: Update field index %d out of range (0-%d)", update_index, field_count - 1);
-                free(content);
-                fclose(fp);
-                for (int f = 0; f < field_count; f++)
-                    free(fields[f]);
-                return DATA_ERROR_INVALID_INPUT;
-            }
+            csv_rewrite_write(&rw, line);
+            continue;
+        }
+
+        // Apply in op order so a later op wins when two touch the same field
+        if (num_matched > 1)
+            qsort(matched, (size_t)num_matched, sizeof(int), compare_op_index);
 
-            // Construct updated line
-            char updated_line[MAX_LINE_LENGTH] = "";
-            for (int i = 0; i < field_count; i++)
+        // Assignments replace field views; untouched fields point into line
+        csv_span_t out[MAX_FIELDS];
+        for (int f = 0; f < field_count; f++)
+            out[f] = fields[f];
+        for (int m = 0; m < num_matched && result == DATA_SUCCESS; m++)
+        {
+            int i = matched[m];
+            for (int k = 0; k < ops[i].num_assignments; k++)
             {
-                if (i > 0)
-                    strcat(updated_line, ", ");
-                if (i == update_index)
-                {
-                    strcat(updated_line, new_value);
-                }
-                else
+                const field_spec_t *set = &parsed[i].sets[k];
+                if (set->index >= field_count)
                 {
-                    strcat(updated_line, fields[i]);
+                    set_error_message("Error: Update field index %d out of range (0-%d)", set->index, field_count - 1);
+                    ops[i].status = DATA_ERROR_INVALID_INPUT;
+                    result = DATA_ERROR_INVALID_INPUT;
+                    break;
                 }
+                out[set->index].ptr = set->value;
+                out[set->index].len = strlen(set->value);
+                out[set->index].quoting = CSV_SPAN_PLAIN;
             }
-            strcat(updated_line, "\n");
+            applied[i] = 1;
+        }
 
-            if (!append_to_buffer(content, &content_len, updated_line))
+        if (result == DATA_SUCCESS)
+        {
+            // Write the updated line field by field
+            for (int f = 0; f < field_count; f++)
             {
-                free(content);
-                fclose(fp);
-                for (int f = 0; f < field_count; f++)
-                    free(fields[f]);
-                return DATA_ERROR_BUFFER_OVERFLOW;
+                if (f > 0)
+                    csv_rewrite_write(&rw, ", ");
+                csv_rewrite_write_span(&rw, &out[f]);
             }
-            record_updated = 1;
+            csv_rewrite_write(&rw, "\n");
+            any_applied = 1;
         }
-        else
+        if (result != DATA_SUCCESS)
+            goto done;
+    }
+
+    if (!any_applied)
+    {
+        set_error(DATA_ERROR_RECORD_NOT_FOUND, "Record not found for update");
+        result = DATA_ERROR_RECORD_NOT_FOUND;
+        goto done;
+    }
+
+    // Swap the new file in (fails if any write above failed)
+    result = csv_rewrite_commit(&rw);
+    rewriting = 0;
+    if (result == DATA_SUCCESS)
+    {
+        for (int i = 0; i < num_ops; i++)
         {
-            if (!append_to_buffer(content, &content_len, line_copy))
-            {
-                free(content);
-                fclose(fp);
-                for (int f = 0; f < field_count; f++)
-                    free(fields[f]);
-                return DATA_ERROR_BUFFER_OVERFLOW;
-            }
+            if (applied[i])
+                ops[i].status = DATA_SUCCESS;
         }
-        for (int f = 0; f < field_count; f++)
-            free(fields[f]);
     }
 
-    fclose(fp);
+done:
+    if (rewriting)
+        csv_rewrite_abort(&rw);
+    if (fp)
+        fclose(fp);
+    free(slots);
+    free(matched);
+    free(applied);
+    free_bulk_ops(parsed, ops, num_ops);
+    return result;
+}
 
-    if (!record_updated)
+// Enhanced update record with comprehensive validation and error handling
+int update_record(const char *filename, char *primary_keys[], int num_keys, const char *field_to_update)
+{
+    // Input validation
+    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH) ||
+        !primary_keys || num_keys <= 0 ||
+        !validate_string_input(field_to_update, "field_to_update", MAX_LINE_LENGTH))
     {
-        set_error_message("Record not found for update");
-        free(content);
-        return DATA_ERROR_RECORD_NOT_FOUND;
+        return DATA_ERROR_INVALID_INPUT;
     }
 
-    // Write updated content back
-    int result = overwrite_file(filename, content);
-    free(content);
+    // Validate field_to_update format
+    if (!strchr(field_to_update, ':'))
+    {
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: field_to_update must be in format 'field_index:new_value'");
+        return DATA_ERROR_INVALID_INPUT;
+    }
 
-    return result;
+    // A single-op bulk update: one pass, one rewrite
+    const char *assignments[] = {field_to_update};
+    record_update_t op = {primary_keys, num_keys, assignments, 1, 0};
+    return update_records_bulk(filename, &op, 1);
 }
 
 // Enhanced delete record with comprehensive validation
@@ -493,86 +705,60 @@ int delete_record(const char *filename, char *primary_keys[], int num_keys)
         return DATA_ERROR_FILE_NOT_FOUND;
     }
 
+    field_spec_t *specs = malloc((size_t)num_keys * sizeof(*specs));
+    if (!specs)
+    {
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for primary keys");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    int rc = parse_key_specs(primary_keys, num_keys, specs);
+    if (rc != DATA_SUCCESS)
+    {
+        free(specs);
+        return rc;
+    }
+
+    // Stream the new file next to the original; it replaces it on commit.
+    // The original is read under the rewrite's lock so no append is lost.
+    csv_rewrite_t rw;
+    rc = csv_rewrite_begin(&rw, filename);
+    if (rc != DATA_SUCCESS)
+    {
+        free_key_specs(specs, num_keys);
+        free(specs);
+        return rc;
+    }
+
     FILE *fp = fopen(filename, "r");
     if (!fp)
     {
         set_error_message("Error: Cannot open file '%s' for reading: %s", filename, strerror(errno));
+        csv_rewrite_abort(&rw);
+        free_key_specs(specs, num_keys);
+        free(specs);
         return DATA_ERROR_FILE_NOT_FOUND;
     }
 
-    char *content = malloc(MAX_FILE_SIZE);
-    if (!content)
-    {
-        set_error_message("Error: Memory allocation failed for file content buffer");
-        fclose(fp);
-        return DATA_ERROR_MEMORY_ALLOCATION;
-    }
-    content[0] = '\0';
-    size_t content_len = 0;
-
     char line[MAX_LINE_LENGTH];
-    int record_deleted = 0;
-    int line_number = 0;
 
-    // Read and copy header
+    // Read header
     if (!fgets(line, sizeof(line), fp))
     {
         set_error_message("Error: Cannot read header from file '%s'", filename);
-        free(content);
         fclose(fp);
+        csv_rewrite_abort(&rw);
+        free_key_specs(specs, num_keys);
+        free(specs);
         return DATA_ERROR_MALFORMED_DATA;
     }
+    csv_rewrite_write(&rw, line);
 
-    strcat(content, line);
-    line_number++;
+    int record_deleted = 0;
 
     // Process each data line
     while (fgets(line, sizeof(line), fp))
     {
-        line_number++;
-
-        char line_copy[MAX_LINE_LENGTH];
-        strncpy(line_copy, line, sizeof(line_copy) - 1);
-        line_copy[sizeof(line_copy) - 1] = '\0';
-
-        char *fields[MAX_FIELDS];
-        int field_count = split_csv_fields(line, fields, MAX_FIELDS, ',');
-        if (field_count <= 0)
-        {
-            if (!append_to_buffer(content, &content_len, line_copy))
-            {
-                free(content);
-                fclose(fp);
-                return DATA_ERROR_BUFFER_OVERFLOW;
-            }
-            continue;
-        }
-
-        // Check if this matches our primary keys
-        int found = 1;
-        for (int j = 0; j < num_keys && found; j++)
-        {
-            char key_copy[MAX_LINE_LENGTH];
-            strncpy(key_copy, primary_keys[j], sizeof(key_copy) - 1);
-            key_copy[sizeof(key_copy) - 1] = '\0';
-
-            char *idx_str = strtok(key_copy, ":");
-            char *value = strtok(NULL, ":");
-
-            if (!idx_str || !value)
-            {
-                found = 0;
-                break;
-            }
-
-            int index = atoi(idx_str);
-            if (index >= field_count || strcmp(fields[index], value) != 0)
-            {
-                found = 0;
-            }
-        }
-
-        if (found)
+        if (line_matches_specs(line, specs, num_keys))
         {
             // Skip this line (delete it)
             record_deleted = 1;
@@ -580,33 +766,53 @@ int delete_record(const char *filename, char *primary_keys[], int num_keys)
         else
         {
             // Keep this line
-            if (!append_to_buffer(content, &content_len, line_copy))
-            {
-                free(content);
-                fclose(fp);
-                for (int f = 0; f < field_count; f++)
-                    free(fields[f]);
-                return DATA_ERROR_BUFFER_OVERFLOW;
-            }
+            csv_rewrite_write(&rw, line);
         }
-        for (int f = 0; f < field_count; f++)
-            free(fields[f]);
     }
 
     fclose(fp);
+    free_key_specs(specs, num_keys);
+    free(specs);
 
     if (!record_deleted)
     {
-        set_error_message("Record not found for deletion");
-        free(content);
+        set_error(DATA_ERROR_RECORD_NOT_FOUND, "Record not found for deletion");
+        csv_rewrite_abort(&rw);
         return DATA_ERROR_RECORD_NOT_FOUND;
     }
 
-    // Write updated content back
-    int result = overwrite_file(filename, content);
-    free(content);
+    // Swap the new file in (fails if any write above failed)
+    return csv_rewrite_commit(&rw);
+}
+
+/* ==== Lookup Indexes ==== */
 
-    return result;
+int create_index(const char *filename, int field_index)
+{
+    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH))
+        return DATA_ERROR_INVALID_INPUT;
+    if (field_index < 0 || field_index >= MAX_FIELDS)
+    {
+        set_error_message("Error: Field index %d out of range (0-%d)", field_index, MAX_FIELDS - 1);
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    if (!validate_file_access(filename, "r"))
+        return DATA_ERROR_FILE_NOT_FOUND;
+
+    return record_index_build(filename, field_index);
+}
+
+int drop_index(const char *filename, int field_index)
+{
+    if (!validate_string_input(filename, "filename", MAX_LINE_LENGTH))
+        return DATA_ERROR_INVALID_INPUT;
+    if (field_index < 0 || field_index >= MAX_FIELDS)
+    {
+        set_error_message("Error: Field index %d out of range (0-%d)", field_index, MAX_FIELDS - 1);
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    return record_index_drop(filename, field_index);
 }
 
 /* ==== Enhanced Entity-Specific CRUD Functions ==== */
@@ -625,12 +831,12 @@ int create_candidate(const char *candidate_number, const char *name, const char
     }
 
     char record[MAX_LINE_LENGTH];
-    int result = snprintf(record, sizeof(record), "%s, %s, %s, %s, %s",
-                          candidate_number, name, party_id, district_id, nic);
+    const char *values[] = {candidate_number, name, party_id, district_id, nic};
+    int result = csv_format_row(record, sizeof(record), values, 5);
 
     if (result >= (int)sizeof(record))
     {
-        set_error_message("Error: Candidate record exceeds maximum length");
+        set_error(DATA_ERROR_BUFFER_OVERFLOW, "Error: Candidate record exceeds maximum length");
         return DATA_ERROR_BUFFER_OVERFLOW;
     }
 
@@ -660,7 +866,7 @@ int update_candidate(const char *candidate_number, int field_index, const char *
 
     if (field_index < 0 || field_index > 4)
     {
-        set_error_message("Error: Field index must be between 0 and 4 for candidates");
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: Field index must be between 0 and 4 for candidates");
         return DATA_ERROR_INVALID_INPUT;
     }
 
@@ -699,12 +905,12 @@ int create_voter(const char *voting_number, const char *name, const char *nic, c
     }
 
     char record[MAX_LINE_LENGTH];
-    int result = snprintf(record, sizeof(record), "%s, %s, %s, %s",
-                          voting_number, name, nic, district_id);
+    const char *values[] = {voting_number, name, nic, district_id};
+    int result = csv_format_row(record, sizeof(record), values, 4);
 
     if (result >= (int)sizeof(record))
     {
-        set_error_message("Error: Voter record exceeds maximum length");
+        set_error(DATA_ERROR_BUFFER_OVERFLOW, "Error: Voter record exceeds maximum length");
         return DATA_ERROR_BUFFER_OVERFLOW;
     }
 
@@ -734,7 +940,7 @@ int update_voter(const char *voting_number, int field_index, const char *new_val
 
     if (field_index < 0 || field_index > 3)
     {
-        set_error_message("Error: Field index must be between 0 and 3 for voters");
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: Field index must be between 0 and 3 for voters");
         return DATA_ERROR_INVALID_INPUT;
     }
 
@@ -771,11 +977,12 @@ int create_party(const char *party_id, const char *party_name)
     }
 
     char record[MAX_LINE_LENGTH];
-    int result = snprintf(record, sizeof(record), "%s, %s", party_id, party_name);
+    const char *values[] = {party_id, party_name};
+    int result = csv_format_row(record, sizeof(record), values, 2);
 
     if (result >= (int)sizeof(record))
     {
-        set_error_message("Error: Party record exceeds maximum length");
+        set_error(DATA_ERROR_BUFFER_OVERFLOW, "Error: Party record exceeds maximum length");
         return DATA_ERROR_BUFFER_OVERFLOW;
     }
 
@@ -836,11 +1043,12 @@ int create_district(const char *district_id, const char *district_name)
     }
 
     char record[MAX_LINE_LENGTH];
-    int result = snprintf(record, sizeof(record), "%s, %s", district_id, district_name);
+    const char *values[] = {district_id, district_name};
+    int result = csv_format_row(record, sizeof(record), values, 2);
 
     if (result >= (int)sizeof(record))
     {
-        set_error_message("Error: District record exceeds maximum length");
+        set_error(DATA_ERROR_BUFFER_OVERFLOW, "Error: District record exceeds maximum length");
         return DATA_ERROR_BUFFER_OVERFLOW;
     }
 
@@ -901,11 +1109,12 @@ int create_parliament_candidate(const char *candidate_number, const char *party_
     }
 
     char record[MAX_LINE_LENGTH];
-    int result = snprintf(record, sizeof(record), "%s, %s", candidate_number, party_id);
+    const char *values[] = {candidate_number, party_id};
+    int result = csv_format_row(record, sizeof(record), values, 2);
 
     if (result >= (int)sizeof(record))
     {
-        set_error_message("Error: Parliament candidate record exceeds maximum length");
+        set_error(DATA_ERROR_BUFFER_OVERFLOW, "Error: Parliament candidate record exceeds maximum length");
         return DATA_ERROR_BUFFER_OVERFLOW;
     }
 
@@ -960,17 +1169,17 @@ int create_voter_count(const char *voting_number, const char *candidate_number,
     long count_value = strtol(count, &endptr, 10);
     if (*endptr != '\0' || count_value < 0)
     {
-        set_error_message("Error: Count must be a non-negative integer");
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: Count must be a non-negative integer");
         return DATA_ERROR_INVALID_INPUT;
     }
 
     char record[MAX_LINE_LENGTH];
-    int result = snprintf(record, sizeof(record), "%s, %s, %s, %s, %s",
-                          voting_number, candidate_number, party_id, district_id, count);
+    const char *values[] = {voting_number, candidate_number, party_id, district_id, count};
+    int result = csv_format_row(record, sizeof(record), values, 5);
 
     if (result >= (int)sizeof(record))
     {
-        set_error_message("Error: Voter count record exceeds maximum length");
+        set_error(DATA_ERROR_BUFFER_OVERFLOW, "Error: Voter count record exceeds maximum length");
         return DATA_ERROR_BUFFER_OVERFLOW;
     }
 
@@ -1014,7 +1223,7 @@ int update_voter_count(const char *voting_number, const char *candidate_number,
     long count_value = strtol(new_count, &endptr, 10);
     if (*endptr != '\0' || count_value < 0)
     {
-        set_error_message("Error: New count must be a non-negative integer");
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: New count must be a non-negative integer");
         return DATA_ERROR_INVALID_INPUT;
     }
 
@@ -1103,31 +1312,19 @@ int update_temp_voted(const char *voting_number, const char *candidate_number, c
         return DATA_ERROR_INVALID_INPUT;
     }
 
-    // Ensure record exists
-    char *existing = read_temp_voted(voting_number);
-    if (!existing)
-    {
-        // Propagate record not found for clarity
-        return DATA_ERROR_RECORD_NOT_FOUND;
-    }
-    free(existing);
-
     char key[MAX_LINE_LENGTH];
     snprintf(key, sizeof(key), "0:%s", voting_number);
     char *primary_keys[] = {key};
 
-    // Update candidate_number (field index 1)
+    // candidate_number (field 1) and party_id (field 2) in one rewrite
     char field_update1[MAX_LINE_LENGTH];
-    snprintf(field_update1, sizeof(field_update1), "1:%s", candidate_number);
-    int rc = update_record("data/temp-voted-list.txt", primary_keys, 1, field_update1);
-    if (rc != DATA_SUCCESS)
-        return rc;
-
-    // Update party_id (field index 2)
     char field_update2[MAX_LINE_LENGTH];
+    snprintf(field_update1, sizeof(field_update1), "1:%s", candidate_number);
     snprintf(field_update2, sizeof(field_update2), "2:%s", party_id);
-    rc = update_record("data/temp-voted-list.txt", primary_keys, 1, field_update2);
-    return rc;
+    const char *assignments[] = {field_update1, field_update2};
+
+    record_update_t op = {primary_keys, 1, assignments, 2, 0};
+    return update_records_bulk("data/temp-voted-list.txt", &op, 1);
 }
 
 int clear_temp_voted(void)
@@ -1146,30 +1343,44 @@ int create_temp_voted(const char *voting_number, const char *candidate_number, c
         return DATA_ERROR_INVALID_INPUT;
     }
 
-    int rc = ensure_temp_voted_header();
-    if (rc != DATA_SUCCESS)
-        return rc;
-
     char record[MAX_LINE_LENGTH];
     int n = snprintf(record, sizeof(record), "%s,%s,%s", voting_number, candidate_number, party_id);
     if (n <= 0 || n >= (int)sizeof(record))
     {
-        set_error_message("Error: temp voted record exceeds maximum length");
+        set_error(DATA_ERROR_BUFFER_OVERFLOW, "Error: temp voted record exceeds maximum length");
         return DATA_ERROR_BUFFER_OVERFLOW;
     }
-    return append_line("data/temp-voted-list.txt", record);
+
+    // Check and record under one lock so two booths cannot both add the voter
+    csv_lock_t lock;
+    int rc = csv_lock_acquire(&lock, "data/temp-voted-list.txt", 1);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    rc = ensure_temp_voted_header();
+    if (rc == DATA_SUCCESS)
+    {
+        char *existing = read_temp_voted(voting_number);
+        if (existing)
+        {
+            free(existing);
+            set_error_arg(DATA_ERROR_DUPLICATE_RECORD, "Voter '%s' has already voted", voting_number);
+            rc = DATA_ERROR_DUPLICATE_RECORD;
+        }
+    }
+    if (rc == DATA_SUCCESS)
+        rc = append_line("data/temp-voted-list.txt", record);
+    csv_lock_release(&lock);
+    return rc;
 }
 
-int read_all_temp_voted(char ****out_records, int *out_rows, int *out_cols)
+int read_temp_voted_table(temp_voted_table_t *table)
 {
-    if (!out_records || !out_rows || !out_cols)
+    if (!table)
     {
         return DATA_ERROR_INVALID_INPUT;
     }
-
-    *out_records = NULL;
-    *out_rows = 0;
-    *out_cols = 0;
+    memset(table, 0, sizeof(*table));
+    table->cols = TEMP_VOTED_COLS;
 
     const char *path = "data/temp-voted-list.txt";
     if (!validate_file_access(path, "r"))
@@ -1177,159 +1388,171 @@ int read_all_temp_voted(char ****out_records, int *out_rows, int *out_cols)
         return DATA_ERROR_FILE_NOT_FOUND;
     }
 
-    FILE *fp = fopen(path, "r");
+    // Shared lock only while the file is read; parsing works on our copy
+    csv_lock_t lock;
+    int rc = csv_lock_acquire(&lock, path, 0);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    FILE *fp = fopen(path, "rb");
     if (!fp)
     {
         set_error_message("Error: Cannot open file '%s' for reading: %s", path, strerror(errno));
+        csv_lock_release(&lock);
         return DATA_ERROR_FILE_NOT_FOUND;
     }
-
-    // Skip header
-    char line[MAX_LINE_LENGTH];
-    if (!fgets(line, sizeof(line), fp))
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 || (unsigned long long)st.st_size >= UINT32_MAX)
     {
-        // empty file: return success with zero rows, 3 cols
+        set_error_message("Error: Cannot size '%s' for loading", path);
         fclose(fp);
-        *out_cols = 3;
-        return DATA_SUCCESS;
+        csv_lock_release(&lock);
+        return DATA_ERROR_BUFFER_OVERFLOW;
     }
 
-    int capacity = 16;
-    int count = 0;
-    char ***rows = (char ***)malloc(sizeof(char **) * capacity);
-    if (!rows)
+    // Read the whole file into the start of the arena (+1 for a final NUL)
+    size_t size = (size_t)st.st_size;
+    char *arena = malloc(size + 1);
+    if (!arena)
     {
         fclose(fp);
+        csv_lock_release(&lock);
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for temp voted list");
         return DATA_ERROR_MEMORY_ALLOCATION;
     }
-
-    while (fgets(line, sizeof(line), fp))
+    size = fread(arena, 1, size, fp);
+    int read_failed = ferror(fp);
+    fclose(fp);
+    csv_lock_release(&lock);
+    if (read_failed)
     {
-        // Defensive copy
-        char line_copy[MAX_LINE_LENGTH];
-        strncpy(line_copy, line, sizeof(line_copy) - 1);
-        line_copy[sizeof(line_copy) - 1] = '\0';
-
-        // Parse CSV fields
-        char *fields[MAX_FIELDS];
-        int n = split_csv_fields(line_copy, fields, MAX_FIELDS, ',');
-        if (n < 3)
-        {
-            for (int i = 0; i < n; ++i)
-                free(fields[i]);
-            continue; // skip malformed lines silently
-        }
+        free(arena);
+        set_error_message("Error: Failed to read '%s'", path);
+        return DATA_ERROR_MALFORMED_DATA;
+    }
 
-        // Trim spaces
-        for (int i = 0; i < 3 && i < n; ++i)
+    // Append the offset/length columns, sized for one row per line
+    size_t max_cells = (csv_count_newlines(arena, size) + 1) * TEMP_VOTED_COLS;
+    size_t pool_size = (size + 1 + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+    char *grown = realloc(arena, pool_size + 2 * max_cells * sizeof(uint32_t));
+    if (!grown)
+    {
+        free(arena);
+        set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for temp voted list");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    arena = grown;
+    uint32_t *offsets = (uint32_t *)(arena + pool_size);
+    uint32_t *lengths = offsets + max_cells;
+
+    // Skip header, then turn every cell into a NUL-terminated string in place
+    char *end = arena + size;
+    char *p = memchr(arena, '\n', size);
+    p = p ? p + 1 : end;
+    int rows = 0;
+    while (p < end)
+    {
+        char *nl = memchr(p, '\n', (size_t)(end - p));
+        char *next = nl ? nl + 1 : end;
+        csv_span_t fields[TEMP_VOTED_COLS];
+        if (csv_split_spans(p, (size_t)((nl ? nl : end) - p), ',', fields, TEMP_VOTED_COLS) == TEMP_VOTED_COLS)
         {
-            if (fields[i])
+            for (int c = 0; c < TEMP_VOTED_COLS; c++)
             {
-                // trim leading/trailing spaces
-                char *s = fields[i];
-                // local trim
-                char *start = s;
-                while (*start == ' ' || *start == '\t' || *start == '\r' || *start == '\n')
-                    start++;
-                char *end = s + strlen(s);
-                while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
-                    end--;
-                size_t len = (size_t)(end - start);
-                if (start != s)
-                    memmove(s, start, len);
-                s[len] = '\0';
+                // Spans point into our own buffer, and a cell is always followed
+                // by a delimiter, quote, blank or terminator we may overwrite
+                char *cell = arena + (fields[c].ptr - arena);
+                size_t len = fields[c].len;
+                if (fields[c].quoting == CSV_SPAN_ESCAPED)
+                    len = csv_span_copy(&fields[c], cell, len + 1); // only ever shrinks
+                cell[len] = '\0';
+                offsets[rows * TEMP_VOTED_COLS + c] = (uint32_t)(cell - arena);
+                lengths[rows * TEMP_VOTED_COLS + c] = (uint32_t)len;
             }
+            rows++;
         }
+        // malformed lines are skipped silently
+        p = next;
+    }
 
-        // Ensure capacity
-        if (count >= capacity)
-        {
-            int newcap = capacity * 2;
-            char ***tmp = (char ***)realloc(rows, sizeof(char **) * newcap);
-            if (!tmp)
-            {
-                // cleanup and bail out
-                for (int r = 0; r < count; ++r)
-                {
-                    for (int c = 0; c < 3; ++c)
-                        free(rows[r][c]);
-                    free(rows[r]);
-                }
-                free(rows);
-                for (int i = 0; i < n; ++i)
-                    free(fields[i]);
-                fclose(fp);
-                return DATA_ERROR_MEMORY_ALLOCATION;
-            }
-            rows = tmp;
-            capacity = newcap;
-        }
+    table->rows = rows;
+    table->pool = arena;
+    table->offsets = offsets;
+    table->lengths = lengths;
+    table->arena = arena;
+    return DATA_SUCCESS;
+}
+
+const char *temp_voted_cell(const temp_voted_table_t *table, int row, int col)
+{
+    if (!table || row < 0 || row >= table->rows || col < 0 || col >= table->cols)
+        return NULL;
+    return table->pool + table->offsets[row * table->cols + col];
+}
 
-        // Create row with 3 columns (voting_number, candidate_number, party_id)
-        char **row = (char **)malloc(sizeof(char *) * 3);
-        if (!row)
+void free_temp_voted_table(temp_voted_table_t *table)
+{
+    if (!table)
+        return;
+    free(table->arena);
+    memset(table, 0, sizeof(*table));
+    table->cols = TEMP_VOTED_COLS;
+}
+
+int read_all_temp_voted(char ****out_records, int *out_rows, int *out_cols)
+{
+    if (!out_records || !out_rows || !out_cols)
+    {
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    *out_records = NULL;
+    *out_rows = 0;
+    *out_cols = 0;
+
+    temp_voted_table_t table;
+    int rc = read_temp_voted_table(&table);
+    if (rc != DATA_SUCCESS)
+        return rc;
+
+    size_t cells = (size_t)table.rows * TEMP_VOTED_COLS;
+    size_t chars = 0;
+    for (size_t i = 0; i < cells; i++)
+        chars += table.lengths[i] + 1;
+
+    // One block: row arrays, then cell pointers, then the strings
+    char ***rows = NULL;
+    if (table.rows > 0)
+    {
+        rows = malloc((size_t)table.rows * sizeof(char **) + cells * sizeof(char *) + chars);
+        if (!rows)
         {
-            for (int r = 0; r < count; ++r)
-            {
-                for (int c = 0; c < 3; ++c)
-                    free(rows[r][c]);
-                free(rows[r]);
-            }
-            free(rows);
-            for (int i = 0; i < n; ++i)
-                free(fields[i]);
-            fclose(fp);
+            free_temp_voted_table(&table);
+            set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for temp voted records");
             return DATA_ERROR_MEMORY_ALLOCATION;
         }
-
-        for (int c = 0; c < 3; ++c)
+        char **cell_ptrs = (char **)(rows + table.rows);
+        char *text = (char *)(cell_ptrs + cells);
+        for (size_t i = 0; i < cells; i++)
         {
-            row[c] = strdup(fields[c] ? fields[c] : "");
-            if (!row[c])
-            {
-                for (int k = 0; k < c; ++k)
-                    free(row[k]);
-                free(row);
-                for (int r = 0; r < count; ++r)
-                {
-                    for (int cc = 0; cc < 3; ++cc)
-                        free(rows[r][cc]);
-                    free(rows[r]);
-                }
-                free(rows);
-                for (int i = 0; i < n; ++i)
-                    free(fields[i]);
-                fclose(fp);
-                return DATA_ERROR_MEMORY_ALLOCATION;
-            }
+            memcpy(text, table.pool + table.offsets[i], table.lengths[i] + 1);
+            cell_ptrs[i] = text;
+            text += table.lengths[i] + 1;
         }
-
-        rows[count++] = row;
-        for (int i = 0; i < n; ++i)
-            free(fields[i]);
+        for (int r = 0; r < table.rows; r++)
+            rows[r] = cell_ptrs + (size_t)r * TEMP_VOTED_COLS;
     }
 
-    fclose(fp);
-
     *out_records = rows;
-    *out_rows = count;
-    *out_cols = 3;
+    *out_rows = table.rows;
+    *out_cols = TEMP_VOTED_COLS;
+    free_temp_voted_table(&table);
     return DATA_SUCCESS;
 }
 
 void free_temp_voted_records(char ***records, int rows, int cols)
 {
-    if (!records)
-        return;
-    (void)cols; // cols is 3, currently unused
-    for (int r = 0; r < rows; ++r)
-    {
-        if (records[r])
-        {
-            for (int c = 0; c < 3; ++c)
-                free(records[r][c]);
-            free(records[r]);
-        }
-    }
+    // read_all_temp_voted hands out a single block
+    (void)rows;
+    (void)cols;
     free(records);
 }
\ No newline at end of file
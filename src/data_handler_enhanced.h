@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include "data_errors.h"
 
 /* ==== Error Handling System (moved to data_errors.h) ==== */
@@ -10,7 +11,7 @@
 /* ==== Constants and Limits ==== */
 #define MAX_LINE_LENGTH 256
 #define MAX_FIELDS 20
-#define MAX_FILE_SIZE (MAX_LINE_LENGTH * 10000)
+#define MAX_FILE_SIZE (MAX_LINE_LENGTH * 10000) // legacy cap; rewrites now stream without it
 
 /* ==== File Operation Functions ==== */
 
@@ -44,16 +45,15 @@ int read_csv_line(FILE *fp, char *fields[], int max_fields, char delimiter);
 int append_line(const char *filename, const char *line);
 
 /**
- * Enhanced file overwrite with backup and recovery
+ * Enhanced file overwrite with atomic replacement
  * @param filename Path to file to overwrite
  * @param content New content for the file
  * @return DATA_SUCCESS on success, negative error code on failure
  *
  * Safety Features:
- * - Automatic backup creation
- * - Rollback on failure
- * - Size limit enforcement
- * - Permission validation
+ * - Content goes to a temp file in the same directory, fsynced, then renamed
+ * - The original stays intact if anything fails before the rename
+ * - Lookup indexes of the file are rebuilt afterwards
  */
 int overwrite_file(const char *filename, const char *content);
 
@@ -88,6 +88,39 @@ int create_record(const char *filename, const char *record);
  */
 char *read_record(const char *filename, char *primary_keys[], int num_keys);
 
+/**
+ * One change for update_records_bulk: the rows matching every primary key get
+ * every field assignment applied
+ */
+typedef struct
+{
+    char **primary_keys;       // "field_index:value" strings identifying the record
+    int num_keys;
+    const char **assignments;  // "field_index:new_value" strings to apply
+    int num_assignments;
+    int status;                // output: DATA_SUCCESS, DATA_ERROR_RECORD_NOT_FOUND,
+                               // or the error that stopped the batch
+} record_update_t;
+
+/**
+ * Apply many record updates in a single scan-and-rewrite of the file
+ * @param filename CSV file to update
+ * @param ops Updates to apply; each op's status is filled in
+ * @param num_ops Number of ops
+ * @return DATA_SUCCESS if at least one op matched and the file was rewritten,
+ *         DATA_ERROR_RECORD_NOT_FOUND if no op matched (file untouched),
+ *         negative error code on failure (file untouched)
+ *
+ * Behavior:
+ * - Ops that match no row are reported with DATA_ERROR_RECORD_NOT_FOUND and
+ *   do not stop the others
+ * - Ops are looked up by their first key, so the pass stays O(rows + ops)
+ * - When several ops match the same row they apply in array order
+ * - A malformed spec or an assignment past the end of a matched row aborts
+ *   the whole batch
+ */
+int update_records_bulk(const char *filename, record_update_t ops[], int num_ops);
+
 /**
  * Update a record with comprehensive validation and safety checks
  * @param filename CSV file to update
@@ -97,10 +130,10 @@ char *read_record(const char *filename, char *primary_keys[], int num_keys);
  * @return DATA_SUCCESS on success, negative error code on failure
  *
  * Safety Features:
- * - Backup and rollback capability
+ * - Single-op update_records_bulk: streams the file once into a temp file
+ *   that atomically replaces it (no file size limit, original untouched on failure)
  * - Field index validation
  * - Data integrity preservation
- * - Atomic update operations
  */
 int update_record(const char *filename, char *primary_keys[], int num_keys, const char *field_to_update);
 
@@ -113,11 +146,36 @@ int update_record(const char *filename, char *primary_keys[], int num_keys, cons
  *
  * Safety Features:
  * - Record existence verification
- * - Backup before deletion
+ * - Streams the file once into a temp file that atomically replaces it
  * - Data integrity preservation
  */
 int delete_record(const char *filename, char *primary_keys[], int num_keys);
 
+/* ==== Lookup Indexes ==== */
+
+/**
+ * Build a persistent lookup index on one column of a CSV data file
+ * @param filename CSV file to index (e.g. "data/approved_candidates.txt")
+ * @param field_index Column to index, numbered like "field_index:value" keys
+ * @return DATA_SUCCESS on success, negative error code on failure
+ *
+ * Behavior:
+ * - The index lives next to the file: <base>.idx for field 0,
+ *   <base>.<field_index>.idx otherwise (data/approved_candidates.2.idx)
+ * - read_record uses it automatically for keys on that column
+ * - create_record/update_record/delete_record keep it in sync
+ * - Calling it again rebuilds the index from scratch
+ */
+int create_index(const char *filename, int field_index);
+
+/**
+ * Remove a lookup index created with create_index
+ * @param filename CSV file the index belongs to
+ * @param field_index Indexed column
+ * @return DATA_SUCCESS on success, DATA_ERROR_FILE_NOT_FOUND if no such index
+ */
+int drop_index(const char *filename, int field_index);
+
 /* ==== Enhanced Entity-Specific CRUD Functions ==== */
 
 /* ---- Candidate Management Functions ---- */
@@ -371,26 +429,69 @@ int update_temp_voted(const char *voting_number, const char *candidate_number, c
 
 /**
  * Clear temp voted list (delete all data except header)
+ * Bypasses the vote journal: a committed batch not yet marked applied is
+ * replayed into the cleared list on the next open. Callers that cast
+ * through the journal use vote_journal_clear_temp_voted instead.
  * @return DATA_SUCCESS on success, negative error code on failure
  */
 int clear_temp_voted(void);
 
 /**
  * Create a temp voted entry (appends a new row). Header is created if missing.
+ * The duplicate check and the append happen under one exclusive lock on the
+ * list, so concurrent booths cannot both record the same voter.
  * @param voting_number Unique voter identifier
  * @param candidate_number Candidate identifier to set
  * @param party_id Party identifier to set
- * @return DATA_SUCCESS on success, negative error code on failure
+ * @return DATA_SUCCESS on success, DATA_ERROR_DUPLICATE_RECORD if the voter
+ *         is already listed, negative error code on failure
  */
 int create_temp_voted(const char *voting_number, const char *candidate_number, const char *party_id);
 
+// Columns of the temp voted list: voting_number, candidate_number, party_id
+#define TEMP_VOTED_COLS 3
+
+/**
+ * The temp voted list loaded into a single arena: the file is read once into
+ * a pool where each cell is NUL-terminated in place, followed by the offset
+ * and length columns. One free releases everything.
+ */
+typedef struct
+{
+    int rows;
+    int cols;                // TEMP_VOTED_COLS
+    const char *pool;        // cell strings
+    const uint32_t *offsets; // rows * cols cell offsets into pool, row-major
+    const uint32_t *lengths; // rows * cols cell lengths
+    void *arena;             // the one allocation behind all of the above
+} temp_voted_table_t;
+
+/**
+ * Load the temp voted list (malformed rows are skipped)
+ * @param table Output table; release with free_temp_voted_table
+ * @return DATA_SUCCESS on success, negative error code on failure
+ */
+int read_temp_voted_table(temp_voted_table_t *table);
+
+/**
+ * A cell of the table
+ * @return NUL-terminated cell, or NULL when row/col is out of range
+ */
+const char *temp_voted_cell(const temp_voted_table_t *table, int row, int col);
+
+/**
+ * Release a table (safe on a zeroed or already freed table)
+ */
+void free_temp_voted_table(temp_voted_table_t *table);
+
 /**
  * Read all temp voted entries as a 2D array of strings.
  * Output shape: rows x cols (cols will be 3: voting_number, candidate_number, party_id)
  * Example: records = {{"V0003","C001","P01"}, {"V0008","C211","P10"}}
+ * Compatibility wrapper over read_temp_voted_table; records is NULL when there are no rows.
  *
  * Ownership:
- *  - The function allocates the 2D array and the inner strings. Caller must free via
+ *  - The array and its strings are one allocation. Caller must free via
  *    free_temp_voted_records(records, rows, cols).
  *
  * @param out_records  Output pointer to 2D array [rows][cols] of null-terminated strings
@@ -428,9 +529,10 @@ SAFETY GUIDELINES FOR USING THESE FUNCTIONS:
    - CSV format validation is performed
 
 4. THREAD SAFETY:
-   - Functions are NOT thread-safe
-   - Use external synchronization for multi-threaded access
-   - Error messages are stored in global state
+   - Functions may be called from several threads at once
+   - Parsing keeps no state between calls (no strtok)
+   - Each thread has its own last error (get_last_error, get_last_error_code)
+   - Files are guarded by csv_lock_acquire against other threads and processes
 
 5. FILE SYSTEM REQUIREMENTS:
    - Ensure sufficient disk space before operations
@@ -461,7 +563,6 @@ BREAKING SCENARIOS:
 
 5. Will FAIL with DATA_ERROR_BUFFER_OVERFLOW:
    - Records exceeding maximum line length
-   - Files exceeding maximum size limits
    - Input strings too long
 
 6. Will FAIL with DATA_ERROR_MALFORMED_DATA:
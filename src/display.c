@@ -1,4 +1,7 @@
 #include "display.h"
+#include "csv_io.h"
+#include "catalog_snapshot.h"
+#include "data_errors.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
@@ -75,110 +78,105 @@ static bool file_exists_and_executable(const char *path)
 	return access(path, X_OK) == 0;
 }
 
-typedef struct
+// Next non-blank data row of fp split into fields (quoted fields understood); 0 at EOF
+static int read_row(FILE *fp, char *line, int size, csv_span_t fields[], int max_fields)
 {
-	char id[16];
-	char name[256];
-} NameMap;
+	int n = 0;
+	while (n == 0 && fgets(line, size, fp))
+		n = csv_split_spans(line, strlen(line), ',', fields, max_fields);
+	return n;
+}
 
-typedef struct
+// Copy a catalog string into a result field, or fallback when there is none
+static void copy_name(char *out, size_t size, const char *name, const char *fallback)
 {
-	char id[16];		  // candidate_number
-	char name[256];		  // candidate name
-	char party_id[16];	  // party id
-	char district_id[16]; // district id
-} CandidateInfo;
+	snprintf(out, size, "%s", name && name[0] ? name : fallback);
+}
 
-static size_t load_party_map(const char *filename, NameMap out[], size_t max_items)
+int load_voting_results(result_row_t **rows, size_t *count)
 {
-	FILE *fp = fopen(filename, "r");
-	if (!fp)
-		return 0;
-	char line[512];
-	size_t n = 0;
-	// skip header
-	if (!fgets(line, sizeof(line), fp))
-	{
-		fclose(fp);
-		return 0;
-	}
-	while (fgets(line, sizeof(line), fp) && n < max_items)
+	*rows = NULL;
+	*count = 0;
+
+	// Parties, districts and candidates come from the compiled catalog snapshot
+	catalog_snapshot_t catalog;
+	if (catalog_snapshot_open(&catalog, CATALOG_SNAPSHOT_FILE) != DATA_SUCCESS ||
+		catalog.party_count == 0 || catalog.candidate_count == 0)
 	{
-		// Trim newline
-		line[strcspn(line, "\r\n")] = '\0';
-		char *id = strtok(line, ",");
-		char *name = strtok(NULL, ""); // rest of line
-		if (!id || !name)
-			continue;
-		strncpy(out[n].id, id, sizeof(out[n].id) - 1);
-		out[n].id[sizeof(out[n].id) - 1] = '\0';
-		strncpy(out[n].name, name, sizeof(out[n].name) - 1);
-		out[n].name[sizeof(out[n].name) - 1] = '\0';
-		n++;
+		catalog_snapshot_close(&catalog);
+		set_error(DATA_ERROR_FILE_NOT_FOUND, "Error: Missing or empty party/candidate data files.");
+		return DATA_ERROR_FILE_NOT_FOUND;
 	}
-	fclose(fp);
-	return n;
-}
 
-static size_t load_candidate_info_map(const char *filename, CandidateInfo out[], size_t max_items)
-{
-	FILE *fp = fopen(filename, "r");
+	FILE *fp = fopen("data/parliament_candidates.txt", "r");
 	if (!fp)
-		return 0;
-	char line[512];
-	size_t n = 0;
-	// skip header
-	if (!fgets(line, sizeof(line), fp))
 	{
-		fclose(fp);
-		return 0;
+		catalog_snapshot_close(&catalog);
+		set_error(DATA_ERROR_FILE_NOT_FOUND, "Error: Could not open data/parliament_candidates.txt");
+		return DATA_ERROR_FILE_NOT_FOUND;
 	}
-	while (fgets(line, sizeof(line), fp) && n < max_items)
+
+	char line[256];
+	// header (an empty file just shows an empty table)
+	int have_rows = fgets(line, sizeof(line), fp) != NULL;
+
+	size_t capacity = 0;
+	int rc = DATA_SUCCESS;
+	csv_span_t fields[2];
+	int nf;
+	while (have_rows && (nf = read_row(fp, line, sizeof(line), fields, 2)) > 0)
 	{
-		// columns: candidate_number,name,party_id,district_id,nic
-		line[strcspn(line, "\r\n")] = '\0';
-		char *cand_id = strtok(line, ",");
-		char *name = strtok(NULL, ",");
-		char *party_id = strtok(NULL, ",");
-		char *district_id = strtok(NULL, ",");
-		if (!cand_id || !name)
+		if (nf < 2)
 			continue;
-		strncpy(out[n].id, cand_id, sizeof(out[n].id) - 1);
-		out[n].id[sizeof(out[n].id) - 1] = '\0';
-		strncpy(out[n].name, name, sizeof(out[n].name) - 1);
-		out[n].name[sizeof(out[n].name) - 1] = '\0';
-		if (party_id)
+		if (*count == capacity)
 		{
-			strncpy(out[n].party_id, party_id, sizeof(out[n].party_id) - 1);
-			out[n].party_id[sizeof(out[n].party_id) - 1] = '\0';
-		}
-		else
-		{
-			out[n].party_id[0] = '\0';
-		}
-		if (district_id)
-		{
-			strncpy(out[n].district_id, district_id, sizeof(out[n].district_id) - 1);
-			out[n].district_id[sizeof(out[n].district_id) - 1] = '\0';
+			capacity = capacity ? capacity * 2 : 64;
+			result_row_t *grown = realloc(*rows, capacity * sizeof(*grown));
+			if (!grown)
+			{
+				set_error(DATA_ERROR_MEMORY_ALLOCATION, "Error: Memory allocation failed for voting results");
+				rc = DATA_ERROR_MEMORY_ALLOCATION;
+				break;
+			}
+			*rows = grown;
 		}
-		else
+		result_row_t *row = &(*rows)[(*count)++];
+		char party_id[64];
+		csv_span_copy(&fields[0], row->candidate_id, sizeof(row->candidate_id));
+		csv_span_copy(&fields[1], party_id, sizeof(party_id));
+		const char *cand_name = NULL;
+		const char *district_id = NULL;
+		int c = catalog_find_candidate(&catalog, row->candidate_id);
+		if (c >= 0)
 		{
-			out[n].district_id[0] = '\0';
+			const catalog_candidate_t *cand = &catalog.candidates[c];
+			cand_name = catalog_str(&catalog, cand->name);
+			district_id = catalog_str(&catalog, cand->district_id);
+			if (!district_id[0])
+				district_id = NULL;
+			// prefer party name from parliament file, but candidate party can serve as fallback
+			if (!party_id[0])
+				snprintf(party_id, sizeof(party_id), "%s", catalog_str(&catalog, cand->party_id));
 		}
-		n++;
+		int p = catalog_find_party(&catalog, party_id);
+		int d = district_id ? catalog_find_district(&catalog, district_id) : -1;
+		copy_name(row->candidate_name, sizeof(row->candidate_name), cand_name, "<unknown>");
+		copy_name(row->party_id, sizeof(row->party_id), party_id, "");
+		copy_name(row->party_name, sizeof(row->party_name),
+				  p >= 0 ? catalog_str(&catalog, catalog.parties[p].name) : NULL, "<unknown>");
+		copy_name(row->district_id, sizeof(row->district_id), district_id, "--");
+		copy_name(row->district_name, sizeof(row->district_name),
+				  d >= 0 ? catalog_str(&catalog, catalog.districts[d].name) : NULL, "<unknown>");
 	}
 	fclose(fp);
-	return n;
-}
-
-static const char *map_lookup(const NameMap map[], size_t n, const char *id)
-{
-	for (size_t i = 0; i < n; i++)
+	catalog_snapshot_close(&catalog);
+	if (rc != DATA_SUCCESS)
 	{
-		if (strcmp(map[i].id, id) == 0)
-			return map[i].name;
+		free(*rows);
+		*rows = NULL;
+		*count = 0;
 	}
-	return NULL;
+	return rc;
 }
 
 static void show_voting_results(void)
@@ -186,112 +184,37 @@ static void show_voting_results(void)
 	clearscreen();
 	typewrite("\n" CYAN_ON_BLACK "Loading voting results..." RESET_COLORS "\n\n", 500);
 
-	// Load lookup maps
-	NameMap parties[256];
-	NameMap districts[256];
-	CandidateInfo candidates[1024];
-	size_t party_count = load_party_map("data/party_name.txt", parties, 256);
-	size_t cand_count = load_candidate_info_map("data/approved_candidates.txt", candidates, 1024);
-
-	// Load districts (district_id,district_name)
-	size_t district_count = 0;
+	result_row_t *rows;
+	size_t count;
+	if (load_voting_results(&rows, &count) != DATA_SUCCESS)
 	{
-		FILE *df = fopen("data/district.txt", "r");
-		if (df)
-		{
-			char l[256];
-			if (fgets(l, sizeof(l), df))
-			{
-				// header skipped
-			}
-			while (fgets(l, sizeof(l), df) && district_count < 256)
-			{
-				l[strcspn(l, "\r\n")] = '\0';
-				char *did = strtok(l, ",");
-				char *dname = strtok(NULL, "");
-				if (!did || !dname)
-					continue;
-				strncpy(districts[district_count].id, did, sizeof(districts[district_count].id) - 1);
-				districts[district_count].id[sizeof(districts[district_count].id) - 1] = '\0';
-				strncpy(districts[district_count].name, dname, sizeof(districts[district_count].name) - 1);
-				districts[district_count].name[sizeof(districts[district_count].name) - 1] = '\0';
-				district_count++;
-			}
-			fclose(df);
-		}
-	}
-
-	if (party_count == 0 || cand_count == 0)
-	{
-		printf(RED_ON_BLACK "Error: Missing or empty party/candidate data files." RESET_COLORS "\n");
-		printf("\n" RED_ON_BLACK "...PRESS ENTER TO RETURN..." RESET_COLORS "\n");
-		clearinputbuff();
-		getchar();
-		return;
-	}
-
-	FILE *fp = fopen("data/parliament_candidates.txt", "r");
-	if (!fp)
-	{
-		printf(RED_ON_BLACK "Error: Could not open data/parliament_candidates.txt" RESET_COLORS "\n");
+		printf(RED_ON_BLACK "%s" RESET_COLORS "\n", get_last_error());
 		printf("\n" RED_ON_BLACK "...PRESS ENTER TO RETURN..." RESET_COLORS "\n");
 		clearinputbuff();
 		getchar();
 		return;
 	}
 
-	char line[256];
-	// header
-	if (!fgets(line, sizeof(line), fp))
-	{
-		fclose(fp);
-	}
-
 	printf(GREEN_ON_BLACK "%-8s  %-24s  %-6s  %-30s  %-6s  %-24s" RESET_COLORS "\n", "ID", "Candidate", "Party", "Party Name", "Dist", "District Name");
 	printf("-----------------------------------------------------------------------------------------------------------\n");
 
-	size_t shown = 0;
-	while (fgets(line, sizeof(line), fp))
+	for (size_t i = 0; i < count; i++)
 	{
-		line[strcspn(line, "\r\n")] = '\0';
-		char *cand_id = strtok(line, ",");
-		char *party_id = strtok(NULL, ",");
-		if (!cand_id || !party_id)
-			continue;
-		const char *cand_name = NULL;
-		const char *district_id = NULL;
-		for (size_t i = 0; i < cand_count; i++)
-		{
-			if (strcmp(candidates[i].id, cand_id) == 0)
-			{
-				cand_name = candidates[i].name;
-				district_id = candidates[i].district_id[0] ? candidates[i].district_id : NULL;
-				// prefer party name from parliament file, but candidate party can serve as fallback
-				if (!party_id[0] && candidates[i].party_id[0])
-				{
-					party_id = candidates[i].party_id;
-				}
-				break;
-			}
-		}
-		const char *party_name = map_lookup(parties, party_count, party_id);
-		const char *district_name = district_id ? map_lookup(districts, district_count, district_id) : NULL;
 		printf("%-8s  %-24s  %-6s  %-30s  %-6s  %-24s\n",
-			   cand_id,
-			   cand_name ? cand_name : "<unknown>",
-			   party_id,
-			   party_name ? party_name : "<unknown>",
-			   district_id ? district_id : "--",
-			   district_name ? district_name : "<unknown>");
-		shown++;
-		if (shown % 30 == 0)
+			   rows[i].candidate_id,
+			   rows[i].candidate_name,
+			   rows[i].party_id,
+			   rows[i].party_name,
+			   rows[i].district_id,
+			   rows[i].district_name);
+		if ((i + 1) % 30 == 0)
 		{
 			printf("\n" CYAN_ON_BLACK "-- More -- Press ENTER to continue --" RESET_COLORS "\n");
 			clearinputbuff();
 			getchar();
 		}
 	}
-	fclose(fp);
+	free(rows);
 
 	printf("\n" RED_ON_BLACK "...PRESS ENTER TO GET BACK TO THE MAIN MENU..." RESET_COLORS "\n");
 	clearinputbuff();
@@ -1,5 +1,6 @@
 
 #include <stdio.h>
+#include <stddef.h>
 #include <unistd.h>
 #define RESET_COLORS "\033[00m"
 #define RED_ON_BLACK "\033[1;31m"
@@ -8,3 +9,18 @@
 void typewrite(const char[], unsigned int);
 void clearscreen(void);
 void showmainmenu(void);
+
+// One row of the results table, with names resolved through the catalog snapshot
+typedef struct
+{
+	char candidate_id[64];
+	char candidate_name[128];
+	char party_id[64];
+	char party_name[128];
+	char district_id[64];
+	char district_name[128];
+} result_row_t;
+
+// Load data/parliament_candidates.txt for display. Returns DATA_SUCCESS with
+// *rows (caller frees) and *count set, or an error code with the message set.
+int load_voting_results(result_row_t **rows, size_t *count);
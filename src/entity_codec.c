@@ -2,7 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "entity_codec.h"
-// Reuse shared CSV splitter from csv_io for consistency
+// Reuse shared CSV splitter and quoting writer from csv_io for consistency
 #include "csv_io.h"
 
 static int check_fit(const char *src, size_t limit)
@@ -46,8 +46,8 @@ int format_candidate_line(const Candidate *in, char *buf, size_t bufsize)
 {
     if (!in || !buf || bufsize == 0)
         return 0;
-    int r = snprintf(buf, bufsize, "%s, %s, %s, %s, %s",
-                     in->candidate_number, in->name, in->party_id, in->district_id, in->nic);
+    const char *values[] = {in->candidate_number, in->name, in->party_id, in->district_id, in->nic};
+    int r = csv_format_row(buf, bufsize, values, 5);
     return r > 0 && (size_t)r < bufsize;
 }
 
@@ -83,7 +83,7 @@ int format_voter_line(const Voter *in, char *buf, size_t bufsize)
 {
     if (!in || !buf || bufsize == 0)
         return 0;
-    int r = snprintf(buf, bufsize, "%s, %s, %s, %s",
-                     in->voting_number, in->name, in->nic, in->district_id);
+    const char *values[] = {in->voting_number, in->name, in->nic, in->district_id};
+    int r = csv_format_row(buf, bufsize, values, 4);
     return r > 0 && (size_t)r < bufsize;
 }
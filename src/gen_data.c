@@ -0,0 +1,750 @@
+/*
+ * VoteMe Synthetic Election Generator (gen_data)
+ *
+ * Writes a complete, schema-correct election for load tests:
+ * approved_voters.txt, approved_candidates.txt, party_name.txt,
+ * district.txt, votes.txt and temp-voted-list.txt.
+ *
+ * Voters and candidates are spread over the districts; each voter turns out
+ * with the given probability and votes for a candidate of their own
+ * district, picked by a Zipf distribution over that district's candidates
+ * (rank k gets weight 1/k^s, s = 0 is uniform). Every random choice is a
+ * hash of (seed, stream, row), so the output depends only on the options
+ * and seed, never on the thread count.
+ *
+ * Ids are zero padded to a fixed width (V0001, C001, P01, D01 or wider when
+ * the counts need it). Every file is produced by all threads at once: each
+ * sizes its share of the rows, then formats them into a large buffer and
+ * pwrite()s it at its offset of a temp file that is renamed into place.
+ * Cast votes go to votes.txt and, as cast_vote would record them, to the
+ * temp voted list (--empty-temp leaves the list with only its header).
+ *
+ * Derived files of the old data (lookup indexes, catalog.bin, voted.bitmap,
+ * tally.ckpt, votes.journal) are removed. Run it with no booth or votemed
+ * using the directory.
+ *
+ * Usage: gen_data [--voters N] [--candidates N] [--parties N]
+ *                 [--districts N] [--turnout F] [--zipf S] [--seed N]
+ *                 [--threads N] [--empty-temp] [--out DIR] [--force]
+ */
+
+// pwrite/ftruncate/sysconf need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define GEN_BUFFER_SIZE (4 << 20) // bytes each thread formats before a pwrite
+#define GEN_MAX_ROW 192
+#define GEN_MAX_THREADS 64
+#define GEN_MIN_ROWS_PER_THREAD 65536
+#define GEN_NIC_SPACE 900000000LL // 9-digit NICs 100000000V..999999999V
+#define GEN_NIC_STRIDE 123456791LL // coprime to GEN_NIC_SPACE: NICs never repeat
+
+// Independent random streams
+#define STREAM_VOTER_DISTRICT 1
+#define STREAM_VOTER_NAME 2
+#define STREAM_TURNOUT 3
+#define STREAM_BALLOT 4
+#define STREAM_CANDIDATE_NAME 5
+#define STREAM_CANDIDATE_PARTY 6
+#define STREAM_RANKING 7
+
+static const char *first_names[] = {
+    "Michael", "Alice", "Kevin", "Bob", "Nimal", "Kamala", "Sunil", "Priya", "David", "Sarah",
+    "Ruwan", "Dilani", "James", "Emma", "Kasun", "Tharushi", "Daniel", "Olivia", "Saman", "Nadeesha",
+    "Chris", "Grace", "Arjun", "Fathima", "Mohamed", "Anjali", "Thomas", "Hannah", "Lahiru", "Ishara",
+    "Peter", "Chloe"};
+
+static const char *last_names[] = {
+    "Wilson", "Smith", "Harris", "Taylor", "Perera", "Fernando", "Silva", "Jayasinghe", "Brown", "Johnson",
+    "Bandara", "Dissanayake", "Walker", "Clark", "Rajapaksa", "Wickramasinghe", "Lewis", "Young", "Kumara", "Herath",
+    "Hall", "Allen", "Ratnayake", "Gunawardena", "King", "Wright", "Senanayake", "Peiris", "Scott", "Green",
+    "Nissanka", "Baker"};
+
+// Names of the first 25 districts, as in the sample data
+static const char *district_names[] = {
+    "Colombo", "Gampaha", "Kalutara", "Kandy", "Matale", "Nuwara Eliya", "Galle", "Matara", "Hambantota",
+    "Jaffna", "Kilinochchi", "Mannar", "Vavuniya", "Mullaitivu", "Batticaloa", "Ampara", "Trincomalee",
+    "Kurunegala", "Puttalam", "Anuradhapura", "Polonnaruwa", "Badulla", "Monaragala", "Ratnapura", "Kegalle"};
+
+static const char *party_words[][2] = {
+    {"United", "National"}, {"People's", "Freedom"}, {"Democratic", "Alliance"}, {"Green", "Progressive"},
+    {"Liberal", "Front"},   {"Socialist", "Unity"},  {"Workers'", "Congress"},   {"National", "Renewal"}};
+
+#define COUNT_OF(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+static struct
+{
+    long long voters;
+    long long candidates;
+    int parties;
+    int districts;
+    double turnout;
+    double zipf;
+    uint64_t seed;
+    int threads;
+    int empty_temp;
+    const char *out;
+    int force;
+} opts;
+
+// Widths of the zero-padded id numbers
+static int voter_width, candidate_width, party_width, district_width;
+
+// Candidates of each district, best ranked first, with the Zipf CDF over them
+static long long *district_first; // index into ranked/cdf of each district's first candidate
+static long long *ranked;         // candidate numbers (0-based)
+static double *cdf;
+
+/* ==== Random values ==== */
+
+// SplitMix64 finalizer over (seed, stream, row): the same inputs always give the same value
+static uint64_t draw(int stream, uint64_t row)
+{
+    uint64_t x = opts.seed ^ ((uint64_t)stream << 56) ^ (row * 0x9e3779b97f4a7c15ULL);
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Uniform in [0, 1)
+static double draw_unit(int stream, uint64_t row)
+{
+    return (double)(draw(stream, row) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* ==== Row formatting ==== */
+
+static char *put_str(char *p, const char *s)
+{
+    size_t n = strlen(s);
+    memcpy(p, s, n);
+    return p + n;
+}
+
+// Zero-padded decimal of at least width digits
+static char *put_num(char *p, unsigned long long v, int width)
+{
+    char tmp[24];
+    int n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n < width)
+        tmp[n++] = '0';
+    while (n)
+        *p++ = tmp[--n];
+    return p;
+}
+
+static char *put_id(char *p, char prefix, long long n, int width)
+{
+    *p++ = prefix;
+    return put_num(p, (unsigned long long)n, width);
+}
+
+static char *put_name(char *p, int stream, uint64_t row)
+{
+    uint64_t r = draw(stream, row);
+    p = put_str(p, first_names[r % COUNT_OF(first_names)]);
+    *p++ = ' ';
+    return put_str(p, last_names[(r >> 32) % COUNT_OF(last_names)]);
+}
+
+// Voters take NICs 0..voters-1 of the sequence, candidates the ones after
+static char *put_nic(char *p, long long k)
+{
+    p = put_num(p, (unsigned long long)(100000000LL + (k * GEN_NIC_STRIDE + 7) % GEN_NIC_SPACE), 9);
+    *p++ = 'V';
+    return p;
+}
+
+static int voter_district(long long v)
+{
+    return (int)(draw(STREAM_VOTER_DISTRICT, (uint64_t)v) % (uint64_t)opts.districts);
+}
+
+// Candidate c stands in district c % districts, so every district gets one
+static int candidate_district(long long c)
+{
+    return (int)(c % opts.districts);
+}
+
+static int candidate_party(long long c)
+{
+    return (int)(draw(STREAM_CANDIDATE_PARTY, (uint64_t)c) % (uint64_t)opts.parties);
+}
+
+// The candidate voter v votes for, or -1 when they stay home
+static long long ballot(long long v)
+{
+    if (draw_unit(STREAM_TURNOUT, (uint64_t)v) >= opts.turnout)
+        return -1;
+    int d = voter_district(v);
+    long long lo = district_first[d], hi = district_first[d + 1] - 1;
+    double u = draw_unit(STREAM_BALLOT, (uint64_t)v);
+    while (lo < hi)
+    {
+        long long mid = lo + (hi - lo) / 2;
+        if (cdf[mid] > u)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return ranked[lo];
+}
+
+// Row formatters: write row i (with its newline) at out and return its
+// length, 0 when the row is skipped. With out NULL they only return the
+// length, which the fixed-width ids make cheap to compute.
+typedef size_t (*row_fn)(long long i, char *out);
+
+static size_t name_length(int stream, uint64_t row)
+{
+    uint64_t r = draw(stream, row);
+    return strlen(first_names[r % COUNT_OF(first_names)]) + 1 + strlen(last_names[(r >> 32) % COUNT_OF(last_names)]);
+}
+
+static size_t voter_row(long long i, char *out)
+{
+    if (!out)
+        return (size_t)(voter_width + district_width) + name_length(STREAM_VOTER_NAME, (uint64_t)i) + 16;
+    char *p = put_id(out, 'V', i + 1, voter_width);
+    *p++ = ',';
+    p = put_name(p, STREAM_VOTER_NAME, (uint64_t)i);
+    *p++ = ',';
+    p = put_nic(p, i);
+    *p++ = ',';
+    p = put_id(p, 'D', voter_district(i) + 1, district_width);
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+static size_t candidate_row(long long i, char *out)
+{
+    if (!out)
+        return (size_t)(candidate_width + party_width + district_width) +
+               name_length(STREAM_CANDIDATE_NAME, (uint64_t)i) + 18;
+    char *p = put_id(out, 'C', i + 1, candidate_width);
+    *p++ = ',';
+    p = put_name(p, STREAM_CANDIDATE_NAME, (uint64_t)i);
+    *p++ = ',';
+    p = put_id(p, 'P', candidate_party(i) + 1, party_width);
+    *p++ = ',';
+    p = put_id(p, 'D', candidate_district(i) + 1, district_width);
+    *p++ = ',';
+    p = put_nic(p, opts.voters + i);
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+static size_t party_row(long long i, char *out)
+{
+    char scratch[GEN_MAX_ROW];
+    if (!out)
+        return party_row(i, scratch);
+    char *p = put_id(out, 'P', i + 1, party_width);
+    *p++ = ',';
+    int n = COUNT_OF(party_words);
+    p = put_str(p, party_words[i % n][0]);
+    *p++ = ' ';
+    p = put_str(p, party_words[(i / n + i) % n][1]);
+    p = put_str(p, " Party");
+    if (i >= (long long)n * n)
+    {
+        *p++ = ' ';
+        p = put_num(p, (unsigned long long)(i / ((long long)n * n) + 1), 1);
+    }
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+static size_t district_row(long long i, char *out)
+{
+    char scratch[GEN_MAX_ROW];
+    if (!out)
+        return district_row(i, scratch);
+    char *p = put_id(out, 'D', i + 1, district_width);
+    *p++ = ',';
+    if (i < COUNT_OF(district_names))
+    {
+        p = put_str(p, district_names[i]);
+    }
+    else
+    {
+        p = put_str(p, "District ");
+        p = put_num(p, (unsigned long long)(i + 1), 1);
+    }
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+static size_t vote_row(long long i, char *out)
+{
+    if (!out)
+        return draw_unit(STREAM_TURNOUT, (uint64_t)i) < opts.turnout ? (size_t)(voter_width + candidate_width) + 4 : 0;
+    long long c = ballot(i);
+    if (c < 0)
+        return 0;
+    char *p = put_id(out, 'V', i + 1, voter_width);
+    *p++ = ',';
+    p = put_id(p, 'C', c + 1, candidate_width);
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+static size_t temp_voted_row(long long i, char *out)
+{
+    if (!out)
+        return vote_row(i, NULL) ? (size_t)(voter_width + candidate_width + party_width) + 6 : 0;
+    long long c = ballot(i);
+    if (c < 0)
+        return 0;
+    char *p = put_id(out, 'V', i + 1, voter_width);
+    *p++ = ',';
+    p = put_id(p, 'C', c + 1, candidate_width);
+    *p++ = ',';
+    p = put_id(p, 'P', candidate_party(c) + 1, party_width);
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+/* ==== Parallel writer ==== */
+
+typedef struct
+{
+    row_fn row;
+    long long first;
+    long long end;
+    int fd;
+    off_t offset; // where this range's bytes go
+    off_t end_offset;
+    off_t bytes;  // size of this range's bytes (pass 1)
+    long long rows; // rows written (skipped rows excluded)
+    int failed;
+} range_t;
+
+static void *size_range(void *arg)
+{
+    range_t *r = arg;
+    off_t bytes = 0;
+    long long rows = 0;
+    for (long long i = r->first; i < r->end; i++)
+    {
+        size_t len = r->row(i, NULL);
+        bytes += (off_t)len;
+        rows += len > 0;
+    }
+    r->bytes = bytes;
+    r->rows = rows;
+    return NULL;
+}
+
+static int flush_range(range_t *r, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = pwrite(r->fd, buf, len, r->offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        buf += n;
+        len -= (size_t)n;
+        r->offset += n;
+    }
+    return 1;
+}
+
+static void *write_range(void *arg)
+{
+    range_t *r = arg;
+    char *buf = malloc(GEN_BUFFER_SIZE);
+    if (!buf)
+    {
+        r->failed = 1;
+        return NULL;
+    }
+    size_t used = 0;
+    for (long long i = r->first; i < r->end && !r->failed; i++)
+    {
+        if (used > GEN_BUFFER_SIZE - GEN_MAX_ROW)
+        {
+            r->failed = !flush_range(r, buf, used);
+            used = 0;
+        }
+        used += r->row(i, buf + used);
+    }
+    if (!r->failed)
+        r->failed = !flush_range(r, buf, used);
+    // A row longer than its size from pass 1 would overwrite the next range
+    if (r->offset != r->end_offset)
+        r->failed = 1;
+    free(buf);
+    return NULL;
+}
+
+// Run fn over every range, on threads when there is more than one
+static int run_ranges(void *(*fn)(void *), range_t ranges[], int count)
+{
+    pthread_t tids[GEN_MAX_THREADS];
+    int started = 0;
+    if (count == 1)
+    {
+        fn(&ranges[0]);
+        return 1;
+    }
+    while (started < count && pthread_create(&tids[started], NULL, fn, &ranges[started]) == 0)
+        started++;
+    for (int t = 0; t < started; t++)
+        pthread_join(tids[t], NULL);
+    return started == count;
+}
+
+// Write header and rows [0, rows) of a table to <out>/<name> through a temp file
+static int write_table(const char *name, const char *header, long long rows, row_fn row)
+{
+    char path[1024], tmp_path[1040];
+    snprintf(path, sizeof(path), "%s/%s", opts.out, name);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    int count = (int)(rows / GEN_MIN_ROWS_PER_THREAD) + 1;
+    if (count > opts.threads)
+        count = opts.threads;
+    range_t ranges[GEN_MAX_THREADS];
+    for (int t = 0; t < count; t++)
+    {
+        ranges[t].row = row;
+        ranges[t].first = rows * t / count;
+        ranges[t].end = rows * (t + 1) / count;
+        ranges[t].failed = 0;
+    }
+    if (!run_ranges(size_range, ranges, count))
+    {
+        fprintf(stderr, "gen_data: cannot start threads\n");
+        return 0;
+    }
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        fprintf(stderr, "gen_data: cannot create %s: %s\n", tmp_path, strerror(errno));
+        return 0;
+    }
+    size_t header_len = strlen(header);
+    off_t offset = (off_t)header_len + 1;
+    long long written = 0;
+    for (int t = 0; t < count; t++)
+    {
+        ranges[t].fd = fd;
+        ranges[t].offset = offset;
+        offset += ranges[t].bytes;
+        ranges[t].end_offset = offset;
+        written += ranges[t].rows;
+    }
+
+    // Size the file first so the ranges can land anywhere in it
+    range_t head = {0};
+    head.fd = fd;
+    int ok = ftruncate(fd, offset) == 0 && flush_range(&head, header, header_len) && flush_range(&head, "\n", 1);
+    ok = ok && run_ranges(write_range, ranges, count);
+    for (int t = 0; t < count && ok; t++)
+        ok = !ranges[t].failed;
+    if (close(fd) != 0)
+        ok = 0;
+    if (!ok || rename(tmp_path, path) != 0)
+    {
+        fprintf(stderr, "gen_data: cannot write %s: %s\n", path, strerror(errno));
+        unlink(tmp_path);
+        return 0;
+    }
+    printf("  %-24s %12lld rows %10.1f MB\n", name, written, (double)offset / (1024.0 * 1024.0));
+    return 1;
+}
+
+/* ==== Election layout ==== */
+
+static int digits(long long n)
+{
+    int d = 1;
+    while (n >= 10)
+    {
+        n /= 10;
+        d++;
+    }
+    return d;
+}
+
+// Rank each district's candidates (a seeded shuffle) and build its Zipf CDF
+static int build_ballots(void)
+{
+    int d_count = opts.districts;
+    district_first = calloc((size_t)d_count + 1, sizeof(*district_first));
+    ranked = malloc((size_t)opts.candidates * sizeof(*ranked));
+    cdf = malloc((size_t)opts.candidates * sizeof(*cdf));
+    if (!district_first || !ranked || !cdf)
+        return 0;
+
+    for (long long c = 0; c < opts.candidates; c++)
+        district_first[candidate_district(c) + 1]++;
+    for (int d = 0; d < d_count; d++)
+        district_first[d + 1] += district_first[d];
+    for (long long c = 0; c < opts.candidates; c++)
+    {
+        int d = candidate_district(c);
+        ranked[district_first[d] + c / d_count] = c;
+    }
+
+    for (int d = 0; d < d_count; d++)
+    {
+        long long lo = district_first[d], n = district_first[d + 1] - lo;
+        for (long long k = n - 1; k > 0; k--)
+        {
+            long long j = (long long)(draw(STREAM_RANKING, (uint64_t)(lo + k)) % (uint64_t)(k + 1));
+            long long t = ranked[lo + k];
+            ranked[lo + k] = ranked[lo + j];
+            ranked[lo + j] = t;
+        }
+        double total = 0.0;
+        for (long long k = 0; k < n; k++)
+        {
+            total += pow((double)(k + 1), -opts.zipf);
+            cdf[lo + k] = total;
+        }
+        for (long long k = 0; k < n; k++)
+            cdf[lo + k] /= total;
+    }
+    return 1;
+}
+
+// Remove files derived from the data set being replaced
+static void remove_derived(void)
+{
+    static const char *bases[] = {"approved_voters", "approved_candidates", "party_name",
+                                  "district",        "votes",               "temp-voted-list"};
+    static const char *files[] = {"catalog.bin", "voted.bitmap", "tally.ckpt", "votes.journal"};
+    char path[1024];
+    for (int i = 0; i < COUNT_OF(files); i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", opts.out, files[i]);
+        unlink(path);
+    }
+
+    // Lookup indexes: <base>.idx and <base>.<field>.idx
+    DIR *dir = opendir(opts.out);
+    if (!dir)
+        return;
+    struct dirent *e;
+    while ((e = readdir(dir)) != NULL)
+    {
+        size_t len = strlen(e->d_name);
+        if (len < 5 || strcmp(e->d_name + len - 4, ".idx") != 0)
+            continue;
+        for (int i = 0; i < COUNT_OF(bases); i++)
+        {
+            size_t blen = strlen(bases[i]);
+            if (strncmp(e->d_name, bases[i], blen) != 0 || e->d_name[blen] != '.')
+                continue;
+            const char *rest = e->d_name + blen + 1;
+            while (*rest >= '0' && *rest <= '9')
+                rest++;
+            if (strcmp(rest, "idx") == 0 || (rest > e->d_name + blen + 1 && strcmp(rest, ".idx") == 0))
+            {
+                snprintf(path, sizeof(path), "%s/%s", opts.out, e->d_name);
+                unlink(path);
+            }
+        }
+    }
+    closedir(dir);
+}
+
+/* ==== Main ==== */
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --voters N       approved voters (default 1000000; k/M suffixes allowed)\n"
+            "  --candidates N   approved candidates (default voters/1000, at least one per district)\n"
+            "  --parties N      parties (default 20)\n"
+            "  --districts N    districts (default 25)\n"
+            "  --turnout F      fraction of voters who vote, 0..1 (default 0.75)\n"
+            "  --zipf S         Zipf exponent of the vote within a district (default 1.1, 0 = uniform)\n"
+            "  --seed N         random seed (default 1)\n"
+            "  --threads N      writer threads (default: online CPUs)\n"
+            "  --empty-temp     leave temp-voted-list.txt with only its header\n"
+            "  --out DIR        output directory (default data)\n"
+            "  --force          replace an existing data set in DIR\n",
+            prog);
+}
+
+// A number that must be all of s; -1 when malformed
+static double parse_real(const char *s)
+{
+    char *end;
+    double v = strtod(s, &end);
+    return end == s || *end ? -1.0 : v;
+}
+
+// "50000000", "50M", "2.5k"; -1 when malformed
+static long long parse_count(const char *s)
+{
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0)
+        return -1;
+    if (*end == 'k' || *end == 'K')
+        v *= 1e3, end++;
+    else if (*end == 'm' || *end == 'M')
+        v *= 1e6, end++;
+    return *end ? -1 : (long long)(v + 0.5);
+}
+
+int main(int argc, char **argv)
+{
+    opts.voters = 1000000;
+    opts.candidates = -1;
+    opts.parties = 20;
+    opts.districts = 25;
+    opts.turnout = 0.75;
+    opts.zipf = 1.1;
+    opts.seed = 1;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    opts.threads = cpus < 1 ? 1 : cpus > GEN_MAX_THREADS ? GEN_MAX_THREADS : (int)cpus;
+    opts.out = "data";
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--empty-temp") == 0)
+        {
+            opts.empty_temp = 1;
+            continue;
+        }
+        if (strcmp(arg, "--force") == 0)
+        {
+            opts.force = 1;
+            continue;
+        }
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!val || strncmp(arg, "--", 2) != 0)
+        {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0 ? 0 : 2;
+        }
+        i++;
+        long long n = parse_count(val);
+        if (strcmp(arg, "--voters") == 0)
+            opts.voters = n;
+        else if (strcmp(arg, "--candidates") == 0)
+            opts.candidates = n < 0 ? -2 : n;
+        else if (strcmp(arg, "--parties") == 0)
+            opts.parties = n < 1 || n > 99999 ? -1 : (int)n;
+        else if (strcmp(arg, "--districts") == 0)
+            opts.districts = n < 1 || n > 99999 ? -1 : (int)n;
+        else if (strcmp(arg, "--turnout") == 0)
+            opts.turnout = parse_real(val);
+        else if (strcmp(arg, "--zipf") == 0)
+            opts.zipf = parse_real(val);
+        else if (strcmp(arg, "--seed") == 0)
+            opts.seed = strtoull(val, NULL, 10);
+        else if (strcmp(arg, "--threads") == 0)
+            opts.threads = (int)n;
+        else if (strcmp(arg, "--out") == 0)
+            opts.out = val;
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (opts.candidates == -1 && opts.voters >= 0)
+        opts.candidates = opts.voters / 1000 > opts.districts ? opts.voters / 1000 : opts.districts;
+
+    const char *bad = NULL;
+    if (opts.voters < 1)
+        bad = "--voters must be a positive count";
+    else if (opts.parties < 1 || opts.districts < 1)
+        bad = "--parties and --districts must be between 1 and 99999";
+    else if (opts.candidates < opts.districts)
+        bad = "--candidates must be at least one per district";
+    else if (opts.voters + opts.candidates > GEN_NIC_SPACE)
+        bad = "too many voters and candidates for unique 9-digit NICs";
+    else if (opts.turnout < 0.0 || opts.turnout > 1.0)
+        bad = "--turnout must be between 0 and 1";
+    else if (opts.zipf < 0.0)
+        bad = "--zipf must not be negative";
+    else if (opts.threads < 1 || opts.threads > GEN_MAX_THREADS)
+        bad = "--threads must be between 1 and 64";
+    if (bad)
+    {
+        fprintf(stderr, "gen_data: %s\n", bad);
+        return 2;
+    }
+
+    if (mkdir(opts.out, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "gen_data: cannot create %s: %s\n", opts.out, strerror(errno));
+        return 1;
+    }
+    char roll[1024];
+    struct stat st;
+    snprintf(roll, sizeof(roll), "%s/approved_voters.txt", opts.out);
+    if (!opts.force && stat(roll, &st) == 0)
+    {
+        fprintf(stderr, "gen_data: %s already holds a data set; use --force to replace it\n", opts.out);
+        return 1;
+    }
+
+    voter_width = digits(opts.voters) > 4 ? digits(opts.voters) : 4;
+    candidate_width = digits(opts.candidates) > 3 ? digits(opts.candidates) : 3;
+    party_width = digits(opts.parties) > 2 ? digits(opts.parties) : 2;
+    district_width = digits(opts.districts) > 2 ? digits(opts.districts) : 2;
+    if (!build_ballots())
+    {
+        fprintf(stderr, "gen_data: out of memory\n");
+        return 1;
+    }
+
+    printf("Generating %lld voters, %lld candidates, %d parties, %d districts into %s/\n"
+           "(turnout %.2f, zipf %.2f, seed %llu, %d threads)\n",
+           opts.voters, opts.candidates, opts.parties, opts.districts, opts.out, opts.turnout, opts.zipf,
+           (unsigned long long)opts.seed, opts.threads);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    remove_derived();
+    int ok = write_table("party_name.txt", "party_id,party_name", opts.parties, party_row) &&
+             write_table("district.txt", "district_id,district_name", opts.districts, district_row) &&
+             write_table("approved_candidates.txt", "candidate_number,name,party_id,district_id,nic",
+                         opts.candidates, candidate_row) &&
+             write_table("approved_voters.txt", "voting_number,name,nic,district_id", opts.voters, voter_row) &&
+             write_table("votes.txt", "voter_id,candidate_id", opts.voters, vote_row) &&
+             write_table("temp-voted-list.txt", "voting_number,candidate_number,party_id",
+                         opts.empty_temp ? 0 : opts.voters, temp_voted_row);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    free(district_first);
+    free(ranked);
+    free(cdf);
+    if (!ok)
+        return 1;
+    printf("Done in %.2f s\n", (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9);
+    return 0;
+}
@@ -0,0 +1,684 @@
+/*
+ * VoteMe Record Index Implementation
+ *
+ * Open-addressing (linear probing) table of row offsets stored in a
+ * sidecar file next to the CSV it indexes. Probes are served with pread,
+ * so a lookup touches a handful of slots instead of the whole data file.
+ */
+
+// pread/pwrite and st_mtim need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "csv_io.h"
+#include "data_handler_enhanced.h"
+#include "record_index.h"
+
+#define RECORD_INDEX_MAGIC "VMRIDX1"
+#define RECORD_INDEX_VERSION 3  // 2: empty fields count as columns, 3: quoted fields
+#define RECORD_INDEX_MIN_CAPACITY 1024
+#define RECORD_INDEX_READ_CHUNK (64 * 1024)
+// Longest row read_record accepts (its fgets buffer minus newline and NUL)
+#define RECORD_INDEX_MAX_ROW (MAX_LINE_LENGTH - 2)
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t field;
+    uint64_t src_size;       // source fingerprint at the time of the last write
+    int64_t src_mtime_sec;
+    int64_t src_mtime_nsec;
+    uint64_t src_ino;
+    uint32_t capacity;
+    uint32_t count;
+} index_header_t;
+
+typedef struct
+{
+    uint64_t offset_plus1;   // row offset + 1; 0 marks an empty slot
+    uint32_t hash;           // hash of the indexed column
+    uint32_t len;            // row length without the newline
+} index_slot_t;
+
+// FNV-1a, same family as the tally index
+static uint32_t hash_key(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static long long mtime_nsec(const struct stat *st)
+{
+#if defined(_WIN32)
+    (void)st;
+    return 0;
+#else
+    return (long long)st->st_mtim.tv_nsec;
+#endif
+}
+
+static void header_set_source(index_header_t *h, const struct stat *st)
+{
+    h->src_size = (uint64_t)st->st_size;
+    h->src_mtime_sec = (int64_t)st->st_mtime;
+    h->src_mtime_nsec = (int64_t)mtime_nsec(st);
+    h->src_ino = (uint64_t)st->st_ino;
+}
+
+static int header_matches_source(const index_header_t *h, const struct stat *st)
+{
+    return h->src_size == (uint64_t)st->st_size &&
+           h->src_mtime_sec == (int64_t)st->st_mtime &&
+           h->src_mtime_nsec == (int64_t)mtime_nsec(st) &&
+           h->src_ino == (uint64_t)st->st_ino;
+}
+
+static int header_valid(const index_header_t *h, int field)
+{
+    return memcmp(h->magic, RECORD_INDEX_MAGIC, sizeof(h->magic)) == 0 &&
+           h->version == RECORD_INDEX_VERSION &&
+           h->field == (uint32_t)field &&
+           h->capacity >= RECORD_INDEX_MIN_CAPACITY &&
+           (h->capacity & (h->capacity - 1)) == 0;
+}
+
+/**
+ * Locate column `field` of a row the way read_record sees it (csv_split_spans)
+ * @param scratch Holds the value when it has escaped quotes to undo
+ * @return 1 if the row has that column, 0 otherwise
+ */
+static int row_field(const char *row, size_t len, int field, char scratch[MAX_LINE_LENGTH],
+                     const char **out, size_t *out_len)
+{
+    csv_span_t fields[MAX_FIELDS];
+    if (field >= MAX_FIELDS || csv_split_spans(row, len, ',', fields, field + 1) <= field)
+        return 0;
+    if (fields[field].quoting == CSV_SPAN_ESCAPED)
+    {
+        *out_len = csv_span_copy(&fields[field], scratch, MAX_LINE_LENGTH);
+        *out = scratch;
+    }
+    else
+    {
+        *out = fields[field].ptr;
+        *out_len = fields[field].len;
+    }
+    return 1;
+}
+
+int record_index_path(const char *source, int field, char *out, size_t outsz)
+{
+    if (!source || !out || outsz == 0 || field < 0)
+        return DATA_ERROR_INVALID_INPUT;
+
+    // Strip the extension of the last path component only
+    size_t base_len = strlen(source);
+    const char *dot = strrchr(source, '.');
+    const char *slash = strrchr(source, '/');
+    if (dot && (!slash || dot > slash))
+        base_len = (size_t)(dot - source);
+
+    int n = (field == 0)
+                ? snprintf(out, outsz, "%.*s.idx", (int)base_len, source)
+                : snprintf(out, outsz, "%.*s.%d.idx", (int)base_len, source, field);
+    if (n < 0 || (size_t)n >= outsz)
+    {
+        set_error_message("Error: Index path for '%s' is too long", source);
+        return DATA_ERROR_BUFFER_OVERFLOW;
+    }
+    return DATA_SUCCESS;
+}
+
+/* ==== Lookup ==== */
+
+int record_index_open(record_index_t *ri, const char *source, int field)
+{
+    if (!ri)
+        return DATA_ERROR_INVALID_INPUT;
+    memset(ri, 0, sizeof(*ri));
+    ri->idx_fd = -1;
+    ri->src_fd = -1;
+
+    char path[MAX_LINE_LENGTH];
+    if (record_index_path(source, field, path, sizeof(path)) != DATA_SUCCESS)
+        return DATA_ERROR_INVALID_INPUT;
+
+    // A missing or stale index is a normal state, so no error message is set
+    ri->idx_fd = open(path, O_RDONLY);
+    if (ri->idx_fd < 0)
+        return DATA_ERROR_FILE_NOT_FOUND;
+
+    index_header_t h;
+    struct stat st;
+    if (pread(ri->idx_fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || !header_valid(&h, field))
+    {
+        record_index_close(ri);
+        return DATA_ERROR_MALFORMED_DATA;
+    }
+
+    ri->src_fd = open(source, O_RDONLY);
+    if (ri->src_fd < 0 || fstat(ri->src_fd, &st) != 0 || !header_matches_source(&h, &st))
+    {
+        record_index_close(ri);
+        return DATA_ERROR_MALFORMED_DATA;
+    }
+
+    ri->field = field;
+    ri->capacity = h.capacity;
+    ri->count = h.count;
+    return DATA_SUCCESS;
+}
+
+int record_index_next(record_index_t *ri, const char *key, unsigned int *cursor,
+                      char *line, size_t line_size)
+{
+    if (!ri || ri->idx_fd < 0 || !key || !cursor || !line || line_size < 2)
+        return DATA_ERROR_INVALID_INPUT;
+
+    size_t key_len = strlen(key);
+    uint32_t h = hash_key(key, key_len);
+    uint32_t mask = ri->capacity - 1;
+
+    while (*cursor < ri->capacity)
+    {
+        index_slot_t slot;
+        off_t at = (off_t)sizeof(index_header_t) + (off_t)((h + *cursor) & mask) * (off_t)sizeof(slot);
+        (*cursor)++;
+        if (pread(ri->idx_fd, &slot, sizeof(slot), at) != (ssize_t)sizeof(slot))
+            return DATA_ERROR_MALFORMED_DATA;
+        if (slot.offset_plus1 == 0)
+            return 0; // end of the probe chain
+        if (slot.hash != h || (size_t)slot.len + 1 >= line_size)
+            continue;
+
+        // Read the row plus its terminator and confirm the column really matches
+        ssize_t n = pread(ri->src_fd, line, (size_t)slot.len + 1, (off_t)(slot.offset_plus1 - 1));
+        if (n < (ssize_t)slot.len)
+            return DATA_ERROR_MALFORMED_DATA;
+        char scratch[MAX_LINE_LENGTH];
+        const char *value;
+        size_t value_len;
+        if (!row_field(line, slot.len, ri->field, scratch, &value, &value_len) ||
+            value_len != key_len || memcmp(value, key, key_len) != 0)
+            continue;
+
+        size_t keep = (n > (ssize_t)slot.len && line[slot.len] == '\n') ? (size_t)slot.len + 1 : slot.len;
+        line[keep] = '\0';
+        return 1;
+    }
+    return 0;
+}
+
+void record_index_close(record_index_t *ri)
+{
+    if (!ri)
+        return;
+    if (ri->idx_fd >= 0)
+        close(ri->idx_fd);
+    if (ri->src_fd >= 0)
+        close(ri->src_fd);
+    ri->idx_fd = -1;
+    ri->src_fd = -1;
+}
+
+/* ==== Build ==== */
+
+typedef struct
+{
+    index_slot_t *rows;      // indexable rows in file order
+    size_t count;
+    size_t cap;
+} row_list_t;
+
+static int row_list_push(row_list_t *list, long long offset, const char *row, size_t len, int field)
+{
+    char scratch[MAX_LINE_LENGTH];
+    const char *value;
+    size_t value_len;
+    if (len > RECORD_INDEX_MAX_ROW || !row_field(row, len, field, scratch, &value, &value_len))
+        return 1; // not reachable by read_record either; nothing to index
+    if (list->count == list->cap)
+    {
+        size_t cap = list->cap ? list->cap * 2 : 4096;
+        index_slot_t *grown = realloc(list->rows, cap * sizeof(*grown));
+        if (!grown)
+            return 0;
+        list->rows = grown;
+        list->cap = cap;
+    }
+    index_slot_t *s = &list->rows[list->count++];
+    s->offset_plus1 = (uint64_t)offset + 1;
+    s->hash = hash_key(value, value_len);
+    s->len = (uint32_t)len;
+    return 1;
+}
+
+/**
+ * Collect every data row (header skipped) of an open source file
+ */
+static int scan_rows(int fd, int field, row_list_t *list)
+{
+    char *buf = malloc(RECORD_INDEX_READ_CHUNK);
+    if (!buf)
+        return DATA_ERROR_MEMORY_ALLOCATION;
+
+    char row[MAX_LINE_LENGTH];
+    size_t row_len = 0;      // bytes of the current row kept in row[]
+    size_t total_len = 0;    // full length of the current row
+    long long row_start = 0;
+    long long pos = 0;
+    int header = 1;
+    int rc = DATA_SUCCESS;
+
+    for (;;)
+    {
+        ssize_t n = read(fd, buf, RECORD_INDEX_READ_CHUNK);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+        {
+            rc = DATA_ERROR_MALFORMED_DATA;
+            break;
+        }
+
+        const char *p = buf;
+        const char *end = buf + n;
+        while (p < end || (n == 0 && total_len > 0))
+        {
+            const char *nl = n > 0 ? memchr(p, '\n', (size_t)(end - p)) : NULL;
+            const char *seg_end = nl ? nl : end;
+            size_t seg = (size_t)(seg_end - p);
+            if (row_len + seg < sizeof(row))
+            {
+                memcpy(row + row_len, p, seg);
+                row_len += seg;
+            }
+            else
+            {
+                row_len = sizeof(row); // overlong: only the length matters now
+            }
+            total_len += seg;
+            if (!nl && n > 0)
+                break; // row continues in the next chunk
+
+            // Row complete (newline, or final unterminated row at EOF)
+            if (header)
+                header = 0;
+            else if (total_len > 0 && !row_list_push(list, row_start, row, total_len, field))
+            {
+                rc = DATA_ERROR_MEMORY_ALLOCATION;
+                break;
+            }
+            row_start = pos + (long long)(seg_end - buf) + 1;
+            row_len = 0;
+            total_len = 0;
+            p = seg_end + 1;
+            if (n == 0)
+                break;
+        }
+        if (rc != DATA_SUCCESS || n == 0)
+            break;
+        pos += n;
+    }
+
+    free(buf);
+    return rc;
+}
+
+static int insert_slot(index_slot_t *slots, uint32_t capacity, const index_slot_t *s)
+{
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+        index_slot_t *dst = &slots[(s->hash + i) & mask];
+        if (dst->offset_plus1 == 0)
+        {
+            *dst = *s;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int record_index_build(const char *source, int field)
+{
+    char path[MAX_LINE_LENGTH];
+    char tmp_path[MAX_LINE_LENGTH + 16];
+    if (!source || field < 0 || field >= MAX_FIELDS)
+    {
+        set_error(DATA_ERROR_INVALID_INPUT, "Error: Invalid parameters for record_index_build");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    int rc = record_index_path(source, field, path, sizeof(path));
+    if (rc != DATA_SUCCESS)
+        return rc;
+    int fd = open(source, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        set_error_message("Error: Cannot open file '%s' for indexing: %s", source, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return DATA_ERROR_FILE_NOT_FOUND;
+    }
+
+    row_list_t list = {0};
+    rc = scan_rows(fd, field, &list);
+    close(fd);
+    if (rc != DATA_SUCCESS)
+    {
+        free(list.rows);
+        set_error_message("Error: Failed to scan '%s' for indexing", source);
+        return rc;
+    }
+
+    // Keep the load factor at or below 1/2 so probe chains stay short
+    uint32_t capacity = RECORD_INDEX_MIN_CAPACITY;
+    while ((size_t)capacity < list.count * 2 && capacity < (1u << 31))
+        capacity <<= 1;
+    index_slot_t *slots = calloc(capacity, sizeof(*slots));
+    if (!slots || list.count * 2 > capacity)
+    {
+        free(slots);
+        free(list.rows);
+        set_error_message("Error: Memory allocation failed for index of '%s'", source);
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    // Insert in file order so equal keys probe in the order a scan meets them
+    for (size_t i = 0; i < list.count; i++)
+        insert_slot(slots, capacity, &list.rows[i]);
+
+    index_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, RECORD_INDEX_MAGIC, sizeof(h.magic));
+    h.version = RECORD_INDEX_VERSION;
+    h.field = (uint32_t)field;
+    header_set_source(&h, &st);
+    h.capacity = capacity;
+    h.count = (uint32_t)list.count;
+
+    // A unique name in the index's directory, so two builds of the same
+    // index never write one file and the final rename() stays atomic
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmpXXXXXX", path);
+    int tmp_fd = mkstemp(tmp_path);
+    FILE *fp = NULL;
+    int saved_errno = errno;
+    if (tmp_fd >= 0)
+    {
+        // Readable like the file it indexes (mkstemp creates 0600)
+        fchmod(tmp_fd, st.st_mode & 0777);
+        fp = fdopen(tmp_fd, "wb");
+        if (!fp)
+        {
+            saved_errno = errno;
+            close(tmp_fd);
+            remove(tmp_path);
+        }
+    }
+    if (!fp)
+    {
+        free(slots);
+        free(list.rows);
+        set_error_message("Error: Cannot write index '%s': %s", path, strerror(saved_errno));
+        return saved_errno == ENOSPC ? DATA_ERROR_DISK_FULL : DATA_ERROR_PERMISSION_DENIED;
+    }
+    int ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+             fwrite(slots, sizeof(*slots), capacity, fp) == capacity;
+    ok = (fclose(fp) == 0) && ok;
+    free(slots);
+    free(list.rows);
+
+    if (!ok || rename(tmp_path, path) != 0)
+    {
+        remove(tmp_path);
+        set_error_message("Error: Failed to write index '%s': %s", path, strerror(errno));
+        return DATA_ERROR_DISK_FULL;
+    }
+    return DATA_SUCCESS;
+}
+
+/* ==== Append maintenance ==== */
+
+static void append_to_index(const char *source, int field, const struct stat *before,
+                            const long long offsets[], const size_t lens[], int n)
+{
+    char path[MAX_LINE_LENGTH];
+    if (record_index_path(source, field, path, sizeof(path)) != DATA_SUCCESS)
+        return;
+    int fd = open(path, O_RDWR);
+    if (fd < 0)
+        return;
+
+    index_header_t h;
+    struct stat after;
+    if (pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || !header_valid(&h, field) ||
+        !header_matches_source(&h, before) || stat(source, &after) != 0)
+    {
+        close(fd);
+        return;
+    }
+
+    int src_fd = -1;
+    for (int r = 0; r < n; r++)
+    {
+        // Offset 0 is the header row of a freshly created file: not a record
+        char row[MAX_LINE_LENGTH];
+        char scratch[MAX_LINE_LENGTH];
+        const char *value;
+        size_t value_len;
+        if (offsets[r] <= 0 || lens[r] > RECORD_INDEX_MAX_ROW)
+            continue;
+        if (src_fd < 0)
+            src_fd = open(source, O_RDONLY);
+        ssize_t got = src_fd >= 0 ? pread(src_fd, row, lens[r], (off_t)offsets[r]) : -1;
+        if (got != (ssize_t)lens[r])
+        {
+            if (src_fd >= 0)
+                close(src_fd);
+            close(fd);
+            remove(path); // cannot tell what was appended; drop rather than go wrong
+            return;
+        }
+        if (!row_field(row, lens[r], field, scratch, &value, &value_len))
+            continue;
+
+        if ((size_t)(h.count + 1) * 2 > h.capacity)
+        {
+            // Too full: regrow from the source (amortized by doubling)
+            if (src_fd >= 0)
+                close(src_fd);
+            close(fd);
+            record_index_build(source, field);
+            return;
+        }
+
+        index_slot_t s = {(uint64_t)offsets[r] + 1, hash_key(value, value_len), (uint32_t)lens[r]};
+        uint32_t mask = h.capacity - 1;
+        int inserted = 0;
+        for (uint32_t i = 0; i < h.capacity; i++)
+        {
+            index_slot_t cur;
+            off_t at = (off_t)sizeof(h) + (off_t)((s.hash + i) & mask) * (off_t)sizeof(cur);
+            if (pread(fd, &cur, sizeof(cur), at) != (ssize_t)sizeof(cur))
+                break;
+            if (cur.offset_plus1 == 0)
+            {
+                inserted = pwrite(fd, &s, sizeof(s), at) == (ssize_t)sizeof(s);
+                break;
+            }
+        }
+        if (!inserted)
+        {
+            if (src_fd >= 0)
+                close(src_fd);
+            close(fd);
+            remove(path);
+            return;
+        }
+        h.count++;
+    }
+    if (src_fd >= 0)
+        close(src_fd);
+
+    // Re-stamp the header last; if anything above failed the index is stale
+    header_set_source(&h, &after);
+    if (pwrite(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h))
+    {
+        close(fd);
+        remove(path);
+        return;
+    }
+    close(fd);
+}
+
+void record_index_note_append(const char *source, const struct stat *before, long long offset, size_t len)
+{
+    record_index_note_append_rows(source, before, &offset, &len, 1);
+}
+
+// Which columns of a source have index files, cached against the fingerprint
+// of its directory: building, renaming or removing an index always changes
+// the directory's mtime, so a matching fingerprint means the same index set.
+// Each thread keeps its own cache, so appends from several threads need no lock.
+typedef struct
+{
+    char source[MAX_LINE_LENGTH];
+    dev_t dir_dev;
+    ino_t dir_ino;
+    long long dir_mtime_sec;
+    long long dir_mtime_nsec;
+    unsigned long fields; // bit per indexed column
+    int valid;
+} index_presence_t;
+
+#define INDEX_PRESENCE_SLOTS 4
+static DATA_THREAD_LOCAL index_presence_t presence_cache[INDEX_PRESENCE_SLOTS];
+static DATA_THREAD_LOCAL int presence_next;
+
+static unsigned long indexed_fields(const char *source)
+{
+    char dir[MAX_LINE_LENGTH];
+    const char *slash = strrchr(source, '/');
+    if (slash)
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - source), source);
+    else
+        snprintf(dir, sizeof(dir), ".");
+
+    struct stat dst;
+    int have_dir = stat(dir, &dst) == 0;
+    index_presence_t *slot = NULL;
+    for (int i = 0; have_dir && i < INDEX_PRESENCE_SLOTS; i++)
+    {
+        index_presence_t *c = &presence_cache[i];
+        if (c->valid && strcmp(c->source, source) == 0)
+        {
+            if (c->dir_dev == dst.st_dev && c->dir_ino == dst.st_ino &&
+                c->dir_mtime_sec == (long long)dst.st_mtime && c->dir_mtime_nsec == mtime_nsec(&dst))
+                return c->fields;
+            slot = c;
+            break;
+        }
+    }
+
+    unsigned long fields = 0;
+    for (int field = 0; field < MAX_FIELDS; field++)
+    {
+        if (record_index_exists(source, field))
+            fields |= 1UL << field;
+    }
+
+    if (have_dir && strlen(source) < sizeof(presence_cache[0].source))
+    {
+        if (!slot)
+        {
+            slot = &presence_cache[presence_next];
+            presence_next = (presence_next + 1) % INDEX_PRESENCE_SLOTS;
+        }
+        strcpy(slot->source, source);
+        slot->dir_dev = dst.st_dev;
+        slot->dir_ino = dst.st_ino;
+        slot->dir_mtime_sec = (long long)dst.st_mtime;
+        slot->dir_mtime_nsec = mtime_nsec(&dst);
+        slot->fields = fields;
+        slot->valid = 1;
+    }
+    return fields;
+}
+
+void record_index_note_append_rows(const char *source, const struct stat *before,
+                                   const long long offsets[], const size_t lens[], int n)
+{
+    if (!source || !before || !offsets || !lens || n <= 0)
+        return;
+    // Appends to unindexed files cost one stat() of the directory
+    unsigned long fields = indexed_fields(source);
+    for (int field = 0; field < MAX_FIELDS && fields; field++)
+    {
+        if (fields & (1UL << field))
+            append_to_index(source, field, before, offsets, lens, n);
+    }
+}
+
+/* ==== Whole-index management ==== */
+
+int record_index_exists(const char *source, int field)
+{
+    char path[MAX_LINE_LENGTH];
+    if (record_index_path(source, field, path, sizeof(path)) != DATA_SUCCESS)
+        return 0;
+    return access(path, F_OK) == 0;
+}
+
+int record_index_drop(const char *source, int field)
+{
+    char path[MAX_LINE_LENGTH];
+    int rc = record_index_path(source, field, path, sizeof(path));
+    if (rc != DATA_SUCCESS)
+        return rc;
+    if (remove(path) != 0)
+    {
+        if (errno == ENOENT)
+        {
+            set_error_message("Error: No index on field %d of '%s'", field, source);
+            return DATA_ERROR_FILE_NOT_FOUND;
+        }
+        set_error_message("Error: Cannot remove index '%s': %s", path, strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+    return DATA_SUCCESS;
+}
+
+int record_index_rebuild_all(const char *source)
+{
+    int rc = DATA_SUCCESS;
+    for (int field = 0; field < MAX_FIELDS; field++)
+    {
+        if (!record_index_exists(source, field))
+            continue;
+        int frc = record_index_build(source, field);
+        if (frc != DATA_SUCCESS)
+        {
+            // A half-maintained index is worse than none: lookups must fall back to scanning
+            record_index_drop(source, field);
+            rc = frc;
+        }
+    }
+    return rc;
+}
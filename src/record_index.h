@@ -0,0 +1,116 @@
+/*
+ * VoteMe Record Index Header
+ *
+ * Persistent on-disk hash index over one column of a CSV data file
+ * (e.g. data/approved_voters.idx maps voting_number -> row offset in
+ * data/approved_voters.txt), so primary-key lookups cost O(1) preads
+ * instead of a scan of the whole file.
+ *
+ * The index stores only (hash, offset, length) per row; candidate rows are
+ * read back from the source and compared in full, so a hash collision can
+ * never return a wrong record. Rows with the same key are kept in file order,
+ * which makes index lookups return exactly what a top-to-bottom scan would.
+ *
+ * An index is only trusted while it is fresh: the source's size, mtime and
+ * inode must equal the values recorded when the index was last written.
+ * append_line() extends existing indexes in place and overwrite_file()
+ * rebuilds them; writes that bypass csv_io leave them stale and lookups
+ * fall back to scanning until they are rebuilt.
+ */
+
+#ifndef RECORD_INDEX_H
+#define RECORD_INDEX_H
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+// An open, fresh index plus the source file it describes
+typedef struct
+{
+    int idx_fd;              // index file
+    int src_fd;              // source CSV file
+    int field;               // indexed column (split_csv_fields numbering)
+    unsigned int capacity;   // slot count (power of two)
+    unsigned int count;      // indexed rows
+} record_index_t;
+
+/**
+ * Derive the index path for a source file and column
+ * Field 0 uses "<base>.idx" (data/approved_voters.idx); other columns use
+ * "<base>.<field>.idx". <base> is the source path without its extension.
+ * @return DATA_SUCCESS on success, DATA_ERROR_BUFFER_OVERFLOW if out is too small
+ */
+int record_index_path(const char *source, int field, char *out, size_t outsz);
+
+/**
+ * Open the index for source/field if it exists and is fresh
+ * @param ri Index handle to initialize
+ * @return DATA_SUCCESS when usable, DATA_ERROR_FILE_NOT_FOUND when missing,
+ *         DATA_ERROR_MALFORMED_DATA when stale or corrupt
+ */
+int record_index_open(record_index_t *ri, const char *source, int field);
+
+/**
+ * Fetch the next source row whose indexed column equals key
+ * @param ri Open index
+ * @param key Key value (compared after the same trimming split_csv_fields does)
+ * @param cursor Probe position; set to 0 before the first call
+ * @param line Output row (NUL-terminated, trailing newline kept like fgets)
+ * @param line_size Capacity of line
+ * @return 1 when a row was produced, 0 when there are no more, negative error code on failure
+ */
+int record_index_next(record_index_t *ri, const char *key, unsigned int *cursor,
+                      char *line, size_t line_size);
+
+/**
+ * Close an index handle (safe on a zeroed or already closed handle)
+ */
+void record_index_close(record_index_t *ri);
+
+/**
+ * (Re)build the index for source/field from scratch
+ * The index is written to a temporary file and renamed into place.
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int record_index_build(const char *source, int field);
+
+/**
+ * Whether an index file exists for source/field (fresh or not)
+ */
+int record_index_exists(const char *source, int field);
+
+/**
+ * Delete the index for source/field
+ * @return DATA_SUCCESS on success, DATA_ERROR_FILE_NOT_FOUND if there is none
+ */
+int record_index_drop(const char *source, int field);
+
+/**
+ * Rebuild every existing index of source (after the file was rewritten)
+ * Indexes that fail to rebuild are dropped so they can never be half right.
+ * @return DATA_SUCCESS if all rebuilt, the last error code otherwise
+ */
+int record_index_rebuild_all(const char *source);
+
+/**
+ * Extend any fresh index of source with a row that was just appended
+ * @param source Source file
+ * @param before stat() of source taken before the append
+ * @param offset Offset of the appended row
+ * @param len Length of the appended row without its newline
+ *
+ * Indexes that were not fresh before the append are left alone (still stale).
+ * Failures are not reported: an index that cannot be updated simply goes stale.
+ */
+void record_index_note_append(const char *source, const struct stat *before, long long offset, size_t len);
+
+/**
+ * record_index_note_append for several rows written by one append
+ * @param offsets Row offsets, in file order
+ * @param lens Row lengths without their newlines
+ * @param n Number of rows
+ */
+void record_index_note_append_rows(const char *source, const struct stat *before,
+                                   const long long offsets[], const size_t lens[], int n);
+
+#endif // RECORD_INDEX_H
@@ -0,0 +1,30 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sys_config.h"
+
+int config_get_int(const char *key, int default_value)
+{
+    if (!key || !*key)
+        return default_value;
+
+    FILE *fp = fopen(SYSTEM_CONFIG_FILE, "r");
+    if (!fp)
+        return default_value;
+
+    size_t key_len = strlen(key);
+    int value = default_value;
+    char line[256];
+    while (fgets(line, sizeof(line), fp))
+    {
+        if (line[0] == '#' || strncmp(line, key, key_len) != 0 || line[key_len] != '=')
+            continue;
+        char *end = NULL;
+        long v = strtol(line + key_len + 1, &end, 10);
+        if (end != line + key_len + 1)
+            value = (int)v;
+    }
+    fclose(fp);
+    return value;
+}
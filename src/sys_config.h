@@ -0,0 +1,13 @@
+#ifndef SYS_CONFIG_H
+#define SYS_CONFIG_H
+
+#include <stddef.h>
+
+// Shared key=value configuration written by the admin console
+#define SYSTEM_CONFIG_FILE "data/system_config.txt"
+
+// Read an integer setting from data/system_config.txt.
+// Returns default_value when the file or key is missing or not a number.
+int config_get_int(const char *key, int default_value);
+
+#endif // SYS_CONFIG_H
@@ -0,0 +1,1089 @@
+/*
+ * VoteMe Tally Engine Implementation
+ *
+ * Direct-mapped numeric decoding with an open-addressing hash fallback,
+ * used by the voting algorithm to attribute votes in O(1) per vote.
+ */
+
+// pread/sysconf need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(_WIN32)
+#define TALLY_NO_THREADS
+#else
+#include <pthread.h>
+#endif
+#include "data_handler_enhanced.h"
+#include "csv_io.h"
+#include "vote_source.h"
+#include "tally.h"
+
+// Largest numeric suffix we decode directly (9 digits always fits in an int)
+#define TALLY_MAX_SUFFIX_DIGITS 9
+// Direct table may be at most this many times sparser than the id count
+#define TALLY_DIRECT_SPARSITY 8
+#define TALLY_DIRECT_SLACK 1024
+// Per-range read buffer for the partitioned counter
+#define TALLY_CHUNK_SIZE (1 << 20)
+// Smallest byte range worth handing to its own thread
+#define TALLY_MIN_RANGE_BYTES (1 << 20)
+#define TALLY_MAX_THREADS 64
+// Highest candidate column a vote log may use
+#define TALLY_MAX_FIELD 15
+// Bytes handed to the structural scanner at a time (one mark slot per byte)
+#define TALLY_SCAN_WINDOW 4096
+#define TALLY_CKPT_VERSION 1
+
+static unsigned int hash_bytes(const char *s, size_t len)
+{
+    // FNV-1a
+    unsigned int h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Split an id into alphabetic prefix and numeric suffix
+ * @return 1 if the id is <prefix><digits>, 0 otherwise
+ */
+static int split_numeric_id(const char *id, size_t len, size_t *prefix_len, long *value)
+{
+    size_t p = 0;
+    while (p < len && !(id[p] >= '0' && id[p] <= '9'))
+        p++;
+    size_t digits = len - p;
+    if (digits == 0 || digits > TALLY_MAX_SUFFIX_DIGITS)
+        return 0;
+    long v = 0;
+    for (size_t i = p; i < len; i++)
+    {
+        if (id[i] < '0' || id[i] > '9')
+            return 0;
+        v = v * 10 + (id[i] - '0');
+    }
+    *prefix_len = p;
+    *value = v;
+    return 1;
+}
+
+static int slot_matches(const tally_index_t *ix, int slot, const char *id, size_t len)
+{
+    return ix->id_lens[slot] == len && memcmp(ix->ids[slot], id, len) == 0;
+}
+
+static void hash_insert(tally_index_t *ix, int slot)
+{
+    size_t pos = hash_bytes(ix->ids[slot], ix->id_lens[slot]) & ix->hash_mask;
+    while (ix->hash_slots[pos] >= 0)
+    {
+        if (slot_matches(ix, ix->hash_slots[pos], ix->ids[slot], ix->id_lens[slot]))
+            return; // duplicate id: first occurrence wins, like the old linear scan
+        pos = (pos + 1) & ix->hash_mask;
+    }
+    ix->hash_slots[pos] = slot;
+}
+
+int tally_index_build(tally_index_t *ix, const char *const ids[], int count)
+{
+    if (!ix || (!ids && count > 0) || count < 0)
+    {
+        set_error_message("Error: Invalid parameters for tally_index_build");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    memset(ix, 0, sizeof(*ix));
+    ix->count = count;
+
+    ix->ids = malloc(sizeof(*ix->ids) * (count > 0 ? count : 1));
+    ix->id_lens = malloc(sizeof(*ix->id_lens) * (count > 0 ? count : 1));
+    size_t capacity = 16;
+    while (capacity < (size_t)count * 2)
+        capacity <<= 1;
+    ix->hash_slots = malloc(sizeof(*ix->hash_slots) * capacity);
+    if (!ix->ids || !ix->id_lens || !ix->hash_slots)
+    {
+        tally_index_free(ix);
+        set_error_message("Error: Memory allocation failed for tally index");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    ix->hash_mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++)
+        ix->hash_slots[i] = -1;
+
+    for (int i = 0; i < count; i++)
+    {
+        ix->ids[i] = ids[i] ? ids[i] : "";
+        ix->id_lens[i] = strlen(ix->ids[i]);
+    }
+
+    // Pick the dominant prefix from the first numeric id and size the direct table
+    long max_value = -1;
+    int have_prefix = 0;
+    for (int i = 0; i < count; i++)
+    {
+        size_t plen;
+        long v;
+        if (!split_numeric_id(ix->ids[i], ix->id_lens[i], &plen, &v) || plen >= sizeof(ix->prefix))
+            continue;
+        if (!have_prefix)
+        {
+            memcpy(ix->prefix, ix->ids[i], plen);
+            ix->prefix[plen] = '\0';
+            ix->prefix_len = plen;
+            have_prefix = 1;
+        }
+        if (plen == ix->prefix_len && memcmp(ix->ids[i], ix->prefix, plen) == 0 && v > max_value)
+            max_value = v;
+    }
+    if (max_value >= 0 && max_value < (long)count * TALLY_DIRECT_SPARSITY + TALLY_DIRECT_SLACK)
+    {
+        ix->direct_size = (size_t)max_value + 1;
+        ix->direct = malloc(sizeof(*ix->direct) * ix->direct_size);
+        if (!ix->direct)
+        {
+            tally_index_free(ix);
+            set_error_message("Error: Memory allocation failed for tally direct table");
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        }
+        for (size_t i = 0; i < ix->direct_size; i++)
+            ix->direct[i] = -1;
+    }
+    else
+    {
+        ix->prefix_len = 0;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        size_t plen;
+        long v;
+        if (ix->direct && split_numeric_id(ix->ids[i], ix->id_lens[i], &plen, &v) &&
+            plen == ix->prefix_len && memcmp(ix->ids[i], ix->prefix, plen) == 0 &&
+            (size_t)v < ix->direct_size)
+        {
+            int prev = ix->direct[v];
+            if (prev < 0)
+            {
+                ix->direct[v] = i;
+                continue;
+            }
+            if (slot_matches(ix, prev, ix->ids[i], ix->id_lens[i]))
+                continue; // exact duplicate id
+            // Same number, different spelling ("C1" vs "C001"): fall through to hash
+        }
+        hash_insert(ix, i);
+    }
+
+    return DATA_SUCCESS;
+}
+
+int tally_index_lookup(const tally_index_t *ix, const char *id, size_t len)
+{
+    if (!ix || !id || len == 0)
+        return -1;
+
+    if (ix->direct && len > ix->prefix_len && memcmp(id, ix->prefix, ix->prefix_len) == 0 &&
+        len - ix->prefix_len <= TALLY_MAX_SUFFIX_DIGITS)
+    {
+        size_t v = 0;
+        size_t i = ix->prefix_len;
+        for (; i < len && id[i] >= '0' && id[i] <= '9'; i++)
+            v = v * 10 + (size_t)(id[i] - '0');
+        if (i == len && v < ix->direct_size)
+        {
+            int slot = ix->direct[v];
+            if (slot >= 0 && slot_matches(ix, slot, id, len))
+                return slot;
+        }
+    }
+
+    size_t pos = hash_bytes(id, len) & ix->hash_mask;
+    while (ix->hash_slots[pos] >= 0)
+    {
+        int slot = ix->hash_slots[pos];
+        if (slot_matches(ix, slot, id, len))
+            return slot;
+        pos = (pos + 1) & ix->hash_mask;
+    }
+    return -1;
+}
+
+void tally_index_free(tally_index_t *ix)
+{
+    if (!ix)
+        return;
+    free(ix->ids);
+    free(ix->id_lens);
+    free(ix->direct);
+    free(ix->hash_slots);
+    memset(ix, 0, sizeof(*ix));
+}
+
+/* ==== Candidate table ==== */
+
+// Make room for need more pool bytes
+static int pool_reserve(tally_table_t *t, size_t need)
+{
+    if (t->pool_used + need <= t->pool_size)
+        return 1;
+    size_t size = t->pool_size ? t->pool_size : 4096;
+    while (size < t->pool_used + need)
+        size *= 2;
+    if (size > UINT32_MAX)
+        return 0; // offsets are 32-bit
+    char *grown = realloc(t->pool, size);
+    if (!grown)
+        return 0;
+    t->pool = grown;
+    t->pool_size = size;
+    return 1;
+}
+
+// Unescape a field at the end of the pool without committing it
+static size_t pool_stage(tally_table_t *t, const csv_span_t *span)
+{
+    return csv_span_copy(span, t->pool + t->pool_used, span ? span->len + 1 : 1);
+}
+
+static int names_find(const tally_table_t *t, const tally_names_t *in, const char *s, size_t len)
+{
+    if (!in->slots)
+        return -1;
+    for (size_t i = hash_bytes(s, len) & in->mask; in->slots[i] >= 0; i = (i + 1) & in->mask)
+    {
+        const char *name = t->pool + in->names[in->slots[i]];
+        if (memcmp(name, s, len) == 0 && name[len] == '\0')
+            return in->slots[i];
+    }
+    return -1;
+}
+
+/**
+ * Intern the string staged at the end of the pool, committing it if new
+ * @return Name index, or -1 on allocation failure
+ */
+static int names_intern(tally_table_t *t, tally_names_t *in, size_t len)
+{
+    const char *s = t->pool + t->pool_used;
+    int found = names_find(t, in, s, len);
+    if (found >= 0)
+        return found;
+
+    if (in->count == in->capacity)
+    {
+        int cap = in->capacity ? in->capacity * 2 : 16;
+        uint32_t *grown = realloc(in->names, (size_t)cap * sizeof(*grown));
+        if (!grown)
+            return -1;
+        in->names = grown;
+        in->capacity = cap;
+    }
+    if (!in->slots || (size_t)(in->count + 1) * 2 > in->mask + 1)
+    {
+        size_t size = in->slots ? (in->mask + 1) * 2 : 32;
+        int *slots = malloc(size * sizeof(*slots));
+        if (!slots)
+            return -1;
+        for (size_t i = 0; i < size; i++)
+            slots[i] = -1;
+        for (int k = 0; k < in->count; k++)
+        {
+            const char *name = t->pool + in->names[k];
+            size_t i = hash_bytes(name, strlen(name)) & (size - 1);
+            while (slots[i] >= 0)
+                i = (i + 1) & (size - 1);
+            slots[i] = k;
+        }
+        free(in->slots);
+        in->slots = slots;
+        in->mask = size - 1;
+    }
+
+    size_t i = hash_bytes(s, len) & in->mask;
+    while (in->slots[i] >= 0)
+        i = (i + 1) & in->mask;
+    in->names[in->count] = (uint32_t)t->pool_used;
+    in->slots[i] = in->count;
+    t->pool_used += len + 1;
+    return in->count++;
+}
+
+static void names_free(tally_names_t *in)
+{
+    free(in->names);
+    free(in->slots);
+    memset(in, 0, sizeof(*in));
+}
+
+// Grow every column to hold at least one more row
+static int table_grow(tally_table_t *t)
+{
+    if (t->count < t->capacity)
+        return 1;
+    size_t cap = t->capacity ? (size_t)t->capacity * 2 : 256;
+    void *p;
+    // Each column is swapped in as soon as it has grown, so a failure leaves
+    // the table consistent at its old capacity
+    if (!(p = realloc(t->votes, cap * sizeof(*t->votes))))
+        return 0;
+    t->votes = p;
+    if (!(p = realloc(t->qualified, cap * sizeof(*t->qualified))))
+        return 0;
+    t->qualified = p;
+    if (!(p = realloc(t->seat_rank, cap * sizeof(*t->seat_rank))))
+        return 0;
+    t->seat_rank = p;
+    if (!(p = realloc(t->party, cap * sizeof(*t->party))))
+        return 0;
+    t->party = p;
+    if (!(p = realloc(t->district, cap * sizeof(*t->district))))
+        return 0;
+    t->district = p;
+    if (!(p = realloc(t->number, cap * sizeof(*t->number))))
+        return 0;
+    t->number = p;
+    if (!(p = realloc(t->name, cap * sizeof(*t->name))))
+        return 0;
+    t->name = p;
+    t->capacity = (int)cap;
+    return 1;
+}
+
+int tally_table_add(tally_table_t *t, const csv_span_t *number, const csv_span_t *name,
+                    const csv_span_t *party_id, const csv_span_t *district_id)
+{
+    size_t need = (number ? number->len : 0) + (name ? name->len : 0) +
+                  (party_id ? party_id->len : 0) + (district_id ? district_id->len : 0) + 4;
+    if (!table_grow(t) || !pool_reserve(t, need))
+    {
+        set_error_message("Error: Memory allocation failed for candidate table");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+
+    int row = t->count;
+    t->number[row] = (uint32_t)t->pool_used;
+    t->pool_used += pool_stage(t, number) + 1;
+    t->name[row] = (uint32_t)t->pool_used;
+    t->pool_used += pool_stage(t, name) + 1;
+    // Party and district strings are only kept once
+    t->party[row] = names_intern(t, &t->parties, pool_stage(t, party_id));
+    t->district[row] = names_intern(t, &t->districts, pool_stage(t, district_id));
+    if (t->party[row] < 0 || t->district[row] < 0)
+    {
+        set_error_message("Error: Memory allocation failed for candidate table");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    t->votes[row] = 0;
+    t->qualified[row] = 0;
+    t->seat_rank[row] = 0;
+    return t->count++;
+}
+
+const char *tally_table_number(const tally_table_t *t, int row)
+{
+    return t->pool + t->number[row];
+}
+
+const char *tally_table_name(const tally_table_t *t, int row)
+{
+    return t->pool + t->name[row];
+}
+
+const char *tally_table_party_id(const tally_table_t *t, int row)
+{
+    return t->pool + t->parties.names[t->party[row]];
+}
+
+const char *tally_table_district_id(const tally_table_t *t, int row)
+{
+    return t->pool + t->districts.names[t->district[row]];
+}
+
+void tally_table_free(tally_table_t *t)
+{
+    if (!t)
+        return;
+    free(t->votes);
+    free(t->qualified);
+    free(t->seat_rank);
+    free(t->party);
+    free(t->district);
+    free(t->number);
+    free(t->name);
+    free(t->pool);
+    names_free(&t->parties);
+    names_free(&t->districts);
+    memset(t, 0, sizeof(*t));
+}
+
+/**
+ * Attribute a row by its candidate field [s, e), trimming spaces and tabs
+ */
+static void count_value(const tally_index_t *ix, const char *s, const char *e,
+                        int counts[], tally_stats_t *stats)
+{
+    while (s < e && (*s == ' ' || *s == '\t'))
+        s++;
+    while (e > s && (e[-1] == ' ' || e[-1] == '\t'))
+        e--;
+    if (e == s)
+    {
+        stats->malformed++;
+        return;
+    }
+    int slot = tally_index_lookup(ix, s, (size_t)(e - s));
+    if (slot >= 0)
+    {
+        counts[slot]++;
+        stats->counted++;
+    }
+    else
+    {
+        stats->unknown++;
+    }
+}
+
+/**
+ * Attribute one CSV row to a candidate slot
+ */
+static void count_line(const tally_index_t *ix, const char *line, size_t len, int field,
+                       int counts[], tally_stats_t *stats)
+{
+    vote_field_t fields[TALLY_MAX_FIELD + 1];
+    int nf = vote_source_split(line, len, fields, field + 1);
+    if (nf <= field)
+    {
+        stats->malformed++;
+        return;
+    }
+    count_value(ix, fields[field].ptr, fields[field].ptr + fields[field].len, counts, stats);
+}
+
+/**
+ * Tokenize a buffer into rows and count each one
+ * Delimiters and newlines come from the vectorized structural scanner a
+ * window at a time; rows and fields are never rescanned byte by byte.
+ * @return Number of bytes consumed (up to and including the last newline)
+ */
+static size_t count_lines(const tally_index_t *ix, const char *buf, size_t len, int field,
+                          int counts[], tally_stats_t *stats)
+{
+    uint32_t marks[TALLY_SCAN_WINDOW];
+    const char *row = buf;     // start of the current row
+    const char *fstart = buf;  // start of the field being read
+    int col = 0;               // column of that field
+    int quoted = 0;            // the row has a '"': leave it to the full parser
+    const char *value = NULL;  // candidate field, once a delimiter closed it
+    const char *value_end = NULL;
+
+    for (size_t w = 0; w < len; w += TALLY_SCAN_WINDOW)
+    {
+        const char *base = buf + w;
+        size_t wlen = len - w < TALLY_SCAN_WINDOW ? len - w : TALLY_SCAN_WINDOW;
+        size_t n = csv_scan_structurals(base, wlen, ',', marks);
+        for (size_t i = 0; i < n; i++)
+        {
+            const char *q = base + marks[i];
+            if (*q == ',')
+            {
+                if (col == field)
+                {
+                    value = fstart;
+                    value_end = q;
+                }
+                col++;
+                fstart = q + 1;
+            }
+            else if (*q == '"')
+            {
+                quoted = 1;
+            }
+            else if (*q == '\n')
+            {
+                size_t rn = (size_t)(q - row);
+                if (rn > 0 && !(rn == 1 && row[0] == '\r'))
+                {
+                    stats->rows++;
+                    if (quoted)
+                    {
+                        // Quotes may hide delimiters: let the full parser split it
+                        count_line(ix, row, rn, field, counts, stats);
+                    }
+                    else
+                    {
+                        if (!value && col == field)
+                        {
+                            // Last field of the row: drop the CR of a CRLF ending
+                            value = fstart;
+                            value_end = q;
+                            while (value_end > value && value_end[-1] == '\r')
+                                value_end--;
+                        }
+                        if (value)
+                            count_value(ix, value, value_end, counts, stats);
+                        else
+                            stats->malformed++;
+                    }
+                }
+                row = fstart = q + 1;
+                col = 0;
+                quoted = 0;
+                value = value_end = NULL;
+            }
+        }
+    }
+    return (size_t)(row - buf);
+}
+
+/**
+ * Count a trailing row that has no newline (last row of the file)
+ */
+static void count_tail(const tally_index_t *ix, const char *p, size_t n, int field,
+                       int counts[], tally_stats_t *stats)
+{
+    while (n > 0 && p[n - 1] == '\r')
+        n--;
+    if (n > 0)
+    {
+        stats->rows++;
+        count_line(ix, p, n, field, counts, stats);
+    }
+}
+
+/**
+ * Find the first line start at or after pos (a byte following '\n')
+ */
+static off_t align_to_line(const vote_source_t *src, off_t pos, off_t size)
+{
+    if (pos <= 0)
+        return 0;
+    if (pos >= size)
+        return size;
+    if (vote_source_is_mapped(src))
+    {
+        const char *nl = memchr(src->data + pos - 1, '\n', (size_t)(size - pos + 1));
+        return nl ? (off_t)(nl - src->data) + 1 : size;
+    }
+    char buf[4096];
+    off_t at = pos - 1;
+    while (at < size)
+    {
+        ssize_t n = pread(src->fd, buf, sizeof(buf), at);
+        if (n <= 0)
+            break;
+        const char *nl = memchr(buf, '\n', (size_t)n);
+        if (nl)
+            return at + (off_t)(nl - buf) + 1;
+        at += n;
+    }
+    return size;
+}
+
+// One contiguous, line-aligned byte range of the vote log
+typedef struct
+{
+    const tally_index_t *ix;
+    const vote_source_t *src;
+    off_t begin;
+    off_t end;
+    int field;
+    int *counts;         // private per-candidate counters
+    tally_stats_t stats; // private statistics
+    int rc;
+} tally_range_t;
+
+/**
+ * Count a range straight out of the mapping (no copies)
+ */
+static void count_mapped_range(tally_range_t *r)
+{
+    const char *base = r->src->data + r->begin;
+    size_t len = (size_t)(r->end - r->begin);
+    size_t used = count_lines(r->ix, base, len, r->field, r->counts, &r->stats);
+    if (used < len)
+        count_tail(r->ix, base + used, len - used, r->field, r->counts, &r->stats);
+}
+
+/**
+ * Count a range through a private pread() buffer (unmappable files)
+ */
+static void count_buffered_range(tally_range_t *r)
+{
+    char *buf = malloc(TALLY_CHUNK_SIZE);
+    if (!buf)
+    {
+        r->rc = DATA_ERROR_MEMORY_ALLOCATION;
+        return;
+    }
+
+    off_t pos = r->begin;
+    size_t carry = 0;
+    int skipping = 0; // inside an overlong row that did not fit the buffer
+    while (pos < r->end)
+    {
+        size_t want = TALLY_CHUNK_SIZE - carry;
+        if ((off_t)want > r->end - pos)
+            want = (size_t)(r->end - pos);
+        ssize_t n = pread(r->src->fd, buf + carry, want, pos);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            r->rc = DATA_ERROR_MALFORMED_DATA;
+            break;
+        }
+        pos += n;
+        size_t avail = carry + (size_t)n;
+        size_t start = 0;
+        if (skipping)
+        {
+            const char *nl = memchr(buf, '\n', avail);
+            if (!nl)
+            {
+                carry = 0;
+                continue;
+            }
+            start = (size_t)(nl - buf) + 1;
+            skipping = 0;
+        }
+        size_t used = start + count_lines(r->ix, buf + start, avail - start, r->field, r->counts, &r->stats);
+        carry = avail - used;
+        if (carry == TALLY_CHUNK_SIZE)
+        {
+            // A single row larger than the buffer cannot be a valid vote
+            r->stats.rows++;
+            r->stats.malformed++;
+            skipping = 1;
+            carry = 0;
+        }
+        else if (carry > 0 && used > 0)
+        {
+            memmove(buf, buf + used, carry);
+        }
+    }
+    if (r->rc == DATA_SUCCESS && carry > 0 && !skipping)
+        count_tail(r->ix, buf, carry, r->field, r->counts, &r->stats);
+    free(buf);
+}
+
+static void *count_range(void *arg)
+{
+    tally_range_t *r = arg;
+    r->rc = DATA_SUCCESS;
+    if (vote_source_is_mapped(r->src))
+        count_mapped_range(r);
+    else
+        count_buffered_range(r);
+    return NULL;
+}
+
+/**
+ * Count a non-seekable source sequentially through the read() buffer
+ */
+static int count_stream(const tally_index_t *ix, vote_source_t *src, int field,
+                        int counts[], tally_stats_t *stats)
+{
+    tally_stats_t local = {0};
+    if (!stats)
+        stats = &local;
+    vote_field_t line;
+    int rc = vote_source_next_line(src, &line); // header
+    while (rc == 1 && (rc = vote_source_next_line(src, &line)) == 1)
+    {
+        stats->rows++;
+        count_line(ix, line.ptr, line.len, field, counts, stats);
+    }
+    return rc < 0 ? rc : DATA_SUCCESS;
+}
+
+static int resolve_thread_count(int threads, off_t data_bytes)
+{
+    if (threads <= 0)
+    {
+#if defined(_SC_NPROCESSORS_ONLN)
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+#else
+        threads = 1;
+#endif
+    }
+    if (threads > TALLY_MAX_THREADS)
+        threads = TALLY_MAX_THREADS;
+    // Not worth a thread per range below a minimum slice size
+    off_t max_by_size = data_bytes / TALLY_MIN_RANGE_BYTES;
+    if (max_by_size < 1)
+        max_by_size = 1;
+    if ((off_t)threads > max_by_size)
+        threads = (int)max_by_size;
+#ifdef TALLY_NO_THREADS
+    threads = 1;
+#endif
+    return threads;
+}
+
+int tally_count_file_parallel(const tally_index_t *ix, const char *path, int field,
+                              int counts[], tally_stats_t *stats, int threads)
+{
+    return tally_count_file_from(ix, path, field, counts, stats, threads, 0, NULL);
+}
+
+int tally_count_file_from(const tally_index_t *ix, const char *path, int field,
+                          int counts[], tally_stats_t *stats, int threads,
+                          long long start, long long *end_offset)
+{
+    if (end_offset)
+        *end_offset = 0;
+    if (!ix || !path || !counts || field < 0 || field > TALLY_MAX_FIELD)
+    {
+        set_error_message("Error: Invalid parameters for tally_count_file");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    vote_source_t src;
+    int rc = vote_source_open(&src, path);
+    if (rc != DATA_SUCCESS)
+        return rc;
+
+    off_t size;
+    if (vote_source_is_mapped(&src))
+    {
+        size = (off_t)src.size;
+    }
+    else
+    {
+        struct stat st;
+        if (fstat(src.fd, &st) != 0)
+        {
+            set_error_message("Error: Cannot stat file '%s': %s", path, strerror(errno));
+            vote_source_close(&src);
+            return DATA_ERROR_FILE_NOT_FOUND;
+        }
+        if (!S_ISREG(st.st_mode))
+        {
+            // Pipes and special files cannot be split, pread or resumed: one streaming pass
+            rc = count_stream(ix, &src, field, counts, stats);
+            vote_source_close(&src);
+            return rc;
+        }
+        size = st.st_size;
+    }
+
+    // Skip the header row (data starts at the first line boundary) unless resuming
+    off_t data_start = start > 0 ? (off_t)start : align_to_line(&src, 1, size);
+    if (data_start > size)
+        data_start = size;
+    int nranges = resolve_thread_count(threads, size - data_start);
+
+    tally_range_t *ranges = calloc((size_t)nranges, sizeof(*ranges));
+    if (!ranges)
+    {
+        vote_source_close(&src);
+        set_error_message("Error: Memory allocation failed for tally ranges");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+
+    off_t span = (size - data_start) / nranges;
+    off_t begin = data_start;
+    for (int i = 0; i < nranges; i++)
+    {
+        tally_range_t *r = &ranges[i];
+        r->ix = ix;
+        r->src = &src;
+        r->field = field;
+        r->begin = begin;
+        r->end = (i == nranges - 1) ? size : align_to_line(&src, data_start + span * (i + 1), size);
+        if (r->end < r->begin)
+            r->end = r->begin;
+        begin = r->end;
+        // The first range counts straight into the caller's array
+        r->counts = (i == 0) ? counts : calloc((size_t)(ix->count > 0 ? ix->count : 1), sizeof(int));
+        if (!r->counts)
+            rc = DATA_ERROR_MEMORY_ALLOCATION;
+    }
+
+#ifndef TALLY_NO_THREADS
+    pthread_t *tids = NULL;
+    int started = 0;
+    if (rc == DATA_SUCCESS && nranges > 1)
+    {
+        tids = malloc(sizeof(*tids) * (size_t)nranges);
+        if (!tids)
+            rc = DATA_ERROR_MEMORY_ALLOCATION;
+        for (int i = 1; rc == DATA_SUCCESS && i < nranges; i++)
+        {
+            if (pthread_create(&tids[i], NULL, count_range, &ranges[i]) != 0)
+            {
+                // Count the remaining ranges on this thread instead
+                break;
+            }
+            started = i;
+        }
+    }
+    if (rc == DATA_SUCCESS)
+    {
+        count_range(&ranges[0]);
+        for (int i = started + 1; i < nranges; i++)
+            count_range(&ranges[i]);
+    }
+    for (int i = 1; i <= started; i++)
+        pthread_join(tids[i], NULL);
+    free(tids);
+#else
+    for (int i = 0; rc == DATA_SUCCESS && i < nranges; i++)
+        count_range(&ranges[i]);
+#endif
+
+    // Merge private counters into the caller's array
+    tally_stats_t local = {0};
+    if (!stats)
+        stats = &local;
+    for (int i = 0; i < nranges; i++)
+    {
+        tally_range_t *r = &ranges[i];
+        if (rc == DATA_SUCCESS && r->rc != DATA_SUCCESS)
+            rc = r->rc;
+        if (i > 0 && r->counts)
+        {
+            for (int c = 0; c < ix->count; c++)
+                counts[c] += r->counts[c];
+            free(r->counts);
+        }
+        stats->rows += r->stats.rows;
+        stats->counted += r->stats.counted;
+        stats->unknown += r->stats.unknown;
+        stats->malformed += r->stats.malformed;
+    }
+    free(ranges);
+
+    // Only a newline-terminated log is a safe resume point; a row still being
+    // appended would otherwise be split across two runs
+    if (rc == DATA_SUCCESS && end_offset)
+    {
+        char last = '\n';
+        if (size > data_start)
+        {
+            if (vote_source_is_mapped(&src))
+                last = src.data[size - 1];
+            else if (pread(src.fd, &last, 1, size - 1) != 1)
+                last = '\0';
+        }
+        *end_offset = (last == '\n') ? (long long)size : 0;
+    }
+    vote_source_close(&src);
+
+    if (rc != DATA_SUCCESS)
+        set_error_message("Error: Failed to tally votes from '%s'", path);
+    return rc;
+}
+
+int tally_count_file(const tally_index_t *ix, const char *path, int field,
+                     int counts[], tally_stats_t *stats)
+{
+    return tally_count_file_parallel(ix, path, field, counts, stats, 1);
+}
+
+/* ==== Incremental checkpoints ==== */
+
+// Bytes before the checkpoint offset that must be unchanged to resume
+#define TALLY_CKPT_TAIL_BYTES 64
+
+/**
+ * Hash the bytes just before offset to detect a rewritten vote log
+ */
+static int hash_tail(const char *path, long long offset, unsigned int *out)
+{
+    char buf[TALLY_CKPT_TAIL_BYTES];
+    long long from = offset > TALLY_CKPT_TAIL_BYTES ? offset - TALLY_CKPT_TAIL_BYTES : 0;
+    size_t want = (size_t)(offset - from);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    ssize_t n = want > 0 ? pread(fd, buf, want, (off_t)from) : 0;
+    close(fd);
+    if (n != (ssize_t)want)
+        return 0;
+    *out = hash_bytes(buf, want);
+    return 1;
+}
+
+/**
+ * Hash the ordered candidate id set so roster changes force a recount
+ */
+static unsigned int hash_candidates(const tally_index_t *ix)
+{
+    unsigned int h = 2166136261u;
+    for (int i = 0; i < ix->count; i++)
+    {
+        h ^= hash_bytes(ix->ids[i], ix->id_lens[i]);
+        h *= 16777619u;
+    }
+    return h ^ (unsigned int)ix->count;
+}
+
+int tally_checkpoint_load(const char *ckpt_path, const char *votes_path, const tally_index_t *ix,
+                          int counts[], tally_stats_t *stats, long long *offset)
+{
+    if (!ckpt_path || !votes_path || !ix || !counts || !offset)
+        return 0;
+    *offset = 0;
+
+    FILE *fp = fopen(ckpt_path, "r");
+    if (!fp)
+        return 0;
+
+    unsigned long long dev = 0, ino = 0;
+    long long ck_offset = -1;
+    unsigned int tail = 0, roster = 0;
+    tally_stats_t saved = {0};
+    int version = 0, in_counts = 0, ok = 1;
+    char line[MAX_LINE_LENGTH];
+
+    // Counts are staged so a bad checkpoint leaves the caller's array untouched
+    int *staged = calloc((size_t)(ix->count > 0 ? ix->count : 1), sizeof(int));
+    if (!staged)
+    {
+        fclose(fp);
+        return 0;
+    }
+
+    while (ok && fgets(line, sizeof(line), fp))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '#' || line[0] == '\0')
+            continue;
+        if (strcmp(line, "[COUNTS]") == 0)
+        {
+            in_counts = 1;
+            continue;
+        }
+        if (in_counts)
+        {
+            char *comma = strrchr(line, ',');
+            if (!comma)
+            {
+                ok = 0;
+                break;
+            }
+            int slot = tally_index_lookup(ix, line, (size_t)(comma - line));
+            if (slot < 0)
+            {
+                ok = 0; // roster hash should have caught this
+                break;
+            }
+            staged[slot] = atoi(comma + 1);
+            continue;
+        }
+        if (sscanf(line, "version=%d", &version) == 1 ||
+            sscanf(line, "device=%llu", &dev) == 1 ||
+            sscanf(line, "inode=%llu", &ino) == 1 ||
+            sscanf(line, "offset=%lld", &ck_offset) == 1 ||
+            sscanf(line, "tail_hash=%u", &tail) == 1 ||
+            sscanf(line, "roster_hash=%u", &roster) == 1 ||
+            sscanf(line, "rows=%ld", &saved.rows) == 1 ||
+            sscanf(line, "counted=%ld", &saved.counted) == 1 ||
+            sscanf(line, "unknown=%ld", &saved.unknown) == 1 ||
+            sscanf(line, "malformed=%ld", &saved.malformed) == 1)
+            continue;
+    }
+    fclose(fp);
+
+    // Resume only if this is the same, merely appended-to vote log
+    struct stat st;
+    unsigned int cur_tail = 0;
+    if (!ok || version != TALLY_CKPT_VERSION || ck_offset <= 0 ||
+        stat(votes_path, &st) != 0 ||
+        (unsigned long long)st.st_dev != dev || (unsigned long long)st.st_ino != ino ||
+        (long long)st.st_size < ck_offset ||
+        roster != hash_candidates(ix) ||
+        !hash_tail(votes_path, ck_offset, &cur_tail) || cur_tail != tail)
+    {
+        free(staged);
+        return 0;
+    }
+
+    for (int i = 0; i < ix->count; i++)
+        counts[i] += staged[i];
+    free(staged);
+    if (stats)
+    {
+        stats->rows += saved.rows;
+        stats->counted += saved.counted;
+        stats->unknown += saved.unknown;
+        stats->malformed += saved.malformed;
+    }
+    *offset = ck_offset;
+    return 1;
+}
+
+int tally_checkpoint_save(const char *ckpt_path, const char *votes_path, const tally_index_t *ix,
+                          const int counts[], const tally_stats_t *stats, long long offset)
+{
+    if (!ckpt_path || !votes_path || !ix || !counts || !stats)
+    {
+        set_error_message("Error: Invalid parameters for tally_checkpoint_save");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    struct stat st;
+    unsigned int tail = 0;
+    if (stat(votes_path, &st) != 0 || !hash_tail(votes_path, offset, &tail))
+    {
+        set_error_message("Error: Cannot fingerprint '%s' for checkpoint", votes_path);
+        return DATA_ERROR_FILE_NOT_FOUND;
+    }
+
+    char tmp_path[MAX_LINE_LENGTH];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", ckpt_path);
+    FILE *fp = fopen(tmp_path, "w");
+    if (!fp)
+    {
+        set_error_message("Error: Cannot write checkpoint '%s': %s", tmp_path, strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+
+    fprintf(fp, "# VoteMe tally checkpoint - safe to delete (forces a full recount)\n");
+    fprintf(fp, "version=%d\n", TALLY_CKPT_VERSION);
+    fprintf(fp, "source=%s\n", votes_path);
+    fprintf(fp, "device=%llu\n", (unsigned long long)st.st_dev);
+    fprintf(fp, "inode=%llu\n", (unsigned long long)st.st_ino);
+    fprintf(fp, "offset=%lld\n", offset);
+    fprintf(fp, "tail_hash=%u\n", tail);
+    fprintf(fp, "roster_hash=%u\n", hash_candidates(ix));
+    fprintf(fp, "rows=%ld\n", stats->rows);
+    fprintf(fp, "counted=%ld\n", stats->counted);
+    fprintf(fp, "unknown=%ld\n", stats->unknown);
+    fprintf(fp, "malformed=%ld\n", stats->malformed);
+    fprintf(fp, "[COUNTS]\n");
+    for (int i = 0; i < ix->count; i++)
+    {
+        if (counts[i] != 0 && tally_index_lookup(ix, ix->ids[i], ix->id_lens[i]) == i)
+            fprintf(fp, "%s,%d\n", ix->ids[i], counts[i]);
+    }
+
+    if (fclose(fp) != 0)
+    {
+        remove(tmp_path);
+        set_error_message("Error: Failed to write checkpoint '%s': %s", tmp_path, strerror(errno));
+        return DATA_ERROR_DISK_FULL;
+    }
+    if (rename(tmp_path, ckpt_path) != 0)
+    {
+        remove(tmp_path);
+        set_error_message("Error: Failed to install checkpoint '%s': %s", ckpt_path, strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+    return DATA_SUCCESS;
+}
@@ -0,0 +1,191 @@
+/*
+ * VoteMe Tally Engine Header
+ *
+ * Resolves candidate_number strings to dense array slots in O(1) so that
+ * counting a vote log costs O(votes) instead of O(votes x candidates).
+ *
+ * Resolution strategy:
+ * 1. Ids of the form <prefix><digits> (e.g. "C278") sharing the dominant
+ *    prefix are decoded straight into a direct-mapped table.
+ * 2. Everything else (irregular ids, colliding numeric values such as
+ *    "C1" vs "C001") goes into an open-addressing hash table.
+ * Both paths verify the full id, so matching stays exact like strcmp.
+ */
+
+#ifndef TALLY_H
+#define TALLY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "csv_io.h"
+
+// Candidate id -> slot index
+typedef struct
+{
+    const char **ids;    // borrowed candidate_number strings, one per slot
+    size_t *id_lens;     // cached strlen of each id
+    int count;           // number of slots
+
+    char prefix[16];     // shared alphabetic prefix for direct decoding ("C")
+    size_t prefix_len;   // 0 when direct decoding is disabled
+    int *direct;         // numeric suffix -> slot, -1 when empty
+    size_t direct_size;
+
+    int *hash_slots;     // open addressing table of slots, -1 when empty
+    size_t hash_mask;    // capacity - 1 (capacity is a power of two)
+} tally_index_t;
+
+// Per-run counting statistics
+typedef struct
+{
+    long rows;           // data rows seen (header excluded)
+    long counted;        // votes attributed to a known candidate
+    long unknown;        // well-formed votes for a candidate not in the index
+    long malformed;      // rows without a candidate field
+} tally_stats_t;
+
+// Interned strings of a candidate table (party_id, district_id)
+typedef struct
+{
+    uint32_t *names;     // pool offsets, one per interned string
+    int count;
+    int capacity;
+    int *slots;          // open addressing over names, -1 when empty
+    size_t mask;         // capacity - 1, 0 when empty
+} tally_names_t;
+
+// Candidate roster as struct-of-arrays: counting and ranking only touch the
+// dense hot columns, the strings live in a cold pool reached by offset
+typedef struct
+{
+    int count;
+    int capacity;        // grows on demand, no fixed roster limit
+
+    // Hot columns, one entry per candidate in file order
+    int *votes;
+    unsigned char *qualified;
+    int *seat_rank;      // 1-based seat for parliament members, 0 otherwise
+    int *party;          // index into parties
+    int *district;       // index into districts
+
+    // Cold side table
+    uint32_t *number;    // pool offset of candidate_number
+    uint32_t *name;      // pool offset of the candidate name
+    char *pool;          // NUL-terminated strings
+    size_t pool_used;
+    size_t pool_size;
+    tally_names_t parties;
+    tally_names_t districts;
+} tally_table_t;
+
+/**
+ * Append a candidate; missing fields (NULL spans) are stored as ""
+ * @return Row index on success, DATA_ERROR_MEMORY_ALLOCATION on failure
+ */
+int tally_table_add(tally_table_t *t, const csv_span_t *number, const csv_span_t *name,
+                    const csv_span_t *party_id, const csv_span_t *district_id);
+
+/**
+ * Cold string accessors (valid until the next tally_table_add)
+ */
+const char *tally_table_number(const tally_table_t *t, int row);
+const char *tally_table_name(const tally_table_t *t, int row);
+const char *tally_table_party_id(const tally_table_t *t, int row);
+const char *tally_table_district_id(const tally_table_t *t, int row);
+
+/**
+ * Release everything the table owns (safe on a zeroed table)
+ */
+void tally_table_free(tally_table_t *t);
+
+/**
+ * Build a lookup index over candidate ids
+ * @param ix Index to initialize
+ * @param ids Array of candidate_number strings (must outlive the index)
+ * @param count Number of ids
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int tally_index_build(tally_index_t *ix, const char *const ids[], int count);
+
+/**
+ * Resolve a candidate id to its slot
+ * @param ix Built index
+ * @param id Candidate id bytes (need not be NUL-terminated)
+ * @param len Length of id
+ * @return Slot index, or -1 if the id is unknown
+ */
+int tally_index_lookup(const tally_index_t *ix, const char *id, size_t len);
+
+/**
+ * Release memory owned by the index (the id strings are not freed)
+ */
+void tally_index_free(tally_index_t *ix);
+
+/**
+ * Count votes from a CSV vote log with a header row
+ * @param ix Built candidate index
+ * @param path Vote file (data/votes.txt or data/temp-voted-list.txt)
+ * @param field Zero-based column holding the candidate id
+ * @param counts Per-slot counters (incremented, not reset)
+ * @param stats Optional statistics output (incremented, not reset)
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int tally_count_file(const tally_index_t *ix, const char *path, int field,
+                     int counts[], tally_stats_t *stats);
+
+/**
+ * Count votes with the file split into line-aligned byte ranges
+ *
+ * Each range is counted on its own worker thread into a private counter
+ * array; the arrays are merged into counts at the end. The file is read
+ * through vote_source (zero-copy mmap, pread fallback when unmappable). Small files are
+ * counted on fewer threads so the split never costs more than it saves.
+ *
+ * @param threads Worker count; 0 uses the number of online CPUs, 1 counts
+ *                on the calling thread only
+ * Other parameters and return value as tally_count_file.
+ */
+int tally_count_file_parallel(const tally_index_t *ix, const char *path, int field,
+                              int counts[], tally_stats_t *stats, int threads);
+
+/**
+ * Count votes from a byte offset onward (incremental re-runs)
+ * @param start Offset of the first unprocessed byte; 0 starts after the header
+ * @param end_offset Optional output: file size covered by this pass, i.e. the
+ *                   offset the next run can resume from (0 when the log does
+ *                   not end on a complete row and cannot be resumed)
+ * Other parameters and return value as tally_count_file_parallel.
+ */
+int tally_count_file_from(const tally_index_t *ix, const char *path, int field,
+                          int counts[], tally_stats_t *stats, int threads,
+                          long long start, long long *end_offset);
+
+/* ==== Incremental checkpoints (data/tally.ckpt) ==== */
+
+#define TALLY_CHECKPOINT_FILE "data/tally.ckpt"
+
+/**
+ * Restore counts from a checkpoint if it still describes votes_path
+ *
+ * The checkpoint is accepted only when the vote log has the same
+ * device/inode, is at least as large as the checkpointed offset, the bytes
+ * just before that offset are unchanged, and the candidate roster is the
+ * same. Anything else (truncation, rewrite, roster edit) means a full recount.
+ *
+ * @param counts Per-slot counters to add the saved counts to
+ * @param stats Optional statistics to add the saved totals to
+ * @param offset Output resume offset (0 when not resumed)
+ * @return 1 if resumed, 0 if a full recount is required
+ */
+int tally_checkpoint_load(const char *ckpt_path, const char *votes_path, const tally_index_t *ix,
+                          int counts[], tally_stats_t *stats, long long *offset);
+
+/**
+ * Atomically write a checkpoint (temp file + rename)
+ * @param offset Offset up to which counts/stats cover votes_path
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int tally_checkpoint_save(const char *ckpt_path, const char *votes_path, const tally_index_t *ix,
+                          const int counts[], const tally_stats_t *stats, long long offset);
+
+#endif // TALLY_H
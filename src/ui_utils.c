@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "csv_io.h"
 #include "ui_utils.h"
 
 void display_banner(void)
@@ -90,17 +91,20 @@ int count_records_in_file(const char *filename)
     if (!fp)
         return -1;
 
-    int count = 0;
-    char line[256];
-
-    if (fgets(line, sizeof(line), fp))
+    // Count newlines a block at a time instead of line by line
+    char buf[32 * 1024];
+    size_t lines = 0;
+    char last = '\n';
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
     {
-        while (fgets(line, sizeof(line), fp))
-        {
-            count++;
-        }
+        lines += csv_count_newlines(buf, n);
+        last = buf[n - 1];
     }
+    if (last != '\n')
+        lines++; // final row without a newline
 
     fclose(fp);
-    return count;
+    // The first row is the header
+    return lines > 0 ? (int)(lines - 1) : 0;
 }
@@ -1,12 +1,23 @@
 #include <stdio.h>
+#include <string.h>
 #include "voting-interface.h"
 #include "data_errors.h"
 
-int main(void)
+// Usage: vote                   record votes in this process
+//        vote --server [path]   send them to a running votemed
+int main(int argc, char **argv)
 {
+    int remote = argc >= 2 && strcmp(argv[1], "--server") == 0;
+    if ((argc >= 2 && !remote) || argc > 3)
+    {
+        fprintf(stderr, "Usage: %s [--server [socket_path]]\n", argv[0]);
+        return 1;
+    }
+
     printf("\nWelcome to VoteMe - Voter Interface\n");
     printf("-----------------------------------\n\n");
-    int rc = vote_for_candidate_interactive();
+    int rc = remote ? vote_for_candidate_interactive_remote(argc == 3 ? argv[2] : NULL)
+                    : vote_for_candidate_interactive();
     if (rc == DATA_SUCCESS)
     {
         printf("\n✅ Vote recorded successfully.\n");
@@ -0,0 +1,1667 @@
+/*
+ * VoteMe Vote Journal Implementation
+ *
+ * Journal records (text, one per line):
+ *   V <voting_number>,<candidate_number>,<party_id>   vote of the next commit
+ *   C <batch_id> <votes> <hash>                       commits the V lines above
+ *   A <batch_id>                                      batch is in both data files
+ *                                                     (rides on the next batch's write)
+ *
+ * A batch (its V lines plus C line) goes out in a single write() while the
+ * journal is fcntl-locked, so batches from concurrent processes never
+ * interleave. V lines without a matching, intact C line are a torn write and
+ * are ignored on replay.
+ */
+
+// fdatasync/pread/clock_gettime need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if defined(_WIN32)
+#define VOTE_JOURNAL_NO_THREADS
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#endif
+
+#include "csv_io.h"
+#include "data_handler_enhanced.h"
+#include "sys_config.h"
+#include "vote_journal.h"
+#include "voted_set.h"
+
+#define TEMP_VOTED_FILE "data/temp-voted-list.txt"
+#define TEMP_VOTED_HEADER "voting_number,candidate_number,party_id"
+#define VOTES_FILE "data/votes.txt"
+#define VOTES_HEADER "voter_id,candidate_id"
+#define APPROVED_VOTERS_FILE "data/approved_voters.txt"
+
+// Votes per batch before the group commit fires early
+#define VOTE_JOURNAL_MAX_BATCH 512
+// Slots of the group-commit ballot ring (a power of two)
+#define VOTE_JOURNAL_RING_SIZE 4096
+// Journal size at which an applied journal is truncated after a commit
+#define VOTE_JOURNAL_COMPACT_BYTES (1024 * 1024)
+
+typedef struct
+{
+    char voting_number[51];
+    char candidate_number[51];
+    char party_id[21];
+    struct timespec queued; // CLOCK_MONOTONIC, for the enqueue-to-durable latency
+} journal_vote_t;
+
+static struct
+{
+    int open;
+    int fd;
+    int sync_ms;
+    unsigned long seq;
+
+    long long journal_end; // journal size after our last write, -1 when unknown
+    char unmarked[48];     // applied batch whose "A" record rides on the next write
+
+    journal_vote_t *queue; // votes not committed yet (the batch being built)
+    int count;
+    int capacity;
+    struct timespec first_queued; // CLOCK_MONOTONIC
+
+    voted_set_t voted;     // who is in the temp list (data/voted.bitmap)
+    int voted_open;
+
+#ifndef VOTE_JOURNAL_NO_THREADS
+    pthread_t flusher;
+    int flusher_running;
+    int stopping;
+#endif
+} journal;
+
+#ifndef VOTE_JOURNAL_NO_THREADS
+static pthread_mutex_t journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define JOURNAL_LOCK() pthread_mutex_lock(&journal_mutex)
+#define JOURNAL_UNLOCK() pthread_mutex_unlock(&journal_mutex)
+#define STAT_ADD(field, n) __atomic_add_fetch(&stats.field, (n), __ATOMIC_RELAXED)
+#define STAT_LOAD(field) __atomic_load_n(&stats.field, __ATOMIC_RELAXED)
+#else
+#define JOURNAL_LOCK() ((void)0)
+#define JOURNAL_UNLOCK() ((void)0)
+#define STAT_ADD(field, n) (stats.field += (n))
+#define STAT_LOAD(field) (stats.field)
+#endif
+
+// Counters behind vote_journal_stats. The vote counts are atomic because
+// ring producers update them without journal_mutex; latencies are only
+// touched by the committer, under journal_mutex.
+static struct
+{
+    unsigned long long enqueued;
+    unsigned long long durable;
+    unsigned long long dropped;
+    unsigned long long max_depth;
+    unsigned long long full_waits;
+    unsigned long long latency_sum_ns;
+    unsigned long long latency_max_ns;
+} stats;
+
+// A data file derived from the journal, kept open between batches
+typedef struct
+{
+    const char *path;
+    const char *header;
+    int fd;
+    long long end; // where our last append ended (append_rows_fd known_end)
+} journal_view_t;
+
+static journal_view_t views[2] = {
+    {TEMP_VOTED_FILE, TEMP_VOTED_HEADER, -1, -1},
+    {VOTES_FILE, VOTES_HEADER, -1, -1}};
+
+/* ==== Small helpers ==== */
+
+// FNV-1a 64, over the V lines of a batch
+static unsigned long long hash_bytes(unsigned long long h, const char *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        h ^= (unsigned char)p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+#define HASH_SEED 14695981039346656037ULL
+
+// Exclusive fcntl lock on the whole journal (blocks until granted)
+static int lock_journal(int fd, int type)
+{
+    struct flock fl;
+    memset(&fl, 0, sizeof(fl));
+    fl.l_type = (short)type;
+    fl.l_whence = SEEK_SET;
+    while (fcntl(fd, F_SETLKW, &fl) != 0)
+    {
+        if (errno != EINTR)
+        {
+            set_error_message("Error: Cannot lock vote journal: %s", strerror(errno));
+            return DATA_ERROR_PERMISSION_DENIED;
+        }
+    }
+    return DATA_SUCCESS;
+}
+
+static int write_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return 0;
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+// Grow-on-demand text buffer for batch and row blocks
+typedef struct
+{
+    char *data;
+    size_t len;
+    size_t cap;
+} text_buf_t;
+
+static int buf_printf(text_buf_t *b, const char *fmt, ...)
+{
+    for (;;)
+    {
+        size_t room = b->cap - b->len;
+        int n = -1;
+        if (room > 0)
+        {
+            va_list ap;
+            va_start(ap, fmt);
+            n = vsnprintf(b->data + b->len, room, fmt, ap);
+            va_end(ap);
+        }
+        if (n >= 0 && (size_t)n < room)
+        {
+            b->len += (size_t)n;
+            return 1;
+        }
+        size_t cap = b->cap ? b->cap * 2 : 4096;
+        while (n >= 0 && cap < b->len + (size_t)n + 1)
+            cap *= 2;
+        char *grown = realloc(b->data, cap);
+        if (!grown)
+            return 0;
+        b->data = grown;
+        b->cap = cap;
+    }
+}
+
+static void add_ms(struct timespec *ts, int ms)
+{
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static long long elapsed_ns(const struct timespec *since, const struct timespec *now)
+{
+    return (long long)(now->tv_sec - since->tv_sec) * 1000000000LL + (now->tv_nsec - since->tv_nsec);
+}
+
+static int deadline_passed(void)
+{
+    struct timespec deadline = journal.first_queued, now;
+    add_ms(&deadline, journal.sync_ms);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline.tv_sec ||
+           (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec);
+}
+
+static int fsync_path(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return errno == ENOENT; // nothing to sync
+    int ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+// before receives the file's stat() from just before the append
+static int view_append(journal_view_t *v, const char *rows, size_t len, struct stat *before)
+{
+    // A rewrite (clear_temp_voted, update/delete) renames a new file over the
+    // one we hold; appends to the old inode would be lost, so reopen
+    if (v->fd >= 0 && (fstat(v->fd, before) != 0 || before->st_nlink == 0))
+    {
+        close(v->fd);
+        v->fd = -1;
+    }
+    if (v->fd < 0)
+    {
+        v->fd = open(v->path, O_RDWR | O_APPEND | O_CREAT, 0644);
+        if (v->fd < 0 || fstat(v->fd, before) != 0)
+        {
+            set_error_message("Error: Cannot open file '%s' for appending: %s", v->path, strerror(errno));
+            return errno == ENOSPC ? DATA_ERROR_DISK_FULL : DATA_ERROR_PERMISSION_DENIED;
+        }
+        v->end = -1;
+    }
+    return append_rows_fd(v->fd, v->path, v->header, rows, len, &v->end);
+}
+
+static void close_views(void)
+{
+    for (size_t i = 0; i < sizeof(views) / sizeof(views[0]); i++)
+    {
+        if (views[i].fd >= 0)
+            close(views[i].fd);
+        views[i].fd = -1;
+        views[i].end = -1;
+    }
+}
+
+// Keep the voted set current across our own temp-list append. A set that
+// was already stale, or cannot be updated, is left for the next check to rebuild.
+static void voted_note_applied(const journal_vote_t *votes, int n, const struct stat *before)
+{
+    struct stat after;
+    if (!journal.voted_open || !voted_set_is_current(&journal.voted, before) || fstat(views[0].fd, &after) != 0)
+        return;
+    for (int i = 0; i < n; i++)
+    {
+        if (voted_set_add(&journal.voted, votes[i].voting_number) < 0)
+            return;
+    }
+    voted_set_stamp(&journal.voted, &after);
+}
+
+// Append the temp-list and votes rows of a set of votes, one write per file
+static int apply_votes(const journal_vote_t *votes, int n)
+{
+    text_buf_t temp_rows = {0}, vote_rows = {0};
+    struct stat before;
+    int rc = DATA_SUCCESS;
+    for (int i = 0; i < n && rc == DATA_SUCCESS; i++)
+    {
+        if (!buf_printf(&temp_rows, "%s,%s,%s\n", votes[i].voting_number, votes[i].candidate_number, votes[i].party_id) ||
+            !buf_printf(&vote_rows, "%s,%s\n", votes[i].voting_number, votes[i].candidate_number))
+        {
+            set_error_message("Error: Memory allocation failed while applying votes");
+            rc = DATA_ERROR_MEMORY_ALLOCATION;
+        }
+    }
+    if (rc == DATA_SUCCESS && temp_rows.len > 0)
+    {
+        rc = view_append(&views[0], temp_rows.data, temp_rows.len, &before);
+        if (rc == DATA_SUCCESS)
+            voted_note_applied(votes, n, &before);
+    }
+    if (rc == DATA_SUCCESS && vote_rows.len > 0)
+        rc = view_append(&views[1], vote_rows.data, vote_rows.len, &before);
+    free(temp_rows.data);
+    free(vote_rows.data);
+    return rc;
+}
+
+/* ==== Replay ==== */
+
+typedef struct
+{
+    char id[48];
+    int first; // index of its first vote
+    int count;
+    int applied;
+} journal_batch_t;
+
+// 1 if the voter has a row in the file, 0 if not (or there is no file yet),
+// negative when the file could not be read
+static int voter_in_file(const char *path, const char *voting_number)
+{
+    char key[MAX_LINE_LENGTH];
+    snprintf(key, sizeof(key), "0:%s", voting_number);
+    char *primary_keys[] = {key};
+    char *row = read_record(path, primary_keys, 1);
+    if (row)
+    {
+        free(row);
+        return 1;
+    }
+    int code = get_last_error_code();
+    if (code == DATA_ERROR_RECORD_NOT_FOUND)
+        return 0;
+    struct stat st;
+    if (code != DATA_ERROR_MEMORY_ALLOCATION && (stat(path, &st) != 0 ? errno == ENOENT : st.st_size == 0))
+        return 0; // nothing recorded yet
+    return code < 0 ? code : DATA_ERROR_PERMISSION_DENIED;
+}
+
+// Voters of the votes being replayed, with whether each data file has them
+typedef struct
+{
+    int *slots;  // first vote of each voter, -1 when empty
+    size_t mask; // slot count - 1
+    unsigned char *in_temp;
+    unsigned char *in_votes;
+} replay_voters_t;
+
+// Slot of a voter (the slot to fill when absent)
+static size_t replay_slot(const replay_voters_t *rv, const journal_vote_t *votes, const char *voting_number)
+{
+    size_t i = (size_t)hash_bytes(HASH_SEED, voting_number, strlen(voting_number)) & rv->mask;
+    while (rv->slots[i] >= 0 && strcmp(votes[rv->slots[i]].voting_number, voting_number) != 0)
+        i = (i + 1) & rv->mask;
+    return i;
+}
+
+// Set found[] for every replayed voter with a row in the file, in one pass
+// over it (instead of a scan of the file per vote)
+static int replay_scan_file(const char *path, const replay_voters_t *rv, const journal_vote_t *votes,
+                            unsigned char *found)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return errno == ENOENT ? DATA_SUCCESS : DATA_ERROR_PERMISSION_DENIED;
+    char line[MAX_LINE_LENGTH];
+    int continued = 0; // the line did not fit: skip the rest of it
+    while (fgets(line, sizeof(line), fp))
+    {
+        size_t len = strlen(line);
+        int starts = !continued;
+        continued = len > 0 && line[len - 1] != '\n' && !feof(fp);
+        csv_span_t field;
+        if (!starts || csv_split_spans(line, len, ',', &field, 1) < 1)
+            continue;
+        char id[sizeof(votes[0].voting_number)];
+        if (field.len >= sizeof(id))
+            continue;
+        csv_span_copy(&field, id, sizeof(id));
+        size_t slot = replay_slot(rv, votes, id);
+        if (rv->slots[slot] >= 0)
+            found[slot] = 1;
+    }
+    int failed = ferror(fp);
+    fclose(fp);
+    return failed ? DATA_ERROR_PERMISSION_DENIED : DATA_SUCCESS;
+}
+
+// Parse one "V a,b,c" payload into a vote; 0 when malformed
+static int parse_vote(const char *p, size_t len, journal_vote_t *v)
+{
+    char line[MAX_LINE_LENGTH];
+    if (len >= sizeof(line))
+        return 0;
+    memcpy(line, p, len);
+    line[len] = '\0';
+    char *fields[MAX_FIELDS];
+    int n = split_csv_fields(line, fields, MAX_FIELDS, ',');
+    int ok = n == 3 && strlen(fields[0]) < sizeof(v->voting_number) &&
+             strlen(fields[1]) < sizeof(v->candidate_number) && strlen(fields[2]) < sizeof(v->party_id);
+    if (ok)
+    {
+        strcpy(v->voting_number, fields[0]);
+        strcpy(v->candidate_number, fields[1]);
+        strcpy(v->party_id, fields[2]);
+    }
+    for (int i = 0; i < n; i++)
+        free(fields[i]);
+    return ok;
+}
+
+/**
+ * Apply committed batches without an applied mark, then truncate the journal
+ * Caller holds the journal's fcntl lock.
+ */
+static int replay_locked(int fd, int *replayed)
+{
+    if (replayed)
+        *replayed = 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        set_error_message("Error: Cannot stat vote journal: %s", strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+    if (st.st_size == 0)
+        return DATA_SUCCESS;
+
+    size_t size = (size_t)st.st_size;
+    char *data = malloc(size);
+    if (!data)
+    {
+        set_error_message("Error: Memory allocation failed while reading vote journal");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    size_t got = 0;
+    while (got < size)
+    {
+        ssize_t n = pread(fd, data + got, size - got, (off_t)got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        got += (size_t)n;
+    }
+    size = got;
+
+    journal_vote_t *votes = NULL;
+    const char **vote_lines = NULL; // raw "V ..." line of each vote, for the batch hash
+    size_t *vote_lens = NULL;
+    journal_batch_t *batches = NULL;
+    int nvotes = 0, vote_cap = 0, nbatches = 0, batch_cap = 0;
+    int open_first = 0; // first vote after the last C line
+    int rc = DATA_SUCCESS;
+
+    size_t pos = 0;
+    while (pos < size && rc == DATA_SUCCESS)
+    {
+        const char *line = data + pos;
+        const char *nl = memchr(line, '\n', size - pos);
+        if (!nl)
+            break; // torn final record
+        size_t len = (size_t)(nl - line);
+        pos += len + 1;
+
+        if (len > 2 && line[0] == 'V' && line[1] == ' ')
+        {
+            if (nvotes == vote_cap)
+            {
+                int cap = vote_cap ? vote_cap * 2 : 64;
+                journal_vote_t *grown = realloc(votes, (size_t)cap * sizeof(*votes));
+                const char **grown_lines = grown ? realloc(vote_lines, (size_t)cap * sizeof(*vote_lines)) : NULL;
+                size_t *grown_lens = grown_lines ? realloc(vote_lens, (size_t)cap * sizeof(*vote_lens)) : NULL;
+                if (grown)
+                    votes = grown;
+                if (grown_lines)
+                    vote_lines = grown_lines;
+                if (!grown_lens)
+                {
+                    rc = DATA_ERROR_MEMORY_ALLOCATION;
+                    break;
+                }
+                vote_lens = grown_lens;
+                vote_cap = cap;
+            }
+            if (parse_vote(line + 2, len - 2, &votes[nvotes]))
+            {
+                vote_lines[nvotes] = line;
+                vote_lens[nvotes] = len + 1;
+                nvotes++;
+            }
+            continue;
+        }
+
+        char rec[MAX_LINE_LENGTH];
+        if (len >= sizeof(rec))
+            continue;
+        memcpy(rec, line, len);
+        rec[len] = '\0';
+
+        char id[48];
+        int count = 0;
+        unsigned long long hash = 0;
+        if (sscanf(rec, "C %47s %d %llx", id, &count, &hash) == 3)
+        {
+            // The batch is the last <count> votes; anything before them since
+            // the previous commit is a torn batch of a crashed writer
+            int first = nvotes - count;
+            unsigned long long h = HASH_SEED;
+            for (int i = first; count > 0 && first >= open_first && i < nvotes; i++)
+                h = hash_bytes(h, vote_lines[i], vote_lens[i]);
+            if (count > 0 && first >= open_first && h == hash)
+            {
+                if (nbatches == batch_cap)
+                {
+                    int cap = batch_cap ? batch_cap * 2 : 16;
+                    journal_batch_t *grown = realloc(batches, (size_t)cap * sizeof(*batches));
+                    if (!grown)
+                    {
+                        rc = DATA_ERROR_MEMORY_ALLOCATION;
+                        break;
+                    }
+                    batches = grown;
+                    batch_cap = cap;
+                }
+                journal_batch_t *b = &batches[nbatches++];
+                snprintf(b->id, sizeof(b->id), "%s", id);
+                b->first = first;
+                b->count = count;
+                b->applied = 0;
+            }
+            open_first = nvotes;
+        }
+        else if (sscanf(rec, "A %47s", id) == 1)
+        {
+            for (int b = nbatches - 1; b >= 0; b--)
+            {
+                if (strcmp(batches[b].id, id) == 0)
+                {
+                    batches[b].applied = 1;
+                    break;
+                }
+            }
+        }
+    }
+    free(vote_lines);
+    free(vote_lens);
+    free(data);
+
+    if (rc == DATA_ERROR_MEMORY_ALLOCATION)
+        set_error_message("Error: Memory allocation failed while reading vote journal");
+
+    // Each file gets the votes it is missing (a crash can land between the two
+    // appends); the check and the append happen under the files' locks
+    int unapplied = 0;
+    for (int b = 0; b < nbatches; b++)
+        unapplied += batches[b].applied ? 0 : batches[b].count;
+    replay_voters_t rv = {0};
+    if (rc == DATA_SUCCESS && unapplied > 0)
+    {
+        size_t nslots = 16;
+        while (nslots < (size_t)unapplied * 2)
+            nslots *= 2;
+        rv.slots = malloc(nslots * sizeof(*rv.slots));
+        rv.in_temp = calloc(nslots, 1);
+        rv.in_votes = calloc(nslots, 1);
+        rv.mask = nslots - 1;
+        if (!rv.slots || !rv.in_temp || !rv.in_votes)
+        {
+            set_error_message("Error: Memory allocation failed while replaying vote journal");
+            rc = DATA_ERROR_MEMORY_ALLOCATION;
+        }
+        for (size_t i = 0; rc == DATA_SUCCESS && i < nslots; i++)
+            rv.slots[i] = -1;
+        for (int b = 0; b < nbatches && rc == DATA_SUCCESS; b++)
+        {
+            for (int i = batches[b].first; !batches[b].applied && i < batches[b].first + batches[b].count; i++)
+            {
+                size_t slot = replay_slot(&rv, votes, votes[i].voting_number);
+                if (rv.slots[slot] < 0)
+                    rv.slots[slot] = i;
+            }
+        }
+    }
+
+    csv_lock_t temp_lock = {0}, votes_lock = {0};
+    if (rc == DATA_SUCCESS)
+        rc = csv_lock_acquire(&temp_lock, TEMP_VOTED_FILE, 1);
+    if (rc == DATA_SUCCESS)
+        rc = csv_lock_acquire(&votes_lock, VOTES_FILE, 1);
+    if (rc == DATA_SUCCESS && unapplied > 0)
+    {
+        rc = replay_scan_file(TEMP_VOTED_FILE, &rv, votes, rv.in_temp);
+        if (rc == DATA_SUCCESS)
+            rc = replay_scan_file(VOTES_FILE, &rv, votes, rv.in_votes);
+        if (rc != DATA_SUCCESS)
+            set_error_message("Error: Cannot read vote files for replay: %s", strerror(errno));
+    }
+
+    // A voter in several unapplied batches is written once
+    text_buf_t temp_rows = {0}, vote_rows = {0};
+    for (int b = 0; b < nbatches && rc == DATA_SUCCESS && unapplied > 0; b++)
+    {
+        if (batches[b].applied)
+            continue;
+        for (int i = batches[b].first; i < batches[b].first + batches[b].count && rc == DATA_SUCCESS; i++)
+        {
+            const journal_vote_t *v = &votes[i];
+            size_t slot = replay_slot(&rv, votes, v->voting_number);
+            int missing = !rv.in_temp[slot] || !rv.in_votes[slot];
+            if ((!rv.in_temp[slot] &&
+                 !buf_printf(&temp_rows, "%s,%s,%s\n", v->voting_number, v->candidate_number, v->party_id)) ||
+                (!rv.in_votes[slot] && !buf_printf(&vote_rows, "%s,%s\n", v->voting_number, v->candidate_number)))
+            {
+                set_error_message("Error: Memory allocation failed while replaying vote journal");
+                rc = DATA_ERROR_MEMORY_ALLOCATION;
+            }
+            rv.in_temp[slot] = rv.in_votes[slot] = 1;
+            if (rc == DATA_SUCCESS && replayed && missing)
+                (*replayed)++;
+        }
+    }
+    if (rc == DATA_SUCCESS && temp_rows.len > 0)
+        rc = append_rows(TEMP_VOTED_FILE, TEMP_VOTED_HEADER, temp_rows.data, temp_rows.len);
+    if (rc == DATA_SUCCESS && vote_rows.len > 0)
+        rc = append_rows(VOTES_FILE, VOTES_HEADER, vote_rows.data, vote_rows.len);
+    free(temp_rows.data);
+    free(vote_rows.data);
+    free(rv.slots);
+    free(rv.in_temp);
+    free(rv.in_votes);
+    free(votes);
+    free(batches);
+
+    // Everything in the journal is now in the data files: make that durable, then drop it
+    if (rc == DATA_SUCCESS && (!fsync_path(TEMP_VOTED_FILE) || !fsync_path(VOTES_FILE)))
+    {
+        set_error_message("Error: Cannot sync vote files: %s", strerror(errno));
+        rc = DATA_ERROR_DISK_FULL;
+    }
+    csv_lock_release(&votes_lock);
+    csv_lock_release(&temp_lock);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    if (ftruncate(fd, 0) != 0 || fdatasync(fd) != 0)
+    {
+        set_error_message("Error: Cannot truncate vote journal: %s", strerror(errno));
+        return DATA_ERROR_DISK_FULL;
+    }
+    return DATA_SUCCESS;
+}
+
+/* ==== Commit ==== */
+
+// Write the "A" record of the last applied batch on its own (before a replay or close)
+static void write_unmarked(void)
+{
+    if (journal.unmarked[0] == '\0')
+        return;
+    char applied[64];
+    int n = snprintf(applied, sizeof(applied), "A %s\n", journal.unmarked);
+    if (write_all(journal.fd, applied, (size_t)n))
+        journal.unmarked[0] = '\0';
+    journal.journal_end = -1;
+}
+
+static int voted_refresh_locked(void);
+
+// Whether a kept vote of the batch (queue[0..kept)) is by the same voter; if
+// not, the voter is indexed as kept vote number kept. Without slots (no
+// memory for the index) the kept votes are scanned.
+static int batch_seen(int *slots, size_t mask, int kept, const char *voting_number)
+{
+    if (!slots)
+    {
+        for (int k = 0; k < kept; k++)
+        {
+            if (strcmp(journal.queue[k].voting_number, voting_number) == 0)
+                return 1;
+        }
+        return 0;
+    }
+    size_t i = (size_t)hash_bytes(HASH_SEED, voting_number, strlen(voting_number)) & mask;
+    for (; slots[i] >= 0; i = (i + 1) & mask)
+    {
+        if (strcmp(journal.queue[slots[i]].voting_number, voting_number) == 0)
+            return 1;
+    }
+    slots[i] = kept;
+    return 0;
+}
+
+// Drop queued votes of voters another booth recorded since they were checked,
+// and all but the first of a voter queued twice. Caller holds the journal's
+// fcntl lock and the temp list's exclusive lock, so nobody can record one of
+// ours until the batch is applied. Returns 1 when the newest queued vote was dropped.
+static int drop_voted_locked(void)
+{
+    int use_set = voted_refresh_locked() == DATA_SUCCESS;
+    size_t nslots = 16;
+    while (nslots < (size_t)journal.count * 2)
+        nslots *= 2;
+    int *slots = journal.count > 1 ? malloc(nslots * sizeof(*slots)) : NULL;
+    for (size_t i = 0; slots && i < nslots; i++)
+        slots[i] = -1;
+
+    int kept = 0, newest_dropped = 0;
+    for (int i = 0; i < journal.count; i++)
+    {
+        const journal_vote_t *v = &journal.queue[i];
+        // A check that fails keeps the vote: it passed the check at cast time
+        // and has been acknowledged
+        int voted = (use_set ? voted_set_contains(&journal.voted, TEMP_VOTED_FILE, v->voting_number)
+                             : voter_in_file(TEMP_VOTED_FILE, v->voting_number)) > 0;
+        int twice = !voted && journal.count > 1 && batch_seen(slots, nslots - 1, kept, v->voting_number);
+        if (!voted && !twice)
+        {
+            if (kept != i)
+                journal.queue[kept] = *v;
+            kept++;
+            continue;
+        }
+        // Group commit already acknowledged the vote: say so where an operator sees it
+        if (journal.sync_ms > 0)
+            fprintf(stderr, "Warning: vote of '%s' dropped: the voter %s.\n", v->voting_number,
+                    twice ? "already has a vote queued" : "already voted at another booth");
+        if (i == journal.count - 1)
+            newest_dropped = 1;
+    }
+    free(slots);
+    STAT_ADD(dropped, (unsigned long long)(journal.count - kept));
+    journal.count = kept;
+    return newest_dropped;
+}
+
+// Commit and apply the queued votes. Caller holds journal_mutex.
+// Returns DATA_ERROR_DUPLICATE_RECORD when the newest queued vote was dropped
+// because its voter had already voted elsewhere.
+static int commit_locked(void)
+{
+    if (journal.count == 0)
+        return DATA_SUCCESS;
+
+    // Journal first, then the temp list: the lock order of every writer
+    int rc = lock_journal(journal.fd, F_WRLCK);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    csv_lock_t temp_lock;
+    rc = csv_lock_acquire(&temp_lock, TEMP_VOTED_FILE, 1);
+    if (rc != DATA_SUCCESS)
+    {
+        lock_journal(journal.fd, F_UNLCK);
+        return rc;
+    }
+    char newest[sizeof(journal.queue[0].voting_number)];
+    strcpy(newest, journal.queue[journal.count - 1].voting_number);
+    int newest_dropped = drop_voted_locked();
+    if (newest_dropped)
+        set_error_arg(DATA_ERROR_DUPLICATE_RECORD, "Voter '%s' has already voted", newest);
+    if (journal.count == 0)
+    {
+        csv_lock_release(&temp_lock);
+        lock_journal(journal.fd, F_UNLCK);
+        return newest_dropped ? DATA_ERROR_DUPLICATE_RECORD : DATA_SUCCESS;
+    }
+
+    // The previous batch's applied mark shares this batch's write
+    text_buf_t batch = {0};
+    size_t votes_at = 0;
+    int ok = 1;
+    if (journal.unmarked[0])
+    {
+        ok = buf_printf(&batch, "A %s\n", journal.unmarked);
+        votes_at = batch.len;
+    }
+    for (int i = 0; i < journal.count && ok; i++)
+    {
+        const journal_vote_t *v = &journal.queue[i];
+        ok = buf_printf(&batch, "V %s,%s,%s\n", v->voting_number, v->candidate_number, v->party_id);
+    }
+    char id[48], commit[128];
+    snprintf(id, sizeof(id), "%ld.%lu", (long)getpid(), ++journal.seq);
+    if (ok)
+    {
+        snprintf(commit, sizeof(commit), "C %s %d %016llx\n", id, journal.count,
+                 hash_bytes(HASH_SEED, batch.data + votes_at, batch.len - votes_at));
+        ok = buf_printf(&batch, "%s", commit);
+    }
+    if (!ok)
+    {
+        free(batch.data);
+        set_error_message("Error: Memory allocation failed for vote journal batch");
+        csv_lock_release(&temp_lock);
+        lock_journal(journal.fd, F_UNLCK);
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+
+    // A crashed writer may have left a torn line: start ours on a fresh one.
+    // Only checked when someone else wrote since our last batch.
+    struct stat st;
+    if (fstat(journal.fd, &st) != 0)
+        st.st_size = 0;
+    if (st.st_size > 0 && st.st_size != journal.journal_end)
+    {
+        char last = '\n';
+        if (pread(journal.fd, &last, 1, st.st_size - 1) == 1 && last != '\n' && write_all(journal.fd, "\n", 1))
+            st.st_size++;
+    }
+
+    // 1) Durable commit: one write, one fdatasync for the whole batch
+    ok = write_all(journal.fd, batch.data, batch.len);
+    if (ok && journal.sync_ms != VOTE_JOURNAL_SYNC_NONE)
+        ok = fdatasync(journal.fd) == 0;
+    journal.journal_end = ok ? (long long)st.st_size + (long long)batch.len : -1;
+    free(batch.data);
+    if (!ok)
+    {
+        // The queue is kept for a retry; a partially written batch is dropped or deduplicated on replay
+        set_error_message("Error: Failed to commit vote journal: %s", strerror(errno));
+        csv_lock_release(&temp_lock);
+        lock_journal(journal.fd, F_UNLCK);
+        return DATA_ERROR_DISK_FULL;
+    }
+    journal.unmarked[0] = '\0';
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    for (int i = 0; i < journal.count; i++)
+    {
+        unsigned long long ns = (unsigned long long)elapsed_ns(&journal.queue[i].queued, &now);
+        stats.latency_sum_ns += ns;
+        if (ns > stats.latency_max_ns)
+            stats.latency_max_ns = ns;
+    }
+    STAT_ADD(durable, (unsigned long long)journal.count);
+
+    // 2) Apply to both data files; if this fails the batch stays unapplied and is replayed on next open
+    rc = apply_votes(journal.queue, journal.count);
+    if (rc == DATA_SUCCESS)
+    {
+        snprintf(journal.unmarked, sizeof(journal.unmarked), "%s", id);
+        if (journal.journal_end >= VOTE_JOURNAL_COMPACT_BYTES)
+        {
+            write_unmarked();
+            replay_locked(journal.fd, NULL);
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Warning: %d journaled vote(s) could not be applied yet (%s); they will be replayed.\n",
+                journal.count, get_last_error());
+        rc = DATA_SUCCESS; // the votes are durable in the journal
+    }
+    csv_lock_release(&temp_lock);
+    lock_journal(journal.fd, F_UNLCK);
+
+    journal.count = 0;
+    if (newest_dropped)
+    {
+        set_error_arg(DATA_ERROR_DUPLICATE_RECORD, "Voter '%s' has already voted", newest);
+        rc = DATA_ERROR_DUPLICATE_RECORD;
+    }
+    return rc;
+}
+
+// Whether the batch being built has a vote by this voter. Caller holds journal_mutex.
+static int queued_locked(const char *voting_number)
+{
+    for (int i = 0; i < journal.count; i++)
+    {
+        if (strcmp(journal.queue[i].voting_number, voting_number) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+/* ==== Ballot ring ==== */
+
+// Count an accepted vote and track the deepest backlog
+static void note_enqueued(void)
+{
+    unsigned long long enqueued = STAT_ADD(enqueued, 1);
+    unsigned long long settled = STAT_LOAD(durable) + STAT_LOAD(dropped);
+    unsigned long long depth = enqueued > settled ? enqueued - settled : 0;
+#ifndef VOTE_JOURNAL_NO_THREADS
+    unsigned long long max = STAT_LOAD(max_depth);
+    while (depth > max && !__atomic_compare_exchange_n(&stats.max_depth, &max, depth, 1, __ATOMIC_RELAXED,
+                                                       __ATOMIC_RELAXED))
+        ;
+#else
+    if (depth > stats.max_depth)
+        stats.max_depth = depth;
+#endif
+}
+
+#ifndef VOTE_JOURNAL_NO_THREADS
+// Under group commit, booths publish votes into a bounded multi-producer,
+// single-consumer ring; journal_mutex is only taken beforehand to reserve the
+// voter (see the reserved set below), not for the push. Each slot carries a
+// sequence number: equal to a position when the slot is free for it, one
+// past it once that position's vote is published. Producers claim positions
+// with a CAS on tail; whoever holds journal_mutex (normally the flusher) is
+// the single consumer and moves votes from head into the batch.
+typedef struct
+{
+    unsigned long seq;
+    journal_vote_t vote;
+} ring_slot_t;
+
+static struct
+{
+    ring_slot_t *slots;
+    unsigned long mask;
+    unsigned long tail; // next position to claim
+    unsigned long head; // next position to consume
+    int writer_idle;    // the flusher sleeps on wake and wants a post
+    sem_t wake;
+} ring;
+
+static int ring_init(void)
+{
+    ring.slots = malloc(VOTE_JOURNAL_RING_SIZE * sizeof(*ring.slots));
+    if (!ring.slots || sem_init(&ring.wake, 0, 0) != 0)
+    {
+        free(ring.slots);
+        ring.slots = NULL;
+        return 0;
+    }
+    for (unsigned long i = 0; i < VOTE_JOURNAL_RING_SIZE; i++)
+        ring.slots[i].seq = i;
+    ring.mask = VOTE_JOURNAL_RING_SIZE - 1;
+    ring.tail = ring.head = 0;
+    ring.writer_idle = 0;
+    return 1;
+}
+
+static void ring_free(void)
+{
+    if (!ring.slots)
+        return;
+    sem_destroy(&ring.wake);
+    free(ring.slots);
+    ring.slots = NULL;
+}
+
+// Whether the vote at head is published (the consumer has something to take)
+static int ring_ready(void)
+{
+    unsigned long head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&ring.slots[head & ring.mask].seq, __ATOMIC_SEQ_CST) == head + 1;
+}
+
+static void ring_wake_writer(void)
+{
+    if (__atomic_load_n(&ring.writer_idle, __ATOMIC_SEQ_CST) &&
+        __atomic_exchange_n(&ring.writer_idle, 0, __ATOMIC_ACQ_REL))
+        sem_post(&ring.wake);
+}
+
+// Claim a position and publish a vote there; 0 when the ring is full
+static int ring_try_push(const journal_vote_t *v)
+{
+    unsigned long pos = __atomic_load_n(&ring.tail, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        ring_slot_t *slot = &ring.slots[pos & ring.mask];
+        long diff = (long)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0)
+        {
+            // A failed exchange reloads pos
+            if (__atomic_compare_exchange_n(&ring.tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                slot->vote = *v;
+                __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_SEQ_CST);
+                return 1;
+            }
+        }
+        else if (diff < 0)
+        {
+            return 0; // the slot still holds the vote from one lap ago
+        }
+        else
+        {
+            pos = __atomic_load_n(&ring.tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// Publish a vote, waiting for room while the ring is full (backpressure)
+static void ring_push(const journal_vote_t *v)
+{
+    if (!ring_try_push(v))
+    {
+        STAT_ADD(full_waits, 1);
+        for (int spins = 0; !ring_try_push(v); spins++)
+        {
+            ring_wake_writer();
+            if (spins < 64)
+            {
+                sched_yield();
+            }
+            else
+            {
+                struct timespec pause = {0, 100000};
+                nanosleep(&pause, NULL);
+            }
+        }
+    }
+    ring_wake_writer();
+}
+
+// Take the vote at head. Caller holds journal_mutex.
+static int ring_pop(journal_vote_t *out)
+{
+    unsigned long pos = ring.head;
+    ring_slot_t *slot = &ring.slots[pos & ring.mask];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1)
+        return 0; // empty, or its producer has not published yet
+    *out = slot->vote;
+    __atomic_store_n(&slot->seq, pos + ring.mask + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring.head, pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// Voters with a vote pushed into the ring that the flusher has not moved
+// into the batch yet. A producer reserves its voter under journal_mutex
+// before pushing, so a second vote by the same voter is refused before
+// either is acknowledged. Open addressing over voting numbers ("" is free);
+// guarded by journal_mutex.
+static struct
+{
+    char (*slots)[sizeof(((journal_vote_t *)0)->voting_number)];
+    size_t mask;
+    size_t count;
+} reserved;
+
+// Slot holding voting_number, or the free slot where it would go
+static size_t reserved_slot(const char *voting_number)
+{
+    size_t i = (size_t)hash_bytes(HASH_SEED, voting_number, strlen(voting_number)) & reserved.mask;
+    while (reserved.slots[i][0] && strcmp(reserved.slots[i], voting_number) != 0)
+        i = (i + 1) & reserved.mask;
+    return i;
+}
+
+static int reserved_has(const char *voting_number)
+{
+    return reserved.slots && reserved.slots[reserved_slot(voting_number)][0];
+}
+
+// Reserve a voter that is not reserved yet; 0 when out of memory
+static int reserved_add(const char *voting_number)
+{
+    if (!reserved.slots || (reserved.count + 1) * 2 > reserved.mask + 1)
+    {
+        size_t old_cap = reserved.slots ? reserved.mask + 1 : 0;
+        size_t cap = old_cap ? old_cap * 2 : 64;
+        char(*old)[sizeof(*reserved.slots)] = reserved.slots;
+        reserved.slots = calloc(cap, sizeof(*reserved.slots));
+        if (!reserved.slots)
+        {
+            reserved.slots = old;
+            return 0;
+        }
+        reserved.mask = cap - 1;
+        for (size_t i = 0; i < old_cap; i++)
+        {
+            if (old[i][0])
+                strcpy(reserved.slots[reserved_slot(old[i])], old[i]);
+        }
+        free(old);
+    }
+    strcpy(reserved.slots[reserved_slot(voting_number)], voting_number);
+    reserved.count++;
+    return 1;
+}
+
+// Release a voter; later entries of its probe run shift back into the gap
+static void reserved_remove(const char *voting_number)
+{
+    if (!reserved.slots)
+        return;
+    size_t i = reserved_slot(voting_number);
+    if (!reserved.slots[i][0])
+        return;
+    reserved.slots[i][0] = '\0';
+    reserved.count--;
+    for (size_t j = (i + 1) & reserved.mask; reserved.slots[j][0]; j = (j + 1) & reserved.mask)
+    {
+        size_t home = (size_t)hash_bytes(HASH_SEED, reserved.slots[j], strlen(reserved.slots[j])) & reserved.mask;
+        // Move the entry unless its home lies cyclically in (i, j]
+        if (((j - home) & reserved.mask) >= ((j - i) & reserved.mask))
+        {
+            strcpy(reserved.slots[i], reserved.slots[j]);
+            reserved.slots[j][0] = '\0';
+            i = j;
+        }
+    }
+}
+
+static void reserved_free(void)
+{
+    free(reserved.slots);
+    reserved.slots = NULL;
+    reserved.mask = reserved.count = 0;
+}
+
+// Move published votes from the ring into the batch, up to a full batch.
+// Caller holds journal_mutex.
+static void ring_drain_locked(void)
+{
+    while (journal.count < VOTE_JOURNAL_MAX_BATCH)
+    {
+        if (journal.count == journal.capacity)
+        {
+            int cap = journal.capacity ? journal.capacity * 2 : 64;
+            journal_vote_t *grown = realloc(journal.queue, (size_t)cap * sizeof(*grown));
+            if (!grown)
+                return; // the votes wait in the ring
+            journal.queue = grown;
+            journal.capacity = cap;
+        }
+        if (!ring_pop(&journal.queue[journal.count]))
+            return;
+        // From here on the batch search finds the vote
+        reserved_remove(journal.queue[journal.count].voting_number);
+        if (journal.count == 0)
+            journal.first_queued = journal.queue[0].queued;
+        journal.count++;
+    }
+}
+#endif
+
+// Commit everything queued when called, including what is still in the
+// ring. Caller holds journal_mutex. Dropped duplicates were acknowledged
+// and reported, so they do not fail the flush.
+static int flush_locked(void)
+{
+    int rc = DATA_SUCCESS;
+#ifndef VOTE_JOURNAL_NO_THREADS
+    unsigned long until = journal.flusher_running ? __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE) : 0;
+#endif
+    for (;;)
+    {
+#ifndef VOTE_JOURNAL_NO_THREADS
+        if (journal.flusher_running)
+            ring_drain_locked();
+#endif
+        if (journal.count == 0)
+            break;
+        rc = commit_locked();
+        if (rc == DATA_ERROR_DUPLICATE_RECORD)
+            rc = DATA_SUCCESS;
+        if (rc != DATA_SUCCESS)
+            break;
+#ifndef VOTE_JOURNAL_NO_THREADS
+        if (!journal.flusher_running || (long)(ring.head - until) >= 0)
+            break;
+#else
+        break;
+#endif
+    }
+    return rc;
+}
+
+/* ==== Group-commit flusher ==== */
+
+#ifndef VOTE_JOURNAL_NO_THREADS
+// The ring's consumer: drains it into batches and commits a batch when it is
+// full or its first vote has waited sync_ms. Sleeps on ring.wake between.
+static void *flusher_main(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        JOURNAL_LOCK();
+        ring_drain_locked();
+        int stopping = journal.stopping;
+        if (journal.count > 0 && (stopping || journal.count >= VOTE_JOURNAL_MAX_BATCH || deadline_passed()))
+        {
+            int rc = commit_locked();
+            JOURNAL_UNLOCK();
+            if (rc != DATA_SUCCESS && rc != DATA_ERROR_DUPLICATE_RECORD)
+            {
+                // On the way out the batch is left to vote_journal_close's flush
+                if (stopping)
+                    break;
+                fprintf(stderr, "Warning: vote journal commit failed (%s); retrying.\n", get_last_error());
+                struct timespec pause = {journal.sync_ms / 1000, (long)(journal.sync_ms % 1000) * 1000000L};
+                nanosleep(&pause, NULL);
+            }
+            continue;
+        }
+        if (stopping)
+        {
+            JOURNAL_UNLOCK();
+            break;
+        }
+
+        // Sleep until a producer posts or, with a batch open, its deadline
+        struct timespec until;
+        int timed = journal.count > 0;
+        if (timed)
+        {
+            struct timespec deadline = journal.first_queued, now;
+            add_ms(&deadline, journal.sync_ms);
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long long left = elapsed_ns(&now, &deadline);
+            clock_gettime(CLOCK_REALTIME, &until); // sem_timedwait's clock
+            add_ms(&until, left > 0 ? (int)(left / 1000000) + 1 : 0);
+        }
+        JOURNAL_UNLOCK();
+
+        __atomic_store_n(&ring.writer_idle, 1, __ATOMIC_SEQ_CST);
+        if (!ring_ready())
+        {
+            while ((timed ? sem_timedwait(&ring.wake, &until) : sem_wait(&ring.wake)) != 0 && errno == EINTR)
+                ;
+        }
+        __atomic_store_n(&ring.writer_idle, 0, __ATOMIC_SEQ_CST);
+    }
+    return NULL;
+}
+#endif
+
+/* ==== Public API ==== */
+
+int vote_journal_open(void)
+{
+#ifndef VOTE_JOURNAL_NO_THREADS
+    // Appends come through here: an open journal must not cost journal_mutex
+    if (__atomic_load_n(&journal.open, __ATOMIC_ACQUIRE))
+        return DATA_SUCCESS;
+#endif
+    JOURNAL_LOCK();
+    if (journal.open)
+    {
+        JOURNAL_UNLOCK();
+        return DATA_SUCCESS;
+    }
+
+    journal.sync_ms = config_get_int(VOTE_JOURNAL_CONFIG_KEY, VOTE_JOURNAL_SYNC_EVERY_VOTE);
+    if (journal.sync_ms < VOTE_JOURNAL_SYNC_NONE)
+        journal.sync_ms = VOTE_JOURNAL_SYNC_NONE;
+
+    journal.fd = open(VOTE_JOURNAL_FILE, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (journal.fd < 0)
+    {
+        set_error_message("Error: Cannot open vote journal '%s': %s", VOTE_JOURNAL_FILE, strerror(errno));
+        JOURNAL_UNLOCK();
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+
+    int rc = lock_journal(journal.fd, F_WRLCK);
+    if (rc == DATA_SUCCESS)
+    {
+        rc = replay_locked(journal.fd, NULL);
+        // Without the voted set, duplicate checks fall back to the temp list
+        if (rc == DATA_SUCCESS)
+            journal.voted_open = voted_set_open(&journal.voted, VOTED_SET_FILE) == DATA_SUCCESS;
+        lock_journal(journal.fd, F_UNLCK);
+    }
+    if (rc != DATA_SUCCESS)
+    {
+        close(journal.fd);
+        journal.fd = -1;
+        JOURNAL_UNLOCK();
+        return rc;
+    }
+
+    journal.count = 0;
+    journal.journal_end = -1;
+    journal.unmarked[0] = '\0';
+#ifndef VOTE_JOURNAL_NO_THREADS
+    // Without the ring or the flusher, group commit falls back to committing
+    // on the next vote past the window
+    journal.stopping = 0;
+    journal.flusher_running = 0;
+    if (journal.sync_ms > 0 && ring_init())
+    {
+        journal.flusher_running = pthread_create(&journal.flusher, NULL, flusher_main, NULL) == 0;
+        if (!journal.flusher_running)
+            ring_free();
+    }
+    __atomic_store_n(&journal.open, 1, __ATOMIC_RELEASE);
+#else
+    journal.open = 1;
+#endif
+    JOURNAL_UNLOCK();
+    return DATA_SUCCESS;
+}
+
+int vote_journal_append(const char *voting_number, const char *candidate_number, const char *party_id)
+{
+    if (!voting_number || !candidate_number || !party_id || !*voting_number || !*candidate_number || !*party_id ||
+        strlen(voting_number) > 50 || strlen(candidate_number) > 50 || strlen(party_id) > 20 ||
+        strpbrk(voting_number, ",\r\n") || strpbrk(candidate_number, ",\r\n") || strpbrk(party_id, ",\r\n"))
+    {
+        set_error_message("Error: Invalid vote for journal");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    int rc = vote_journal_open();
+    if (rc != DATA_SUCCESS)
+        return rc;
+
+    journal_vote_t vote;
+    strcpy(vote.voting_number, voting_number);
+    strcpy(vote.candidate_number, candidate_number);
+    strcpy(vote.party_id, party_id);
+    clock_gettime(CLOCK_MONOTONIC, &vote.queued);
+
+#ifndef VOTE_JOURNAL_NO_THREADS
+    if (journal.flusher_running)
+    {
+        // The voter is checked and reserved in one hold of journal_mutex, so of
+        // two booths casting for the same voter only one is acknowledged. The
+        // push happens after the unlock: a full ring waits for the flusher,
+        // which needs the mutex.
+        JOURNAL_LOCK();
+        int duplicate = queued_locked(voting_number) || reserved_has(voting_number);
+        int reserved_ok = !duplicate && reserved_add(voting_number);
+        JOURNAL_UNLOCK();
+        if (duplicate)
+        {
+            set_error_arg(DATA_ERROR_DUPLICATE_RECORD, "Voter '%s' has already voted", voting_number);
+            return DATA_ERROR_DUPLICATE_RECORD;
+        }
+        if (!reserved_ok)
+        {
+            set_error_message("Error: Memory allocation failed for vote journal queue");
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        }
+        note_enqueued();
+        ring_push(&vote);
+        return DATA_SUCCESS;
+    }
+#endif
+
+    JOURNAL_LOCK();
+    if (queued_locked(voting_number))
+    {
+        JOURNAL_UNLOCK();
+        set_error_arg(DATA_ERROR_DUPLICATE_RECORD, "Voter '%s' has already voted", voting_number);
+        return DATA_ERROR_DUPLICATE_RECORD;
+    }
+
+    if (journal.count == journal.capacity)
+    {
+        int cap = journal.capacity ? journal.capacity * 2 : 16;
+        journal_vote_t *grown = realloc(journal.queue, (size_t)cap * sizeof(*grown));
+        if (!grown)
+        {
+            JOURNAL_UNLOCK();
+            set_error_message("Error: Memory allocation failed for vote journal queue");
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        }
+        journal.queue = grown;
+        journal.capacity = cap;
+    }
+    note_enqueued();
+    journal.queue[journal.count++] = vote;
+    if (journal.count == 1)
+        journal.first_queued = vote.queued;
+
+    rc = DATA_SUCCESS;
+    if (journal.sync_ms <= 0 || journal.count >= VOTE_JOURNAL_MAX_BATCH)
+    {
+        rc = commit_locked();
+        // Not journaled: the caller sees the failure (a duplicate is already out of the queue)
+        if (rc != DATA_SUCCESS && journal.count > 0 &&
+            strcmp(journal.queue[journal.count - 1].voting_number, voting_number) == 0)
+        {
+            journal.count--;
+            STAT_ADD(dropped, 1);
+        }
+    }
+    else if (deadline_passed())
+    {
+        rc = commit_locked(); // no flusher thread: commit on the next vote past the window
+    }
+    JOURNAL_UNLOCK();
+    return rc;
+}
+
+int vote_journal_pending(const char *voting_number)
+{
+    if (!voting_number)
+        return 0;
+    // A vote in the ring is reserved until it is in the batch; journal_mutex
+    // keeps it from moving between the two while both are searched
+    JOURNAL_LOCK();
+    int found = queued_locked(voting_number);
+#ifndef VOTE_JOURNAL_NO_THREADS
+    if (!found)
+        found = reserved_has(voting_number);
+#endif
+    JOURNAL_UNLOCK();
+    return found;
+}
+
+int vote_journal_flush(void)
+{
+    JOURNAL_LOCK();
+    int rc = journal.open ? flush_locked() : DATA_SUCCESS;
+    JOURNAL_UNLOCK();
+    return rc;
+}
+
+int vote_journal_close(void)
+{
+#ifndef VOTE_JOURNAL_NO_THREADS
+    // The flusher drains the ring and commits its last batches before it exits
+    JOURNAL_LOCK();
+    int running = journal.flusher_running;
+    journal.stopping = 1;
+    JOURNAL_UNLOCK();
+    if (running)
+    {
+        sem_post(&ring.wake);
+        pthread_join(journal.flusher, NULL);
+    }
+#endif
+
+    JOURNAL_LOCK();
+    // Whatever a failed last commit left behind gets one more try
+    int rc = journal.open ? flush_locked() : DATA_SUCCESS;
+#ifndef VOTE_JOURNAL_NO_THREADS
+    if (running)
+        ring_free();
+    reserved_free(); // every reserved vote was drained by the flush
+    journal.flusher_running = 0;
+#endif
+    if (journal.open)
+    {
+        // Leave an empty journal behind when everything was applied
+        if (rc == DATA_SUCCESS && journal.count == 0 && lock_journal(journal.fd, F_WRLCK) == DATA_SUCCESS)
+        {
+            write_unmarked();
+            rc = replay_locked(journal.fd, NULL);
+            lock_journal(journal.fd, F_UNLCK);
+        }
+        close(journal.fd);
+        journal.fd = -1;
+        close_views();
+        if (journal.voted_open)
+            voted_set_close(&journal.voted);
+        journal.voted_open = 0;
+#ifndef VOTE_JOURNAL_NO_THREADS
+        __atomic_store_n(&journal.open, 0, __ATOMIC_RELEASE);
+#else
+        journal.open = 0;
+#endif
+    }
+    free(journal.queue);
+    journal.queue = NULL;
+    journal.count = journal.capacity = 0;
+    JOURNAL_UNLOCK();
+    return rc;
+}
+
+void vote_journal_get_stats(vote_journal_stats_t *st)
+{
+    JOURNAL_LOCK();
+    st->enqueued = STAT_LOAD(enqueued);
+    st->durable = STAT_LOAD(durable);
+    st->dropped = STAT_LOAD(dropped);
+    st->depth = st->enqueued > st->durable + st->dropped ? st->enqueued - st->durable - st->dropped : 0;
+    st->max_depth = STAT_LOAD(max_depth);
+    st->full_waits = STAT_LOAD(full_waits);
+    st->avg_latency_us = st->durable ? (double)stats.latency_sum_ns / 1000.0 / (double)st->durable : 0.0;
+    st->max_latency_us = (double)stats.latency_max_ns / 1000.0;
+    JOURNAL_UNLOCK();
+}
+
+int vote_journal_clear_temp_voted(void)
+{
+    // Our own journal must be used when it is open: closing another
+    // descriptor of the file would drop this process's fcntl lock on it
+    JOURNAL_LOCK();
+    int rc = journal.open ? flush_locked() : DATA_SUCCESS;
+    int fd = journal.open ? journal.fd : open(VOTE_JOURNAL_FILE, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (rc == DATA_SUCCESS && fd < 0)
+    {
+        set_error_message("Error: Cannot open vote journal '%s': %s", VOTE_JOURNAL_FILE, strerror(errno));
+        rc = DATA_ERROR_PERMISSION_DENIED;
+    }
+    if (rc == DATA_SUCCESS)
+        rc = lock_journal(fd, F_WRLCK);
+    if (rc == DATA_SUCCESS)
+    {
+        rc = replay_locked(fd, NULL);
+        if (rc == DATA_SUCCESS)
+        {
+            // The truncated journal no longer holds the batch the mark was for
+            journal.unmarked[0] = '\0';
+            journal.journal_end = -1;
+            rc = overwrite_file(TEMP_VOTED_FILE, TEMP_VOTED_HEADER "\n");
+        }
+        lock_journal(fd, F_UNLCK);
+    }
+    if (fd >= 0 && !journal.open)
+        close(fd);
+    JOURNAL_UNLOCK();
+    return rc;
+}
+
+int vote_journal_recover(int *replayed)
+{
+    if (replayed)
+        *replayed = 0;
+    int fd = open(VOTE_JOURNAL_FILE, O_RDWR);
+    if (fd < 0)
+    {
+        if (errno == ENOENT)
+            return DATA_SUCCESS; // no journal, nothing to replay
+        set_error_message("Error: Cannot open vote journal '%s': %s", VOTE_JOURNAL_FILE, strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+    int rc = lock_journal(fd, F_WRLCK);
+    if (rc == DATA_SUCCESS)
+    {
+        rc = replay_locked(fd, replayed);
+        lock_journal(fd, F_UNLCK);
+    }
+    close(fd);
+    return rc;
+}
+
+/* ==== Ballot casting ==== */
+
+/**
+ * Rebuild the voted set when the temp list was changed outside the journal
+ * (cleared, rewritten or edited). Caller holds journal_mutex, the journal's
+ * fcntl lock and a lock on the temp list.
+ * @return DATA_SUCCESS when the set is current, negative when unavailable
+ */
+static int voted_refresh_locked(void)
+{
+    if (!journal.open || !journal.voted_open)
+        return DATA_ERROR_FILE_NOT_FOUND;
+
+    struct stat st;
+    if (stat(TEMP_VOTED_FILE, &st) != 0)
+        memset(&st, 0, sizeof(st));
+    if (voted_set_is_current(&journal.voted, &st))
+        return DATA_SUCCESS;
+    return voted_set_rebuild(&journal.voted, TEMP_VOTED_FILE, APPROVED_VOTERS_FILE);
+}
+
+/**
+ * Whether the voter is in the temp voted list, via the voted set
+ * Caller holds journal_mutex.
+ * @return 1 if voted, 0 if not, negative when the set is unavailable
+ */
+static int voted_lookup_locked(const char *voting_number)
+{
+    if (!journal.open || !journal.voted_open)
+        return DATA_ERROR_FILE_NOT_FOUND;
+
+    struct stat st;
+    if (stat(TEMP_VOTED_FILE, &st) != 0)
+        memset(&st, 0, sizeof(st));
+    if (!voted_set_is_current(&journal.voted, &st))
+    {
+        int rc = lock_journal(journal.fd, F_WRLCK);
+        if (rc != DATA_SUCCESS)
+            return rc;
+        // Another process may have caught it up while we waited
+        csv_lock_t temp_lock;
+        rc = csv_lock_acquire(&temp_lock, TEMP_VOTED_FILE, 0);
+        if (rc == DATA_SUCCESS)
+        {
+            rc = voted_refresh_locked();
+            csv_lock_release(&temp_lock);
+        }
+        lock_journal(journal.fd, F_UNLCK);
+        if (rc != DATA_SUCCESS)
+            return rc;
+    }
+    return voted_set_contains(&journal.voted, TEMP_VOTED_FILE, voting_number);
+}
+
+int vote_journal_voted(const char *voting_number)
+{
+    if (!voting_number || !*voting_number)
+    {
+        set_error_message("Error: Voting number cannot be empty");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    int rc = vote_journal_open();
+    if (rc != DATA_SUCCESS)
+        return rc;
+
+    JOURNAL_LOCK();
+    int voted = voted_lookup_locked(voting_number);
+    JOURNAL_UNLOCK();
+    if (voted < 0)
+        voted = voter_in_file(TEMP_VOTED_FILE, voting_number);
+    if (voted < 0)
+        return voted; // an error, not a vote
+    return voted || vote_journal_pending(voting_number);
+}
+
+int check_voter_eligible(const char *voting_number, char **voter_row)
+{
+    if (voter_row)
+        *voter_row = NULL;
+    if (!voting_number || !*voting_number)
+    {
+        set_error_message("Error: Voting number cannot be empty");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+
+    char *voter = read_voter(voting_number);
+    if (!voter)
+    {
+        set_error_arg(DATA_ERROR_RECORD_NOT_FOUND, "Voter ID '%s' not found or not approved", voting_number);
+        return DATA_ERROR_RECORD_NOT_FOUND;
+    }
+
+    int voted = vote_journal_voted(voting_number);
+    if (voted < 0)
+    {
+        free(voter);
+        return voted;
+    }
+    if (voted)
+    {
+        free(voter);
+        set_error_arg(DATA_ERROR_DUPLICATE_RECORD, "Voter '%s' has already voted", voting_number);
+        return DATA_ERROR_DUPLICATE_RECORD;
+    }
+    if (voter_row)
+        *voter_row = voter;
+    else
+        free(voter);
+    return DATA_SUCCESS;
+}
+
+int cast_vote(const char *voting_number, const char *candidate_number, const char *party_id)
+{
+    int rc = check_voter_eligible(voting_number, NULL);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    return vote_journal_append(voting_number, candidate_number, party_id);
+}
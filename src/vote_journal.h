@@ -0,0 +1,147 @@
+/*
+ * VoteMe Vote Journal Header
+ *
+ * Write-ahead log in front of data/temp-voted-list.txt and data/votes.txt.
+ * Votes are queued in memory and committed in batches: one write() of the
+ * whole batch to data/votes.journal plus one fdatasync(), after which the
+ * rows are appended to both data files with one write() per file. A batch is
+ * marked applied in the journal once both files have it.
+ *
+ * On open, committed batches that never got marked applied (the process died
+ * between commit and apply) are replayed into both files, skipping voters
+ * that already made it there, and the journal is truncated.
+ *
+ * Sync policy comes from journal_sync_ms in data/system_config.txt:
+ *   -1  none: batches are written per vote but never fdatasync'ed
+ *    0  every vote: each vote is its own batch and synced before returning
+ *   >0  group commit: votes are batched and committed at most this many
+ *       milliseconds after the first one was queued
+ *
+ * Under group commit, appends hold journal_mutex only to reserve the voter,
+ * so a second vote by the same voter is rejected at once, then put the vote
+ * into a bounded in-process ring that a writer thread (the flusher) drains in
+ * batches of up to 512. When the ring is full, appends wait for the flusher to
+ * make room.
+ * Vote counts, backlog depth and enqueue-to-durable latency are kept for
+ * vote_journal_get_stats.
+ */
+
+#ifndef VOTE_JOURNAL_H
+#define VOTE_JOURNAL_H
+
+#define VOTE_JOURNAL_FILE "data/votes.journal"
+#define VOTE_JOURNAL_CONFIG_KEY "journal_sync_ms"
+
+#define VOTE_JOURNAL_SYNC_NONE -1
+#define VOTE_JOURNAL_SYNC_EVERY_VOTE 0
+
+// Counters since the process started
+typedef struct
+{
+    unsigned long long enqueued;   // votes accepted by vote_journal_append
+    unsigned long long durable;    // votes committed to the journal
+    unsigned long long dropped;    // dropped at commit (voter already voted) or not journaled
+    unsigned long long depth;      // accepted but not committed yet
+    unsigned long long max_depth;  // deepest the backlog has been
+    unsigned long long full_waits; // appends that waited for room in the ring
+    double avg_latency_us;         // enqueue to durable, over the durable votes
+    double max_latency_us;
+} vote_journal_stats_t;
+
+/**
+ * Open the journal: read the sync policy, replay unapplied batches and start
+ * the group-commit flusher when the policy needs one
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int vote_journal_open(void);
+
+/**
+ * Queue a vote (voting_number,candidate_number,party_id)
+ * Under the every-vote policy the vote is durable when this returns;
+ * otherwise it is committed with its batch.
+ * @return DATA_SUCCESS on success, DATA_ERROR_DUPLICATE_RECORD when the voter
+ *         already has a vote queued, error code on failure
+ */
+int vote_journal_append(const char *voting_number, const char *candidate_number, const char *party_id);
+
+/**
+ * Whether a voter has a vote queued in this process that is not in the data
+ * files yet (duplicate checks must consult this as well as the files)
+ * @return 1 if pending, 0 otherwise
+ */
+int vote_journal_pending(const char *voting_number);
+
+/**
+ * Commit and apply everything queued so far
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int vote_journal_flush(void);
+
+/**
+ * Flush, stop the flusher, and truncate the fully applied journal
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int vote_journal_close(void);
+
+/**
+ * Read the journal's counters
+ */
+void vote_journal_get_stats(vote_journal_stats_t *st);
+
+/**
+ * Replay committed-but-unapplied batches without opening the journal for
+ * writing (e.g. at admin startup, before votes are tallied)
+ * @param replayed Optional output: number of votes written back to the data files
+ * @return DATA_SUCCESS on success (including when there is no journal), error code on failure
+ */
+int vote_journal_recover(int *replayed);
+
+/* ==== Ballot casting ==== */
+
+/**
+ * Whether a voter is in the temp voted list or has a vote queued
+ * The list is consulted through the voted set (data/voted.bitmap), which is
+ * rebuilt first if the list was changed outside the journal.
+ * @return 1 if voted, 0 if not, negative error code on failure
+ */
+int vote_journal_voted(const char *voting_number);
+
+/**
+ * Check whether a voter may vote
+ * @param voting_number Voter to check
+ * @param voter_row Optional output: the voter's approved_voters row (caller
+ *                  frees), set only when the voter is eligible
+ * The temp voted list is consulted through the voted set (data/voted.bitmap),
+ * which is rebuilt first if the list was changed outside the journal.
+ * @return DATA_SUCCESS if eligible, DATA_ERROR_RECORD_NOT_FOUND if not an
+ *         approved voter, DATA_ERROR_DUPLICATE_RECORD if the voter is already
+ *         in the temp voted list or has a vote queued in the journal
+ */
+int check_voter_eligible(const char *voting_number, char **voter_row);
+
+/**
+ * Clear the temp voted list (delete all data except header) through the journal
+ * Everything queued here is committed, every committed batch is applied and
+ * the journal is truncated, all under the journal's lock, so no journaled
+ * vote can be replayed into the new list. Use this instead of
+ * clear_temp_voted wherever votes go through the journal.
+ * @return DATA_SUCCESS on success, negative error code on failure
+ */
+int vote_journal_clear_temp_voted(void);
+
+/**
+ * Cast a ballot as one journal record
+ * Validates the voter and checks for a duplicate once, then records the vote
+ * with a single journal write; the temp voted list row
+ * (voting_number,candidate_number,party_id) and the data/votes.txt row
+ * (voter_id,candidate_id) are both derived from that record.
+ * The check is repeated when the vote is committed, under the journal lock
+ * and the temp voted list's lock: if another booth recorded the voter in
+ * between, the vote is dropped (inline commits return
+ * DATA_ERROR_DUPLICATE_RECORD; group commits report it on stderr).
+ * @return DATA_SUCCESS on success, error code as check_voter_eligible or
+ *         vote_journal_append on failure
+ */
+int cast_vote(const char *voting_number, const char *candidate_number, const char *party_id);
+
+#endif // VOTE_JOURNAL_H
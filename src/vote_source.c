@@ -0,0 +1,224 @@
+/*
+ * VoteMe Vote Source Reader Implementation
+ *
+ * mmap + memchr row walker with a buffered read() fallback; rows are
+ * split into fields by csv_split_spans.
+ */
+
+// mmap/posix_madvise need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#define VOTE_SOURCE_HAVE_MMAP 1
+#endif
+
+#include "data_errors.h"
+#include "vote_source.h"
+
+#define VOTE_SOURCE_READ_CHUNK (64 * 1024)
+
+int vote_source_split(const char *line, size_t len, vote_field_t fields[], int max_fields)
+{
+    if (!line || !fields || max_fields <= 0)
+        return 0;
+
+    int n = csv_split_spans(line, len, ',', fields, max_fields);
+    if (n == 0)
+    {
+        // A row of blanks still has its (empty) first field
+        fields[0].ptr = line;
+        fields[0].len = 0;
+        fields[0].quoting = CSV_SPAN_PLAIN;
+        n = 1;
+    }
+    return n;
+}
+
+void vote_field_copy(const vote_field_t *field, char *out, size_t outsz)
+{
+    csv_span_copy(field, out, outsz);
+}
+
+int vote_source_open(vote_source_t *src, const char *path)
+{
+    if (!src || !path)
+    {
+        set_error_message("Error: Invalid parameters for vote_source_open");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    memset(src, 0, sizeof(*src));
+    src->fd = open(path, O_RDONLY);
+    if (src->fd < 0)
+    {
+        set_error_message("Error: Cannot open file '%s' for reading: %s", path, strerror(errno));
+        return DATA_ERROR_FILE_NOT_FOUND;
+    }
+
+#ifdef VOTE_SOURCE_HAVE_MMAP
+    struct stat st;
+    if (fstat(src->fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        if (st.st_size == 0)
+        {
+            // Nothing to map; behave like an empty mapping
+            src->data = "";
+            src->size = 0;
+            return DATA_SUCCESS;
+        }
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, src->fd, 0);
+        if (map != MAP_FAILED)
+        {
+            posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+            src->data = map;
+            src->size = (size_t)st.st_size;
+            return DATA_SUCCESS;
+        }
+    }
+#endif
+
+    // Fall back to buffered read()
+    src->buf_cap = VOTE_SOURCE_READ_CHUNK;
+    src->buf = malloc(src->buf_cap);
+    if (!src->buf)
+    {
+        close(src->fd);
+        src->fd = -1;
+        set_error_message("Error: Memory allocation failed for vote source buffer");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    return DATA_SUCCESS;
+}
+
+int vote_source_is_mapped(const vote_source_t *src)
+{
+    return src && src->data != NULL;
+}
+
+/**
+ * Refill the streaming buffer, keeping the unconsumed tail
+ * @return Bytes added, 0 at EOF, negative error code on failure
+ */
+static long fill_buffer(vote_source_t *src)
+{
+    if (src->buf_pos > 0)
+    {
+        memmove(src->buf, src->buf + src->buf_pos, src->buf_len - src->buf_pos);
+        src->buf_len -= src->buf_pos;
+        src->buf_pos = 0;
+    }
+    if (src->buf_len == src->buf_cap)
+    {
+        // A single row is longer than the buffer: grow instead of truncating
+        size_t cap = src->buf_cap * 2;
+        char *grown = realloc(src->buf, cap);
+        if (!grown)
+        {
+            set_error_message("Error: Memory allocation failed while reading long row");
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        }
+        src->buf = grown;
+        src->buf_cap = cap;
+    }
+    for (;;)
+    {
+        ssize_t n = read(src->fd, src->buf + src->buf_len, src->buf_cap - src->buf_len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+        {
+            set_error_message("Error: Failed to read vote source: %s", strerror(errno));
+            return DATA_ERROR_MALFORMED_DATA;
+        }
+        if (n == 0)
+            src->eof = 1;
+        src->buf_len += (size_t)n;
+        return (long)n;
+    }
+}
+
+int vote_source_next_line(vote_source_t *src, vote_field_t *line)
+{
+    if (!src || !line || src->fd < 0)
+        return DATA_ERROR_INVALID_INPUT;
+
+    for (;;)
+    {
+        const char *start;
+        size_t len;
+        if (src->data)
+        {
+            if (src->pos >= src->size)
+                return 0;
+            start = src->data + src->pos;
+            const char *nl = memchr(start, '\n', src->size - src->pos);
+            len = nl ? (size_t)(nl - start) : src->size - src->pos;
+            src->pos += len + (nl ? 1 : 0);
+        }
+        else
+        {
+            const char *nl = NULL;
+            while (!(nl = memchr(src->buf + src->buf_pos, '\n', src->buf_len - src->buf_pos)))
+            {
+                if (src->eof)
+                    break;
+                long rc = fill_buffer(src);
+                if (rc < 0)
+                    return (int)rc;
+            }
+            if (!nl && src->buf_pos >= src->buf_len)
+                return 0;
+            start = src->buf + src->buf_pos;
+            len = nl ? (size_t)(nl - start) : src->buf_len - src->buf_pos;
+            src->buf_pos += len + (nl ? 1 : 0);
+        }
+
+        while (len > 0 && start[len - 1] == '\r')
+            len--;
+        if (len == 0)
+            continue; // skip blank rows
+        line->ptr = start;
+        line->len = len;
+        return 1;
+    }
+}
+
+int vote_source_next(vote_source_t *src, vote_field_t fields[], int max_fields, int *nfields)
+{
+    vote_field_t line;
+    int rc = vote_source_next_line(src, &line);
+    if (rc <= 0)
+    {
+        if (nfields)
+            *nfields = 0;
+        return rc;
+    }
+    int n = vote_source_split(line.ptr, line.len, fields, max_fields);
+    if (nfields)
+        *nfields = n;
+    return 1;
+}
+
+void vote_source_close(vote_source_t *src)
+{
+    if (!src)
+        return;
+#ifdef VOTE_SOURCE_HAVE_MMAP
+    if (src->data && src->size > 0)
+        munmap((void *)src->data, src->size);
+#endif
+    free(src->buf);
+    if (src->fd >= 0)
+        close(src->fd);
+    memset(src, 0, sizeof(*src));
+    src->fd = -1;
+}
@@ -0,0 +1,94 @@
+/*
+ * VoteMe Vote Source Reader Header
+ *
+ * Zero-copy row/field access to the vote logs (data/votes.txt and
+ * data/temp-voted-list.txt) and other CSV inputs of the tally path.
+ *
+ * Files are mapped read-only and walked with memchr; every field is handed
+ * out as a (pointer, length) view into the mapping, so a full scan neither
+ * copies nor allocates per row. Files that cannot be mapped (pipes, special
+ * files, platforms without mmap) are streamed through a growable read()
+ * buffer with the same interface.
+ */
+
+#ifndef VOTE_SOURCE_H
+#define VOTE_SOURCE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "csv_io.h"
+
+// A field view; ptr is NOT NUL-terminated (see csv_span_t for quoted fields)
+typedef csv_span_t vote_field_t;
+
+typedef struct
+{
+    int fd;
+    const char *data; // mapped file contents, NULL when streaming
+    size_t size;      // mapped length (file size at open time)
+    size_t pos;       // cursor into the mapping
+
+    // read() fallback state
+    char *buf;
+    size_t buf_cap;
+    size_t buf_len;
+    size_t buf_pos;
+    int eof;
+} vote_source_t;
+
+/**
+ * Open a vote source, mapping the file when possible
+ * @param src Source to initialize
+ * @param path File to read
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int vote_source_open(vote_source_t *src, const char *path);
+
+/**
+ * Whether the source is served from a memory mapping
+ */
+int vote_source_is_mapped(const vote_source_t *src);
+
+/**
+ * Fetch the next non-empty row
+ * @param src Open source
+ * @param line Output view of the whole row without the line terminator
+ * @return 1 when a row was produced, 0 at end of file, negative error code on failure
+ *
+ * Views stay valid until the next call (streaming) or until close (mapped).
+ */
+int vote_source_next_line(vote_source_t *src, vote_field_t *line);
+
+/**
+ * Fetch the next non-empty row split into trimmed field views
+ * @param src Open source
+ * @param fields Output field views
+ * @param max_fields Capacity of fields; fields beyond it are ignored
+ * @param nfields Output number of fields filled
+ * @return 1 when a row was produced, 0 at end of file, negative error code on failure
+ */
+int vote_source_next(vote_source_t *src, vote_field_t fields[], int max_fields, int *nfields);
+
+/**
+ * Release the mapping or buffer and close the file
+ */
+void vote_source_close(vote_source_t *src);
+
+/**
+ * Split one row into trimmed comma-separated field views (csv_split_spans
+ * rules, except that a blank row is one empty field)
+ * @param line Row bytes (without or with trailing CR/LF)
+ * @param len Row length
+ * @param fields Output field views
+ * @param max_fields Capacity of fields; splitting stops once it is full
+ * @return Number of fields filled
+ */
+int vote_source_split(const char *line, size_t len, vote_field_t fields[], int max_fields);
+
+/**
+ * Copy a field's value into a fixed-size NUL-terminated buffer (truncating)
+ */
+void vote_field_copy(const vote_field_t *field, char *out, size_t outsz);
+
+#endif // VOTE_SOURCE_H
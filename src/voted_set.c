@@ -0,0 +1,523 @@
+/*
+ * VoteMe Voted Set Implementation
+ *
+ * File layout: voted_header_t, padded to VOTED_SET_BITS_OFFSET, then
+ * capacity / 8 bytes of bitmap (bit n = canonical id n). The file only grows;
+ * the capacity field is published after ftruncate(), so another process that
+ * sees a larger capacity can always map that much.
+ *
+ * Writers (adds, rebuilds, growth) are serialized by the caller, which holds
+ * the vote journal lock; readers may run concurrently in other processes.
+ */
+
+// mmap/ftruncate/strnlen need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#include "data_handler_enhanced.h"
+#include "vote_source.h"
+#include "voted_set.h"
+
+#define VOTED_SET_MAGIC "VMVSET1"
+#define VOTED_SET_VERSION 1
+#define VOTED_SET_BITS_OFFSET 128
+#define VOTED_SET_MIN_CAPACITY (64 * 1024)
+// Canonical numbers have at most 9 digits, so the bitmap tops out at 125 MB
+#define VOTED_SET_MAX_DIGITS 9
+#define VOTED_SET_DEFAULT_PREFIX "V"
+#define VOTED_SET_DEFAULT_WIDTH 4
+
+#if !defined(_WIN32)
+
+static long long mtime_nsec(const struct stat *st)
+{
+    return (long long)st->st_mtim.tv_nsec;
+}
+
+static size_t map_bytes(uint64_t capacity)
+{
+    return VOTED_SET_BITS_OFFSET + (size_t)(capacity / 8);
+}
+
+static uint64_t mapped_capacity(const voted_set_t *vs)
+{
+    return (uint64_t)(vs->map_size - VOTED_SET_BITS_OFFSET) * 8;
+}
+
+static uint64_t *bit_words(const voted_set_t *vs)
+{
+    return (uint64_t *)((char *)vs->hdr + VOTED_SET_BITS_OFFSET);
+}
+
+/* ==== Id format ==== */
+
+// Split an id into <non-digit prefix><1..9 digits>; 0 when it has another shape
+static int split_id(const char *id, size_t *prefix_len, size_t *digits)
+{
+    size_t p = 0;
+    while (id[p] && (id[p] < '0' || id[p] > '9'))
+        p++;
+    size_t d = 0;
+    while (id[p + d] >= '0' && id[p + d] <= '9')
+        d++;
+    if (id[p + d] != '\0' || d == 0 || d > VOTED_SET_MAX_DIGITS || p >= sizeof(((voted_header_t *)0)->prefix))
+        return 0;
+    *prefix_len = p;
+    *digits = d;
+    return 1;
+}
+
+/**
+ * Map an id to its bit if it is exactly the canonical spelling of a number:
+ * the set's prefix, then the number zero-padded to the set's width. "V0001"
+ * is bit 1 under width 4, while "V1" and "V00001" are irregular, so distinct
+ * ids never share a bit.
+ */
+static int decode_id(const voted_header_t *h, const char *id, uint64_t *n)
+{
+    size_t p, d;
+    size_t want = strnlen(h->prefix, sizeof(h->prefix));
+    if (h->width == 0 || !split_id(id, &p, &d) || p != want || memcmp(id, h->prefix, p) != 0)
+        return 0;
+    if (d < h->width || (d > h->width && id[p] == '0'))
+        return 0;
+    uint64_t v = 0;
+    for (size_t i = 0; i < d; i++)
+        v = v * 10 + (uint64_t)(id[p + i] - '0');
+    *n = v;
+    return 1;
+}
+
+// Adopt the format of a sample id; 0 when it has no <prefix><digits> shape
+static int set_format(voted_header_t *h, const char *id)
+{
+    size_t p, d;
+    if (!split_id(id, &p, &d))
+        return 0;
+    memset(h->prefix, 0, sizeof(h->prefix));
+    memcpy(h->prefix, id, p);
+    h->width = (uint32_t)d;
+    return 1;
+}
+
+/* ==== Irregular ids ==== */
+
+// FNV-1a, same family as the record indexes
+static size_t hash_id(const char *s)
+{
+    uint32_t h = 2166136261u;
+    for (; *s; s++)
+    {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void irregular_clear(voted_irregular_t *set)
+{
+    if (set->slots)
+    {
+        for (size_t i = 0; i <= set->mask; i++)
+            free(set->slots[i]);
+        free(set->slots);
+    }
+    set->slots = NULL;
+    set->mask = 0;
+    set->count = 0;
+}
+
+static int irregular_find(const voted_irregular_t *set, const char *id)
+{
+    if (!set->slots)
+        return 0;
+    for (size_t i = hash_id(id) & set->mask; set->slots[i]; i = (i + 1) & set->mask)
+    {
+        if (strcmp(set->slots[i], id) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+// Insert an id that is not present yet
+static int irregular_insert(voted_irregular_t *set, const char *id)
+{
+    if (!set->slots || (set->count + 1) * 2 > set->mask + 1)
+    {
+        size_t cap = set->slots ? (set->mask + 1) * 2 : 64;
+        char **slots = calloc(cap, sizeof(*slots));
+        if (!slots)
+            return 0;
+        for (size_t i = 0; set->slots && i <= set->mask; i++)
+        {
+            if (!set->slots[i])
+                continue;
+            size_t j = hash_id(set->slots[i]) & (cap - 1);
+            while (slots[j])
+                j = (j + 1) & (cap - 1);
+            slots[j] = set->slots[i];
+        }
+        free(set->slots);
+        set->slots = slots;
+        set->mask = cap - 1;
+    }
+    char *copy = strdup(id);
+    if (!copy)
+        return 0;
+    size_t i = hash_id(id) & set->mask;
+    while (set->slots[i])
+        i = (i + 1) & set->mask;
+    set->slots[i] = copy;
+    set->count++;
+    return 1;
+}
+
+/* ==== Mapping ==== */
+
+static int map_file(voted_set_t *vs, size_t size)
+{
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, vs->fd, 0);
+    if (map == MAP_FAILED)
+    {
+        set_error_message("Error: Cannot map voted set: %s", strerror(errno));
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    if (vs->hdr)
+        munmap(vs->hdr, vs->map_size);
+    vs->hdr = map;
+    vs->map_size = size;
+    return DATA_SUCCESS;
+}
+
+// Follow growth done by another process
+static int refresh_mapping(voted_set_t *vs)
+{
+    uint64_t cap = __atomic_load_n(&vs->hdr->capacity, __ATOMIC_ACQUIRE);
+    return cap > mapped_capacity(vs) ? map_file(vs, map_bytes(cap)) : DATA_SUCCESS;
+}
+
+static int ensure_capacity(voted_set_t *vs, uint64_t n)
+{
+    int rc = refresh_mapping(vs);
+    if (rc != DATA_SUCCESS || n < mapped_capacity(vs))
+        return rc;
+    uint64_t cap = mapped_capacity(vs);
+    while (cap <= n)
+        cap *= 2;
+    if (ftruncate(vs->fd, (off_t)map_bytes(cap)) != 0)
+    {
+        set_error_message("Error: Cannot grow voted set: %s", strerror(errno));
+        return DATA_ERROR_DISK_FULL;
+    }
+    rc = map_file(vs, map_bytes(cap));
+    if (rc == DATA_SUCCESS)
+        __atomic_store_n(&vs->hdr->capacity, cap, __ATOMIC_RELEASE);
+    return rc;
+}
+
+static int header_valid(const voted_header_t *h, off_t file_size)
+{
+    return memcmp(h->magic, VOTED_SET_MAGIC, sizeof(h->magic)) == 0 &&
+           h->version == VOTED_SET_VERSION &&
+           h->capacity >= VOTED_SET_MIN_CAPACITY && h->capacity % 64 == 0 &&
+           (uint64_t)file_size >= map_bytes(h->capacity);
+}
+
+/* ==== Public API ==== */
+
+int voted_set_open(voted_set_t *vs, const char *path)
+{
+    memset(vs, 0, sizeof(*vs));
+    vs->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (vs->fd < 0)
+    {
+        set_error_message("Error: Cannot open voted set '%s': %s", path, strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+
+    struct stat st;
+    voted_header_t h;
+    int valid = fstat(vs->fd, &st) == 0 &&
+                pread(vs->fd, &h, sizeof(h), 0) == (ssize_t)sizeof(h) && header_valid(&h, st.st_size);
+    int rc;
+    if (valid)
+    {
+        rc = map_file(vs, map_bytes(h.capacity));
+    }
+    else
+    {
+        // Missing or unusable: start empty with a fingerprint no file has
+        if (ftruncate(vs->fd, 0) != 0 || ftruncate(vs->fd, (off_t)map_bytes(VOTED_SET_MIN_CAPACITY)) != 0)
+        {
+            set_error_message("Error: Cannot initialize voted set '%s': %s", path, strerror(errno));
+            rc = DATA_ERROR_DISK_FULL;
+        }
+        else
+        {
+            rc = map_file(vs, map_bytes(VOTED_SET_MIN_CAPACITY));
+        }
+        if (rc == DATA_SUCCESS)
+        {
+            memcpy(vs->hdr->magic, VOTED_SET_MAGIC, sizeof(vs->hdr->magic));
+            vs->hdr->version = VOTED_SET_VERSION;
+            vs->hdr->capacity = VOTED_SET_MIN_CAPACITY;
+        }
+    }
+    if (rc != DATA_SUCCESS)
+    {
+        close(vs->fd);
+        vs->fd = -1;
+        return rc;
+    }
+    vs->irregular.gen = (uint64_t)-1; // loaded on first irregular lookup
+    return DATA_SUCCESS;
+}
+
+void voted_set_close(voted_set_t *vs)
+{
+    if (vs->hdr)
+    {
+        munmap(vs->hdr, vs->map_size);
+        close(vs->fd);
+    }
+    irregular_clear(&vs->irregular);
+    vs->hdr = NULL;
+    vs->map_size = 0;
+    vs->fd = -1;
+}
+
+int voted_set_is_current(const voted_set_t *vs, const struct stat *source_st)
+{
+    const voted_header_t *h = vs->hdr;
+    return h && h->src_size == (uint64_t)source_st->st_size &&
+           h->src_mtime_sec == (int64_t)source_st->st_mtime &&
+           h->src_mtime_nsec == (int64_t)mtime_nsec(source_st) &&
+           h->src_ino == (uint64_t)source_st->st_ino;
+}
+
+void voted_set_stamp(voted_set_t *vs, const struct stat *source_st)
+{
+    vs->hdr->src_size = (uint64_t)source_st->st_size;
+    vs->hdr->src_mtime_sec = (int64_t)source_st->st_mtime;
+    vs->hdr->src_mtime_nsec = (int64_t)mtime_nsec(source_st);
+    vs->hdr->src_ino = (uint64_t)source_st->st_ino;
+}
+
+// Call fn on the voting_number of every data row of source (missing file: no rows)
+static int for_each_voter(const char *source, int (*fn)(voted_set_t *, const char *), voted_set_t *vs,
+                          struct stat *st)
+{
+    vote_source_t src;
+    if (access(source, F_OK) != 0)
+    {
+        if (st)
+            memset(st, 0, sizeof(*st));
+        return DATA_SUCCESS;
+    }
+    int rc = vote_source_open(&src, source);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    if (st && fstat(src.fd, st) != 0)
+    {
+        vote_source_close(&src);
+        set_error_message("Error: Cannot stat '%s': %s", source, strerror(errno));
+        return DATA_ERROR_FILE_NOT_FOUND;
+    }
+
+    vote_field_t field;
+    int nfields, r, header = 1;
+    while ((r = vote_source_next(&src, &field, 1, &nfields)) == 1)
+    {
+        if (header)
+        {
+            header = 0;
+            continue;
+        }
+        char id[64];
+        vote_field_copy(&field, id, sizeof(id));
+        if (id[0] && (r = fn(vs, id)) <= 0)
+            break;
+    }
+    vote_source_close(&src);
+    return r < 0 ? r : DATA_SUCCESS;
+}
+
+static int adopt_format(voted_set_t *vs, const char *id)
+{
+    return set_format(vs->hdr, id) ? 0 : 1; // 0 stops the walk
+}
+
+static int add_id(voted_set_t *vs, const char *id)
+{
+    int r = voted_set_add(vs, id);
+    return r < 0 ? r : 1;
+}
+
+static int add_irregular(voted_set_t *vs, const char *id)
+{
+    uint64_t n;
+    if (decode_id(vs->hdr, id, &n) || irregular_find(&vs->irregular, id))
+        return 1;
+    if (!irregular_insert(&vs->irregular, id))
+    {
+        set_error_message("Error: Memory allocation failed for voted set");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    return 1;
+}
+
+int voted_set_rebuild(voted_set_t *vs, const char *source, const char *id_hint)
+{
+    int rc = refresh_mapping(vs);
+    if (rc != DATA_SUCCESS)
+        return rc;
+
+    // The first vote fixes the canonical format; with no votes yet use the hint file
+    vs->hdr->width = 0;
+    rc = for_each_voter(source, adopt_format, vs, NULL);
+    if (rc == DATA_SUCCESS && vs->hdr->width == 0 && id_hint)
+        rc = for_each_voter(id_hint, adopt_format, vs, NULL);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    if (vs->hdr->width == 0)
+    {
+        memset(vs->hdr->prefix, 0, sizeof(vs->hdr->prefix));
+        strcpy(vs->hdr->prefix, VOTED_SET_DEFAULT_PREFIX);
+        vs->hdr->width = VOTED_SET_DEFAULT_WIDTH;
+    }
+
+    memset(bit_words(vs), 0, (size_t)(mapped_capacity(vs) / 8));
+    vs->hdr->count = 0;
+    irregular_clear(&vs->irregular);
+    vs->irregular.gen = __atomic_add_fetch(&vs->hdr->irregular_gen, 1, __ATOMIC_ACQ_REL);
+
+    struct stat st;
+    rc = for_each_voter(source, add_id, vs, &st);
+    if (rc == DATA_SUCCESS)
+        voted_set_stamp(vs, &st);
+    return rc;
+}
+
+int voted_set_add(voted_set_t *vs, const char *voting_number)
+{
+    uint64_t n;
+    if (decode_id(vs->hdr, voting_number, &n))
+    {
+        int rc = ensure_capacity(vs, n);
+        if (rc != DATA_SUCCESS)
+            return rc;
+        uint64_t mask = 1ULL << (n & 63);
+        uint64_t old = __atomic_fetch_or(&bit_words(vs)[n >> 6], mask, __ATOMIC_ACQ_REL);
+        if (old & mask)
+            return 0;
+        __atomic_add_fetch(&vs->hdr->count, 1, __ATOMIC_RELAXED);
+        return 1;
+    }
+
+    if (irregular_find(&vs->irregular, voting_number))
+        return 0;
+    if (!irregular_insert(&vs->irregular, voting_number))
+    {
+        set_error_message("Error: Memory allocation failed for voted set");
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    // Tell other processes to reload; our own set stays valid if nobody else added one
+    uint64_t old = __atomic_fetch_add(&vs->hdr->irregular_gen, 1, __ATOMIC_ACQ_REL);
+    if (old == vs->irregular.gen)
+        vs->irregular.gen = old + 1;
+    return 1;
+}
+
+int voted_set_contains(voted_set_t *vs, const char *source, const char *voting_number)
+{
+    uint64_t n;
+    if (decode_id(vs->hdr, voting_number, &n))
+    {
+        if (refresh_mapping(vs) != DATA_SUCCESS)
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        if (n >= mapped_capacity(vs))
+            return 0;
+        return (int)((__atomic_load_n(&bit_words(vs)[n >> 6], __ATOMIC_ACQUIRE) >> (n & 63)) & 1);
+    }
+
+    uint64_t gen = __atomic_load_n(&vs->hdr->irregular_gen, __ATOMIC_ACQUIRE);
+    if (gen != vs->irregular.gen)
+    {
+        irregular_clear(&vs->irregular);
+        int rc = for_each_voter(source, add_irregular, vs, NULL);
+        if (rc != DATA_SUCCESS)
+        {
+            irregular_clear(&vs->irregular);
+            vs->irregular.gen = (uint64_t)-1;
+            return rc;
+        }
+        vs->irregular.gen = gen;
+    }
+    return irregular_find(&vs->irregular, voting_number);
+}
+
+#else // _WIN32: no shared mappings; callers fall back to scanning the temp list
+
+int voted_set_open(voted_set_t *vs, const char *path)
+{
+    memset(vs, 0, sizeof(*vs));
+    vs->fd = -1;
+    set_error_message("Error: Voted set '%s' is not supported on this platform", path);
+    return DATA_ERROR_FILE_NOT_FOUND;
+}
+
+void voted_set_close(voted_set_t *vs)
+{
+    vs->fd = -1;
+}
+
+int voted_set_is_current(const voted_set_t *vs, const struct stat *source_st)
+{
+    (void)vs;
+    (void)source_st;
+    return 0;
+}
+
+void voted_set_stamp(voted_set_t *vs, const struct stat *source_st)
+{
+    (void)vs;
+    (void)source_st;
+}
+
+int voted_set_rebuild(voted_set_t *vs, const char *source, const char *id_hint)
+{
+    (void)vs;
+    (void)source;
+    (void)id_hint;
+    return DATA_ERROR_FILE_NOT_FOUND;
+}
+
+int voted_set_add(voted_set_t *vs, const char *voting_number)
+{
+    (void)vs;
+    (void)voting_number;
+    return DATA_ERROR_FILE_NOT_FOUND;
+}
+
+int voted_set_contains(voted_set_t *vs, const char *source, const char *voting_number)
+{
+    (void)vs;
+    (void)source;
+    (void)voting_number;
+    return DATA_ERROR_FILE_NOT_FOUND;
+}
+
+#endif
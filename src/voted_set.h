@@ -0,0 +1,108 @@
+/*
+ * VoteMe Voted Set Header
+ *
+ * Persistent "who has voted" set over the voting_number column of
+ * data/temp-voted-list.txt, so the booth's double-vote check is O(1)
+ * instead of a scan of the temp list.
+ *
+ * Ids of the canonical form <prefix><digits> (V0001 -> 1) are bits in an
+ * mmapped bitmap file (data/voted.bitmap): 10M voters cost about 1.2 MB.
+ * Bits are set with atomic fetch-or on the shared mapping, so concurrent
+ * processes see each other's updates. Ids that do not decode exactly
+ * (other prefix, other zero padding, huge numbers) go into an in-memory
+ * hash set that is reloaded from the temp list when another process adds one.
+ *
+ * Like the record indexes, the set records the size/mtime/inode of the temp
+ * list it describes; when the list is changed behind its back (cleared,
+ * rewritten, edited) it no longer matches and must be rebuilt.
+ */
+
+#ifndef VOTED_SET_H
+#define VOTED_SET_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#define VOTED_SET_FILE "data/voted.bitmap"
+
+// Mapped header of data/voted.bitmap
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t width;          // digits of a canonical id (V0001 -> 4)
+    char prefix[16];         // prefix of a canonical id ("V")
+    uint64_t capacity;       // bits in the map (multiple of 64)
+    uint64_t count;          // canonical ids set
+    uint64_t irregular_gen;  // bumped whenever an irregular id is added
+    uint64_t src_size;       // temp list fingerprint at the last update
+    int64_t src_mtime_sec;
+    int64_t src_mtime_nsec;
+    uint64_t src_ino;
+    char reserved[32];
+} voted_header_t;
+
+// Irregular ids, open addressing over strdup'ed strings
+typedef struct
+{
+    char **slots;
+    size_t mask;             // capacity - 1, 0 when empty
+    size_t count;
+    uint64_t gen;            // irregular_gen this set was loaded at
+} voted_irregular_t;
+
+typedef struct
+{
+    int fd;
+    voted_header_t *hdr;     // mapping of the whole file
+    size_t map_size;
+    voted_irregular_t irregular;
+} voted_set_t;
+
+/**
+ * Open (creating if missing) and map the bitmap file
+ * A newly created set matches no temp list, so it will be rebuilt on first use.
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int voted_set_open(voted_set_t *vs, const char *path);
+
+/**
+ * Unmap and close (safe on a zeroed or closed set)
+ */
+void voted_set_close(voted_set_t *vs);
+
+/**
+ * Whether the set describes the temp list with this stat()
+ */
+int voted_set_is_current(const voted_set_t *vs, const struct stat *source_st);
+
+/**
+ * Record the temp list fingerprint after the set was brought up to date
+ */
+void voted_set_stamp(voted_set_t *vs, const struct stat *source_st);
+
+/**
+ * Rebuild the set from the voting_number column of source and stamp it
+ * @param source Temp voted list (first row is a header)
+ * @param id_hint Optional file whose first data row shows the canonical id
+ *                format when source has no votes yet (data/approved_voters.txt)
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int voted_set_rebuild(voted_set_t *vs, const char *source, const char *id_hint);
+
+/**
+ * Add a voter
+ * @return 1 if newly added, 0 if already present, negative error code on failure
+ */
+int voted_set_add(voted_set_t *vs, const char *voting_number);
+
+/**
+ * Whether a voter is in the set
+ * @param source Temp voted list, read when another process added irregular ids
+ * @return 1 if present, 0 if not, negative error code when the bitmap cannot be
+ *         remapped or the temp list cannot be read (test with > 0)
+ */
+int voted_set_contains(voted_set_t *vs, const char *source, const char *voting_number);
+
+#endif // VOTED_SET_H
@@ -0,0 +1,601 @@
+/*
+ * VoteMe Vote Server (votemed)
+ *
+ * Long-running owner of the vote log for the booths of one host. The voter
+ * roll (data/approved_voters.txt) and the ballot catalog are loaded into
+ * memory once; who has voted comes from the vote journal's voted set, and
+ * ballots go through the vote journal. Booths (bin/vote --server) send
+ * lookup/validate/cast requests over an AF_UNIX socket (votemed_proto.h),
+ * so a vote costs a hash lookup and a journal append instead of CSV scans.
+ *
+ * The roll and the catalog are reloaded when their files change on disk
+ * (size/mtime/inode, checked per request). Booths that still write the
+ * files directly stay safe: the journal re-checks every voter under the
+ * temp list's lock when it commits.
+ *
+ * Usage: votemed [socket_path]   (default data/votemed.sock)
+ */
+
+// sigaction/strnlen/st_mtim need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "ballot_catalog.h"
+#include "data_handler_enhanced.h"
+#include "sys_config.h"
+#include "vote_journal.h"
+#include "vote_source.h"
+#include "votemed_proto.h"
+
+#define VOTER_ROLL_FILE "data/approved_voters.txt"
+#define VOTEMED_MAX_CLIENTS 64
+// Replies queued for a booth that is slow to read them
+#define VOTEMED_CLIENT_OUT (16 * VOTEMED_MAX_FRAME)
+
+/* ==== Voter roll ==== */
+
+// approved_voters.txt in memory: voting_number -> district_id
+typedef struct
+{
+    char *pool;              // "voting_number\0district_id\0" per voter
+    size_t pool_used;
+    size_t pool_size;
+    uint32_t *ids;           // pool offset of each voter's voting_number
+    uint32_t *districts;     // pool offset of each voter's district_id
+    int count;
+    int capacity;
+    int32_t *slots;          // voter per slot, -1 when empty
+    size_t mask;             // slot count - 1
+    struct stat source;      // file the roll was loaded from (zeroed when missing)
+} voter_roll_t;
+
+// FNV-1a, like every other table in the tree
+static size_t hash_id(const char *s)
+{
+    uint32_t h = 2166136261u;
+    for (; *s; s++)
+    {
+        h ^= (unsigned char)*s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void roll_free(voter_roll_t *roll)
+{
+    free(roll->pool);
+    free(roll->ids);
+    free(roll->districts);
+    free(roll->slots);
+    memset(roll, 0, sizeof(*roll));
+}
+
+static int roll_find(const voter_roll_t *roll, const char *voting_number)
+{
+    if (!roll->slots)
+        return -1;
+    for (size_t i = hash_id(voting_number) & roll->mask; roll->slots[i] >= 0; i = (i + 1) & roll->mask)
+    {
+        if (strcmp(roll->pool + roll->ids[roll->slots[i]], voting_number) == 0)
+            return roll->slots[i];
+    }
+    return -1;
+}
+
+// Copy a string into the pool; its offset, or -1 when out of memory
+static long pool_add(voter_roll_t *roll, const char *s)
+{
+    size_t len = strlen(s) + 1;
+    if (roll->pool_used + len > roll->pool_size)
+    {
+        size_t size = roll->pool_size ? roll->pool_size * 2 : 64 * 1024;
+        while (size < roll->pool_used + len)
+            size *= 2;
+        char *grown = realloc(roll->pool, size);
+        if (!grown)
+            return -1;
+        roll->pool = grown;
+        roll->pool_size = size;
+    }
+    memcpy(roll->pool + roll->pool_used, s, len);
+    roll->pool_used += len;
+    return (long)(roll->pool_used - len);
+}
+
+// Add a voter; the first row of a voting_number wins, as with a scan
+static int roll_add(voter_roll_t *roll, const char *voting_number, const char *district_id)
+{
+    if (roll_find(roll, voting_number) >= 0)
+        return DATA_SUCCESS;
+
+    if (roll->count == roll->capacity)
+    {
+        int cap = roll->capacity ? roll->capacity * 2 : 1024;
+        uint32_t *ids = realloc(roll->ids, (size_t)cap * sizeof(*ids));
+        if (!ids)
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        roll->ids = ids;
+        uint32_t *districts = realloc(roll->districts, (size_t)cap * sizeof(*districts));
+        if (!districts)
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        roll->districts = districts;
+        roll->capacity = cap;
+    }
+    if (!roll->slots || (size_t)(roll->count + 1) * 2 > roll->mask + 1)
+    {
+        size_t size = roll->slots ? (roll->mask + 1) * 2 : 2048;
+        int32_t *slots = malloc(size * sizeof(*slots));
+        if (!slots)
+            return DATA_ERROR_MEMORY_ALLOCATION;
+        for (size_t i = 0; i < size; i++)
+            slots[i] = -1;
+        for (int k = 0; k < roll->count; k++)
+        {
+            size_t i = hash_id(roll->pool + roll->ids[k]) & (size - 1);
+            while (slots[i] >= 0)
+                i = (i + 1) & (size - 1);
+            slots[i] = k;
+        }
+        free(roll->slots);
+        roll->slots = slots;
+        roll->mask = size - 1;
+    }
+
+    long id = pool_add(roll, voting_number);
+    long district = id >= 0 ? pool_add(roll, district_id) : -1;
+    if (district < 0 || roll->pool_used > UINT32_MAX)
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    size_t i = hash_id(voting_number) & roll->mask;
+    while (roll->slots[i] >= 0)
+        i = (i + 1) & roll->mask;
+    roll->ids[roll->count] = (uint32_t)id;
+    roll->districts[roll->count] = (uint32_t)district;
+    roll->slots[i] = roll->count++;
+    return DATA_SUCCESS;
+}
+
+// Load the roll (voting_number,name,nic,district_id); a missing file is an empty roll
+static int roll_load(voter_roll_t *roll, const char *path)
+{
+    memset(roll, 0, sizeof(*roll));
+    if (access(path, F_OK) != 0)
+        return DATA_SUCCESS;
+
+    vote_source_t src;
+    int rc = vote_source_open(&src, path);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    if (fstat(src.fd, &roll->source) != 0)
+        memset(&roll->source, 0, sizeof(roll->source));
+
+    vote_field_t fields[4];
+    int nfields, r, header = 1;
+    while ((r = vote_source_next(&src, fields, 4, &nfields)) == 1)
+    {
+        if (header)
+        {
+            header = 0;
+            continue;
+        }
+        char id[64], district[64];
+        vote_field_copy(&fields[0], id, sizeof(id));
+        vote_field_copy(nfields >= 4 ? &fields[3] : NULL, district, sizeof(district));
+        if (id[0] && (rc = roll_add(roll, id, district)) != DATA_SUCCESS)
+            break;
+    }
+    vote_source_close(&src);
+    if (r < 0)
+        rc = r;
+    if (rc == DATA_ERROR_MEMORY_ALLOCATION)
+        set_error_message("Error: Memory allocation failed while loading the voter roll");
+    if (rc != DATA_SUCCESS)
+        roll_free(roll);
+    return rc;
+}
+
+/* ==== Server state ==== */
+
+static voter_roll_t roll;
+static ballot_catalog_t catalog;
+static struct stat catalog_sources[3];
+static int by_district;
+static volatile sig_atomic_t stopping;
+
+static const char *const catalog_paths[3] = {CATALOG_PARTIES_FILE, CATALOG_DISTRICTS_FILE,
+                                              CATALOG_CANDIDATES_FILE};
+
+// stat() that reads a missing file as all zeros
+static void stat_or_zero(const char *path, struct stat *st)
+{
+    if (stat(path, st) != 0)
+        memset(st, 0, sizeof(*st));
+}
+
+static int same_file(const struct stat *a, const struct stat *b)
+{
+    return a->st_size == b->st_size && a->st_ino == b->st_ino && a->st_mtime == b->st_mtime &&
+           a->st_mtim.tv_nsec == b->st_mtim.tv_nsec;
+}
+
+// Reload the roll or the catalog when its files changed; on failure the
+// loaded copy keeps serving
+static void refresh_sources(void)
+{
+    struct stat st;
+    stat_or_zero(VOTER_ROLL_FILE, &st);
+    if (!same_file(&st, &roll.source))
+    {
+        voter_roll_t fresh;
+        if (roll_load(&fresh, VOTER_ROLL_FILE) == DATA_SUCCESS)
+        {
+            roll_free(&roll);
+            roll = fresh;
+        }
+        else
+        {
+            fprintf(stderr, "votemed: keeping the old voter roll (%s)\n", get_last_error());
+        }
+    }
+
+    struct stat now[3];
+    int changed = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        stat_or_zero(catalog_paths[i], &now[i]);
+        changed |= !same_file(&now[i], &catalog_sources[i]);
+    }
+    if (changed)
+    {
+        ballot_catalog_t fresh;
+        if (ballot_catalog_load(&fresh, CATALOG_SNAPSHOT_FILE) == DATA_SUCCESS)
+        {
+            ballot_catalog_free(&catalog);
+            catalog = fresh;
+            memcpy(catalog_sources, now, sizeof(now));
+        }
+        else
+        {
+            fprintf(stderr, "votemed: keeping the old catalog (%s)\n", get_last_error());
+        }
+    }
+}
+
+/* ==== Requests ==== */
+
+// Approved and not voted yet; *voter is its roll row
+static int check_eligible(const char *voting_number, int *voter)
+{
+    *voter = roll_find(&roll, voting_number);
+    if (*voter < 0)
+    {
+        set_error_arg(DATA_ERROR_RECORD_NOT_FOUND, "Voter ID '%s' not found or not approved", voting_number);
+        return DATA_ERROR_RECORD_NOT_FOUND;
+    }
+    int voted = vote_journal_voted(voting_number);
+    if (voted < 0)
+        return voted;
+    if (voted)
+    {
+        set_error_arg(DATA_ERROR_DUPLICATE_RECORD, "Voter '%s' has already voted", voting_number);
+        return DATA_ERROR_DUPLICATE_RECORD;
+    }
+    return DATA_SUCCESS;
+}
+
+// Whether the candidate stands for the party (in the voter's district when filtering)
+static int on_ballot(int voter, int party, const char *candidate_number)
+{
+    int district = BALLOT_ANY_DISTRICT;
+    if (by_district)
+        district = ballot_catalog_district(&catalog, roll.pool + roll.districts[voter]);
+    const ballot_candidate_t *first;
+    int count = ballot_catalog_candidates(&catalog, party, district, &first);
+    for (int i = 0; i < count; i++)
+    {
+        if (strcmp(first[i].id, candidate_number) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+static int handle(const votemed_msg_t *req, votemed_msg_t *reply)
+{
+    static const int wanted[] = {0, 0, 1, 1, 3}; // fields per op
+    votemed_msg_init(reply, req->op, DATA_SUCCESS);
+    if (req->op < VOTEMED_OP_PING || req->op > VOTEMED_OP_CAST || req->nfields != wanted[req->op])
+    {
+        set_error_message("Error: Unknown or malformed votemed request");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    if (req->op == VOTEMED_OP_PING)
+        return DATA_SUCCESS;
+
+    refresh_sources();
+    const char *voting_number = req->fields[0];
+    int voter = roll_find(&roll, voting_number);
+    if (req->op == VOTEMED_OP_LOOKUP)
+    {
+        if (voter < 0)
+        {
+            set_error_arg(DATA_ERROR_RECORD_NOT_FOUND, "Voter ID '%s' not found or not approved", voting_number);
+            return DATA_ERROR_RECORD_NOT_FOUND;
+        }
+        int voted = vote_journal_voted(voting_number);
+        if (voted < 0)
+            return voted;
+        const char *district = roll.pool + roll.districts[voter];
+        char flag = (char)(voted != 0);
+        votemed_msg_add(reply, district, strlen(district));
+        votemed_msg_add(reply, &flag, 1);
+        return DATA_SUCCESS;
+    }
+
+    int rc = check_eligible(voting_number, &voter);
+    if (rc != DATA_SUCCESS)
+        return rc;
+    if (req->op == VOTEMED_OP_VALIDATE)
+    {
+        const char *district = roll.pool + roll.districts[voter];
+        votemed_msg_add(reply, district, strlen(district));
+        return DATA_SUCCESS;
+    }
+
+    // CAST: the ballot must be one this voter could have been shown
+    int party = ballot_catalog_find_party(&catalog, req->fields[2]);
+    if (party < 0 || !on_ballot(voter, party, req->fields[1]))
+    {
+        set_error_message("Candidate '%s' of party '%s' is not on this voter's ballot", req->fields[1],
+                          req->fields[2]);
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    return vote_journal_append(voting_number, req->fields[1], catalog.parties[party].id);
+}
+
+/* ==== Socket ==== */
+
+// A booth's connection. Its socket is non-blocking: replies it has not read
+// yet wait in out, and its requests are not read while out is full, so a
+// booth that stops reading cannot stall the others.
+typedef struct
+{
+    int fd;
+    unsigned char buf[VOTEMED_MAX_FRAME]; // request bytes read so far
+    size_t len;
+    unsigned char out[VOTEMED_CLIENT_OUT]; // reply bytes not sent yet
+    size_t out_len;
+} client_t;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stopping = 1;
+}
+
+static int listen_on(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "votemed: socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // A socket file nobody answers on is left over from a crash
+    votemed_conn_t probe;
+    if (votemed_connect(&probe, path) == DATA_SUCCESS)
+    {
+        votemed_disconnect(&probe);
+        fprintf(stderr, "votemed: already running on %s\n", path);
+        return -1;
+    }
+    unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0)
+    {
+        fprintf(stderr, "votemed: cannot listen on %s: %s\n", path, strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Whether another reply fits in the client's queue
+static int out_room(const client_t *c)
+{
+    return sizeof(c->out) - c->out_len >= VOTEMED_MAX_FRAME;
+}
+
+// Answer the complete requests in the client's buffer while replies fit;
+// 0 on a malformed frame
+static int serve_requests(client_t *c)
+{
+    votemed_msg_t req, reply;
+    int used = 0;
+    while (out_room(c) && (used = votemed_decode(c->buf, c->len, &req)) > 0)
+    {
+        int rc = handle(&req, &reply);
+        if (rc != DATA_SUCCESS)
+        {
+            const char *msg = get_last_error();
+            votemed_msg_init(&reply, req.op, rc);
+            votemed_msg_add(&reply, msg, strnlen(msg, VOTEMED_MAX_FIELD));
+        }
+        c->out_len += votemed_encode(&reply, c->out + c->out_len);
+        c->len -= (size_t)used;
+        memmove(c->buf, c->buf + used, c->len);
+    }
+    return used >= 0;
+}
+
+// Send what the socket takes without blocking; 0 when the booth is gone
+static int flush_client(client_t *c)
+{
+    size_t sent = 0;
+    while (sent < c->out_len)
+    {
+        ssize_t n = write(c->fd, c->out + sent, c->out_len - sent);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0)
+            return 0;
+        sent += (size_t)n;
+    }
+    c->out_len -= sent;
+    memmove(c->out, c->out + sent, c->out_len);
+    return 1;
+}
+
+// Read, answer and send for one client; 0 when it must be dropped
+static int serve_client(client_t *c, short revents)
+{
+    if ((revents & POLLIN) && out_room(c) && c->len < sizeof(c->buf))
+    {
+        ssize_t n = read(c->fd, c->buf + c->len, sizeof(c->buf) - c->len);
+        if (n == 0 || (n < 0 && errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK))
+            return 0;
+        if (n > 0)
+            c->len += (size_t)n;
+    }
+    else if (revents & (POLLERR | POLLHUP | POLLNVAL))
+    {
+        return 0;
+    }
+
+    // Sending frees room for requests that were waiting on it
+    for (;;)
+    {
+        if (!serve_requests(c))
+            return 0; // a malformed frame ends the connection
+        size_t queued = c->out_len;
+        if (!flush_client(c))
+            return 0;
+        if (c->out_len == queued || c->len == 0)
+            return 1;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2 || (argc == 2 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)))
+    {
+        fprintf(stderr, "Usage: %s [socket_path]   (default %s)\n", argv[0], VOTEMED_SOCKET_FILE);
+        return argc > 2 ? 1 : 0;
+    }
+    const char *path = argc == 2 ? argv[1] : VOTEMED_SOCKET_FILE;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal; // no SA_RESTART: poll() returns on a stop request
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN); // a booth that hangs up must not kill the server
+
+    if (vote_journal_open() != DATA_SUCCESS)
+    {
+        fprintf(stderr, "votemed: cannot open vote journal (%s)\n", get_last_error());
+        return 1;
+    }
+    by_district = config_get_int(BALLOT_DISTRICT_FILTER_CONFIG_KEY, 0) != 0;
+    refresh_sources();
+
+    int listen_fd = listen_on(path);
+    if (listen_fd < 0)
+    {
+        vote_journal_close();
+        return 1;
+    }
+    printf("votemed: %d voters, %d parties, %d candidates; listening on %s\n", roll.count,
+           catalog.party_count, catalog.candidate_count, path);
+    fflush(stdout);
+
+    client_t *clients = calloc(VOTEMED_MAX_CLIENTS, sizeof(*clients));
+    struct pollfd fds[VOTEMED_MAX_CLIENTS + 1];
+    int nclients = 0;
+    while (clients && !stopping)
+    {
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < nclients; i++)
+        {
+            fds[i + 1].fd = clients[i].fd;
+            fds[i + 1].events = (short)((out_room(&clients[i]) ? POLLIN : 0) | (clients[i].out_len ? POLLOUT : 0));
+        }
+        if (poll(fds, (nfds_t)nclients + 1, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "votemed: poll failed: %s\n", strerror(errno));
+            break;
+        }
+
+        // Serve before accepting so the indexes of fds and clients agree
+        for (int i = nclients - 1; i >= 0; i--)
+        {
+            if (!fds[i + 1].revents || serve_client(&clients[i], fds[i + 1].revents))
+                continue;
+            close(clients[i].fd);
+            clients[i] = clients[--nclients];
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0 && nclients == VOTEMED_MAX_CLIENTS)
+            {
+                fprintf(stderr, "votemed: too many booths connected, refusing one\n");
+                close(fd);
+            }
+            else if (fd >= 0 && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0)
+            {
+                fprintf(stderr, "votemed: cannot make a booth socket non-blocking: %s\n", strerror(errno));
+                close(fd);
+            }
+            else if (fd >= 0)
+            {
+                clients[nclients].fd = fd;
+                clients[nclients].len = 0;
+                clients[nclients].out_len = 0;
+                nclients++;
+            }
+        }
+    }
+
+    for (int i = 0; i < nclients; i++)
+        close(clients[i].fd);
+    free(clients);
+    close(listen_fd);
+    unlink(path);
+
+    // Commit whatever the group commit still holds
+    int rc = vote_journal_close();
+    if (rc != DATA_SUCCESS)
+        fprintf(stderr, "votemed: vote journal close failed (%s)\n", get_last_error());
+    vote_journal_stats_t st;
+    vote_journal_get_stats(&st);
+    printf("votemed: %llu votes durable, %llu dropped; backlog peak %llu, full-ring waits %llu; "
+           "enqueue-to-durable %.0f us avg, %.0f us max\n",
+           st.durable, st.dropped, st.max_depth, st.full_waits, st.avg_latency_us, st.max_latency_us);
+    ballot_catalog_free(&catalog);
+    roll_free(&roll);
+    return rc == DATA_SUCCESS ? 0 : 1;
+}
@@ -0,0 +1,278 @@
+/*
+ * VoteMe Vote Server Protocol Implementation
+ */
+
+// Sockets and read/write need POSIX under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "data_errors.h"
+#include "votemed_proto.h"
+
+/* ==== Frames ==== */
+
+void votemed_msg_init(votemed_msg_t *m, int op, int status)
+{
+    m->op = op;
+    m->status = status;
+    m->nfields = 0;
+}
+
+int votemed_msg_add(votemed_msg_t *m, const char *data, size_t len)
+{
+    if (m->nfields == VOTEMED_MAX_FIELDS || len > VOTEMED_MAX_FIELD)
+    {
+        set_error_message("Error: Field does not fit in a votemed message");
+        return DATA_ERROR_BUFFER_OVERFLOW;
+    }
+    memcpy(m->fields[m->nfields], data, len);
+    m->fields[m->nfields][len] = '\0';
+    m->lens[m->nfields] = (unsigned char)len;
+    m->nfields++;
+    return DATA_SUCCESS;
+}
+
+size_t votemed_encode(const votemed_msg_t *m, unsigned char *out)
+{
+    size_t n = VOTEMED_HEADER_SIZE;
+    for (int i = 0; i < m->nfields; i++)
+    {
+        out[n++] = m->lens[i];
+        memcpy(out + n, m->fields[i], m->lens[i]);
+        n += m->lens[i];
+    }
+    size_t body = n - VOTEMED_HEADER_SIZE;
+    out[0] = (unsigned char)m->op;
+    out[1] = (unsigned char)(signed char)m->status;
+    out[2] = (unsigned char)(body >> 8);
+    out[3] = (unsigned char)body;
+    return n;
+}
+
+int votemed_decode(const unsigned char *buf, size_t len, votemed_msg_t *m)
+{
+    if (len < VOTEMED_HEADER_SIZE)
+        return 0;
+    size_t body = ((size_t)buf[2] << 8) | buf[3];
+    if (body > VOTEMED_MAX_FRAME - VOTEMED_HEADER_SIZE)
+        return DATA_ERROR_MALFORMED_DATA;
+    if (len < VOTEMED_HEADER_SIZE + body)
+        return 0;
+
+    votemed_msg_init(m, buf[0], (signed char)buf[1]);
+    const unsigned char *p = buf + VOTEMED_HEADER_SIZE;
+    const unsigned char *end = p + body;
+    while (p < end)
+    {
+        size_t flen = *p++;
+        if (flen > (size_t)(end - p) || m->nfields == VOTEMED_MAX_FIELDS)
+            return DATA_ERROR_MALFORMED_DATA;
+        votemed_msg_add(m, (const char *)p, flen);
+        p += flen;
+    }
+    return (int)(VOTEMED_HEADER_SIZE + body);
+}
+
+#if !defined(_WIN32)
+
+int votemed_send(int fd, const votemed_msg_t *m)
+{
+    unsigned char frame[VOTEMED_MAX_FRAME];
+    size_t len = votemed_encode(m, frame);
+    const unsigned char *p = frame;
+    while (len > 0)
+    {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            set_error_message("Error: Cannot send to votemed: %s", strerror(errno));
+            return DATA_ERROR_PERMISSION_DENIED;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return DATA_SUCCESS;
+}
+
+/* ==== Client ==== */
+
+int votemed_connect(votemed_conn_t *c, const char *socket_path)
+{
+    c->fd = -1;
+    c->len = 0;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (!socket_path || strlen(socket_path) >= sizeof(addr.sun_path))
+    {
+        set_error_message("Error: Invalid votemed socket path");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        set_error_message("Error: Cannot create socket: %s", strerror(errno));
+        return DATA_ERROR_PERMISSION_DENIED;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        set_error_message("Error: votemed is not running at '%s': %s", socket_path, strerror(errno));
+        close(fd);
+        return DATA_ERROR_FILE_NOT_FOUND;
+    }
+    c->fd = fd;
+    return DATA_SUCCESS;
+}
+
+void votemed_disconnect(votemed_conn_t *c)
+{
+    if (c->fd >= 0)
+        close(c->fd);
+    c->fd = -1;
+    c->len = 0;
+}
+
+int votemed_call(votemed_conn_t *c, const votemed_msg_t *request, votemed_msg_t *reply)
+{
+    if (c->fd < 0)
+    {
+        set_error_message("Error: Not connected to votemed");
+        return DATA_ERROR_INVALID_INPUT;
+    }
+    int rc = votemed_send(c->fd, request);
+    if (rc != DATA_SUCCESS)
+        return rc;
+
+    // One request in flight at a time: the reply is the next frame
+    int used;
+    while ((used = votemed_decode(c->buf, c->len, reply)) == 0)
+    {
+        ssize_t n = read(c->fd, c->buf + c->len, sizeof(c->buf) - c->len);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            set_error_message("Error: votemed closed the connection");
+            votemed_disconnect(c);
+            return DATA_ERROR_FILE_NOT_FOUND;
+        }
+        c->len += (size_t)n;
+    }
+    if (used < 0 || reply->op != request->op)
+    {
+        set_error_message("Error: Malformed reply from votemed");
+        votemed_disconnect(c);
+        return DATA_ERROR_MALFORMED_DATA;
+    }
+    c->len -= (size_t)used;
+    memmove(c->buf, c->buf + used, c->len);
+
+    if (reply->status != DATA_SUCCESS && reply->nfields > 0)
+        set_error_message("%s", reply->fields[0]);
+    return reply->status;
+}
+
+#else // _WIN32: no AF_UNIX in the supported toolchains
+
+int votemed_send(int fd, const votemed_msg_t *m)
+{
+    (void)fd;
+    (void)m;
+    set_error_message("Error: votemed is not available on this platform");
+    return DATA_ERROR_FILE_NOT_FOUND;
+}
+
+int votemed_connect(votemed_conn_t *c, const char *socket_path)
+{
+    (void)socket_path;
+    c->fd = -1;
+    c->len = 0;
+    set_error_message("Error: votemed is not available on this platform");
+    return DATA_ERROR_FILE_NOT_FOUND;
+}
+
+void votemed_disconnect(votemed_conn_t *c)
+{
+    c->fd = -1;
+    c->len = 0;
+}
+
+int votemed_call(votemed_conn_t *c, const votemed_msg_t *request, votemed_msg_t *reply)
+{
+    (void)c;
+    (void)request;
+    (void)reply;
+    set_error_message("Error: votemed is not available on this platform");
+    return DATA_ERROR_FILE_NOT_FOUND;
+}
+
+#endif
+
+// Request with the given string fields
+static int call_with(votemed_conn_t *c, int op, const char *const values[], int count, votemed_msg_t *reply)
+{
+    votemed_msg_t request;
+    votemed_msg_init(&request, op, 0);
+    for (int i = 0; i < count; i++)
+    {
+        const char *v = values[i] ? values[i] : "";
+        int rc = votemed_msg_add(&request, v, strlen(v));
+        if (rc != DATA_SUCCESS)
+            return rc;
+    }
+    return votemed_call(c, &request, reply);
+}
+
+int votemed_lookup(votemed_conn_t *c, const char *voting_number, char *district_id, size_t district_size,
+                   int *voted)
+{
+    votemed_msg_t reply;
+    const char *values[] = {voting_number ? voting_number : ""};
+    int rc = call_with(c, VOTEMED_OP_LOOKUP, values, 1, &reply);
+    if (rc == DATA_SUCCESS && reply.nfields < 2)
+    {
+        set_error_message("Error: Malformed reply from votemed");
+        rc = DATA_ERROR_MALFORMED_DATA;
+    }
+    if (rc == DATA_SUCCESS)
+    {
+        if (district_id && district_size > 0)
+            snprintf(district_id, district_size, "%s", reply.fields[0]);
+        if (voted)
+            *voted = reply.lens[1] > 0 && reply.fields[1][0] != 0;
+    }
+    return rc;
+}
+
+int votemed_validate(votemed_conn_t *c, const char *voting_number, char *district_id, size_t district_size)
+{
+    votemed_msg_t reply;
+    const char *values[] = {voting_number ? voting_number : ""};
+    int rc = call_with(c, VOTEMED_OP_VALIDATE, values, 1, &reply);
+    if (rc == DATA_SUCCESS && district_id && district_size > 0)
+        snprintf(district_id, district_size, "%s", reply.nfields > 0 ? reply.fields[0] : "");
+    return rc;
+}
+
+int votemed_cast(votemed_conn_t *c, const char *voting_number, const char *candidate_number,
+                 const char *party_id)
+{
+    votemed_msg_t reply;
+    const char *values[] = {voting_number, candidate_number, party_id};
+    return call_with(c, VOTEMED_OP_CAST, values, 3, &reply);
+}
@@ -0,0 +1,129 @@
+/*
+ * VoteMe Vote Server Protocol Header
+ *
+ * Wire format between booths and the votemed daemon over an AF_UNIX stream
+ * socket. Every message, request or reply, is one frame:
+ *
+ *   byte 0     op (VOTEMED_OP_*)
+ *   byte 1     status: 0 in requests, a DATA_* code (int8) in replies
+ *   bytes 2-3  body length, big endian
+ *   body       fields, each a length byte followed by that many bytes
+ *
+ * Requests and their fields:
+ *   PING      -                                       -> -
+ *   LOOKUP    voting_number                           -> district_id, voted (1 byte, 0/1)
+ *   VALIDATE  voting_number                           -> district_id
+ *   CAST      voting_number, candidate_number, party  -> -
+ * A failed reply carries the server's error message as its only field.
+ * VALIDATE and CAST answer like check_voter_eligible and cast_vote.
+ */
+
+#ifndef VOTEMED_PROTO_H
+#define VOTEMED_PROTO_H
+
+#include <stddef.h>
+
+#define VOTEMED_SOCKET_FILE "data/votemed.sock"
+
+#define VOTEMED_OP_PING 1
+#define VOTEMED_OP_LOOKUP 2
+#define VOTEMED_OP_VALIDATE 3
+#define VOTEMED_OP_CAST 4
+
+#define VOTEMED_HEADER_SIZE 4
+#define VOTEMED_MAX_FIELDS 4
+#define VOTEMED_MAX_FIELD 255
+#define VOTEMED_MAX_FRAME (VOTEMED_HEADER_SIZE + VOTEMED_MAX_FIELDS * (1 + VOTEMED_MAX_FIELD))
+
+// A decoded frame; fields are NUL-terminated copies
+typedef struct
+{
+    int op;
+    int status;
+    int nfields;
+    unsigned char lens[VOTEMED_MAX_FIELDS];
+    char fields[VOTEMED_MAX_FIELDS][VOTEMED_MAX_FIELD + 1];
+} votemed_msg_t;
+
+/**
+ * Start a message
+ */
+void votemed_msg_init(votemed_msg_t *m, int op, int status);
+
+/**
+ * Add a field (len bytes of data)
+ * @return DATA_SUCCESS, or DATA_ERROR_BUFFER_OVERFLOW when it does not fit
+ */
+int votemed_msg_add(votemed_msg_t *m, const char *data, size_t len);
+
+/**
+ * Encode a message into a frame
+ * @param out Buffer of at least VOTEMED_MAX_FRAME bytes
+ * @return Frame length
+ */
+size_t votemed_encode(const votemed_msg_t *m, unsigned char *out);
+
+/**
+ * Decode the frame at the start of a buffer
+ * @return Bytes consumed, 0 when the frame is incomplete, DATA_ERROR_MALFORMED_DATA
+ *         when the bytes cannot be a frame
+ */
+int votemed_decode(const unsigned char *buf, size_t len, votemed_msg_t *m);
+
+/**
+ * Write a whole frame to a socket
+ * @return DATA_SUCCESS on success, error code on failure
+ */
+int votemed_send(int fd, const votemed_msg_t *m);
+
+/* ==== Client ==== */
+
+// Connection from a booth to votemed
+typedef struct
+{
+    int fd;
+    unsigned char buf[VOTEMED_MAX_FRAME]; // bytes of the reply read so far
+    size_t len;
+} votemed_conn_t;
+
+/**
+ * Connect to a running votemed
+ * @param socket_path Socket path (VOTEMED_SOCKET_FILE)
+ * @return DATA_SUCCESS on success, DATA_ERROR_FILE_NOT_FOUND when no server listens
+ */
+int votemed_connect(votemed_conn_t *c, const char *socket_path);
+
+/**
+ * Close the connection (safe on a closed one)
+ */
+void votemed_disconnect(votemed_conn_t *c);
+
+/**
+ * Send a request and wait for its reply
+ * A failed reply's message becomes the last error.
+ * @return The reply's status, or an error code when the exchange failed
+ */
+int votemed_call(votemed_conn_t *c, const votemed_msg_t *request, votemed_msg_t *reply);
+
+/**
+ * Look up a voter on the server
+ * @param district_id Output: the voter's district_id
+ * @param voted Output: 1 if the voter already voted
+ * @return DATA_SUCCESS, or DATA_ERROR_RECORD_NOT_FOUND if not an approved voter
+ */
+int votemed_lookup(votemed_conn_t *c, const char *voting_number, char *district_id, size_t district_size,
+                   int *voted);
+
+/**
+ * check_voter_eligible on the server
+ * @param district_id Optional output: the voter's district_id
+ */
+int votemed_validate(votemed_conn_t *c, const char *voting_number, char *district_id, size_t district_size);
+
+/**
+ * cast_vote on the server
+ */
+int votemed_cast(votemed_conn_t *c, const char *voting_number, const char *candidate_number,
+                 const char *party_id);
+
+#endif // VOTEMED_PROTO_H
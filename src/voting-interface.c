@@ -2,12 +2,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
-#include <ctype.h>
 
+#include "ballot_catalog.h"
 #include "csv_io.h"
 #include "data_handler_enhanced.h"
 #include "data_errors.h"
 #include "voting-interface.h"
+#include "sys_config.h"
+#include "vote_journal.h"
+#include "votemed_proto.h"
 
 #define INPUT_BUF 256
 
@@ -22,251 +25,91 @@ static void trim_newline(char *s)
         s[--n] = '\0';
 }
 
-// Trim leading and trailing ASCII whitespace
-static void trim_spaces(char *s)
+// District of an approved_voters row (voting_number,name,nic,district_id)
+static void voter_district(const char *row, char *out, size_t outsz)
 {
-    if (!s)
-        return;
-    char *start = s;
-    while (*start && isspace((unsigned char)*start))
-        start++;
-    char *end = s + strlen(s);
-    while (end > start && isspace((unsigned char)end[-1]))
-        end--;
-    size_t len = (size_t)(end - start);
-    if (start != s)
-        memmove(s, start, len);
-    s[len] = '\0';
-}
-
-// Local safe strdup (portable)
-static char *sdup(const char *s)
-{
-    size_t len = strlen(s) + 1;
-    char *p = malloc(len);
-    if (p)
-        memcpy(p, s, len);
-    return p;
-}
-
-// Normalize party id by uppercasing and removing leading zeros after 'P'
-static void normalize_party_id(const char *in, char *out, size_t outsz)
-{
-    if (!in || !out || outsz == 0)
-        return;
-    char tmp[MAX_LINE_LENGTH];
-    strncpy(tmp, in, sizeof(tmp) - 1);
-    tmp[sizeof(tmp) - 1] = '\0';
-    trim_spaces(tmp);
-    for (char *p = tmp; *p; ++p)
-        *p = (char)toupper((unsigned char)*p);
-    if (tmp[0] == 'P')
+    char line[MAX_LINE_LENGTH];
+    char *fields[MAX_FIELDS];
+    out[0] = '\0';
+    strncpy(line, row, sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    int nf = split_csv_fields(line, fields, MAX_FIELDS, ',');
+    if (nf >= 4)
     {
-        const char *digits = tmp + 1;
-        while (*digits == '0')
-            digits++;
-        out[0] = 'P';
-        size_t n = 1;
-        if (*digits == '\0')
-        {
-            // all zeros or empty -> P0
-            if (n < outsz - 1)
-            {
-                out[n++] = '0';
-            }
-            out[n] = '\0';
-            return;
-        }
-        while (*digits && n < outsz - 1)
-            out[n++] = *digits++;
-        out[n] = '\0';
-    }
-    else
-    {
-        strncpy(out, tmp, outsz - 1);
+        strncpy(out, fields[3], outsz - 1);
         out[outsz - 1] = '\0';
     }
+    for (int i = 0; i < nf; ++i)
+        free(fields[i]);
 }
 
-static bool eq_party_id(const char *a, const char *b)
-{
-    char na[MAX_LINE_LENGTH], nb[MAX_LINE_LENGTH];
-    normalize_party_id(a, na, sizeof(na));
-    normalize_party_id(b, nb, sizeof(nb));
-    return strcmp(na, nb) == 0;
-}
-
-static bool ensure_votes_file_exists(const char *path)
+// Index of a candidate id within a ballot range, -1 if absent
+static int find_candidate(const char *id, const ballot_candidate_t *first, int count)
 {
-    FILE *f = fopen(path, "r");
-    if (f)
+    for (int i = 0; i < count; ++i)
     {
-        fclose(f);
-        return true;
+        if (strcmp(id, first[i].id) == 0)
+            return i;
     }
-    // Create with header if not present
-    return overwrite_file(path, "voter_id,candidate_id\n") == DATA_SUCCESS;
+    return -1;
 }
 
-// Read party_id -> party_name into arrays for quick lookup
-static int load_party_names(const char *parties_path, char *ids[], char *names[], int max)
+// Eligibility check, through votemed when connected; district_id (optional)
+// receives the voter's district
+static int booth_check(votemed_conn_t *server, const char *voting_number, char *district_id, size_t size)
 {
-    FILE *f = fopen(parties_path, "r");
-    if (!f)
-        return 0;
-    int n = 0;
-    while (1)
-    {
-        char *fields[MAX_FIELDS] = {0};
-        int nf = read_csv_line(f, fields, MAX_FIELDS, ',');
-        if (nf <= 0)
-            break;
-        if (nf >= 2 && n < max)
-        {
-            trim_spaces(fields[0]);
-            trim_spaces(fields[1]);
-            // Skip header row if present (expects: party_id,party_name)
-            if (fields[0] && fields[1] && strcmp(fields[0], "party_id") == 0 && strcmp(fields[1], "party_name") == 0)
-            {
-                for (int i = 0; i < nf; ++i)
-                    free(fields[i]);
-                continue;
-            }
-            ids[n] = sdup(fields[0]);
-            names[n] = sdup(fields[1]);
-            if (ids[n] && names[n])
-                n++;
-            else
-            {
-                free(ids[n]);
-                free(names[n]);
-            }
-        }
-        for (int i = 0; i < nf; ++i)
-            free(fields[i]);
-    }
-    fclose(f);
-    return n;
+    if (server)
+        return votemed_validate(server, voting_number, district_id, size);
+
+    char *voter_row = NULL;
+    int rc = check_voter_eligible(voting_number, district_id ? &voter_row : NULL);
+    if (district_id)
+        voter_district(voter_row ? voter_row : "", district_id, size);
+    free(voter_row);
+    return rc;
 }
 
-// Build unique list of party IDs that have at least one candidate
-static __attribute__((unused)) int collect_candidate_backed_parties(const char *candidates_path, char *out_ids[], int max_ids)
+static int booth_cast(votemed_conn_t *server, const char *voting_number, const char *candidate_number,
+                      const char *party_id)
 {
-    FILE *f = fopen(candidates_path, "r");
-    if (!f)
-        return 0;
-    int count = 0;
-    while (1)
-    {
-        char *fields[MAX_FIELDS] = {0};
-        int nf = read_csv_line(f, fields, MAX_FIELDS, ',');
-        if (nf <= 0)
-            break;
-        if (nf >= 3)
-        {
-            trim_spaces(fields[2]);
-            const char *pid = fields[2];
-            int seen = 0;
-            for (int i = 0; i < count; ++i)
-                if (eq_party_id(out_ids[i], pid))
-                {
-                    seen = 1;
-                    break;
-                }
-            if (!seen && count < max_ids)
-            {
-                out_ids[count] = sdup(pid);
-                if (out_ids[count])
-                    count++;
-            }
-        }
-        for (int i = 0; i < nf; ++i)
-            free(fields[i]);
-    }
-    fclose(f);
-    return count;
+    if (server)
+        return votemed_cast(server, voting_number, candidate_number, party_id);
+    return cast_vote(voting_number, candidate_number, party_id);
 }
 
-static __attribute__((unused)) const char *lookup_party_name(const char *id, char *pids[], char *pnames[], int n)
+// The booth session; server is NULL when this process records votes itself
+static int run_booth(votemed_conn_t *server)
 {
-    for (int i = 0; i < n; ++i)
-        if (pids[i] && eq_party_id(pids[i], id))
-            return pnames[i];
-    return NULL;
-}
+    char buf[INPUT_BUF];
 
-static int list_candidates_for_party(const char *candidates_path, const char *party_id, const char *party_name, char *out_ids[], int max_ids)
-{
-    FILE *f = fopen(candidates_path, "r");
-    if (!f)
+    // Replays votes a crashed session committed but did not apply
+    int jrc = server ? DATA_SUCCESS : vote_journal_open();
+    if (jrc != DATA_SUCCESS)
     {
-        fprintf(stderr, "Error: cannot open %s (%s)\n", candidates_path, get_last_error());
-        return -1;
+        fprintf(stderr, "Cannot open vote journal (%s)\n", get_last_error());
+        return jrc;
     }
-    int count = 0;
-    if (party_name && *party_name)
-        printf("\nCandidates in selected party (%s - %s):\n", party_id, party_name);
-    else
-        printf("\nCandidates in selected party (%s):\n", party_id);
-    while (1)
+
+    // Load parties and candidates once; ballots between voters are built from memory
+    ballot_catalog_t catalog;
+    int crc = ballot_catalog_load(&catalog, CATALOG_SNAPSHOT_FILE);
+    if (crc != DATA_SUCCESS)
     {
-        char *fields[MAX_FIELDS] = {0};
-        int nf = read_csv_line(f, fields, MAX_FIELDS, ',');
-        if (nf <= 0)
-            break;
-        // Expect: candidate_id, candidate_name, party_id, district_id, ...
-        if (nf >= 3)
-        {
-            trim_spaces(fields[2]);
-            if (eq_party_id(fields[2], party_id))
-            {
-                trim_spaces(fields[0]);
-                trim_spaces(fields[1]);
-                printf("  %s - %s\n", fields[0], fields[1]);
-                if (count < max_ids)
-                {
-                    out_ids[count] = sdup(fields[0]);
-                    if (out_ids[count])
-                        count++;
-                }
-            }
-        }
-        for (int i = 0; i < nf; ++i)
-            free(fields[i]);
+        fprintf(stderr, "Cannot load ballot (%s)\n", get_last_error());
+        if (!server)
+            vote_journal_close();
+        return crc;
     }
-    fclose(f);
-    if (count == 0)
+    bool by_district = config_get_int(BALLOT_DISTRICT_FILTER_CONFIG_KEY, 0) != 0;
+    int *disp_idx = malloc((size_t)(catalog.party_count > 0 ? catalog.party_count : 1) * sizeof(*disp_idx));
+    if (!disp_idx)
     {
-        printf("No candidates found for party %s.\n", party_id);
+        fprintf(stderr, "Cannot load ballot (out of memory)\n");
+        ballot_catalog_free(&catalog);
+        if (!server)
+            vote_journal_close();
+        return DATA_ERROR_MEMORY_ALLOCATION;
     }
-    return count;
-}
-
-// (count_candidates_for_party removed; superseded by collect_candidate_backed_parties)
-
-static bool id_in_list(const char *id, char *ids[], int n)
-{
-    for (int i = 0; i < n; ++i)
-    {
-        if (ids[i] && strcmp(id, ids[i]) == 0)
-            return true;
-    }
-    return false;
-}
-
-int vote_for_candidate_interactive(void)
-{
-    const char *parties_path = "data/party_name.txt";
-    const char *candidates_path = "data/approved_candidates.txt";
-    const char *votes_path = "data/votes.txt"; // persistent votes file used by voting.c
-
-    char buf[INPUT_BUF];
-
-    // Preload party names and candidate-backed parties to display only parties with candidates
-    char *party_ids[256] = {0}, *party_names[256] = {0};
-    int known_parties = load_party_names(parties_path, party_ids, party_names, 256);
-    char *backed_ids[256] = {0};
-    int backed_count = collect_candidate_backed_parties(candidates_path, backed_ids, 256);
 
     for (;;)
     {
@@ -283,45 +126,39 @@ int vote_for_candidate_interactive(void)
             continue;
         }
 
-        // Validate voter exists
-        char *voter_rec = read_voter(buf);
-        if (!voter_rec)
+        // Approved and not voted yet (checked again when the ballot is cast)
+        char district_id[MAX_LINE_LENGTH];
+        int elig = booth_check(server, buf, by_district ? district_id : NULL, sizeof(district_id));
+        if (elig == DATA_ERROR_DUPLICATE_RECORD)
+        {
+            printf("Voter '%s' has already voted (temp list found). Skipping.\n", buf);
+            continue;
+        }
+        if (elig != DATA_SUCCESS && server && server->fd < 0)
+        {
+            fprintf(stderr, "Lost the vote server (%s)\n", get_last_error());
+            break;
+        }
+        if (elig != DATA_SUCCESS)
         {
             printf("Voter ID '%s' not found or not approved.\n", buf);
             continue;
         }
-        // Save a safe copy and free record
         char voter_id_copy[MAX_LINE_LENGTH];
         strncpy(voter_id_copy, buf, sizeof(voter_id_copy) - 1);
         voter_id_copy[sizeof(voter_id_copy) - 1] = '\0';
-        free(voter_rec);
 
-        // Check if already voted in temp list
-        char *prev = read_temp_voted(voter_id_copy);
-        if (prev)
-        {
-            printf("Voter '%s' has already voted (temp list found). Skipping.\n", voter_id_copy);
-            free(prev);
-            continue;
-        }
+        // Restrict the ballot to the voter's district when configured
+        int district = BALLOT_ANY_DISTRICT;
+        if (by_district)
+            district = ballot_catalog_district(&catalog, district_id);
 
         // 2) Build filtered party list: only parties that have candidates
         int disp_count = 0;
-        int disp_idx[256]; // indices into party arrays
-        for (int i = 0; i < known_parties; ++i)
+        for (int i = 0; i < catalog.party_count; ++i)
         {
-            if (!party_ids[i])
-                continue;
-            int has = 0;
-            for (int j = 0; j < backed_count; ++j)
-            {
-                if (backed_ids[j] && eq_party_id(party_ids[i], backed_ids[j]))
-                {
-                    has = 1;
-                    break;
-                }
-            }
-            if (has)
+            const ballot_candidate_t *first;
+            if (ballot_catalog_candidates(&catalog, i, district, &first) > 0)
                 disp_idx[disp_count++] = i;
         }
         if (disp_count == 0)
@@ -331,9 +168,7 @@ int vote_for_candidate_interactive(void)
         }
 
         // 2b) Prompt for party selection (q cancels this voter and continues to next)
-        char party_id[MAX_LINE_LENGTH];
-        char selected_party_name[MAX_LINE_LENGTH];
-        selected_party_name[0] = '\0';
+        const ballot_party_t *party = NULL;
         bool party_menu_printed = false;
         while (1)
         {
@@ -343,9 +178,8 @@ int vote_for_candidate_interactive(void)
                 printf("  party_id - party_name\n");
                 for (int k = 0; k < disp_count; ++k)
                 {
-                    int i = disp_idx[k];
-                    if (party_ids[i] && party_names[i])
-                        printf("  %s - %s\n", party_ids[i], party_names[i]);
+                    const ballot_party_t *p = &catalog.parties[disp_idx[k]];
+                    printf("  %s - %s\n", p->id, p->name);
                 }
                 party_menu_printed = true;
             }
@@ -368,44 +202,29 @@ int vote_for_candidate_interactive(void)
                 continue;
             }
 
-            int sel_index = -1;
-            for (int k = 0; k < disp_count; ++k)
-            {
-                int i = disp_idx[k];
-                if (party_ids[i] && eq_party_id(buf, party_ids[i]))
-                {
-                    sel_index = i;
-                    break;
-                }
-            }
-            if (sel_index < 0)
+            int sel_index = ballot_catalog_find_party(&catalog, buf);
+            const ballot_candidate_t *first;
+            if (sel_index < 0 || ballot_catalog_candidates(&catalog, sel_index, district, &first) == 0)
             {
                 printf("Party '%s' is not in the list. Please choose from the list.\n", buf);
                 continue;
             }
-
-            // Stash selected party id and name
-            strncpy(party_id, party_ids[sel_index], sizeof(party_id) - 1);
-            party_id[sizeof(party_id) - 1] = '\0';
-            if (party_names[sel_index])
-            {
-                strncpy(selected_party_name, party_names[sel_index], sizeof(selected_party_name) - 1);
-                selected_party_name[sizeof(selected_party_name) - 1] = '\0';
-            }
+            party = &catalog.parties[sel_index];
             break;
         }
+        if (!party)
+            goto next_voter;
 
         // 3) Show candidates filtered by selected party
         {
-            char *candidate_ids[128] = {0};
-            int cand_count = list_candidates_for_party(candidates_path, party_id, selected_party_name, candidate_ids, 128);
-            if (cand_count <= 0)
-            {
-                printf("No candidates found for selected party.\n");
-                for (int i = 0; i < cand_count; ++i)
-                    free(candidate_ids[i]);
-                goto next_voter;
-            }
+            const ballot_candidate_t *candidates;
+            int cand_count = ballot_catalog_candidates(&catalog, (int)(party - catalog.parties), district, &candidates);
+            if (party->name[0])
+                printf("\nCandidates in selected party (%s - %s):\n", party->id, party->name);
+            else
+                printf("\nCandidates in selected party (%s):\n", party->id);
+            for (int i = 0; i < cand_count; ++i)
+                printf("  %s - %s\n", candidates[i].id, candidates[i].name);
 
             while (1)
             {
@@ -413,15 +232,11 @@ int vote_for_candidate_interactive(void)
                 if (!fgets(buf, sizeof(buf), stdin))
                 {
                     // input error -> cancel this voter
-                    for (int i = 0; i < cand_count; ++i)
-                        free(candidate_ids[i]);
                     goto next_voter;
                 }
                 trim_newline(buf);
                 if (strcmp(buf, "q") == 0 || strcmp(buf, "Q") == 0)
                 {
-                    for (int i = 0; i < cand_count; ++i)
-                        free(candidate_ids[i]);
                     goto next_voter;
                 }
                 if (buf[0] == '\0')
@@ -429,7 +244,7 @@ int vote_for_candidate_interactive(void)
                     printf("Candidate ID cannot be empty.\n");
                     continue;
                 }
-                if (!id_in_list(buf, candidate_ids, cand_count))
+                if (find_candidate(buf, candidates, cand_count) < 0)
                 {
                     printf("Candidate ID '%s' is not in the selected party.\n", buf);
                     continue;
@@ -440,51 +255,46 @@ int vote_for_candidate_interactive(void)
             strncpy(candidate_id, buf, sizeof(candidate_id) - 1);
             candidate_id[sizeof(candidate_id) - 1] = '\0';
 
-            // 3.5) Append to temp voted list (voting_number,candidate_number,party_id). Non-fatal on failure.
-            {
-                int rc = create_temp_voted(voter_id_copy, candidate_id, party_id);
-                if (rc != DATA_SUCCESS)
-                {
-                    fprintf(stderr, "Warning: failed to write temp voted list (code %d) - proceeding to record permanent vote.\n", rc);
-                }
-            }
-
-            // 4) Persist the vote
-            if (!ensure_votes_file_exists(votes_path))
-            {
-                fprintf(stderr, "Failed to prepare votes file '%s' (%s)\n", votes_path, get_last_error());
-                for (int i = 0; i < cand_count; ++i)
-                    free(candidate_ids[i]);
-                goto next_voter;
-            }
-
-            char record[1024];
-            snprintf(record, sizeof(record), "%s,%s", voter_id_copy, candidate_id);
-            int err = append_line(votes_path, record);
+            // 4) Cast the ballot: one journal record, from which the temp voted list
+            // and data/votes.txt (voter_id,candidate_id) rows are both derived
+            int err = booth_cast(server, voter_id_copy, candidate_id, party->id);
             if (err != DATA_SUCCESS)
             {
-                fprintf(stderr, "Failed to record vote (code %d)\n", err);
-                for (int i = 0; i < cand_count; ++i)
-                    free(candidate_ids[i]);
+                fprintf(stderr, "Failed to record vote (code %d): %s\n", err, get_last_error());
                 goto next_voter;
             }
 
             printf("\nYour vote has been recorded. Next voter please.\n");
-            for (int i = 0; i < cand_count; ++i)
-                free(candidate_ids[i]);
         }
 
     next_voter:; // continue outer loop for the next voter
     }
 
-    // cleanup preload arrays
-    for (int i = 0; i < known_parties; ++i)
+    // Commit whatever the group commit still holds
+    int close_rc = server ? DATA_SUCCESS : vote_journal_close();
+    if (close_rc != DATA_SUCCESS)
+        fprintf(stderr, "Warning: vote journal close failed (%s)\n", get_last_error());
+
+    free(disp_idx);
+    ballot_catalog_free(&catalog);
+    return close_rc;
+}
+
+int vote_for_candidate_interactive(void)
+{
+    return run_booth(NULL);
+}
+
+int vote_for_candidate_interactive_remote(const char *socket_path)
+{
+    votemed_conn_t server;
+    int rc = votemed_connect(&server, socket_path ? socket_path : VOTEMED_SOCKET_FILE);
+    if (rc != DATA_SUCCESS)
     {
-        free(party_ids[i]);
-        free(party_names[i]);
+        fprintf(stderr, "Cannot reach the vote server (%s)\n", get_last_error());
+        return rc;
     }
-    for (int j = 0; j < backed_count; ++j)
-        free(backed_ids[j]);
-
-    return DATA_SUCCESS;
+    rc = run_booth(&server);
+    votemed_disconnect(&server);
+    return rc;
 }
@@ -5,9 +5,18 @@
 // 1) Prompt voter id and validate against approved voters
 // 2) Show party list and prompt for a valid party id
 // 3) Show candidates filtered by party and prompt for candidate id
-// 4) Append the vote as "voter_id,candidate_id" to data/votes.txt
+//    (parties and candidates are loaded once per session into a ballot
+//    catalog; with ballot_district_filter=1 in data/system_config.txt only
+//    candidates of the voter's district_id are offered)
+// 4) Record the vote through the vote journal, which appends it to
+//    data/temp-voted-list.txt and data/votes.txt ("voter_id,candidate_id")
 //
 // Returns 0 on success, negative error code (from data_errors.h) on failure.
 int vote_for_candidate_interactive(void);
 
+// The same flow with the voter checks and the ballot sent to the votemed
+// server at socket_path (NULL for data/votemed.sock) instead of touching
+// the data files; the ballot itself is still read from the catalog snapshot.
+int vote_for_candidate_interactive_remote(const char *socket_path);
+
 #endif // VOTING_INTERFACE_H
@@ -15,6 +15,11 @@
 #include "data_handle.h"
 #include "data_handler_enhanced.h"
 #include "voting.h"
+#include "tally.h"
+#include "vote_source.h"
+#include "catalog_snapshot.h"
+#include "sys_config.h"
+#include "vote_journal.h"
 
 // Color codes for result display
 #define GREEN "\033[0;32m"
@@ -27,22 +32,13 @@
 #define RESET "\033[0m"
 #define BOLD "\033[1m"
 
-// Voting results structure
-typedef struct
-{
-    char candidate_number[20];
-    char candidate_name[100];
-    char party_id[20];
-    char district_id[20];
-    int vote_count;
-    int qualified_for_parliament;
-} candidate_result_t;
-
 // Voting statistics structure
 typedef struct
 {
     int total_candidates;
     int total_votes_cast;
+    int unknown_candidate_votes;
+    int malformed_vote_rows;
     int qualified_candidates;
     int parliament_members_selected;
     int min_votes_threshold;
@@ -51,125 +47,114 @@ typedef struct
     char voting_time[50];
 } voting_statistics_t;
 
+// View of a snapshot string as a field for the tally table
+static csv_span_t catalog_span(const catalog_snapshot_t *catalog, uint32_t offset)
+{
+    csv_span_t span;
+    span.ptr = catalog_str(catalog, offset);
+    span.len = strlen(span.ptr);
+    span.quoting = CSV_SPAN_PLAIN;
+    return span;
+}
+
 /**
- * Load candidate votes from the votes file
- * @param candidates Array to store candidate results
- * @param max_candidates Maximum number of candidates
- * @return Number of candidates loaded
+ * Load the candidate roster from the catalog snapshot
+ * @param candidates Empty table to fill (grows as needed)
+ * @return Number of candidates loaded, negative error code on allocation failure
  */
-static int load_candidates(candidate_result_t candidates[], int max_candidates)
+static int load_candidates(tally_table_t *candidates)
 {
-    FILE *candidates_file = fopen("data/approved_candidates.txt", "r");
-
-    if (!candidates_file)
+    catalog_snapshot_t catalog;
+    if (catalog_snapshot_open(&catalog, CATALOG_SNAPSHOT_FILE) != DATA_SUCCESS)
     {
         printf(RED "❌ Error: Unable to open voting files!\n" RESET);
-        if (candidates_file)
-            fclose(candidates_file);
         return 0;
     }
 
-    // Initialize candidate data from approved candidates
-    char line[256];
-    int candidate_count = 0;
-
-    // Skip header in candidates file
-    if (fgets(line, sizeof(line), candidates_file))
+    for (int i = 0; i < catalog.candidate_count; i++)
     {
-        while (fgets(line, sizeof(line), candidates_file) && candidate_count < max_candidates)
+        const catalog_candidate_t *row = &catalog.candidates[i];
+        csv_span_t number = catalog_span(&catalog, row->number);
+        csv_span_t name = catalog_span(&catalog, row->name);
+        csv_span_t party = catalog_span(&catalog, row->party_id);
+        csv_span_t district = catalog_span(&catalog, row->district_id);
+        if (tally_table_add(candidates, &number, &name, &party, &district) < 0)
         {
-            char *token = strtok(line, ",");
-            if (!token)
-                continue;
-
-            strcpy(candidates[candidate_count].candidate_number, token);
-
-            token = strtok(NULL, ",");
-            if (token)
-                strcpy(candidates[candidate_count].candidate_name, token);
-
-            token = strtok(NULL, ",");
-            if (token)
-                strcpy(candidates[candidate_count].party_id, token);
-
-            token = strtok(NULL, ",");
-            if (token)
-                strcpy(candidates[candidate_count].district_id, token);
-
-            candidates[candidate_count].vote_count = 0;
-            candidates[candidate_count].qualified_for_parliament = 0;
-            candidate_count++;
+            catalog_snapshot_close(&catalog);
+            return DATA_ERROR_MEMORY_ALLOCATION;
         }
     }
-    fclose(candidates_file);
+    catalog_snapshot_close(&catalog);
 
-    return candidate_count;
+    return candidates->count;
 }
 
 /**
- * Count votes for candidates from data/votes.txt
+ * Count votes for candidates from a vote log via the hash-indexed tally engine
+ * @param candidates Candidate table; votes are added to its vote column
+ * @param path Vote log (data/votes.txt or data/temp-voted-list.txt)
+ * @param threads Worker threads for the partitioned tally (0 = one per CPU)
+ * @param stats Output tally statistics (rows, counted, unknown, malformed)
+ * @return DATA_SUCCESS on success, error code on failure
  */
-static void count_votes_from_votes_txt(candidate_result_t candidates[], int candidate_count)
+static int count_votes(tally_table_t *candidates, const char *path,
+                       const char *checkpoint, int threads, tally_stats_t *stats)
 {
-    FILE *votes_file = fopen("data/votes.txt", "r");
-    if (!votes_file)
-        return;
-
-    char line[256];
-    if (fgets(line, sizeof(line), votes_file))
+    int candidate_count = candidates->count;
+    const char **ids = malloc(sizeof(*ids) * (candidate_count > 0 ? candidate_count : 1));
+    if (!ids)
     {
-        while (fgets(line, sizeof(line), votes_file))
-        {
-            char voter_id[64], candidate_id[64];
-            if (sscanf(line, "%[^,],%63s", voter_id, candidate_id) == 2)
-            {
-                candidate_id[strcspn(candidate_id, "\n")] = 0;
-                for (int i = 0; i < candidate_count; i++)
-                {
-                    if (strcmp(candidates[i].candidate_number, candidate_id) == 0)
-                    {
-                        candidates[i].vote_count++;
-                        break;
-                    }
-                }
-            }
-        }
+        set_error_message("Error: Memory allocation failed for vote counters");
+        return DATA_ERROR_MEMORY_ALLOCATION;
     }
-    fclose(votes_file);
-}
+    for (int i = 0; i < candidate_count; i++)
+        ids[i] = tally_table_number(candidates, i);
 
-/**
- * Count votes for candidates from data/temp-voted-list.txt using enhanced API
- */
-static void count_votes_from_temp_list(candidate_result_t candidates[], int candidate_count)
-{
-    char ***records = NULL;
-    int rows = 0, cols = 0;
-    if (read_all_temp_voted(&records, &rows, &cols) != DATA_SUCCESS || rows <= 0 || cols < 3)
-    {
-        return;
-    }
-    // Columns: [0]=voting_number, [1]=candidate_number, [2]=party_id
-    for (int r = 0; r < rows; ++r)
+    tally_index_t index;
+    int rc = tally_index_build(&index, ids, candidate_count);
+    if (rc == DATA_SUCCESS)
     {
-        const char *candidate_id = (records[r][1] ? records[r][1] : "");
-        for (int i = 0; i < candidate_count; i++)
+        // Count straight into the dense vote column: the slots are the table rows
+        int *counts = candidates->votes;
+
+        // Resume after the last checkpointed byte when the log was only appended to
+        long long start = 0, end = 0;
+        tally_stats_t run = {0};
+        if (checkpoint && tally_checkpoint_load(checkpoint, path, &index, counts, &run, &start))
+            printf(CYAN "ℹ️  Resuming tally from checkpoint (%ld votes already counted)\n" RESET, run.rows);
+
+        // Both logs carry candidate_number in column 1
+        rc = tally_count_file_from(&index, path, 1, counts, &run, threads, start, &end);
+        if (rc == DATA_SUCCESS && checkpoint && end > 0 &&
+            tally_checkpoint_save(checkpoint, path, &index, counts, &run, end) != DATA_SUCCESS)
         {
-            if (strcmp(candidates[i].candidate_number, candidate_id) == 0)
-            {
-                candidates[i].vote_count++;
-                break;
-            }
+            // Not fatal: the next run simply recounts from the beginning
+            printf(YELLOW "⚠️  %s\n" RESET, get_last_error());
         }
+        if (stats)
+        {
+            stats->rows += run.rows;
+            stats->counted += run.counted;
+            stats->unknown += run.unknown;
+            stats->malformed += run.malformed;
+        }
+        tally_index_free(&index);
     }
-    free_temp_voted_records(records, rows, cols);
+
+    free(ids);
+    return rc;
 }
 
+// Rows shown on the console "complete results" page
+#define RESULTS_PAGE_SIZE 50
+
 /**
  * Overwrite parliament candidates file with selected top candidates.
  * Writes to data/parliament_candidates.txt with header: candidate_number,party_id
+ * Members are written in seat (rank) order.
  */
-static void write_parliament_candidates(const candidate_result_t candidates[], int candidate_count)
+static void write_parliament_candidates(const tally_table_t *candidates,
+                                        const int members[], int member_count)
 {
     FILE *fp = fopen("data/parliament_candidates.txt", "w");
     if (!fp)
@@ -178,68 +163,143 @@ static void write_parliament_candidates(const candidate_result_t candidates[], i
         return;
     }
     fprintf(fp, "candidate_number,party_id\n");
-    for (int i = 0; i < candidate_count; ++i)
+    for (int i = 0; i < member_count; ++i)
     {
-        if (candidates[i].qualified_for_parliament)
-        {
-            fprintf(fp, "%s,%s\n", candidates[i].candidate_number, candidates[i].party_id);
-        }
+        fprintf(fp, "%s,%s\n", tally_table_number(candidates, members[i]),
+                tally_table_party_id(candidates, members[i]));
     }
     fclose(fp);
 }
 
 /**
- * Comparison function for sorting candidates by vote count (descending)
+ * Rank order: more votes first, ties broken by candidate_number so that
+ * repeated runs over the same data always produce the same ranking
+ * @return Non-zero if a ranks strictly ahead of b
  */
-static int compare_candidates(const void *a, const void *b)
+static int ranks_ahead(const tally_table_t *candidates, int a, int b)
 {
-    const candidate_result_t *ca = (const candidate_result_t *)a;
-    const candidate_result_t *cb = (const candidate_result_t *)b;
-    return cb->vote_count - ca->vote_count; // Descending order
+    if (candidates->votes[a] != candidates->votes[b])
+        return candidates->votes[a] > candidates->votes[b];
+    // Only ties reach the cold strings
+    return strcmp(tally_table_number(candidates, a), tally_table_number(candidates, b)) < 0;
 }
 
 /**
- * Apply minimum vote requirements and select parliament members
- * @param candidates Array of candidate results
- * @param candidate_count Total number of candidates
- * @param min_votes Minimum votes required for parliament
- * @param max_parliament_seats Maximum parliament seats available
- * @return Number of parliament members selected
+ * Restore the bounded heap property below pos (root = lowest-ranked entry)
  */
-static int select_parliament_members(candidate_result_t candidates[], int candidate_count,
-                                     int min_votes, int max_parliament_seats)
+static void heap_sift_down(const tally_table_t *candidates, int heap[], int n, int pos)
 {
-    // Sort candidates by vote count (highest first)
-    qsort(candidates, candidate_count, sizeof(candidate_result_t), compare_candidates);
+    for (;;)
+    {
+        int worst = pos;
+        int left = 2 * pos + 1;
+        int right = left + 1;
+        if (left < n && ranks_ahead(candidates, heap[worst], heap[left]))
+            worst = left;
+        if (right < n && ranks_ahead(candidates, heap[worst], heap[right]))
+            worst = right;
+        if (worst == pos)
+            return;
+        int tmp = heap[pos];
+        heap[pos] = heap[worst];
+        heap[worst] = tmp;
+        pos = worst;
+    }
+}
 
-    int parliament_members = 0;
+/**
+ * Pick the k highest-ranked candidates with at least min_votes votes
+ *
+ * Keeps a bounded min-heap of k indices, so selection costs O(C log k)
+ * and only the k winners are ever sorted.
+ *
+ * @param candidates Candidate table (not reordered)
+ * @param k Number of candidates wanted
+ * @param min_votes Minimum votes a candidate needs to be considered
+ * @param out Output indices into candidates, best first (capacity >= k)
+ * @return Number of indices written (<= k)
+ */
+static int select_top_candidates(const tally_table_t *candidates, int k, int min_votes, int out[])
+{
+    int n = 0;
+    if (k <= 0)
+        return 0;
 
-    // Ignore min-vote threshold: always select top N
-    for (int i = 0; i < candidate_count; i++)
+    const int *votes = candidates->votes;
+    for (int i = 0; i < candidates->count; i++)
     {
-        if (i < max_parliament_seats)
+        if (votes[i] < min_votes)
+            continue;
+        if (n < k)
         {
-            candidates[i].qualified_for_parliament = 1;
-            parliament_members++;
+            // Sift the new entry up towards the root while it ranks behind its parent
+            int pos = n++;
+            out[pos] = i;
+            while (pos > 0)
+            {
+                int parent = (pos - 1) / 2;
+                if (!ranks_ahead(candidates, out[parent], out[pos]))
+                    break;
+                int tmp = out[parent];
+                out[parent] = out[pos];
+                out[pos] = tmp;
+                pos = parent;
+            }
         }
-        else
+        else if (ranks_ahead(candidates, i, out[0]))
         {
-            candidates[i].qualified_for_parliament = 0;
+            out[0] = i;
+            heap_sift_down(candidates, out, n, 0);
         }
     }
 
+    // Heap sort the winners: repeatedly move the lowest-ranked entry to the back
+    for (int end = n - 1; end > 0; end--)
+    {
+        int tmp = out[0];
+        out[0] = out[end];
+        out[end] = tmp;
+        heap_sift_down(candidates, out, end, 0);
+    }
+    return n;
+}
+
+/**
+ * Apply minimum vote requirements and select parliament members
+ * @param candidates Candidate table (flags updated, order kept)
+ * @param min_votes Minimum votes required for parliament
+ * @param max_parliament_seats Maximum parliament seats available
+ * @param members Output member indices in seat order (capacity >= max_parliament_seats)
+ * @return Number of parliament members selected
+ */
+static int select_parliament_members(tally_table_t *candidates, int min_votes,
+                                     int max_parliament_seats, int members[])
+{
+    memset(candidates->qualified, 0, (size_t)candidates->count * sizeof(*candidates->qualified));
+    memset(candidates->seat_rank, 0, (size_t)candidates->count * sizeof(*candidates->seat_rank));
+
+    int parliament_members = select_top_candidates(candidates, max_parliament_seats, min_votes, members);
+    for (int i = 0; i < parliament_members; i++)
+    {
+        candidates->qualified[members[i]] = 1;
+        candidates->seat_rank[members[i]] = i + 1;
+    }
+
     return parliament_members;
 }
 
 /**
  * Generate detailed voting results report
- * @param candidates Array of candidate results
- * @param candidate_count Total number of candidates
+ * @param candidates Candidate table
+ * @param members Parliament member indices in seat order
+ * @param member_count Number of parliament members
  * @param stats Voting statistics
  */
-static void generate_results_report(candidate_result_t candidates[], int candidate_count,
+static void generate_results_report(const tally_table_t *candidates,
+                                    const int members[], int member_count,
                                     voting_statistics_t *stats)
 {
+    int candidate_count = candidates->count;
     printf("\n");
     printf(BOLD CYAN "═══════════════════════════════════════════════════════════════════════════════\n");
     printf("                           🗳️  VOTING RESULTS REPORT 🗳️                           \n");
@@ -250,6 +310,8 @@ static void generate_results_report(candidate_result_t candidates[], int candida
     printf("┌─────────────────────────────────────────────────────────────────────────────┐\n");
     printf("│ " BLUE "Total Candidates:" RESET "        %-8d │ " BLUE "Total Votes Cast:" RESET "       %-8d │\n",
            stats->total_candidates, stats->total_votes_cast);
+    printf("│ " BLUE "Unknown-Candidate Votes:" RESET " %-8d │ " BLUE "Malformed Vote Rows:" RESET "    %-8d │\n",
+           stats->unknown_candidate_votes, stats->malformed_vote_rows);
     printf("│ " BLUE "Qualified Candidates:" RESET "    %-8d │ " BLUE "Parliament Members:" RESET "     %-8d │\n",
            stats->qualified_candidates, stats->parliament_members_selected);
     printf("│ " BLUE "Min Votes Required:" RESET "      %-8d │ " BLUE "Max Parliament Seats:" RESET "   %-8d │\n",
@@ -264,42 +326,53 @@ static void generate_results_report(candidate_result_t candidates[], int candida
     printf("│ " BOLD "Rank │ Candidate │      Name      │ Party │ District │ Votes │ Status" RESET " │\n");
     printf("├─────────────────────────────────────────────────────────────────────────────┤\n");
 
-    int rank = 1;
-    for (int i = 0; i < candidate_count; i++)
+    for (int i = 0; i < member_count; i++)
     {
-        if (candidates[i].qualified_for_parliament)
-        {
-            printf("│ %4d │ %-9s │ %-14s │ %-5s │ %-8s │ %5d │ " GREEN "✓ MP" RESET "   │\n",
-                   rank++, candidates[i].candidate_number, candidates[i].candidate_name,
-                   candidates[i].party_id, candidates[i].district_id, candidates[i].vote_count);
-        }
+        int c = members[i];
+        printf("│ %4d │ %-9s │ %-14s │ %-5s │ %-8s │ %5d │ " GREEN "✓ MP" RESET "   │\n",
+               i + 1, tally_table_number(candidates, c), tally_table_name(candidates, c),
+               tally_table_party_id(candidates, c), tally_table_district_id(candidates, c),
+               candidates->votes[c]);
     }
     printf("└─────────────────────────────────────────────────────────────────────────────┘\n");
 
-    // All Candidates Results
-    printf(BOLD YELLOW "\n📋 COMPLETE RESULTS (All Candidates):\n" RESET);
+    // Top page of all candidates; only this page is ranked, not the whole roster
+    int page_size = candidate_count < RESULTS_PAGE_SIZE ? candidate_count : RESULTS_PAGE_SIZE;
+    int page[RESULTS_PAGE_SIZE];
+    int shown = select_top_candidates(candidates, page_size, 0, page);
+
+    printf(BOLD YELLOW "\n📋 COMPLETE RESULTS (Top %d of %d Candidates):\n" RESET, shown, candidate_count);
     printf("┌─────────────────────────────────────────────────────────────────────────────┐\n");
     printf("│ " BOLD "Rank │ Candidate │      Name      │ Party │ District │ Votes │ Status" RESET " │\n");
     printf("├─────────────────────────────────────────────────────────────────────────────┤\n");
 
-    for (int i = 0; i < candidate_count; i++)
+    for (int i = 0; i < shown; i++)
     {
-        const char *status = candidates[i].qualified_for_parliament ? GREEN "✓ MP" RESET : RED "✗ Failed" RESET;
+        int c = page[i];
+        const char *status = candidates->qualified[c] ? GREEN "✓ MP" RESET : RED "✗ Failed" RESET;
 
         printf("│ %4d │ %-9s │ %-14s │ %-5s │ %-8s │ %5d │ %-12s │\n",
-               i + 1, candidates[i].candidate_number, candidates[i].candidate_name,
-               candidates[i].party_id, candidates[i].district_id, candidates[i].vote_count, status);
+               i + 1, tally_table_number(candidates, c), tally_table_name(candidates, c),
+               tally_table_party_id(candidates, c), tally_table_district_id(candidates, c),
+               candidates->votes[c], status);
     }
     printf("└─────────────────────────────────────────────────────────────────────────────┘\n");
+    if (shown < candidate_count)
+    {
+        printf(CYAN "ℹ️  %d more candidate(s) listed in 'data/voting_results.txt'\n" RESET,
+               candidate_count - shown);
+    }
 }
 
 /**
  * Save voting results to file
- * @param candidates Array of candidate results
- * @param candidate_count Total number of candidates
+ * @param candidates Candidate table
+ * @param members Parliament member indices in seat order
+ * @param member_count Number of parliament members
  * @param stats Voting statistics
  */
-static void save_results_to_file(candidate_result_t candidates[], int candidate_count,
+static void save_results_to_file(const tally_table_t *candidates,
+                                 const int members[], int member_count,
                                  voting_statistics_t *stats)
 {
     FILE *results_file = fopen("data/voting_results.txt", "w");
@@ -314,6 +387,8 @@ static void save_results_to_file(candidate_result_t candidates[], int candidate_
     fprintf(results_file, "\n[STATISTICS]\n");
     fprintf(results_file, "total_candidates=%d\n", stats->total_candidates);
     fprintf(results_file, "total_votes_cast=%d\n", stats->total_votes_cast);
+    fprintf(results_file, "unknown_candidate_votes=%d\n", stats->unknown_candidate_votes);
+    fprintf(results_file, "malformed_vote_rows=%d\n", stats->malformed_vote_rows);
     fprintf(results_file, "qualified_candidates=%d\n", stats->qualified_candidates);
     fprintf(results_file, "parliament_members_selected=%d\n", stats->parliament_members_selected);
     fprintf(results_file, "min_votes_threshold=%d\n", stats->min_votes_threshold);
@@ -321,27 +396,28 @@ static void save_results_to_file(candidate_result_t candidates[], int candidate_
 
     fprintf(results_file, "\n[PARLIAMENT_MEMBERS]\n");
     fprintf(results_file, "candidate_number,name,party_id,district_id,votes,rank\n");
-    int rank = 1;
-    for (int i = 0; i < candidate_count; i++)
+    for (int i = 0; i < member_count; i++)
     {
-        if (candidates[i].qualified_for_parliament)
-        {
-            fprintf(results_file, "%s,%s,%s,%s,%d,%d\n",
-                    candidates[i].candidate_number, candidates[i].candidate_name,
-                    candidates[i].party_id, candidates[i].district_id,
-                    candidates[i].vote_count, rank++);
-        }
+        int c = members[i];
+        fprintf(results_file, "%s,%s,%s,%s,%d,%d\n",
+                tally_table_number(candidates, c), tally_table_name(candidates, c),
+                tally_table_party_id(candidates, c), tally_table_district_id(candidates, c),
+                candidates->votes[c], i + 1);
     }
 
+    // Roster order; only members carry a rank (their seat number)
     fprintf(results_file, "\n[ALL_RESULTS]\n");
     fprintf(results_file, "candidate_number,name,party_id,district_id,votes,rank,qualified_for_parliament\n");
-    for (int i = 0; i < candidate_count; i++)
+    for (int i = 0; i < candidates->count; i++)
     {
-        fprintf(results_file, "%s,%s,%s,%s,%d,%d,%s\n",
-                candidates[i].candidate_number, candidates[i].candidate_name,
-                candidates[i].party_id, candidates[i].district_id,
-                candidates[i].vote_count, i + 1,
-                candidates[i].qualified_for_parliament ? "YES" : "NO");
+        char rank[16] = "-";
+        if (candidates->seat_rank[i] > 0)
+            snprintf(rank, sizeof(rank), "%d", candidates->seat_rank[i]);
+        fprintf(results_file, "%s,%s,%s,%s,%d,%s,%s\n",
+                tally_table_number(candidates, i), tally_table_name(candidates, i),
+                tally_table_party_id(candidates, i), tally_table_district_id(candidates, i),
+                candidates->votes[i], rank,
+                candidates->qualified[i] ? "YES" : "NO");
     }
 
     fclose(results_file);
@@ -362,16 +438,16 @@ int execute_voting_algorithm(int min_votes_required, int max_parliament_members)
     // Determine vote source: prefer temp-voted-list if it has data; else fallback to votes.txt
     int use_temp_list = 0;
     {
-        FILE *tmp = fopen("data/temp-voted-list.txt", "r");
-        if (tmp)
+        vote_source_t tmp;
+        if (vote_source_open(&tmp, "data/temp-voted-list.txt") == DATA_SUCCESS)
         {
-            char buf[256];
-            if (fgets(buf, sizeof buf, tmp))
+            vote_field_t row;
+            if (vote_source_next_line(&tmp, &row) == 1)
             {
-                if (fgets(buf, sizeof buf, tmp)) // has at least one data row
+                if (vote_source_next_line(&tmp, &row) == 1) // has at least one data row
                     use_temp_list = 1;
             }
-            fclose(tmp);
+            vote_source_close(&tmp);
         }
     }
     if (!use_temp_list)
@@ -385,57 +461,77 @@ int execute_voting_algorithm(int min_votes_required, int max_parliament_members)
         fclose(votes_check);
     }
 
-    // Initialize candidate results array
-    const int MAX_CANDIDATES = 1000;
-    candidate_result_t *candidates = malloc(MAX_CANDIDATES * sizeof(candidate_result_t));
-    if (!candidates)
+    // Load candidate list and vote counts; the table grows with the roster
+    tally_table_t candidates = {0};
+    printf(YELLOW "📊 Loading candidate data and vote counts...\n" RESET);
+    int candidate_count = load_candidates(&candidates);
+    if (candidate_count < 0)
     {
         printf(RED "❌ Error: Memory allocation failed!\n" RESET);
+        tally_table_free(&candidates);
         return DATA_ERROR_MEMORY_ALLOCATION;
     }
-
-    // Load candidate list and vote counts
-    printf(YELLOW "📊 Loading candidate data and vote counts...\n" RESET);
-    int candidate_count = load_candidates(candidates, MAX_CANDIDATES);
     if (candidate_count == 0)
     {
         printf(RED "❌ Error: No candidates found or unable to load data!\n" RESET);
-        free(candidates);
+        tally_table_free(&candidates);
         return DATA_ERROR_FILE_NOT_FOUND;
     }
 
-    // Reset vote counts (safety) and count from chosen source
-    for (int i = 0; i < candidate_count; ++i)
-        candidates[i].vote_count = 0;
-    if (use_temp_list)
-        count_votes_from_temp_list(candidates, candidate_count);
-    else
-        count_votes_from_votes_txt(candidates, candidate_count);
+    tally_stats_t tally = {0};
+    int tally_threads = config_get_int("tally_threads", 0);
+    // Only the append-only vote log is checkpointed; the temp list is reset between elections
+    int count_rc = use_temp_list
+                       ? count_votes(&candidates, "data/temp-voted-list.txt",
+                                     NULL, tally_threads, &tally)
+                       : count_votes(&candidates, "data/votes.txt",
+                                     TALLY_CHECKPOINT_FILE, tally_threads, &tally);
+    if (count_rc != DATA_SUCCESS)
+    {
+        printf(RED "❌ Error: Failed to count votes: %s\n" RESET, get_last_error());
+        tally_table_free(&candidates);
+        return count_rc;
+    }
 
     // Calculate total votes
     int total_votes = 0;
     for (int i = 0; i < candidate_count; i++)
     {
-        total_votes += candidates[i].vote_count;
+        total_votes += candidates.votes[i];
     }
 
     printf(GREEN "✅ Loaded %d candidates with %d total votes\n" RESET, candidate_count, total_votes);
+    if (tally.unknown > 0 || tally.malformed > 0)
+    {
+        printf(YELLOW "⚠️  %ld vote(s) for unknown candidates and %ld malformed row(s) were not counted\n" RESET,
+               tally.unknown, tally.malformed);
+    }
 
     // Apply voting algorithm
     printf(YELLOW "🏛️  Applying parliament selection algorithm...\n" RESET);
-    int parliament_members = select_parliament_members(candidates, candidate_count,
-                                                       min_votes_required, max_parliament_members);
+    int seat_capacity = max_parliament_members < candidate_count ? max_parliament_members : candidate_count;
+    int *members = malloc(sizeof(int) * (seat_capacity > 0 ? seat_capacity : 1));
+    if (!members)
+    {
+        printf(RED "❌ Error: Memory allocation failed!\n" RESET);
+        tally_table_free(&candidates);
+        return DATA_ERROR_MEMORY_ALLOCATION;
+    }
+    int parliament_members = select_parliament_members(&candidates, min_votes_required,
+                                                       seat_capacity, members);
 
-    // Count qualified candidates = selected top N (threshold ignored)
+    // Qualified = met the minimum vote threshold (seats may still run out)
     int qualified_count = 0;
     for (int i = 0; i < candidate_count; i++)
-        if (candidates[i].qualified_for_parliament)
+        if (candidates.votes[i] >= min_votes_required)
             qualified_count++;
 
     // Prepare statistics
     voting_statistics_t stats;
     stats.total_candidates = candidate_count;
     stats.total_votes_cast = total_votes;
+    stats.unknown_candidate_votes = (int)tally.unknown;
+    stats.malformed_vote_rows = (int)tally.malformed;
     stats.qualified_candidates = qualified_count;
     stats.parliament_members_selected = parliament_members;
     stats.min_votes_threshold = min_votes_required;
@@ -450,18 +546,18 @@ int execute_voting_algorithm(int min_votes_required, int max_parliament_members)
     printf(GREEN "✅ Parliament selection complete: %d members selected\n" RESET, parliament_members);
 
     // Generate and display results
-    generate_results_report(candidates, candidate_count, &stats);
+    generate_results_report(&candidates, members, parliament_members, &stats);
 
     // Save results to file
-    save_results_to_file(candidates, candidate_count, &stats);
+    save_results_to_file(&candidates, members, parliament_members, &stats);
 
     // Overwrite parliament candidates file with selected members only
-    write_parliament_candidates(candidates, candidate_count);
+    write_parliament_candidates(&candidates, members, parliament_members);
 
     // If temp list was used, clear it after processing
     if (use_temp_list)
     {
-        int rc = clear_temp_voted();
+        int rc = vote_journal_clear_temp_voted();
         if (rc == DATA_SUCCESS)
             printf(GREEN "🧹 Cleared temporary voted list after processing.\n" RESET);
         else
@@ -469,7 +565,8 @@ int execute_voting_algorithm(int min_votes_required, int max_parliament_members)
     }
 
     // Clean up
-    free(candidates);
+    free(members);
+    tally_table_free(&candidates);
 
     printf(BOLD GREEN "\n🎉 VOTING ALGORITHM COMPLETED SUCCESSFULLY!\n" RESET);
     printf("═══════════════════════════════════════════════════════════════════════════════\n");
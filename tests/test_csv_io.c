@@ -0,0 +1,320 @@
+/*
+ * CSV quoting test
+ *
+ * Table-driven checks of the RFC 4180 handling in csv_io:
+ *
+ *   split       csv_split_spans on quoted, escaped, blank-padded, torn and
+ *               CRLF-terminated rows, read back with csv_span_copy/csv_span_eq
+ *   quote       csv_quote_field output, including truncation
+ *   round trip  csv_format_row then csv_split_spans gives the values back
+ *   rewrite     update_record keeps the quoted fields of the row it rewrites
+ *
+ * Exits non-zero when any check fails.
+ */
+
+// mkdtemp/chdir need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "csv_io.h"
+#include "data_handler_enhanced.h"
+
+#define MAX_TEST_FIELDS 6
+
+static int failures = 0;
+
+static void fail(const char *what, const char *input, const char *detail)
+{
+    printf("  %s [%s]: %s\n", what, input, detail);
+    failures++;
+}
+
+/* ==== Split ==== */
+
+typedef struct
+{
+    const char *line;
+    int count;                             // fields expected
+    const char *values[MAX_TEST_FIELDS];   // after csv_span_copy
+    int quoting[MAX_TEST_FIELDS];          // CSV_SPAN_* expected
+} split_case_t;
+
+static const split_case_t split_cases[] = {
+    {"P01,Green Party,GP", 3, {"P01", "Green Party", "GP"}, {0, 0, 0}},
+    {"C001,\"Smith, J.\",P01", 3, {"C001", "Smith, J.", "P01"}, {0, CSV_SPAN_QUOTED, 0}},
+    {"C002,\"say \"\"hi\"\"\",P02", 3, {"C002", "say \"hi\"", "P02"}, {0, CSV_SPAN_ESCAPED, 0}},
+    {"\"\",x", 2, {"", "x"}, {CSV_SPAN_QUOTED, 0}},
+    {"\"\"\"\"", 1, {"\""}, {CSV_SPAN_ESCAPED}},
+    // A quoted field followed by blanks before the delimiter or the end
+    {"\"a, b\"  , c", 2, {"a, b", "c"}, {CSV_SPAN_QUOTED, 0}},
+    {"x, \"a, b\" \t", 2, {"x", "a, b"}, {0, CSV_SPAN_QUOTED}},
+    // Quoted field at the end of a CRLF line
+    {"C003,\"Smith, J.\"\r\n", 2, {"C003", "Smith, J."}, {0, CSV_SPAN_QUOTED}},
+    {"C004,\"Smith, J.\"\n", 2, {"C004", "Smith, J."}, {0, CSV_SPAN_QUOTED}},
+    // An unterminated quote, or text after the closing quote, is plain text
+    {"\"abc,def", 2, {"\"abc", "def"}, {0, 0}},
+    {"\"a\"x,b", 2, {"\"a\"x", "b"}, {0, 0}},
+    // Quotes inside an unquoted field are literal
+    {"a\"b,c", 2, {"a\"b", "c"}, {0, 0}},
+    // Empty fields are kept, blank rows have none
+    {"a,,b", 3, {"a", "", "b"}, {0, 0, 0}},
+    {"a,b,", 3, {"a", "b", ""}, {0, 0, 0}},
+    {"  a ,\tb\t", 2, {"a", "b"}, {0, 0}},
+    {" \r\n", 0, {NULL}, {0}},
+};
+
+static void test_split(void)
+{
+    for (size_t c = 0; c < sizeof(split_cases) / sizeof(split_cases[0]); c++)
+    {
+        const split_case_t *t = &split_cases[c];
+        csv_span_t spans[MAX_TEST_FIELDS];
+        int n = csv_split_spans(t->line, strlen(t->line), ',', spans, MAX_TEST_FIELDS);
+        char detail[256];
+        if (n != t->count)
+        {
+            snprintf(detail, sizeof(detail), "%d fields, expected %d", n, t->count);
+            fail("split", t->line, detail);
+            continue;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            char value[128];
+            csv_span_copy(&spans[i], value, sizeof(value));
+            if (strcmp(value, t->values[i]) != 0 || !csv_span_eq(&spans[i], t->values[i]))
+            {
+                snprintf(detail, sizeof(detail), "field %d is '%s', expected '%s'", i, value, t->values[i]);
+                fail("split", t->line, detail);
+            }
+            else if (spans[i].quoting != t->quoting[i])
+            {
+                snprintf(detail, sizeof(detail), "field %d quoting %d, expected %d", i, spans[i].quoting,
+                         t->quoting[i]);
+                fail("split", t->line, detail);
+            }
+        }
+
+        // split_csv_fields follows the same rules
+        char *fields[MAX_TEST_FIELDS];
+        int m = split_csv_fields(t->line, fields, MAX_TEST_FIELDS, ',');
+        for (int i = 0; i < m; i++)
+        {
+            if (m != n || strcmp(fields[i], t->values[i]) != 0)
+            {
+                snprintf(detail, sizeof(detail), "split_csv_fields field %d is '%s'", i, fields[i]);
+                fail("split", t->line, detail);
+            }
+            free(fields[i]);
+        }
+    }
+}
+
+/* ==== Quote ==== */
+
+typedef struct
+{
+    const char *value;
+    const char *quoted;
+} quote_case_t;
+
+static const quote_case_t quote_cases[] = {
+    {"Green Party", "Green Party"},
+    {"", ""},
+    {"Smith, J.", "\"Smith, J.\""},
+    {"say \"hi\"", "\"say \"\"hi\"\"\""},
+    {"\"", "\"\"\"\""},
+    {" padded ", "\" padded \""},
+    {"tab\t", "\"tab\t\""},
+};
+
+static void test_quote(void)
+{
+    for (size_t c = 0; c < sizeof(quote_cases) / sizeof(quote_cases[0]); c++)
+    {
+        const quote_case_t *t = &quote_cases[c];
+        char out[64];
+        int n = csv_quote_field(t->value, out, sizeof(out));
+        if (strcmp(out, t->quoted) != 0 || n != (int)strlen(t->quoted))
+        {
+            char detail[256];
+            snprintf(detail, sizeof(detail), "'%s' (%d), expected '%s'", out, n, t->quoted);
+            fail("quote", t->value, detail);
+        }
+    }
+
+    // Like snprintf: the full length comes back and the output is cut to fit
+    char small[6];
+    int n = csv_quote_field("Smith, J.", small, sizeof(small));
+    if (n != 11 || strcmp(small, "\"Smit") != 0)
+        fail("quote", "Smith, J. into 6 bytes", small);
+    char row[8];
+    const char *values[] = {"a", "Smith, J."};
+    n = csv_format_row(row, sizeof(row), values, 2);
+    if (n != 14 || strcmp(row, "a, \"Smi") != 0)
+        fail("format", "a, Smith, J. into 8 bytes", row);
+}
+
+/* ==== Round trip ==== */
+
+static const char *const round_trip_rows[][MAX_TEST_FIELDS] = {
+    {"C001", "Smith, J.", "P01", "D01", NULL},
+    {"C002", "say \"hi\"", "", " padded ", NULL},
+    {"\"", "\"\"", ",", ", ,", NULL},
+    {"", "", NULL},
+    {"O'Brien", "a\"b", "tab\tinside", NULL},
+};
+
+static void test_round_trip(void)
+{
+    for (size_t r = 0; r < sizeof(round_trip_rows) / sizeof(round_trip_rows[0]); r++)
+    {
+        const char *const *values = round_trip_rows[r];
+        int count = 0;
+        while (count < MAX_TEST_FIELDS && values[count])
+            count++;
+
+        char line[512];
+        csv_format_row(line, sizeof(line), values, count);
+        csv_span_t spans[MAX_TEST_FIELDS];
+        int n = csv_split_spans(line, strlen(line), ',', spans, MAX_TEST_FIELDS);
+        int ok = n == count;
+        for (int i = 0; ok && i < n; i++)
+        {
+            char value[128];
+            csv_span_copy(&spans[i], value, sizeof(value));
+            ok = strcmp(value, values[i]) == 0;
+        }
+        if (!ok)
+            fail("round trip", line, "values changed");
+    }
+}
+
+/* ==== Rewrite ==== */
+
+#define PARTY_FILE "data/party_name.txt"
+
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return NULL;
+    char *text = calloc(1, 4096);
+    if (text)
+        text[fread(text, 1, 4095, fp)] = '\0';
+    fclose(fp);
+    return text;
+}
+
+static void test_rewrite(void)
+{
+    FILE *fp = fopen(PARTY_FILE, "w");
+    if (!fp)
+    {
+        fail("rewrite", PARTY_FILE, strerror(errno));
+        return;
+    }
+    fputs("party_id,name,leader\n"
+          "P01,\"Green, Party\",\"say \"\"hi\"\"\"\n"
+          "P02,Blue Party,\"Smith, J.\"\n",
+          fp);
+    fclose(fp);
+
+    // Rewrite one field of each row; the quoted ones must survive
+    char key1[] = "0:P01", key2[] = "0:P02";
+    char *keys1[] = {key1}, *keys2[] = {key2};
+    if (update_record(PARTY_FILE, keys1, 1, "2:Jones, K.") != DATA_SUCCESS ||
+        update_record(PARTY_FILE, keys2, 1, "1:Blue \"B\" Party") != DATA_SUCCESS)
+    {
+        fail("rewrite", PARTY_FILE, get_last_error());
+        return;
+    }
+
+    const char *expected[][3] = {
+        {"P01", "Green, Party", "Jones, K."},
+        {"P02", "Blue \"B\" Party", "Smith, J."},
+    };
+    char *text = read_file(PARTY_FILE);
+    char *line = text ? strchr(text, '\n') : NULL; // past the header
+    for (int r = 0; r < 2; r++)
+    {
+        char *next = line ? strchr(line + 1, '\n') : NULL;
+        if (!next)
+        {
+            fail("rewrite", PARTY_FILE, "rows missing");
+            break;
+        }
+        csv_span_t spans[MAX_TEST_FIELDS];
+        int n = csv_split_spans(line + 1, (size_t)(next - line), ',', spans, MAX_TEST_FIELDS);
+        for (int i = 0; i < 3; i++)
+        {
+            char value[128];
+            csv_span_copy(i < n ? &spans[i] : NULL, value, sizeof(value));
+            if (strcmp(value, expected[r][i]) != 0)
+                fail("rewrite", expected[r][0], value);
+        }
+        line = next;
+    }
+    free(text);
+}
+
+// Remove a directory with the files the data layer leaves in it
+static void remove_tree(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir)
+    {
+        struct dirent *e;
+        char child[1024];
+        while ((e = readdir(dir)) != NULL)
+        {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+            snprintf(child, sizeof(child), "%s/%s", path, e->d_name);
+            // unlink() of a directory fails with EISDIR on Linux, EPERM elsewhere
+            if (unlink(child) != 0 && (errno == EISDIR || errno == EPERM))
+                remove_tree(child);
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+int main(void)
+{
+    char scratch[] = "/tmp/voteme-test-XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0 || mkdir("data", 0755) != 0)
+    {
+        fprintf(stderr, "test_csv_io: cannot set up %s: %s\n", scratch, strerror(errno));
+        return 1;
+    }
+
+    struct
+    {
+        const char *name;
+        void (*run)(void);
+    } tests[] = {
+        {"split", test_split},
+        {"quote", test_quote},
+        {"round trip", test_round_trip},
+        {"rewrite", test_rewrite},
+    };
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        int before = failures;
+        tests[i].run();
+        printf("%s csv: %s\n", failures == before ? "✅" : "❌", tests[i].name);
+    }
+
+    if (chdir("/") == 0)
+        remove_tree(scratch);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * read_voter hammer test
+ *
+ * Runs read_voter from many threads at once over a generated roll, first
+ * with the file scan and then through the voting_number index. Each thread
+ * mixes three lookups and checks every answer:
+ *
+ *   present voter   the exact row of the roll
+ *   absent voter    NULL, DATA_ERROR_RECORD_NOT_FOUND and its message
+ *   malformed key   NULL, code 0 and a message naming this thread's key
+ *
+ * The malformed key is unique per thread and per operation, so a message
+ * that leaks between threads, or a stale one, shows up as a mismatch.
+ *
+ * Usage: test_read_voter_mt [threads] [ops]
+ * Exits non-zero on the first mismatch of any thread.
+ */
+
+// mkdtemp/chdir need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "data_handler_enhanced.h"
+
+#define VOTERS_FILE "data/approved_voters.txt"
+#define ROLL_SIZE 2000
+#define MAX_THREADS 64
+#define DEFAULT_THREADS 8
+#define DEFAULT_OPS 3000
+
+#define NOT_FOUND_MESSAGE "Record not found with specified primary key(s)"
+
+typedef struct
+{
+    int id;
+    int ops;
+    int failures;
+    char detail[512];
+} worker_t;
+
+static void voter_row(char *out, size_t size, int n)
+{
+    snprintf(out, size, "V%06d,Voter %d,%09dV,D%02d\n", n, n, 100000000 + n * 7, n % 25 + 1);
+}
+
+static int write_roll(void)
+{
+    FILE *fp = fopen(VOTERS_FILE, "w");
+    if (!fp)
+        return 0;
+    fprintf(fp, "voting_number,name,nic,district_id\n");
+    char row[128];
+    for (int n = 1; n <= ROLL_SIZE; n++)
+    {
+        voter_row(row, sizeof(row), n);
+        fputs(row, fp);
+    }
+    return fclose(fp) == 0;
+}
+
+// Remove a directory with the files the data layer leaves in it
+static void remove_tree(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir)
+    {
+        struct dirent *e;
+        char child[1024];
+        while ((e = readdir(dir)) != NULL)
+        {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+            snprintf(child, sizeof(child), "%s/%s", path, e->d_name);
+            // unlink() of a directory fails with EISDIR on Linux, EPERM elsewhere
+            if (unlink(child) != 0 && (errno == EISDIR || errno == EPERM))
+                remove_tree(child);
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+// Record the first mismatch of a thread
+static void fail(worker_t *w, int op, const char *what, const char *got)
+{
+    if (w->failures++ == 0)
+        snprintf(w->detail, sizeof(w->detail), "thread %d op %d: %s (got \"%s\")", w->id, op, what,
+                 got ? got : "(null)");
+}
+
+static void *hammer(void *arg)
+{
+    worker_t *w = arg;
+    char id[32], expected[128], message[256], key[64];
+    for (int i = 0; i < w->ops; i++)
+    {
+        int n = (int)(((unsigned)w->id * 7919u + (unsigned)i * 104729u) % (ROLL_SIZE + ROLL_SIZE / 4)) + 1;
+        char *row;
+        switch ((i + w->id) % 3)
+        {
+        case 0:
+        case 1:
+            // n past the roll asks for a voter who is not on it
+            snprintf(id, sizeof(id), "V%06d", n);
+            row = read_voter(id);
+            if (n <= ROLL_SIZE)
+            {
+                voter_row(expected, sizeof(expected), n);
+                if (!row || strcmp(row, expected) != 0)
+                    fail(w, i, "wrong row", row ? row : get_last_error());
+            }
+            else if (row)
+            {
+                fail(w, i, "row for an absent voter", row);
+            }
+            else if (get_last_error_code() != DATA_ERROR_RECORD_NOT_FOUND ||
+                     strcmp(get_last_error(), NOT_FOUND_MESSAGE) != 0)
+            {
+                fail(w, i, "wrong not-found error", get_last_error());
+            }
+            free(row);
+            break;
+        default:
+            snprintf(key, sizeof(key), "T%d-%d", w->id, i);
+            char *keys[] = {key};
+            row = read_record(VOTERS_FILE, keys, 1);
+            snprintf(message, sizeof(message), "Error: Primary key '%s' must be in format 'field_index:value'", key);
+            if (row)
+                fail(w, i, "row for a malformed key", row);
+            else if (get_last_error_code() != 0 || strcmp(get_last_error(), message) != 0)
+                fail(w, i, "wrong malformed-key error", get_last_error());
+            free(row);
+            break;
+        }
+    }
+    return NULL;
+}
+
+// Run every thread against the roll as it is indexed now; 0 on success
+static int run(const char *name, int threads, int ops)
+{
+    worker_t workers[MAX_THREADS];
+    pthread_t tids[MAX_THREADS];
+    int started = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        workers[t].id = t;
+        workers[t].ops = ops;
+        workers[t].failures = 0;
+        workers[t].detail[0] = '\0';
+        if (pthread_create(&tids[t], NULL, hammer, &workers[t]) != 0)
+            break;
+        started++;
+    }
+    int failures = 0;
+    for (int t = 0; t < started; t++)
+    {
+        pthread_join(tids[t], NULL);
+        if (workers[t].failures)
+        {
+            printf("  %s\n", workers[t].detail);
+            failures += workers[t].failures;
+        }
+    }
+    if (started < threads)
+    {
+        printf("❌ %s: only %d of %d threads started\n", name, started, threads);
+        return 1;
+    }
+    if (failures)
+    {
+        printf("❌ %s: %d mismatches in %d lookups\n", name, failures, threads * ops);
+        return 1;
+    }
+    printf("✅ %s: %d threads, %d lookups\n", name, threads, threads * ops);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int threads = argc > 1 ? atoi(argv[1]) : DEFAULT_THREADS;
+    int ops = argc > 2 ? atoi(argv[2]) : DEFAULT_OPS;
+    if (threads < 1 || threads > MAX_THREADS || ops < 1)
+    {
+        fprintf(stderr, "Usage: %s [threads 1-%d] [ops]\n", argv[0], MAX_THREADS);
+        return 2;
+    }
+
+    char scratch[] = "/tmp/voteme-test-XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0 || mkdir("data", 0755) != 0 || !write_roll())
+    {
+        fprintf(stderr, "test_read_voter_mt: cannot set up %s: %s\n", scratch, strerror(errno));
+        return 1;
+    }
+
+    int rc = run("read_voter (file scan)", threads, ops);
+    if (create_index(VOTERS_FILE, 0) != DATA_SUCCESS)
+    {
+        printf("❌ create_index failed: %s\n", get_last_error());
+        rc = 1;
+    }
+    else
+    {
+        rc |= run("read_voter (indexed)", threads, ops);
+    }
+
+    if (chdir("/") == 0)
+        remove_tree(scratch);
+    return rc;
+}
@@ -0,0 +1,395 @@
+/*
+ * Vote journal test
+ *
+ * Writes journals by hand in a scratch directory and checks what replay
+ * leaves in data/temp-voted-list.txt, data/votes.txt and the journal:
+ *
+ *   unapplied batch      committed, never applied: both files get its votes
+ *   partly applied       a crash between the two appends: each file gets
+ *                        only the votes it is missing
+ *   applied and torn     a batch with its "A" mark, a batch whose hash does
+ *                        not match and V lines without a C line: none replayed
+ *   repeated voter       a voter in two unapplied batches is written once
+ *   exit before mark     a booth that exits after applying its last batch
+ *                        (its "A" mark still deferred): nothing is doubled
+ *   replay at open       vote_journal_open replays, and vote_journal_close
+ *                        leaves an empty journal after new votes, with
+ *                        every-vote sync and under group commit
+ *   same voter at once   booths casting for the same voters concurrently
+ *                        under group commit: one vote per voter is
+ *                        accepted, the rest are rejected before queuing
+ *
+ * Exits non-zero when any check fails.
+ */
+
+// mkdtemp/chdir/fork need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "data_handler_enhanced.h"
+#include "vote_journal.h"
+
+#define TEMP_VOTED_FILE "data/temp-voted-list.txt"
+#define TEMP_VOTED_HEADER "voting_number,candidate_number,party_id\n"
+#define VOTES_FILE "data/votes.txt"
+#define VOTES_HEADER "voter_id,candidate_id\n"
+#define CONFIG_FILE "data/system_config.txt"
+
+static int failures = 0;
+
+static void check(int ok, const char *test, const char *what)
+{
+    if (!ok)
+    {
+        printf("  %s: %s\n", test, what);
+        failures++;
+    }
+}
+
+static int write_file(const char *path, const char *text)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+        return 0;
+    fputs(text, fp);
+    return fclose(fp) == 0;
+}
+
+// Whole file as a string (empty when missing); caller frees
+static char *read_file(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char *text = calloc(1, 1);
+    if (!fp)
+        return text;
+    size_t len = 0;
+    char chunk[1024];
+    size_t n;
+    while (text && (n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+    {
+        char *grown = realloc(text, len + n + 1);
+        if (!grown)
+        {
+            free(text);
+            text = NULL;
+            break;
+        }
+        text = grown;
+        memcpy(text + len, chunk, n);
+        len += n;
+        text[len] = '\0';
+    }
+    fclose(fp);
+    return text;
+}
+
+static void check_file(const char *test, const char *path, const char *expected)
+{
+    char *text = read_file(path);
+    if (!text || strcmp(text, expected) != 0)
+    {
+        printf("  %s: %s is\n%s  expected\n%s", test, path, text ? text : "(unreadable)\n", expected);
+        failures++;
+    }
+    free(text);
+}
+
+// FNV-1a 64, as the journal hashes the V lines of a batch
+static unsigned long long fnv1a(const char *p)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    for (; *p; p++)
+    {
+        h ^= (unsigned char)*p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Append a committed batch: its V lines, then the C line that commits them
+static void add_batch(char *journal, size_t size, const char *id, const char *lines, int count)
+{
+    size_t len = strlen(journal);
+    snprintf(journal + len, size - len, "%sC %s %d %016llx\n", lines, id, count, fnv1a(lines));
+}
+
+// Fresh data files, config and (unless NULL) journal
+static void reset(const char *temp_rows, const char *vote_rows, const char *journal, int sync_ms)
+{
+    char text[4096], config[64];
+    snprintf(text, sizeof(text), TEMP_VOTED_HEADER "%s", temp_rows);
+    write_file(TEMP_VOTED_FILE, text);
+    snprintf(text, sizeof(text), VOTES_HEADER "%s", vote_rows);
+    write_file(VOTES_FILE, text);
+    snprintf(config, sizeof(config), "journal_sync_ms=%d\n", sync_ms);
+    write_file(CONFIG_FILE, config);
+    unlink("data/voted.bitmap");
+    if (journal)
+        write_file(VOTE_JOURNAL_FILE, journal);
+    else
+        unlink(VOTE_JOURNAL_FILE);
+}
+
+static void test_unapplied_batch(void)
+{
+    const char *test = "unapplied batch";
+    char journal[4096] = "";
+    add_batch(journal, sizeof(journal), "100.1", "V V0001,C001,P01\nV V0002,C002,P02\n", 2);
+    reset("", "", journal, 0);
+
+    int replayed = -1;
+    check(vote_journal_recover(&replayed) == DATA_SUCCESS, test, get_last_error());
+    check(replayed == 2, test, "replayed count is not 2");
+    check_file(test, TEMP_VOTED_FILE, TEMP_VOTED_HEADER "V0001,C001,P01\nV0002,C002,P02\n");
+    check_file(test, VOTES_FILE, VOTES_HEADER "V0001,C001\nV0002,C002\n");
+    check_file(test, VOTE_JOURNAL_FILE, "");
+}
+
+static void test_partly_applied(void)
+{
+    const char *test = "partly applied";
+    char journal[4096] = "";
+    add_batch(journal, sizeof(journal), "100.1", "V V0001,C001,P01\nV V0002,C002,P02\nV V0003,C001,P01\n", 3);
+    // V0001 reached both files, V0002 only votes.txt
+    reset("V0001,C001,P01\n", "V0001,C001\nV0002,C002\n", journal, 0);
+
+    int replayed = -1;
+    check(vote_journal_recover(&replayed) == DATA_SUCCESS, test, get_last_error());
+    check(replayed == 2, test, "replayed count is not 2");
+    check_file(test, TEMP_VOTED_FILE, TEMP_VOTED_HEADER "V0001,C001,P01\nV0002,C002,P02\nV0003,C001,P01\n");
+    check_file(test, VOTES_FILE, VOTES_HEADER "V0001,C001\nV0002,C002\nV0003,C001\n");
+    check_file(test, VOTE_JOURNAL_FILE, "");
+}
+
+static void test_applied_and_torn(void)
+{
+    const char *test = "applied and torn";
+    char journal[4096] = "";
+    add_batch(journal, sizeof(journal), "100.1", "V V0001,C001,P01\n", 1);
+    strcat(journal, "A 100.1\n");
+    // A commit whose hash does not cover its votes, then a batch cut off before its C line
+    strcat(journal, "V V0002,C002,P02\nC 100.2 1 0000000000000001\n");
+    strcat(journal, "V V0003,C003,P03\nV V0004,C0");
+    reset("", "", journal, 0);
+
+    int replayed = -1;
+    check(vote_journal_recover(&replayed) == DATA_SUCCESS, test, get_last_error());
+    check(replayed == 0, test, "replayed count is not 0");
+    check_file(test, TEMP_VOTED_FILE, TEMP_VOTED_HEADER);
+    check_file(test, VOTES_FILE, VOTES_HEADER);
+    check_file(test, VOTE_JOURNAL_FILE, "");
+}
+
+static void test_repeated_voter(void)
+{
+    const char *test = "repeated voter";
+    char journal[4096] = "";
+    add_batch(journal, sizeof(journal), "100.1", "V V0001,C001,P01\n", 1);
+    add_batch(journal, sizeof(journal), "200.1", "V V0001,C002,P02\nV V0002,C002,P02\n", 2);
+    reset("", "", journal, 0);
+
+    int replayed = -1;
+    check(vote_journal_recover(&replayed) == DATA_SUCCESS, test, get_last_error());
+    check(replayed == 2, test, "replayed count is not 2");
+    check_file(test, TEMP_VOTED_FILE, TEMP_VOTED_HEADER "V0001,C001,P01\nV0002,C002,P02\n");
+    check_file(test, VOTES_FILE, VOTES_HEADER "V0001,C001\nV0002,C002\n");
+}
+
+static void test_exit_before_mark(void)
+{
+    const char *test = "exit before mark";
+    reset("", "", NULL, 0);
+
+    // Every vote is its own batch: applied when append returns, marked with the next one
+    pid_t pid = fork();
+    if (pid == 0)
+        _exit(vote_journal_append("V0001", "C001", "P01") == DATA_SUCCESS &&
+                      vote_journal_append("V0002", "C002", "P02") == DATA_SUCCESS
+                  ? 0
+                  : 1);
+    int status = 0;
+    check(pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0, test,
+          "booth process failed");
+    char *left = read_file(VOTE_JOURNAL_FILE);
+    const char *last = left ? strstr(left, "V V0002,C002,P02\n") : NULL;
+    check(last && !strstr(last, "\nA "), test, "journal does not hold the last batch unmarked");
+    free(left);
+
+    int replayed = -1;
+    check(vote_journal_recover(&replayed) == DATA_SUCCESS, test, get_last_error());
+    check(replayed == 0, test, "replayed count is not 0");
+    check_file(test, TEMP_VOTED_FILE, TEMP_VOTED_HEADER "V0001,C001,P01\nV0002,C002,P02\n");
+    check_file(test, VOTES_FILE, VOTES_HEADER "V0001,C001\nV0002,C002\n");
+    check_file(test, VOTE_JOURNAL_FILE, "");
+}
+
+static void open_and_close(const char *test, int sync_ms)
+{
+    char journal[4096] = "";
+    add_batch(journal, sizeof(journal), "100.1", "V V0001,C001,P01\n", 1);
+    reset("", "", journal, sync_ms);
+
+    check(vote_journal_open() == DATA_SUCCESS, test, get_last_error());
+    check_file(test, TEMP_VOTED_FILE, TEMP_VOTED_HEADER "V0001,C001,P01\n");
+    check(vote_journal_append("V0002", "C002", "P02") == DATA_SUCCESS, test, get_last_error());
+    check(vote_journal_append("V0003", "C003", "P03") == DATA_SUCCESS, test, get_last_error());
+    check(vote_journal_close() == DATA_SUCCESS, test, get_last_error());
+
+    check_file(test, TEMP_VOTED_FILE, TEMP_VOTED_HEADER "V0001,C001,P01\nV0002,C002,P02\nV0003,C003,P03\n");
+    check_file(test, VOTES_FILE, VOTES_HEADER "V0001,C001\nV0002,C002\nV0003,C003\n");
+    check_file(test, VOTE_JOURNAL_FILE, "");
+}
+
+static void test_open_and_close(void)
+{
+    open_and_close("open and close", 0);
+}
+
+static void test_group_commit(void)
+{
+    open_and_close("group commit", 20);
+}
+
+#define RACE_VOTERS 400 // below one batch, so nothing commits until close
+#define RACE_THREADS 8
+
+typedef struct
+{
+    int accepted;
+    int rejected;
+    int other;
+} race_worker_t;
+
+static void *cast_all(void *arg)
+{
+    race_worker_t *w = arg;
+    char voter[16];
+    for (int n = 1; n <= RACE_VOTERS; n++)
+    {
+        snprintf(voter, sizeof(voter), "V%04d", n);
+        int rc = vote_journal_append(voter, "C001", "P01");
+        if (rc == DATA_SUCCESS)
+            w->accepted++;
+        else if (rc == DATA_ERROR_DUPLICATE_RECORD)
+            w->rejected++;
+        else
+            w->other++;
+    }
+    return NULL;
+}
+
+static void test_same_voter_at_once(void)
+{
+    const char *test = "same voter at once";
+    // A long sync interval keeps the batch open, so duplicates can only be
+    // caught at append time, not dropped by the commit
+    reset("", "", NULL, 60000);
+    check(vote_journal_open() == DATA_SUCCESS, test, get_last_error());
+    vote_journal_stats_t before;
+    vote_journal_get_stats(&before);
+
+    race_worker_t workers[RACE_THREADS];
+    pthread_t tids[RACE_THREADS];
+    int started = 0;
+    memset(workers, 0, sizeof(workers));
+    for (int t = 0; t < RACE_THREADS; t++)
+    {
+        if (pthread_create(&tids[t], NULL, cast_all, &workers[t]) != 0)
+            break;
+        started++;
+    }
+    int accepted = 0, rejected = 0, other = 0;
+    for (int t = 0; t < started; t++)
+    {
+        pthread_join(tids[t], NULL);
+        accepted += workers[t].accepted;
+        rejected += workers[t].rejected;
+        other += workers[t].other;
+    }
+    check(started == RACE_THREADS, test, "threads did not start");
+    check(accepted == RACE_VOTERS, test, "not exactly one vote per voter accepted");
+    check(rejected == (started - 1) * RACE_VOTERS, test, "duplicates not rejected");
+    check(other == 0, test, "appends failed");
+    check(vote_journal_close() == DATA_SUCCESS, test, get_last_error());
+
+    vote_journal_stats_t after;
+    vote_journal_get_stats(&after);
+    check(after.dropped == before.dropped, test, "duplicates reached the commit");
+    char *temp = read_file(TEMP_VOTED_FILE);
+    int rows = 0;
+    for (char *p = temp ? strchr(temp, '\n') : NULL; p && p[1]; p = strchr(p + 1, '\n'))
+        rows++;
+    check(rows == RACE_VOTERS, test, "temp list does not have one row per voter");
+    free(temp);
+}
+
+// Remove a directory with the files the data layer leaves in it
+static void remove_tree(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir)
+    {
+        struct dirent *e;
+        char child[1024];
+        while ((e = readdir(dir)) != NULL)
+        {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+            snprintf(child, sizeof(child), "%s/%s", path, e->d_name);
+            // unlink() of a directory fails with EISDIR on Linux, EPERM elsewhere
+            if (unlink(child) != 0 && (errno == EISDIR || errno == EPERM))
+                remove_tree(child);
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+int main(void)
+{
+    char scratch[] = "/tmp/voteme-test-XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0 || mkdir("data", 0755) != 0 ||
+        !write_file("data/approved_voters.txt", "voting_number,name,nic,district_id\n"
+                                                "V0001,Ann,100000001V,D01\nV0002,Bob,100000002V,D01\n"
+                                                "V0003,Cal,100000003V,D02\nV0004,Dee,100000004V,D02\n"))
+    {
+        fprintf(stderr, "test_vote_journal: cannot set up %s: %s\n", scratch, strerror(errno));
+        return 1;
+    }
+
+    struct
+    {
+        const char *name;
+        void (*run)(void);
+    } tests[] = {
+        {"unapplied batch", test_unapplied_batch},
+        {"partly applied", test_partly_applied},
+        {"applied and torn", test_applied_and_torn},
+        {"repeated voter", test_repeated_voter},
+        {"exit before mark", test_exit_before_mark},
+        {"replay at open, empty after close", test_open_and_close},
+        {"same under group commit", test_group_commit},
+        {"same voter at once", test_same_voter_at_once},
+    };
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        int before = failures;
+        tests[i].run();
+        printf("%s vote journal: %s\n", failures == before ? "✅" : "❌", tests[i].name);
+    }
+
+    if (chdir("/") == 0)
+        remove_tree(scratch);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,297 @@
+/*
+ * Voted set test
+ *
+ * Checks data/voted.bitmap against temp voted lists written in a scratch
+ * directory:
+ *
+ *   canonical    ids of the adopted <prefix><width digits> form are bits;
+ *                "V1" and "V00001" stay distinct from "V0001" under width 4
+ *   format       the format comes from the first vote, else from the hint
+ *                file, else V/4
+ *   two handles  a second handle on the same file (another process) sees
+ *                new bits and growth, and reloads its irregular ids only
+ *                when irregular_gen changes
+ *   stamp        voted_set_is_current follows the temp list's fingerprint
+ *   errors       an unreadable temp list is an error, not "not voted"
+ *
+ * Exits non-zero when any check fails.
+ */
+
+// mkdtemp/chdir need POSIX 2008 under -std=c99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "data_handler_enhanced.h"
+#include "voted_set.h"
+
+#define TEMP_VOTED_FILE "data/temp-voted-list.txt"
+#define TEMP_VOTED_HEADER "voting_number,candidate_number,party_id\n"
+#define HINT_FILE "data/approved_voters.txt"
+
+static int failures = 0;
+
+static void expect(const char *test, const char *what, int got, int want)
+{
+    if (got != want)
+    {
+        printf("  %s: %s is %d, expected %d\n", test, what, got, want);
+        failures++;
+    }
+}
+
+// Temp list with a header and one row per id (NULL-terminated)
+static void write_temp_list(const char *const ids[])
+{
+    FILE *fp = fopen(TEMP_VOTED_FILE, "w");
+    if (!fp)
+        return;
+    fputs(TEMP_VOTED_HEADER, fp);
+    for (int i = 0; ids[i]; i++)
+        fprintf(fp, "%s,C001,P01\n", ids[i]);
+    fclose(fp);
+}
+
+static void append_temp_row(const char *id)
+{
+    FILE *fp = fopen(TEMP_VOTED_FILE, "a");
+    if (!fp)
+        return;
+    fprintf(fp, "%s,C001,P01\n", id);
+    fclose(fp);
+}
+
+static int open_fresh(const char *test, voted_set_t *vs)
+{
+    unlink(VOTED_SET_FILE);
+    int rc = voted_set_open(vs, VOTED_SET_FILE);
+    expect(test, "voted_set_open", rc, DATA_SUCCESS);
+    return rc == DATA_SUCCESS;
+}
+
+static void test_canonical(void)
+{
+    const char *test = "canonical";
+    const char *const ids[] = {"V0001", "V0042", NULL};
+    write_temp_list(ids);
+    voted_set_t vs;
+    if (!open_fresh(test, &vs))
+        return;
+    expect(test, "rebuild", voted_set_rebuild(&vs, TEMP_VOTED_FILE, NULL), DATA_SUCCESS);
+    expect(test, "width", (int)vs.hdr->width, 4);
+    expect(test, "prefix is V", strcmp(vs.hdr->prefix, "V") == 0, 1);
+    expect(test, "count", (int)vs.hdr->count, 2);
+
+    expect(test, "contains V0001", voted_set_contains(&vs, TEMP_VOTED_FILE, "V0001"), 1);
+    expect(test, "contains V0042", voted_set_contains(&vs, TEMP_VOTED_FILE, "V0042"), 1);
+    expect(test, "contains V0002", voted_set_contains(&vs, TEMP_VOTED_FILE, "V0002"), 0);
+    // Other spellings of number 1 are other voters
+    expect(test, "contains V1", voted_set_contains(&vs, TEMP_VOTED_FILE, "V1"), 0);
+    expect(test, "contains V00001", voted_set_contains(&vs, TEMP_VOTED_FILE, "V00001"), 0);
+    expect(test, "contains W0001", voted_set_contains(&vs, TEMP_VOTED_FILE, "W0001"), 0);
+
+    expect(test, "add V0001 again", voted_set_add(&vs, "V0001"), 0);
+    expect(test, "add V1", voted_set_add(&vs, "V1"), 1);
+    expect(test, "add V1 again", voted_set_add(&vs, "V1"), 0);
+    expect(test, "contains V1 after add", voted_set_contains(&vs, TEMP_VOTED_FILE, "V1"), 1);
+    expect(test, "contains V00001 after V1", voted_set_contains(&vs, TEMP_VOTED_FILE, "V00001"), 0);
+    expect(test, "add V00001", voted_set_add(&vs, "V00001"), 1);
+    expect(test, "count after irregular adds", (int)vs.hdr->count, 2);
+
+    // More digits than the width without a leading zero is still canonical
+    expect(test, "add V12345", voted_set_add(&vs, "V12345"), 1);
+    expect(test, "count after V12345", (int)vs.hdr->count, 3);
+    expect(test, "contains V012345", voted_set_contains(&vs, TEMP_VOTED_FILE, "V012345"), 0);
+    voted_set_close(&vs);
+}
+
+static void test_format(void)
+{
+    const char *test = "format";
+    const char *const none[] = {NULL};
+    write_temp_list(none);
+    FILE *fp = fopen(HINT_FILE, "w");
+    if (fp)
+    {
+        fputs("voting_number,name,nic,district_id\nAB000123,Ann,100000001V,D01\n", fp);
+        fclose(fp);
+    }
+
+    voted_set_t vs;
+    if (!open_fresh(test, &vs))
+        return;
+    expect(test, "rebuild with hint", voted_set_rebuild(&vs, TEMP_VOTED_FILE, HINT_FILE), DATA_SUCCESS);
+    expect(test, "hint width", (int)vs.hdr->width, 6);
+    expect(test, "hint prefix is AB", strcmp(vs.hdr->prefix, "AB") == 0, 1);
+    expect(test, "add AB000123", voted_set_add(&vs, "AB000123"), 1);
+    expect(test, "count", (int)vs.hdr->count, 1);
+
+    // The first vote wins over the hint
+    const char *const votes[] = {"V01", NULL};
+    write_temp_list(votes);
+    expect(test, "rebuild from votes", voted_set_rebuild(&vs, TEMP_VOTED_FILE, HINT_FILE), DATA_SUCCESS);
+    expect(test, "vote width", (int)vs.hdr->width, 2);
+    expect(test, "contains V01", voted_set_contains(&vs, TEMP_VOTED_FILE, "V01"), 1);
+    expect(test, "contains AB000123 after rebuild", voted_set_contains(&vs, TEMP_VOTED_FILE, "AB000123"), 0);
+
+    write_temp_list(none);
+    unlink(HINT_FILE);
+    expect(test, "rebuild without rows", voted_set_rebuild(&vs, TEMP_VOTED_FILE, HINT_FILE), DATA_SUCCESS);
+    expect(test, "default width", (int)vs.hdr->width, 4);
+    expect(test, "default prefix is V", strcmp(vs.hdr->prefix, "V") == 0, 1);
+    voted_set_close(&vs);
+}
+
+static void test_two_handles(void)
+{
+    const char *test = "two handles";
+    const char *const ids[] = {"V0001", NULL};
+    write_temp_list(ids);
+    voted_set_t a, b;
+    if (!open_fresh(test, &a))
+        return;
+    expect(test, "rebuild", voted_set_rebuild(&a, TEMP_VOTED_FILE, NULL), DATA_SUCCESS);
+    expect(test, "second open", voted_set_open(&b, VOTED_SET_FILE), DATA_SUCCESS);
+
+    // Bits are shared, including past the capacity b mapped
+    expect(test, "b contains V0001", voted_set_contains(&b, TEMP_VOTED_FILE, "V0001"), 1);
+    expect(test, "a adds V0005", voted_set_add(&a, "V0005"), 1);
+    expect(test, "b contains V0005", voted_set_contains(&b, TEMP_VOTED_FILE, "V0005"), 1);
+    expect(test, "a adds V999999", voted_set_add(&a, "V999999"), 1);
+    expect(test, "b contains V999999", voted_set_contains(&b, TEMP_VOTED_FILE, "V999999"), 1);
+    expect(test, "b contains V999998", voted_set_contains(&b, TEMP_VOTED_FILE, "V999998"), 0);
+
+    // b loads its irregular ids once and keeps them while irregular_gen stands
+    expect(test, "b contains X-7", voted_set_contains(&b, TEMP_VOTED_FILE, "X-7"), 0);
+    append_temp_row("Y-1"); // written behind the set's back: no reload
+    expect(test, "b contains Y-1 without a gen bump", voted_set_contains(&b, TEMP_VOTED_FILE, "Y-1"), 0);
+
+    // An irregular add by a bumps irregular_gen; b reloads from the temp list
+    append_temp_row("X-7");
+    expect(test, "a adds X-7", voted_set_add(&a, "X-7"), 1);
+    expect(test, "b contains X-7 after the gen bump", voted_set_contains(&b, TEMP_VOTED_FILE, "X-7"), 1);
+    expect(test, "b contains Y-1 after the reload", voted_set_contains(&b, TEMP_VOTED_FILE, "Y-1"), 1);
+    expect(test, "a contains X-7", voted_set_contains(&a, TEMP_VOTED_FILE, "X-7"), 1);
+
+    // A rebuild by a bumps it too, and b drops ids the list no longer has
+    write_temp_list(ids);
+    expect(test, "a rebuilds", voted_set_rebuild(&a, TEMP_VOTED_FILE, NULL), DATA_SUCCESS);
+    expect(test, "b contains X-7 after the rebuild", voted_set_contains(&b, TEMP_VOTED_FILE, "X-7"), 0);
+    expect(test, "b contains V0005 after the rebuild", voted_set_contains(&b, TEMP_VOTED_FILE, "V0005"), 0);
+    voted_set_close(&b);
+    voted_set_close(&a);
+}
+
+static void test_stamp(void)
+{
+    const char *test = "stamp";
+    const char *const ids[] = {"V0001", NULL};
+    write_temp_list(ids);
+    voted_set_t vs;
+    if (!open_fresh(test, &vs))
+        return;
+    struct stat st;
+    stat(TEMP_VOTED_FILE, &st);
+    expect(test, "current before the first rebuild", voted_set_is_current(&vs, &st), 0);
+    expect(test, "rebuild", voted_set_rebuild(&vs, TEMP_VOTED_FILE, NULL), DATA_SUCCESS);
+    expect(test, "current after the rebuild", voted_set_is_current(&vs, &st), 1);
+    append_temp_row("V0002");
+    stat(TEMP_VOTED_FILE, &st);
+    expect(test, "current after an append", voted_set_is_current(&vs, &st), 0);
+    voted_set_stamp(&vs, &st);
+    expect(test, "current after the stamp", voted_set_is_current(&vs, &st), 1);
+    voted_set_close(&vs);
+
+    // The stamp is in the file, so a reopened set still matches
+    expect(test, "reopen", voted_set_open(&vs, VOTED_SET_FILE), DATA_SUCCESS);
+    expect(test, "current after reopening", voted_set_is_current(&vs, &st), 1);
+    expect(test, "contains V0001 after reopening", voted_set_contains(&vs, TEMP_VOTED_FILE, "V0001"), 1);
+    voted_set_close(&vs);
+}
+
+static void test_errors(void)
+{
+    const char *test = "errors";
+    const char *const ids[] = {"V0001", NULL};
+    write_temp_list(ids);
+    voted_set_t vs;
+    if (!open_fresh(test, &vs))
+        return;
+    expect(test, "rebuild", voted_set_rebuild(&vs, TEMP_VOTED_FILE, NULL), DATA_SUCCESS);
+
+    append_temp_row("X-1");
+
+    // A second handle's first irregular lookup reads the temp list; a
+    // directory cannot be read
+    voted_set_t other;
+    expect(test, "second open", voted_set_open(&other, VOTED_SET_FILE), DATA_SUCCESS);
+    mkdir("data/not-a-list", 0755);
+    int rc = voted_set_contains(&other, "data/not-a-list", "X-1");
+    expect(test, "contains with an unreadable list is negative", rc < 0, 1);
+    // The failed load is not kept: the next lookup reads the list again
+    expect(test, "contains after the failure", voted_set_contains(&other, TEMP_VOTED_FILE, "X-1"), 1);
+    voted_set_close(&other);
+    voted_set_close(&vs);
+}
+
+// Remove a directory with the files the data layer leaves in it
+static void remove_tree(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (dir)
+    {
+        struct dirent *e;
+        char child[1024];
+        while ((e = readdir(dir)) != NULL)
+        {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+                continue;
+            snprintf(child, sizeof(child), "%s/%s", path, e->d_name);
+            // unlink() of a directory fails with EISDIR on Linux, EPERM elsewhere
+            if (unlink(child) != 0 && (errno == EISDIR || errno == EPERM))
+                remove_tree(child);
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+int main(void)
+{
+    char scratch[] = "/tmp/voteme-test-XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0 || mkdir("data", 0755) != 0)
+    {
+        fprintf(stderr, "test_voted_set: cannot set up %s: %s\n", scratch, strerror(errno));
+        return 1;
+    }
+
+    struct
+    {
+        const char *name;
+        void (*run)(void);
+    } tests[] = {
+        {"canonical and irregular ids", test_canonical},
+        {"id format", test_format},
+        {"two handles on one file", test_two_handles},
+        {"temp list fingerprint", test_stamp},
+        {"errors", test_errors},
+    };
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        int before = failures;
+        tests[i].run();
+        printf("%s voted set: %s\n", failures == before ? "✅" : "❌", tests[i].name);
+    }
+
+    if (chdir("/") == 0)
+        remove_tree(scratch);
+    return failures ? 1 : 0;
+}